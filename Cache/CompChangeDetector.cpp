@@ -0,0 +1,288 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Comp Change Detector                          */
+/*      Idle-time detection of layer table edits as typed events   */
+/*                                                                 */
+/*******************************************************************/
+
+#include "CompChangeDetector.h"
+#include "LayerIdMap.h"
+#include "FoldLayers.h"
+
+#include <algorithm>
+#include <cstring>
+
+CompChangeDetector	S_comp_changes;
+
+// 64-bit FNV-1a over the ID sequence
+static const uint64_t	HASH_SEED	= 14695981039346656037ULL;
+static const uint64_t	HASH_PRIME	= 1099511628211ULL;
+
+static uint64_t HashLayerId(uint64_t hash, AEGP_LayerIDVal id)
+{
+	for (int i = 0; i < 4; i++) {
+		hash ^= (uint64_t)((id >> (i * 8)) & 0xFF);
+		hash *= HASH_PRIME;
+	}
+	return hash;
+}
+
+uint64_t HashLayerIds(const std::vector<AEGP_LayerIDVal>& ids)
+{
+	uint64_t hash = HASH_SEED;
+	for (size_t i = 0; i < ids.size(); i++) {
+		hash = HashLayerId(hash, ids[i]);
+	}
+	return hash;
+}
+
+CompChangeDetector::CompChangeDetector()
+	: m_comp(NULL)
+	, m_baseHash(HASH_SEED)
+	, m_haveBase(false)
+	, m_passHash(HASH_SEED)
+	, m_cursor(0)
+	, m_passLayers(-1)
+	, m_candidateHash(0)
+	, m_haveCandidate(false)
+	, m_overflowed(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void CompChangeDetector::Reset(AEGP_CompH compH)
+{
+	m_comp = compH;
+	m_baseIds.clear();
+	m_baseHash = HASH_SEED;
+	m_haveBase = false;
+	m_haveCandidate = false;
+	m_passLayers = -1;
+	m_dividerNames.clear();
+	m_classified.clear();
+	m_toClassify.clear();
+	RestartPass();
+
+	m_events.clear();
+	m_overflowed = false;
+	Emit(CompChange_Reset, 0, -1, -1);
+}
+
+void CompChangeDetector::RestartPass()
+{
+	m_passIds.clear();
+	m_passHandles.clear();
+	m_passHash = HASH_SEED;
+	m_cursor = 0;
+}
+
+void CompChangeDetector::Emit(A_long type, AEGP_LayerIDVal id, A_long oldIndex, A_long newIndex)
+{
+	if (m_overflowed) return;
+
+	if (m_events.size() >= COMP_CHANGE_MAX_EVENTS) {
+		// Consumers fell behind: one Reset says "rebuild from BaselineIds()"
+		m_events.clear();
+		type = CompChange_Reset;
+		id = 0;
+		oldIndex = newIndex = -1;
+		m_overflowed = true;
+	}
+
+	CompChangeEvent ev = { type, id, oldIndex, newIndex };
+	m_events.push_back(ev);
+	m_stats.eventsEmitted++;
+}
+
+void CompChangeDetector::DrainEvents(std::vector<CompChangeEvent>& outEvents)
+{
+	outEvents.insert(outEvents.end(), m_events.begin(), m_events.end());
+	m_events.clear();
+	m_overflowed = false;
+}
+
+void CompChangeDetector::Diff()
+{
+	const std::vector<AEGP_LayerIDVal>& oldIds = m_baseIds;
+	const std::vector<AEGP_LayerIDVal>& newIds = m_passIds;
+
+	std::unordered_map<AEGP_LayerIDVal, A_long> oldIndexOf;
+	oldIndexOf.reserve(oldIds.size());
+	for (size_t i = 0; i < oldIds.size(); i++) {
+		oldIndexOf[oldIds[i]] = (A_long)i;
+	}
+
+	// Inserted layers, and old indices of the survivors in their new order
+	std::vector<A_long> survivorOld;
+	std::vector<A_long> survivorNew;
+	survivorOld.reserve(newIds.size());
+	survivorNew.reserve(newIds.size());
+	for (size_t i = 0; i < newIds.size(); i++) {
+		std::unordered_map<AEGP_LayerIDVal, A_long>::iterator it = oldIndexOf.find(newIds[i]);
+		if (it == oldIndexOf.end()) {
+			Emit(CompChange_Inserted, newIds[i], -1, (A_long)i);
+		} else {
+			survivorOld.push_back(it->second);
+			survivorNew.push_back((A_long)i);
+			it->second = -1;	// Seen
+		}
+	}
+
+	// Deleted layers: old IDs never seen above
+	for (size_t i = 0; i < oldIds.size(); i++) {
+		std::unordered_map<AEGP_LayerIDVal, A_long>::const_iterator it = oldIndexOf.find(oldIds[i]);
+		if (it != oldIndexOf.end() && it->second >= 0) {
+			Emit(CompChange_Deleted, oldIds[i], (A_long)i, -1);
+			m_dividerNames.erase(oldIds[i]);
+			m_classified.erase(oldIds[i]);
+		}
+	}
+
+	// Survivors on the longest run that kept its relative order stayed put;
+	// the rest moved (the fewest moves that explain the new order)
+	const size_t n = survivorOld.size();
+	std::vector<size_t> tails;			// Index into survivors of the smallest tail per run length
+	std::vector<size_t> prev(n, (size_t)-1);
+	for (size_t i = 0; i < n; i++) {
+		size_t lo = 0, hi = tails.size();
+		while (lo < hi) {
+			const size_t mid = (lo + hi) / 2;
+			if (survivorOld[tails[mid]] < survivorOld[i]) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo > 0) prev[i] = tails[lo - 1];
+		if (lo == tails.size()) tails.push_back(i);
+		else tails[lo] = i;
+	}
+
+	std::vector<bool> stayed(n, false);
+	for (size_t i = tails.empty() ? (size_t)-1 : tails.back(); i != (size_t)-1; i = prev[i]) {
+		stayed[i] = true;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (!stayed[i]) {
+			Emit(CompChange_Moved, newIds[survivorNew[i]], survivorOld[i], survivorNew[i]);
+		}
+	}
+}
+
+void CompChangeDetector::FinishPass()
+{
+	m_stats.passes++;
+
+	if (m_haveBase && m_passHash == m_baseHash) {
+		m_haveCandidate = false;
+		RestartPass();
+		return;
+	}
+
+	if (m_haveBase) m_stats.hashMismatches++;
+
+	// A walk spread over several ticks may straddle an edit; only a state two
+	// passes agree on is diffed
+	if (!m_haveCandidate || m_candidateHash != m_passHash) {
+		m_candidateHash = m_passHash;
+		m_haveCandidate = true;
+		RestartPass();
+		return;
+	}
+
+	if (m_haveBase) {
+		m_stats.diffs++;
+		Diff();
+	}
+
+	S_layer_id_map.ApplySnapshot(m_comp, m_passIds, m_passHandles);
+
+	// Handles are only trusted while the layer count holds (see Tick)
+	m_toClassify.clear();
+	for (size_t i = 0; i < m_passIds.size(); i++) {
+		if (!m_classified.count(m_passIds[i])) {
+			m_toClassify.push_back(std::make_pair(m_passIds[i], m_passHandles[i]));
+		}
+	}
+
+	m_baseIds.swap(m_passIds);
+	m_baseHash = m_passHash;
+	m_haveBase = true;
+	m_haveCandidate = false;
+	RestartPass();
+}
+
+A_Err CompChangeDetector::Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH)
+{
+	A_Err err = A_Err_NONE;
+
+	if (compH != m_comp) Reset(compH);
+	if (!compH) return err;
+
+	const double start = PerfNowSeconds();
+	m_stats.ticks++;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	// Insert or delete: the IDs read so far no longer line up
+	if (numLayers != m_passLayers) {
+		if (m_passLayers >= 0) m_stats.countChanges++;
+		RestartPass();
+		m_toClassify.clear();
+		m_passLayers = numLayers;
+		m_passIds.reserve((size_t)numLayers);
+		m_passHandles.reserve((size_t)numLayers);
+	}
+
+	uint32_t examined = 0;
+	while (examined < COMP_CHANGE_TICK_BUDGET && m_cursor < numLayers && !err) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, m_cursor, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (err) break;
+		examined++;
+
+		m_passIds.push_back(id);
+		m_passHandles.push_back(layerH);
+		m_passHash = HashLayerId(m_passHash, id);
+
+		// Known dividers also get a name check while there is budget left
+		std::unordered_map<AEGP_LayerIDVal, std::string>::iterator it = m_dividerNames.find(id);
+		if (it != m_dividerNames.end() && examined < COMP_CHANGE_TICK_BUDGET) {
+			std::string name;
+			examined++;
+			// Folding rewrites the fold marker in the name; only the name
+			// itself counts as a rename
+			if (GetLayerNameStr(suites, layerH, name) == A_Err_NONE && GetDividerName(name) != it->second) {
+				it->second = GetDividerName(name);
+				Emit(CompChange_DividerRenamed, id, m_cursor, m_cursor);
+			}
+		}
+
+		m_cursor++;
+	}
+
+	if (!err && m_cursor >= numLayers) {
+		FinishPass();
+	}
+
+	// Leftover budget: find out which new layers are dividers
+	while (!err && examined < COMP_CHANGE_TICK_BUDGET && !m_toClassify.empty()) {
+		const AEGP_LayerIDVal id = m_toClassify.back().first;
+		AEGP_LayerH layerH = m_toClassify.back().second;
+		m_toClassify.pop_back();
+		m_classified.insert(id);
+		examined++;
+
+		std::string name;
+		if (IsDividerLayer(suites, layerH) && GetLayerNameStr(suites, layerH, name) == A_Err_NONE) {
+			m_dividerNames[id] = GetDividerName(name);
+		}
+	}
+
+	m_stats.layersExamined += examined;
+	if (examined > m_stats.maxExaminedPerTick) m_stats.maxExaminedPerTick = examined;
+	m_tickCost.Record(PerfNowSeconds() - start);
+
+	return err;
+}
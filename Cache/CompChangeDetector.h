@@ -0,0 +1,130 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Comp Change Detector                          */
+/*      Idle-time detection of layer table edits as typed events   */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef COMP_CHANGE_DETECTOR_H
+#define COMP_CHANGE_DETECTOR_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Utils/PerfStats.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Upper bound on layers examined per Tick. Reading a layer's ID, reading a
+// divider's name and classifying a new layer each count as one.
+#define COMP_CHANGE_TICK_BUDGET		256
+
+// Events queued beyond this collapse into a single CompChange_Reset
+#define COMP_CHANGE_MAX_EVENTS		4096
+
+enum CompChangeType {
+	CompChange_Reset = 0,		// Comp switched or queue overflowed: rebuild from scratch
+	CompChange_Inserted,		// id now at newIndex
+	CompChange_Deleted,			// id was at oldIndex
+	CompChange_Moved,			// id moved oldIndex -> newIndex (beyond the shift from inserts/deletes)
+	CompChange_DividerRenamed	// Divider id's name changed (fold marker and label prefix ignored)
+};
+
+typedef struct {
+	A_long				type;		// CompChangeType
+	AEGP_LayerIDVal		id;
+	A_long				oldIndex;	// -1 if not applicable
+	A_long				newIndex;	// -1 if not applicable
+} CompChangeEvent;
+
+typedef struct {
+	uint32_t	ticks;				// Tick calls with an active comp
+	uint32_t	layersExamined;		// Total budget units spent
+	uint32_t	maxExaminedPerTick;	// Never above COMP_CHANGE_TICK_BUDGET
+	uint32_t	passes;				// Completed walks over the comp
+	uint32_t	countChanges;		// Passes restarted by a layer count change
+	uint32_t	hashMismatches;		// Passes whose hash differed from the baseline
+	uint32_t	diffs;				// Confirmed mismatches escalated to a full diff
+	uint32_t	eventsEmitted;
+} CompChangeStats;
+
+// Walks the active comp at most COMP_CHANGE_TICK_BUDGET layers per tick,
+// folding layer IDs (in index order) into a rolling hash. The layer count is
+// checked every tick, so inserts and deletes restart the walk at once. A
+// pass whose hash matches the baseline costs nothing more. On a mismatch the
+// pass's ID sequence is kept. Once a second pass sees the same hash (so the
+// comp was not being edited mid-walk), the two sequences are diffed in
+// memory into typed events and the snapshot becomes the new baseline.
+// The rolling hash over a whole ID sequence (index order), for comparing
+// against BaselineHash() or a stored fingerprint
+uint64_t HashLayerIds(const std::vector<AEGP_LayerIDVal>& ids);
+
+class CompChangeDetector {
+public:
+	CompChangeDetector();
+
+	// One bounded step for compH (NULL: no active comp)
+	A_Err		Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH);
+
+	// Move queued events to outEvents (appends)
+	void		DrainEvents(std::vector<CompChangeEvent>& outEvents);
+	bool		HasEvents() const { return !m_events.empty(); }
+
+	// Last confirmed layer IDs in index order
+	const std::vector<AEGP_LayerIDVal>&	BaselineIds() const { return m_baseIds; }
+	uint64_t	BaselineHash() const { return m_baseHash; }
+	bool		HasBaseline() const { return m_haveBase; }
+	AEGP_CompH	Comp() const { return m_comp; }
+
+	// Per-tick cost (seconds) and counters
+	const LatencyHistogram&	TickCost() const { return m_tickCost; }
+	const CompChangeStats&	Stats() const { return m_stats; }
+
+private:
+	CompChangeDetector(const CompChangeDetector&);
+	CompChangeDetector& operator=(const CompChangeDetector&);
+
+	void		Reset(AEGP_CompH compH);
+	void		RestartPass();
+	void		Emit(A_long type, AEGP_LayerIDVal id, A_long oldIndex, A_long newIndex);
+	void		FinishPass();
+	void		Diff();
+
+	AEGP_CompH							m_comp;
+
+	// Confirmed state
+	std::vector<AEGP_LayerIDVal>		m_baseIds;
+	uint64_t							m_baseHash;
+	bool								m_haveBase;
+
+	// Pass in progress
+	std::vector<AEGP_LayerIDVal>		m_passIds;
+	std::vector<AEGP_LayerH>			m_passHandles;
+	uint64_t							m_passHash;
+	A_long								m_cursor;
+	A_long								m_passLayers;		// Layer count the pass started with
+
+	// Previous mismatching pass (waiting for confirmation)
+	uint64_t							m_candidateHash;
+	bool								m_haveCandidate;
+
+	// Divider names by ID; layers classified so far; baseline layers still
+	// to classify (dropped on a count change, refilled at the next baseline)
+	std::unordered_map<AEGP_LayerIDVal, std::string>	m_dividerNames;
+	std::unordered_set<AEGP_LayerIDVal>	m_classified;
+	std::vector<std::pair<AEGP_LayerIDVal, AEGP_LayerH> >	m_toClassify;
+
+	std::vector<CompChangeEvent>		m_events;
+	bool								m_overflowed;	// Queue holds only a Reset until drained
+	LatencyHistogram					m_tickCost;
+	CompChangeStats						m_stats;
+};
+
+// Detector for the active comp, ticked from IdleHook
+extern CompChangeDetector	S_comp_changes;
+
+#endif // COMP_CHANGE_DETECTOR_H
@@ -0,0 +1,278 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Index                                 */
+/*      Per-comp divider lists persisted across sessions           */
+/*                                                                 */
+/*******************************************************************/
+
+#include "DividerIndex.h"
+#include "Utils/PerfStats.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef AE_OS_WIN
+	#include <windows.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+static_assert(sizeof(DividerIndexEntry) == 8, "DividerIndexEntry is part of the file format");
+static_assert(sizeof(DividerIndexCompHeader) == 24, "DividerIndexCompHeader is part of the file format");
+static_assert(sizeof(DividerIndexFileHeader) == 24, "DividerIndexFileHeader is part of the file format");
+
+DividerIndex::DividerIndex()
+	: m_projectKey(0)
+	, m_dirty(false)
+	, m_lastSave(0.0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+bool DividerIndex::BindProject(uint64_t projectKey)
+{
+	if (projectKey == m_projectKey) return false;
+
+	m_projectKey = projectKey;
+	m_comps.clear();
+	m_dirty = false;
+	return true;
+}
+
+const DividerIndexComp* DividerIndex::Find(A_long compItemId) const
+{
+	std::unordered_map<A_long, DividerIndexComp>::const_iterator it = m_comps.find(compItemId);
+	return it == m_comps.end() ? NULL : &it->second;
+}
+
+void DividerIndex::Store(A_long compItemId, uint32_t numLayers, uint64_t layerHash,
+						 const std::vector<DividerIndexEntry>& entries)
+{
+	DividerIndexComp& comp = m_comps[compItemId];
+	comp.numLayers = numLayers;
+	comp.layerHash = layerHash;
+	comp.stale = false;
+	comp.entries = entries;
+	m_dirty = true;
+}
+
+void DividerIndex::Invalidate(A_long compItemId)
+{
+	if (m_comps.erase(compItemId)) m_dirty = true;
+}
+
+void DividerIndex::SetFolded(A_long compItemId, AEGP_LayerIDVal id, bool folded)
+{
+	std::unordered_map<A_long, DividerIndexComp>::iterator it = m_comps.find(compItemId);
+	if (it == m_comps.end()) return;
+
+	std::vector<DividerIndexEntry>& entries = it->second.entries;
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].layerId == id && entries[i].folded != (uint8_t)folded) {
+			entries[i].folded = (uint8_t)folded;
+			m_dirty = true;
+		}
+	}
+}
+
+void DividerIndex::ApplyEvents(A_long compItemId, const std::vector<CompChangeEvent>& events,
+							   uint64_t fromHash, uint64_t toHash, uint32_t toLayers)
+{
+	std::unordered_map<A_long, DividerIndexComp>::iterator it = m_comps.find(compItemId);
+	if (it == m_comps.end()) return;
+
+	DividerIndexComp& comp = it->second;
+	if (comp.stale || comp.layerHash != fromHash) return;
+
+	for (size_t i = 0; i < events.size(); i++) {
+		// The detector lost track (comp switch, overflow): nothing to build on
+		if (events[i].type == CompChange_Reset) return;
+	}
+
+	for (size_t i = 0; i < events.size(); i++) {
+		const CompChangeEvent& e = events[i];
+		if (e.type == CompChange_Deleted) {
+			for (size_t d = 0; d < comp.entries.size(); d++) {
+				if (comp.entries[d].layerId == e.id) {
+					comp.entries.erase(comp.entries.begin() + d);
+					break;
+				}
+			}
+		} else if (e.type == CompChange_Inserted) {
+			// Could be a pasted or duplicated divider
+			comp.stale = true;
+		}
+		m_stats.eventsApplied++;
+	}
+
+	comp.layerHash = toHash;
+	comp.numLayers = toLayers;
+	m_dirty = true;
+}
+
+void DividerIndex::Serialize(std::vector<uint8_t>& out) const
+{
+	size_t total = sizeof(DividerIndexFileHeader);
+	for (std::unordered_map<A_long, DividerIndexComp>::const_iterator it = m_comps.begin(); it != m_comps.end(); ++it) {
+		if (!it->second.stale) {
+			total += sizeof(DividerIndexCompHeader) + it->second.entries.size() * sizeof(DividerIndexEntry);
+		}
+	}
+	out.assign(total, 0);
+
+	DividerIndexFileHeader file;
+	memset(&file, 0, sizeof(file));
+	file.magic = DIVIDER_INDEX_MAGIC;
+	file.version = DIVIDER_INDEX_VERSION;
+	file.projectKey = m_projectKey;
+
+	size_t pos = sizeof(file);
+	for (std::unordered_map<A_long, DividerIndexComp>::const_iterator it = m_comps.begin(); it != m_comps.end(); ++it) {
+		const DividerIndexComp& comp = it->second;
+		if (comp.stale) continue;
+
+		DividerIndexCompHeader header;
+		memset(&header, 0, sizeof(header));
+		header.compItemId = (int32_t)it->first;
+		header.numLayers = comp.numLayers;
+		header.layerHash = comp.layerHash;
+		header.entryCount = (uint32_t)comp.entries.size();
+
+		memcpy(&out[pos], &header, sizeof(header));
+		pos += sizeof(header);
+		if (!comp.entries.empty()) {
+			memcpy(&out[pos], &comp.entries[0], comp.entries.size() * sizeof(DividerIndexEntry));
+			pos += comp.entries.size() * sizeof(DividerIndexEntry);
+		}
+		file.compCount++;
+	}
+
+	memcpy(&out[0], &file, sizeof(file));
+}
+
+bool DividerIndex::Deserialize(const uint8_t* data, size_t size)
+{
+	m_comps.clear();
+
+	DividerIndexFileHeader file;
+	if (!data || size < sizeof(file)) return false;
+	memcpy(&file, data, sizeof(file));
+	if (file.magic != DIVIDER_INDEX_MAGIC || file.version != DIVIDER_INDEX_VERSION ||
+		file.projectKey != m_projectKey || file.compCount > DIVIDER_INDEX_MAX_COMPS) {
+		return false;
+	}
+
+	size_t pos = sizeof(file);
+	for (uint32_t c = 0; c < file.compCount; c++) {
+		DividerIndexCompHeader header;
+		if (size - pos < sizeof(header)) break;
+		memcpy(&header, data + pos, sizeof(header));
+		pos += sizeof(header);
+
+		const size_t bytes = (size_t)header.entryCount * sizeof(DividerIndexEntry);
+		if (header.entryCount > DIVIDER_INDEX_MAX_ENTRIES || size - pos < bytes) break;
+
+		DividerIndexComp& comp = m_comps[(A_long)header.compItemId];
+		comp.numLayers = header.numLayers;
+		comp.layerHash = header.layerHash;
+		comp.stale = false;
+		comp.entries.resize(header.entryCount);
+		if (bytes) memcpy(&comp.entries[0], data + pos, bytes);
+		pos += bytes;
+	}
+
+	// Truncated file: keep nothing rather than a partial index
+	if (m_comps.size() != file.compCount) {
+		m_comps.clear();
+		return false;
+	}
+	return true;
+}
+
+bool DividerIndex::SidecarPath(std::string& outPath, bool create) const
+{
+	if (!m_projectKey) return false;
+
+	char dir[512];
+#ifdef AE_OS_WIN
+	const char* base = getenv("LOCALAPPDATA");
+	if (!base) return false;
+	snprintf(dir, sizeof(dir), "%s\\FoldLayers", base);
+	if (create) CreateDirectoryA(dir, NULL);
+	const char sep = '\\';
+#else
+	const char* base = getenv("HOME");
+	if (!base) return false;
+	snprintf(dir, sizeof(dir), "%s/Library/Caches/FoldLayers", base);
+	if (create) mkdir(dir, 0755);
+	const char sep = '/';
+#endif
+
+	char path[600];
+	snprintf(path, sizeof(path), "%s%c%016llx%s", dir, sep, (unsigned long long)m_projectKey, DIVIDER_INDEX_EXTENSION);
+	outPath = path;
+	return true;
+}
+
+A_Err DividerIndex::Load()
+{
+	m_comps.clear();
+	m_dirty = false;
+
+	std::string path;
+	if (!SidecarPath(path, false)) return A_Err_NONE;
+
+	const double start = PerfNowSeconds();
+
+	// No sidecar yet is the normal first-open case
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) return A_Err_NONE;
+
+	std::vector<uint8_t> data;
+	if (fseek(f, 0, SEEK_END) == 0) {
+		const long size = ftell(f);
+		if (size > 0 && fseek(f, 0, SEEK_SET) == 0) {
+			data.resize((size_t)size);
+			if (fread(&data[0], 1, data.size(), f) != data.size()) data.clear();
+		}
+	}
+	fclose(f);
+
+	// A bad file only costs a cold scan; it is replaced on the next save
+	if (!data.empty()) Deserialize(&data[0], data.size());
+
+	m_stats.loads++;
+	m_stats.compsLoaded = (uint32_t)m_comps.size();
+	m_stats.lastLoadSeconds = PerfNowSeconds() - start;
+	return A_Err_NONE;
+}
+
+A_Err DividerIndex::Save()
+{
+	std::string path;
+	if (!m_dirty || !SidecarPath(path, true)) return A_Err_NONE;
+
+	// Failures retry at the next interval, not on every idle call
+	m_lastSave = PerfNowSeconds();
+
+	std::vector<uint8_t> data;
+	Serialize(data);
+
+	// Write beside the old file and swap, so a crash never leaves half a file
+	const std::string tmpPath = path + ".tmp";
+	FILE* f = fopen(tmpPath.c_str(), "wb");
+	if (!f) return A_Err_GENERIC;
+	const bool written = fwrite(&data[0], 1, data.size(), f) == data.size();
+	if (fclose(f) != 0 || !written) {
+		remove(tmpPath.c_str());
+		return A_Err_GENERIC;
+	}
+
+	remove(path.c_str());
+	if (rename(tmpPath.c_str(), path.c_str()) != 0) return A_Err_GENERIC;
+
+	m_dirty = false;
+	m_stats.saves++;
+	return A_Err_NONE;
+}
@@ -0,0 +1,188 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Index                                 */
+/*      Per-comp divider lists persisted across sessions           */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef DIVIDER_INDEX_H
+#define DIVIDER_INDEX_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Cache/CompChangeDetector.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Sidecar file: one per saved project, named after a hash of the project
+// path, in the user cache folder. Little-endian, fixed-width and 8-byte
+// aligned throughout, so the file can be mapped or read in one go and used
+// in place:
+//   DividerIndexFileHeader
+//   per comp: DividerIndexCompHeader, then entryCount x DividerIndexEntry
+#define DIVIDER_INDEX_MAGIC			0x58444C46	// "FLDX"
+#define DIVIDER_INDEX_VERSION		1
+#define DIVIDER_INDEX_EXTENSION		".fldx"
+
+// Upper bounds applied on load (a corrupt file is dropped, not trusted)
+#define DIVIDER_INDEX_MAX_COMPS		65536
+#define DIVIDER_INDEX_MAX_ENTRIES	65536
+
+// Dirty indexes are written from idle at most this often (and at shutdown)
+#define DIVIDER_INDEX_SAVE_INTERVAL	10.0		// seconds
+
+// Idle calls between checks of the open project's path
+#define DIVIDER_INDEX_BIND_INTERVAL	40
+
+enum DividerIndexKind {
+	DividerIndexKind_Shape = 0,
+	DividerIndexKind_Null
+};
+
+typedef struct {
+	uint32_t	layerId;
+	uint8_t		depth;			// GetHierarchyDepth of the divider's hierarchy
+	uint8_t		folded;			// Last known fold bit (a hint; the layer is authoritative)
+	uint8_t		kind;			// DividerIndexKind
+	uint8_t		reserved;
+} DividerIndexEntry;
+
+typedef struct {
+	int32_t		compItemId;		// AEGP_GetItemID of the comp item
+	uint32_t	numLayers;		// Fingerprint: layer count ...
+	uint64_t	layerHash;		// ... and HashLayerIds over every layer ID in index order
+	uint32_t	entryCount;
+	uint32_t	reserved;
+} DividerIndexCompHeader;
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	version;
+	uint64_t	projectKey;		// Hash of the project path (guards against name collisions)
+	uint32_t	compCount;
+	uint32_t	reserved;
+} DividerIndexFileHeader;
+
+typedef struct {
+	uint32_t	loads;
+	uint32_t	compsLoaded;
+	double		lastLoadSeconds;	// Read + parse time of the last Load
+	uint32_t	saves;
+	uint32_t	hits;				// GetAllDividers served from the index
+	uint32_t	misses;				// No entry, stale entry or failed fingerprint
+	uint32_t	rejected;			// Entry fingerprint matched but a divider failed its check
+	uint32_t	eventsApplied;		// Change detector events folded into entries
+} DividerIndexStats;
+
+// One comp's dividers in index order, with the fingerprint of the layer
+// table they were recorded against
+typedef struct {
+	uint32_t						numLayers;
+	uint64_t						layerHash;
+	bool							stale;		// Rebuild on next use
+	std::vector<DividerIndexEntry>	entries;
+} DividerIndexComp;
+
+// In-memory index for the current project. Pure data; the AE-facing
+// helpers below (IndexedDividers.cpp) look entries up, validate and
+// refresh them.
+class DividerIndex {
+public:
+	DividerIndex();
+
+	// Switch to another project (0: unsaved, nothing persisted). Returns
+	// true if the key changed; the caller saves the old index first.
+	bool		BindProject(uint64_t projectKey);
+	uint64_t	ProjectKey() const { return m_projectKey; }
+
+	const DividerIndexComp*	Find(A_long compItemId) const;
+	void		Store(A_long compItemId, uint32_t numLayers, uint64_t layerHash,
+					  const std::vector<DividerIndexEntry>& entries);
+	void		Invalidate(A_long compItemId);
+	void		SetFolded(A_long compItemId, AEGP_LayerIDVal id, bool folded);
+
+	// Fold confirmed layer table edits into compItemId's entry. Only applies
+	// when the entry was recorded against fromHash; afterwards it matches
+	// (toHash, toLayers). Deleted dividers drop out; an inserted layer may be
+	// a divider, so the entry goes stale.
+	void		ApplyEvents(A_long compItemId, const std::vector<CompChangeEvent>& events,
+							uint64_t fromHash, uint64_t toHash, uint32_t toLayers);
+
+	// File image (see the layout above)
+	void		Serialize(std::vector<uint8_t>& out) const;
+	bool		Deserialize(const uint8_t* data, size_t size);
+
+	// Sidecar I/O for the bound project
+	A_Err		Load();
+	A_Err		Save();
+	bool		Dirty() const { return m_dirty; }
+	double		LastSaveTime() const { return m_lastSave; }
+
+	size_t		Size() const { return m_comps.size(); }
+	DividerIndexStats&	Stats() { return m_stats; }
+
+private:
+	DividerIndex(const DividerIndex&);
+	DividerIndex& operator=(const DividerIndex&);
+
+	bool		SidecarPath(std::string& outPath, bool create) const;
+
+	uint64_t									m_projectKey;
+	std::unordered_map<A_long, DividerIndexComp>	m_comps;
+	bool										m_dirty;
+	double										m_lastSave;
+	DividerIndexStats							m_stats;
+};
+
+// Index for the open project; bound and saved from IdleHook
+extern DividerIndex	S_divider_index;
+
+// Item ID of compH's comp item
+A_Err GetCompItemId(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long* outItemId);
+
+// Hash of the open project's path; 0 for an unsaved project
+A_Err GetProjectKey(AEGP_SuiteHandler& suites, uint64_t* outKey);
+
+// Warm start for GetAllDividers: fills dividers from compH's entry when its
+// fingerprint still matches and every divider passes its identity check.
+// *outServed is false (dividers untouched) otherwise.
+A_Err GetIndexedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						 std::vector<std::pair<AEGP_LayerH, A_long> >& dividers, bool* outServed);
+
+// A divider as the index remembers it, placed by the layer ID map
+typedef struct {
+	AEGP_LayerIDVal	id;
+	AEGP_LayerH		layerH;
+	A_long			index;
+	int				depth;
+	bool			folded;		// As last recorded; probe before relying on it
+} IndexedDivider;
+
+// Like GetIndexedDividers but without the identity probes: the dividers of
+// compH's current entry in index order, for callers that only touch a few
+// of them (and probe those). Each divider's index is confirmed with one
+// AEGP_GetLayerIndex call (no identity probes). *outServed is false when
+// there is no current entry or a divider moved since the last map pass.
+A_Err GetIndexedStructure(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  std::vector<IndexedDivider>& dividers, bool* outServed);
+
+// Record the result of a full scan (layerIds: every layer ID in index order)
+A_Err RecordIndexedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+							const std::vector<AEGP_LayerIDVal>& layerIds,
+							const std::vector<std::pair<AEGP_LayerH, A_long> >& dividers);
+
+// Keep an entry's fold bit current / drop the entry of layerH's comp
+void NoteIndexedFold(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH, bool folded);
+void InvalidateIndexedComp(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
+
+// Idle work: follow the open project (every few calls), fold compH's change
+// events into its entry, save when dirty. diffHashBefore is the detector's
+// baseline hash before this idle call's Tick.
+void TickDividerIndex(AEGP_SuiteHandler& suites, AEGP_CompH compH, uint64_t diffHashBefore);
+
+#endif // DIVIDER_INDEX_H
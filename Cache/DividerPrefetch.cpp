@@ -0,0 +1,194 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Prefetch                              */
+/*      Warms the divider index of the active comp from idle       */
+/*                                                                 */
+/*******************************************************************/
+
+#include "DividerPrefetch.h"
+#include "DividerIndex.h"
+#include "LayerIdMap.h"
+#include "FoldLayers.h"
+
+#include <algorithm>
+#include <cstring>
+
+DividerPrefetcher	S_divider_prefetch;
+
+DividerPrefetcher::DividerPrefetcher()
+	: m_comp(NULL)
+	, m_itemId(0)
+	, m_phase(Phase_Idle)
+	, m_gaveUp(false)
+	, m_cursor(0)
+	, m_numLayers(-1)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+bool DividerPrefetcher::InLru(A_long itemId) const
+{
+	return std::find(m_lru.begin(), m_lru.end(), itemId) != m_lru.end();
+}
+
+void DividerPrefetcher::Touch(A_long itemId)
+{
+	std::vector<A_long>::iterator it = std::find(m_lru.begin(), m_lru.end(), itemId);
+	if (it != m_lru.end()) m_lru.erase(it);
+	m_lru.insert(m_lru.begin(), itemId);
+	if (m_lru.size() > DIVIDER_PREFETCH_LRU_SIZE) m_lru.resize(DIVIDER_PREFETCH_LRU_SIZE);
+}
+
+void DividerPrefetcher::StartScan()
+{
+	m_phase = Phase_Scan;
+	m_cursor = 0;
+	m_numLayers = -1;
+	m_ids.clear();
+	m_found.clear();
+}
+
+void DividerPrefetcher::Finish()
+{
+	Touch(m_itemId);
+	m_phase = Phase_Idle;
+	m_ids.clear();
+	m_found.clear();
+}
+
+A_Err DividerPrefetcher::ScanSlice(AEGP_SuiteHandler& suites, double start)
+{
+	A_Err err = A_Err_NONE;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(m_comp, &numLayers));
+	if (err) return err;
+
+	// Insert or delete mid-scan: the indices read so far no longer line up
+	if (numLayers != m_numLayers) {
+		if (m_numLayers >= 0) m_stats.restarts++;
+		StartScan();
+		m_numLayers = numLayers;
+		m_ids.reserve((size_t)numLayers);
+	}
+
+	A_long examined = 0;
+	while (m_cursor < numLayers && examined < DIVIDER_PREFETCH_SLICE_LAYERS && !err) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(m_comp, m_cursor, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (err) break;
+
+		m_ids.push_back(id);
+		if (IsDividerLayer(suites, layerH)) {
+			m_found.push_back(std::make_pair(layerH, m_cursor));
+		}
+		m_cursor++;
+		examined++;
+		m_stats.layersProbed++;
+
+		// Probes on shape layers vary a lot in cost; the clock has the last word
+		if (PerfNowSeconds() - start >= DIVIDER_PREFETCH_SLICE_SECONDS) break;
+	}
+	if (err || m_cursor < numLayers) return err;
+
+	// A scan spread over idle calls may straddle a reorder: only record it
+	// if the layer order still matches what was read
+	for (A_long i = 0; i < numLayers && !err; i++) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(m_comp, i, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (!err && id != m_ids[(size_t)i]) {
+			m_stats.restarts++;
+			StartScan();
+			return err;
+		}
+	}
+
+	ERR(RecordIndexedDividers(suites, m_comp, m_ids, m_found));
+	if (!err) {
+		m_stats.rebuilds++;
+		Finish();
+	}
+	return err;
+}
+
+A_Err DividerPrefetcher::Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH)
+{
+	A_Err err = A_Err_NONE;
+
+	if (compH != m_comp) {
+		if (Busy()) m_stats.abandoned++;
+		m_comp = compH;
+		m_itemId = 0;
+		m_phase = Phase_Idle;
+		m_gaveUp = false;
+		m_ids.clear();
+		m_found.clear();
+		if (!compH) return err;
+
+		ERR(GetCompItemId(suites, compH, &m_itemId));
+		if (err) return err;
+		m_stats.activations++;
+
+		const DividerIndexComp* entry = S_divider_index.Find(m_itemId);
+		if (entry && !entry->stale && InLru(m_itemId)) {
+			m_stats.lruHits++;
+			Touch(m_itemId);
+			return err;
+		}
+		m_phase = Phase_SyncMap;
+	}
+	if (!compH) return err;
+
+	if (m_phase == Phase_Idle) {
+		// Entry dropped or gone stale while this comp is active
+		const DividerIndexComp* entry = S_divider_index.Find(m_itemId);
+		if (m_gaveUp || (entry && !entry->stale)) return err;
+		m_stats.misses++;
+		StartScan();
+	}
+
+	const double start = PerfNowSeconds();
+
+	if (m_phase == Phase_SyncMap) {
+		bool complete = false;
+		ERR(S_layer_id_map.Sync(suites, compH, DIVIDER_PREFETCH_SLICE_LAYERS, &complete));
+		if (!err && complete) m_phase = Phase_Validate;
+	} else if (m_phase == Phase_Validate) {
+		// Fingerprint from the synced map, one identity probe per divider
+		const DividerIndexComp* entry = S_divider_index.Find(m_itemId);
+		std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+		bool served = false;
+		if (entry && !entry->stale) {
+			ERR(GetIndexedDividers(suites, compH, dividers, &served));
+		}
+		if (!err && served) {
+			m_stats.indexHits++;
+			Finish();
+		} else if (!err) {
+			m_stats.misses++;
+			StartScan();
+		}
+	} else if (m_phase == Phase_Scan) {
+		ERR(ScanSlice(suites, start));
+	}
+
+	m_sliceCost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	if (!err && m_phase == Phase_Idle) {
+		PerfLog("divider prefetch: %u activations, %u lru hits, %u index hits, %u misses, %u rebuilds, %s",
+			m_stats.activations, m_stats.lruHits, m_stats.indexHits, m_stats.misses, m_stats.rebuilds,
+			m_sliceCost.Summary("slice").c_str());
+	}
+#endif
+
+	// Give up on this comp until it is activated again rather than retry every tick
+	if (err) {
+		m_phase = Phase_Idle;
+		m_gaveUp = true;
+	}
+	return err;
+}
@@ -0,0 +1,95 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Prefetch                              */
+/*      Warms the divider index of the active comp from idle       */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef DIVIDER_PREFETCH_H
+#define DIVIDER_PREFETCH_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Utils/PerfStats.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Recently active comps whose index entries are trusted without a recheck
+#define DIVIDER_PREFETCH_LRU_SIZE		4
+
+// Per-tick slice bounds: layers read or probed, and wall time
+#define DIVIDER_PREFETCH_SLICE_LAYERS	128
+#define DIVIDER_PREFETCH_SLICE_SECONDS	0.004
+
+typedef struct {
+	uint32_t	activations;		// Active comp changed to a comp
+	uint32_t	lruHits;			// Recent comp with a current entry: no work at all
+	uint32_t	indexHits;			// Entry (e.g. loaded from disk) validated
+	uint32_t	misses;				// No usable entry: identity scan started
+	uint32_t	rebuilds;			// Identity scans completed and recorded
+	uint32_t	restarts;			// Scans restarted by a layer table edit
+	uint32_t	abandoned;			// Comp switched away before warming finished
+	uint32_t	layersProbed;		// Identity probes spent by scans
+} DividerPrefetchStats;
+
+// When the active comp changes, brings its divider index entry up to date
+// before the first gesture needs it, one bounded slice per idle call:
+//   1. sync the layer ID map (ID reads only)
+//   2. validate an existing entry (one identity probe per divider)
+//   3. otherwise scan for dividers and record a fresh entry
+// Comps in the LRU whose entry is still current skip all three, so
+// switching between a few comps costs nothing. An active comp whose entry
+// is dropped or goes stale (new dividers, pasted layers) is rescanned the
+// same way.
+class DividerPrefetcher {
+public:
+	DividerPrefetcher();
+
+	// One slice for the active comp (NULL: none)
+	A_Err		Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH);
+
+	bool		Busy() const { return m_phase != Phase_Idle; }
+
+	const DividerPrefetchStats&	Stats() const { return m_stats; }
+	const LatencyHistogram&		SliceCost() const { return m_sliceCost; }
+
+private:
+	DividerPrefetcher(const DividerPrefetcher&);
+	DividerPrefetcher& operator=(const DividerPrefetcher&);
+
+	enum Phase {
+		Phase_Idle = 0,
+		Phase_SyncMap,
+		Phase_Validate,
+		Phase_Scan
+	};
+
+	bool		InLru(A_long itemId) const;
+	void		Touch(A_long itemId);
+	void		StartScan();
+	void		Finish();
+	A_Err		ScanSlice(AEGP_SuiteHandler& suites, double start);
+
+	AEGP_CompH									m_comp;
+	A_long										m_itemId;
+	int											m_phase;
+	bool										m_gaveUp;	// AE error: wait for the next activation
+
+	// Scan in progress
+	A_long										m_cursor;
+	A_long										m_numLayers;
+	std::vector<AEGP_LayerIDVal>				m_ids;
+	std::vector<std::pair<AEGP_LayerH, A_long> >	m_found;
+
+	std::vector<A_long>							m_lru;		// Comp item IDs, most recent first
+	DividerPrefetchStats						m_stats;
+	LatencyHistogram							m_sliceCost;
+};
+
+// Prefetcher for the active comp, ticked from IdleHook
+extern DividerPrefetcher	S_divider_prefetch;
+
+#endif // DIVIDER_PREFETCH_H
@@ -0,0 +1,314 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Indexed Dividers                              */
+/*      Divider index lookups checked against the live comp        */
+/*                                                                 */
+/*******************************************************************/
+
+#include "DividerIndex.h"
+#include "LayerIdMap.h"
+#include "FoldLayers.h"
+
+#include <algorithm>
+#include <cstring>
+
+DividerIndex	S_divider_index;
+
+// 64-bit FNV-1a, for the project key
+static const uint64_t	KEY_SEED	= 14695981039346656037ULL;
+static const uint64_t	KEY_PRIME	= 1099511628211ULL;
+
+A_Err GetCompItemId(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long* outItemId)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_ItemH itemH = NULL;
+
+	*outItemId = 0;
+	ERR(suites.CompSuite11()->AEGP_GetItemFromComp(compH, &itemH));
+	ERR(suites.ItemSuite9()->AEGP_GetItemID(itemH, outItemId));
+	return err;
+}
+
+A_Err GetProjectKey(AEGP_SuiteHandler& suites, uint64_t* outKey)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_ProjectH projH = NULL;
+	AEGP_MemHandle pathH = NULL;
+
+	*outKey = 0;
+	ERR(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projH));
+	ERR(suites.ProjSuite6()->AEGP_GetProjectPath(projH, &pathH));
+	if (err || !pathH) return err;
+
+	// Hash the UTF-16 units as they are; an empty path means "never saved"
+	void* dataP = NULL;
+	ERR(suites.MemorySuite1()->AEGP_LockMemHandle(pathH, &dataP));
+	if (!err && dataP) {
+		const A_UTF16Char* path16 = (const A_UTF16Char*)dataP;
+		uint64_t hash = KEY_SEED;
+		for (size_t i = 0; path16[i] && i < AEGP_MAX_PATH_SIZE * 4; i++) {
+			hash ^= (uint64_t)path16[i];
+			hash *= KEY_PRIME;
+		}
+		if (path16[0]) *outKey = hash;
+		suites.MemorySuite1()->AEGP_UnlockMemHandle(pathH);
+	}
+	suites.MemorySuite1()->AEGP_FreeMemHandle(pathH);
+	return err;
+}
+
+// Fingerprint of compH's layer table now. The layer ID map's last pass
+// stands in for an ID walk only once every divider of comp is still the
+// layer at the index the map remembers (LayerIdMap::ConfirmAt): a reorder
+// the map has not caught up with keeps the layer count, so the remembered
+// order alone can lag, and a cached handle may belong to a deleted layer.
+// *outMapConfirmed is true in that case.
+static A_Err GetLayerFingerprint(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long numLayers,
+								 const DividerIndexComp* comp, uint64_t* outHash, bool* outMapConfirmed)
+{
+	A_Err err = A_Err_NONE;
+	*outMapConfirmed = false;
+
+	if (S_layer_id_map.Comp() == compH && S_layer_id_map.Synced() &&
+		S_layer_id_map.Order().size() == (size_t)numLayers) {
+		bool confirmed = true;
+		for (size_t i = 0; i < comp->entries.size() && confirmed; i++) {
+			const LayerIdEntry* mapped = S_layer_id_map.Find(comp->entries[i].layerId);
+			AEGP_LayerH layerH = NULL;
+			confirmed = mapped && LayerIdMap::ConfirmAt(suites, compH, mapped->id, mapped->index, &layerH) &&
+				layerH == mapped->layerH;
+		}
+		if (confirmed) {
+			*outHash = HashLayerIds(S_layer_id_map.Order());
+			*outMapConfirmed = true;
+			return err;
+		}
+	}
+
+	std::vector<AEGP_LayerIDVal> ids;
+	ids.reserve((size_t)numLayers);
+	for (A_long i = 0; i < numLayers && !err; i++) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		ids.push_back(id);
+	}
+	*outHash = HashLayerIds(ids);
+	return err;
+}
+
+static bool DividerByIndex(const std::pair<AEGP_LayerH, A_long>& a, const std::pair<AEGP_LayerH, A_long>& b)
+{
+	return a.second < b.second;
+}
+
+static bool StructureByIndex(const IndexedDivider& a, const IndexedDivider& b)
+{
+	return a.index < b.index;
+}
+
+// compH's entry when its fingerprint matches the comp (NULL otherwise).
+// *outMapConfirmed: the layer ID map's index for each of its dividers was
+// checked against AE while fingerprinting.
+static A_Err FindCurrentEntry(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long* outItemId,
+							  const DividerIndexComp** outComp, bool* outMapConfirmed)
+{
+	A_Err err = A_Err_NONE;
+	*outComp = NULL;
+	*outMapConfirmed = false;
+
+	A_long numLayers = 0;
+	ERR(GetCompItemId(suites, compH, outItemId));
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	const DividerIndexComp* comp = S_divider_index.Find(*outItemId);
+	if (!comp || comp->stale || comp->numLayers != (uint32_t)numLayers) return err;
+
+	uint64_t hash = 0;
+	ERR(GetLayerFingerprint(suites, compH, numLayers, comp, &hash, outMapConfirmed));
+	if (!err && hash == comp->layerHash) *outComp = comp;
+	return err;
+}
+
+A_Err GetIndexedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						 std::vector<std::pair<AEGP_LayerH, A_long> >& dividers, bool* outServed)
+{
+	A_Err err = A_Err_NONE;
+	DividerIndexStats& stats = S_divider_index.Stats();
+	*outServed = false;
+
+	A_long itemId = 0;
+	const DividerIndexComp* comp = NULL;
+	bool mapConfirmed = false;
+	ERR(FindCurrentEntry(suites, compH, &itemId, &comp, &mapConfirmed));
+	if (err || !comp) {
+		stats.misses++;
+		return err;
+	}
+
+	// Same layers in the same order. Still confirm each divider (undo can
+	// strip an identity without touching the layer table).
+	std::vector<std::pair<AEGP_LayerH, A_long> > found;
+	std::vector<std::pair<AEGP_LayerIDVal, bool> > foldBits;
+	found.reserve(comp->entries.size());
+	for (size_t i = 0; i < comp->entries.size(); i++) {
+		const DividerIndexEntry& entry = comp->entries[i];
+		AEGP_LayerH layerH = NULL;
+		A_long index = -1;
+		bool folded = false;
+		if (!S_layer_id_map.Resolve(suites, compH, entry.layerId, &layerH, &index) ||
+			!ProbeDividerState(suites, layerH, &folded)) {
+			stats.rejected++;
+			S_divider_index.Invalidate(itemId);
+			return err;
+		}
+		found.push_back(std::make_pair(layerH, index));
+		if (folded != (entry.folded != 0)) foldBits.push_back(std::make_pair(entry.layerId, folded));
+	}
+
+	for (size_t i = 0; i < foldBits.size(); i++) {
+		S_divider_index.SetFolded(itemId, foldBits[i].first, foldBits[i].second);
+	}
+
+	std::sort(found.begin(), found.end(), DividerByIndex);
+	dividers.insert(dividers.end(), found.begin(), found.end());
+	stats.hits++;
+	*outServed = true;
+	return err;
+}
+
+A_Err GetIndexedStructure(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  std::vector<IndexedDivider>& dividers, bool* outServed)
+{
+	A_Err err = A_Err_NONE;
+	DividerIndexStats& stats = S_divider_index.Stats();
+	*outServed = false;
+
+	A_long itemId = 0;
+	const DividerIndexComp* comp = NULL;
+	bool mapConfirmed = false;
+	ERR(FindCurrentEntry(suites, compH, &itemId, &comp, &mapConfirmed));
+	if (err || !comp) {
+		stats.misses++;
+		return err;
+	}
+
+	// Positions come from the layer ID map, straight from memory when the
+	// fingerprint just confirmed them against AE, else through Resolve
+	// (which checks the live index); identities are left to the caller
+
+	std::vector<IndexedDivider> found;
+	found.reserve(comp->entries.size());
+	for (size_t i = 0; i < comp->entries.size(); i++) {
+		const DividerIndexEntry& entry = comp->entries[i];
+		IndexedDivider divider;
+		divider.id = entry.layerId;
+		divider.depth = entry.depth;
+		divider.folded = entry.folded != 0;
+
+		const LayerIdEntry* mapped = mapConfirmed ? S_layer_id_map.Find(entry.layerId) : NULL;
+		if (mapped) {
+			divider.layerH = mapped->layerH;
+			divider.index = mapped->index;
+		} else if (!S_layer_id_map.Resolve(suites, compH, entry.layerId, &divider.layerH, &divider.index)) {
+			stats.rejected++;
+			S_divider_index.Invalidate(itemId);
+			return err;
+		}
+		found.push_back(divider);
+	}
+
+	std::sort(found.begin(), found.end(), StructureByIndex);
+	dividers.swap(found);
+	stats.hits++;
+	*outServed = true;
+	return err;
+}
+
+A_Err RecordIndexedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+							const std::vector<AEGP_LayerIDVal>& layerIds,
+							const std::vector<std::pair<AEGP_LayerH, A_long> >& dividers)
+{
+	A_Err err = A_Err_NONE;
+
+	A_long itemId = 0;
+	ERR(GetCompItemId(suites, compH, &itemId));
+	if (err) return err;
+
+	std::vector<DividerIndexEntry> entries;
+	entries.reserve(dividers.size());
+	for (size_t i = 0; i < dividers.size() && !err; i++) {
+		AEGP_LayerH layerH = dividers[i].first;
+		DividerIndexEntry entry;
+		memset(&entry, 0, sizeof(entry));
+
+		bool folded = false;
+		AEGP_LayerFlags flags = 0;
+		ProbeDividerState(suites, layerH, &folded);
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &entry.layerId));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags));
+
+		const int depth = GetHierarchyDepth(GetHierarchyFromHiddenGroup(suites, layerH));
+		entry.depth = (uint8_t)std::min(std::max(depth, 0), 255);
+		entry.folded = folded ? 1 : 0;
+		entry.kind = (flags & AEGP_LayerFlag_NULL_LAYER) ? DividerIndexKind_Null : DividerIndexKind_Shape;
+		entries.push_back(entry);
+	}
+
+	if (!err) {
+		S_divider_index.Store(itemId, (uint32_t)layerIds.size(), HashLayerIds(layerIds), entries);
+	}
+	return err;
+}
+
+void NoteIndexedFold(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH, bool folded)
+{
+	A_long itemId = 0;
+	AEGP_LayerIDVal id = 0;
+	if (GetCompItemId(suites, compH, &itemId) == A_Err_NONE &&
+		suites.LayerSuite9()->AEGP_GetLayerID(dividerH, &id) == A_Err_NONE) {
+		S_divider_index.SetFolded(itemId, id, folded);
+	}
+}
+
+void InvalidateIndexedComp(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
+{
+	AEGP_CompH compH = NULL;
+	A_long itemId = 0;
+	if (suites.LayerSuite9()->AEGP_GetLayerParentComp(layerH, &compH) == A_Err_NONE && compH &&
+		GetCompItemId(suites, compH, &itemId) == A_Err_NONE) {
+		S_divider_index.Invalidate(itemId);
+	}
+}
+
+void TickDividerIndex(AEGP_SuiteHandler& suites, AEGP_CompH compH, uint64_t diffHashBefore)
+{
+	// Project opened, closed or saved under a new name
+	if (S_idle_counter % DIVIDER_INDEX_BIND_INTERVAL == 1) {
+		uint64_t key = 0;
+		if (GetProjectKey(suites, &key) == A_Err_NONE && key != S_divider_index.ProjectKey()) {
+			S_divider_index.Save();
+			S_divider_index.BindProject(key);
+			S_divider_index.Load();
+			const DividerIndexStats& stats = S_divider_index.Stats();
+			PerfLog("divider index: %u comps loaded in %.3f ms", stats.compsLoaded, stats.lastLoadSeconds * 1e3);
+		}
+	}
+
+	if (compH && S_comp_changes.Comp() == compH && S_comp_changes.HasEvents()) {
+		std::vector<CompChangeEvent> events;
+		S_comp_changes.DrainEvents(events);
+
+		A_long itemId = 0;
+		if (GetCompItemId(suites, compH, &itemId) == A_Err_NONE) {
+			S_divider_index.ApplyEvents(itemId, events, diffHashBefore, S_comp_changes.BaselineHash(),
+										(uint32_t)S_comp_changes.BaselineIds().size());
+		}
+	}
+
+	if (S_divider_index.Dirty() && PerfNowSeconds() - S_divider_index.LastSaveTime() >= DIVIDER_INDEX_SAVE_INTERVAL) {
+		S_divider_index.Save();
+	}
+}
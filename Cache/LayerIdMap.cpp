@@ -0,0 +1,279 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Layer ID Map                                  */
+/*      Per-comp layer ID -> {handle, index}, kept in sync in idle */
+/*                                                                 */
+/*******************************************************************/
+
+#include "LayerIdMap.h"
+#include "AE_Macros.h"
+
+#include <cstring>
+
+LayerIdMap	S_layer_id_map;
+
+// Smallest table allocated once the first entry arrives
+static const size_t	MIN_CAPACITY	= 64;
+
+LayerIdMap::LayerIdMap()
+	: m_count(0)
+	, m_comp(NULL)
+	, m_cursor(0)
+	, m_changed(false)
+	, m_synced(false)
+	, m_batchResynced(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void LayerIdMap::Reset(AEGP_CompH compH)
+{
+	m_slots.clear();
+	m_order.clear();
+	m_count = 0;
+	m_comp = compH;
+	m_cursor = 0;
+	m_changed = false;
+	m_synced = false;
+	m_batchResynced = false;
+}
+
+size_t LayerIdMap::SlotFor(AEGP_LayerIDVal id) const
+{
+	// Multiplicative hash; fold the high bits down for the power-of-two mask
+	uint32_t h = (uint32_t)id * 2654435761u;
+	h ^= h >> 16;
+	return (size_t)h & (m_slots.size() - 1);
+}
+
+const LayerIdEntry* LayerIdMap::Find(AEGP_LayerIDVal id)
+{
+	m_stats.lookups++;
+	if (!id || m_slots.empty()) return NULL;
+
+	const size_t mask = m_slots.size() - 1;
+	for (size_t i = SlotFor(id); ; i = (i + 1) & mask) {
+		m_stats.probes++;
+		if (m_slots[i].id == id) return &m_slots[i];
+		if (m_slots[i].id == 0) return NULL;
+	}
+}
+
+void LayerIdMap::Grow()
+{
+	std::vector<LayerIdEntry> old;
+	old.swap(m_slots);
+
+	LayerIdEntry empty = { 0, NULL, 0 };
+	m_slots.assign(old.empty() ? MIN_CAPACITY : old.size() * 2, empty);
+	m_count = 0;
+
+	for (size_t i = 0; i < old.size(); i++) {
+		if (old[i].id) {
+			Put(old[i].id, old[i].layerH, old[i].index);
+		}
+	}
+}
+
+void LayerIdMap::Put(AEGP_LayerIDVal id, AEGP_LayerH layerH, A_long index)
+{
+	if (!id) return;
+	if ((m_count + 1) * 2 > m_slots.size()) Grow();
+
+	const size_t mask = m_slots.size() - 1;
+	size_t i = SlotFor(id);
+	while (m_slots[i].id && m_slots[i].id != id) {
+		i = (i + 1) & mask;
+	}
+
+	if (!m_slots[i].id) m_count++;
+	m_slots[i].id = id;
+	m_slots[i].layerH = layerH;
+	m_slots[i].index = index;
+	m_stats.entriesUpdated++;
+}
+
+bool LayerIdMap::Erase(AEGP_LayerIDVal id)
+{
+	if (!id || m_slots.empty()) return false;
+
+	const size_t mask = m_slots.size() - 1;
+	size_t i = SlotFor(id);
+	while (m_slots[i].id != id) {
+		if (!m_slots[i].id) return false;
+		i = (i + 1) & mask;
+	}
+
+	// Backward-shift: pull later entries of the probe run into the hole so
+	// lookups never need tombstones
+	for (size_t j = (i + 1) & mask; m_slots[j].id; j = (j + 1) & mask) {
+		const size_t home = SlotFor(m_slots[j].id);
+		const bool homeInHoleRun = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+		if (!homeInHoleRun) {
+			m_slots[i] = m_slots[j];
+			i = j;
+		}
+	}
+
+	m_slots[i].id = 0;
+	m_slots[i].layerH = NULL;
+	m_count--;
+	return true;
+}
+
+void LayerIdMap::PurgeStale()
+{
+	// Entries whose remembered index no longer holds their ID were deleted
+	std::vector<AEGP_LayerIDVal> stale;
+	for (size_t i = 0; i < m_slots.size(); i++) {
+		const LayerIdEntry& e = m_slots[i];
+		if (e.id && (e.index < 0 || (size_t)e.index >= m_order.size() || m_order[e.index] != e.id)) {
+			stale.push_back(e.id);
+		}
+	}
+	for (size_t i = 0; i < stale.size(); i++) {
+		Erase(stale[i]);
+	}
+	m_stats.entriesPurged += (uint32_t)stale.size();
+}
+
+A_Err LayerIdMap::Sync(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long budget, bool* outPassComplete)
+{
+	A_Err err = A_Err_NONE;
+	if (outPassComplete) *outPassComplete = false;
+
+	if (compH != m_comp) Reset(compH);
+	if (!compH) {
+		if (outPassComplete) *outPassComplete = true;
+		return err;
+	}
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	// Insert or delete: everything below the change shifted, so verify again
+	if ((size_t)numLayers != m_order.size()) {
+		m_order.resize((size_t)numLayers, 0);
+		m_cursor = 0;
+		m_changed = true;
+		m_synced = false;
+	}
+
+	// A pass done in one call sees a frozen comp and is exact; passes spread
+	// over idle ticks are only trusted once one finds nothing to change
+	const bool wholePass = (m_cursor == 0) && (budget <= 0 || budget >= numLayers);
+	const A_long end = (budget > 0 && m_cursor + budget < numLayers) ? m_cursor + budget : numLayers;
+
+	A_long i = m_cursor;
+	for (; i < end && !err; i++) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (err) break;
+
+		m_stats.layersVerified++;
+		if (m_order[i] != id) {
+			m_order[i] = id;
+			m_changed = true;
+		}
+
+		const LayerIdEntry* e = Find(id);
+		if (!e || e->index != i || e->layerH != layerH) {
+			Put(id, layerH, i);
+			m_changed = true;
+		}
+	}
+	m_cursor = i;
+
+	if (!err && m_cursor >= numLayers) {
+		if (m_changed) PurgeStale();
+		m_synced = wholePass || !m_changed;
+		m_changed = false;
+		m_cursor = 0;
+		m_stats.passesCompleted++;
+		if (outPassComplete) *outPassComplete = true;
+	}
+
+	return err;
+}
+
+void LayerIdMap::ApplySnapshot(AEGP_CompH compH, const std::vector<AEGP_LayerIDVal>& ids,
+							  const std::vector<AEGP_LayerH>& handles)
+{
+	if (compH != m_comp) Reset(compH);
+
+	m_order = ids;
+	for (size_t i = 0; i < ids.size() && i < handles.size(); i++) {
+		const LayerIdEntry* e = Find(ids[i]);
+		if (!e || e->index != (A_long)i || e->layerH != handles[i]) {
+			Put(ids[i], handles[i], (A_long)i);
+		}
+	}
+
+	PurgeStale();
+	m_cursor = 0;
+	m_changed = false;
+	m_synced = true;
+	m_batchResynced = false;
+	m_stats.passesCompleted++;
+}
+
+bool LayerIdMap::ConfirmAt(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id, A_long index,
+						   AEGP_LayerH* outLayerH)
+{
+	AEGP_LayerH layerH = NULL;
+	AEGP_LayerIDVal liveId = 0;
+	if (index < 0 ||
+		suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, index, &layerH) != A_Err_NONE || !layerH ||
+		suites.LayerSuite9()->AEGP_GetLayerID(layerH, &liveId) != A_Err_NONE || liveId != id) {
+		return false;
+	}
+	*outLayerH = layerH;
+	return true;
+}
+
+bool LayerIdMap::Resolve(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id,
+						 AEGP_LayerH* outLayerH, A_long* outIndex)
+{
+	A_long numLayers = 0;
+	if (suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers) != A_Err_NONE) return false;
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		const bool catchUp = compH != m_comp || !m_synced || (size_t)numLayers != m_order.size() || attempt > 0;
+		if (catchUp) {
+			// Catch up in one go (reads only; no rehash of unchanged entries)
+			if (compH == m_comp) {
+				m_cursor = 0;
+				m_changed = false;
+			}
+			if (Sync(suites, compH, 0, NULL) != A_Err_NONE) return false;
+			m_batchResynced = true;
+			if (attempt > 0) m_stats.resolveResyncs++;
+		}
+
+		// The layer at the remembered index must still be this one: a
+		// reorder leaves the index stale, a delete plus an add at the same
+		// count can leave the handle pointing at a deleted layer
+		const LayerIdEntry* e = Find(id);
+		AEGP_LayerH layerH = NULL;
+		if (e && ConfirmAt(suites, compH, id, e->index, &layerH)) {
+			const A_long index = e->index;
+			if (layerH != e->layerH) Put(id, layerH, index);
+			if (outLayerH) *outLayerH = layerH;
+			if (outIndex) *outIndex = index;
+			return true;
+		}
+
+		// Right after a pass, "not in this comp". Otherwise the map may just
+		// not have seen the layer yet (a same-count change), but once per batch.
+		if (catchUp) return false;
+		if (m_batchResynced) {
+			m_stats.resyncsSkipped++;
+			return false;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,116 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Layer ID Map                                  */
+/*      Per-comp layer ID -> {handle, index}, kept in sync in idle */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef LAYER_ID_MAP_H
+#define LAYER_ID_MAP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <cstdint>
+#include <vector>
+
+// Where a layer was last seen
+typedef struct {
+	AEGP_LayerIDVal	id;			// 0 = empty slot (AE layer IDs start at 1)
+	AEGP_LayerH		layerH;
+	A_long			index;		// 0-based comp index
+} LayerIdEntry;
+
+typedef struct {
+	uint32_t	lookups;			// Find calls
+	uint32_t	probes;				// Slots visited by Find (lookups + collisions)
+	uint32_t	entriesUpdated;		// Put calls that inserted or moved an entry
+	uint32_t	entriesPurged;		// Entries dropped for deleted layers
+	uint32_t	layersVerified;		// Layers read back from AE by Sync
+	uint32_t	passesCompleted;	// Full verification passes over the comp
+	uint32_t	resolveResyncs;		// Re-syncs Resolve ran for a miss or a moved layer
+	uint32_t	resyncsSkipped;		// Misses answered without one (batch already re-synced)
+} LayerIdMapStats;
+
+// Open-addressing (linear probing, backward-shift delete) map for one comp,
+// plus the ID sequence by index as last seen. Sync() walks the comp a bounded
+// number of layers at a time (ApplySnapshot takes a walk done by the comp
+// change detector) and only touches entries whose position changed:
+// a layer count change restarts the walk (insert/delete), an ID that differs
+// from the remembered one at an index is a move, and IDs not seen again by
+// the end of a pass are deleted layers. Nothing is rebuilt from scratch
+// unless the comp itself changes.
+class LayerIdMap {
+public:
+	LayerIdMap();
+
+	// Forget everything and start tracking compH (may be NULL)
+	void				Reset(AEGP_CompH compH);
+	AEGP_CompH			Comp() const { return m_comp; }
+	size_t				Size() const { return m_count; }
+
+	// Pure map operations (no AE calls)
+	const LayerIdEntry*	Find(AEGP_LayerIDVal id);
+	void				Put(AEGP_LayerIDVal id, AEGP_LayerH layerH, A_long index);
+	bool				Erase(AEGP_LayerIDVal id);
+
+	// Verify up to budget layers of compH (budget <= 0: the whole comp).
+	// *outPassComplete (may be NULL) is true when the map matches the comp.
+	A_Err				Sync(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long budget, bool* outPassComplete);
+
+	// Take a confirmed ID/handle sequence read elsewhere (the comp change
+	// detector): entries whose index or handle changed are updated, IDs no
+	// longer present are dropped, and the map counts as synced.
+	void				ApplySnapshot(AEGP_CompH compH, const std::vector<AEGP_LayerIDVal>& ids,
+									  const std::vector<AEGP_LayerH>& handles);
+
+	// Handle and index for id in compH. Catches up with Sync first when the
+	// map is behind (other comp, layer count changed, pass in progress). An
+	// entry only counts once the layer at its index still has its ID (a
+	// cached handle may belong to a layer deleted since). A miss or a moved
+	// layer re-syncs the map, at most once per resolve batch: a member row
+	// full of deleted IDs would otherwise walk the comp once per ID.
+	// false if not found.
+	bool				Resolve(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id,
+								AEGP_LayerH* outLayerH, A_long* outIndex);
+
+	// Start a resolve batch (each command, fold intent and idle tick):
+	// the next miss may re-sync again. A snapshot from idle does the same.
+	void				BeginResolveBatch() { m_batchResynced = false; }
+
+	// Handle of the layer at index in compH if that layer still has id
+	static bool			ConfirmAt(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id, A_long index,
+								  AEGP_LayerH* outLayerH);
+
+	// ID at each comp index as of the last completed pass (only meaningful
+	// while Synced() for the comp in question)
+	const std::vector<AEGP_LayerIDVal>&	Order() const { return m_order; }
+	bool				Synced() const { return m_synced; }
+
+	const LayerIdMapStats&	Stats() const { return m_stats; }
+
+private:
+	LayerIdMap(const LayerIdMap&);
+	LayerIdMap& operator=(const LayerIdMap&);
+
+	size_t				SlotFor(AEGP_LayerIDVal id) const;
+	void				Grow();
+	void				PurgeStale();
+
+	std::vector<LayerIdEntry>		m_slots;	// Power-of-two capacity, load <= 1/2
+	std::vector<AEGP_LayerIDVal>	m_order;	// ID at each comp index (0 = not read yet)
+	size_t							m_count;
+	AEGP_CompH						m_comp;
+	A_long							m_cursor;	// Next index Sync verifies
+	bool							m_changed;	// Something moved during this pass
+	bool							m_synced;	// Last pass completed with no pending work
+	bool							m_batchResynced;	// Resolve re-synced in this batch
+	LayerIdMapStats					m_stats;
+};
+
+// Map for the active comp; fed by the comp change detector from IdleHook,
+// shared by every module
+extern LayerIdMap	S_layer_id_map;
+
+#endif // LAYER_ID_MAP_H
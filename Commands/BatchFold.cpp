@@ -0,0 +1,419 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Batch Fold                                    */
+/*      Fold/unfold groups across many comps in one undo step      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "BatchFold.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+#include "Utils/Scripting.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+BatchFoldJob	S_batch_fold;
+
+// Comps of the project, or only those selected in the Project panel
+static A_Err GetScopeComps(AEGP_SuiteHandler& suites, A_long scope, std::vector<AEGP_CompH>& comps)
+{
+	A_Err err = A_Err_NONE;
+
+	if (scope != BatchFoldScope_Project) {
+		AEGP_ProjectH projH = NULL;
+		AEGP_ItemH itemH = NULL;
+		ERR(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projH));
+		ERR(suites.ItemSuite9()->AEGP_GetFirstProjItem(projH, &itemH));
+
+		while (!err && itemH) {
+			AEGP_ItemType itemType = AEGP_ItemType_NONE;
+			A_Boolean selected = FALSE;
+			ERR(suites.ItemSuite9()->AEGP_GetItemType(itemH, &itemType));
+			ERR(suites.ItemSuite9()->AEGP_IsItemSelected(itemH, &selected));
+			if (!err && selected && itemType == AEGP_ItemType_COMP) {
+				AEGP_CompH compH = NULL;
+				ERR(suites.CompSuite11()->AEGP_GetCompFromItem(itemH, &compH));
+				if (!err && compH) comps.push_back(compH);
+			}
+
+			AEGP_ItemH nextH = NULL;
+			ERR(suites.ItemSuite9()->AEGP_GetNextProjItem(projH, itemH, &nextH));
+			itemH = nextH;
+		}
+		if (err || !comps.empty() || scope == BatchFoldScope_Selected) return err;
+	}
+
+	ERR(GetProjectComps(suites, comps));
+	return err;
+}
+
+BatchFoldJob::BatchFoldJob()
+	: m_next(0)
+	, m_running(false)
+	, m_projectKey(0)
+	, m_started(0.0)
+{
+	m_request.action = BatchFold_Toggle;
+	m_request.scope = BatchFoldScope_Auto;
+	memset(&m_result, 0, sizeof(m_result));
+}
+
+A_Err BatchFoldJob::Start(AEGP_SuiteHandler& suites, const BatchFoldRequest& request)
+{
+	A_Err err = A_Err_NONE;
+
+	Cancel();
+	m_request = request;
+	memset(&m_result, 0, sizeof(m_result));
+	m_started = PerfNowSeconds();
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetScopeComps(suites, request.scope, comps));
+	ERR(GetProjectKey(suites, &m_projectKey));
+	if (err) return err;
+
+	m_comps.resize(comps.size());
+	for (size_t i = 0; i < comps.size() && !err; i++) {
+		ERR(GetCompItemId(suites, comps[i], &m_comps[i].itemId));
+		m_comps[i].compH = comps[i];
+		RestartSnapshot(m_comps[i]);
+	}
+	if (err) {
+		m_comps.clear();
+		return err;
+	}
+	m_result.comps = (A_long)comps.size();
+	m_running = true;
+	return err;
+}
+
+void BatchFoldJob::Cancel()
+{
+	m_comps.clear();
+	m_next = 0;
+	m_running = false;
+}
+
+// Comp handles are not kept across calls: the job's comps are found again
+// by item ID, and those no longer in the project get a NULL handle
+A_Err BatchFoldJob::ResolveComps(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetProjectComps(suites, comps));
+
+	std::unordered_map<A_long, AEGP_CompH> byItemId;
+	for (size_t i = 0; i < comps.size() && !err; i++) {
+		A_long itemId = 0;
+		ERR(GetCompItemId(suites, comps[i], &itemId));
+		if (!err) byItemId[itemId] = comps[i];
+	}
+	if (err) return err;
+
+	for (size_t c = 0; c < m_comps.size(); c++) {
+		std::unordered_map<A_long, AEGP_CompH>::const_iterator it = byItemId.find(m_comps[c].itemId);
+		m_comps[c].compH = (it != byItemId.end()) ? it->second : NULL;
+	}
+	return err;
+}
+
+void BatchFoldJob::RestartSnapshot(CompSnapshot& comp)
+{
+	comp.numLayers = -1;
+	comp.cursor = 0;
+	comp.indexed = false;
+	comp.knownDivider.clear();
+	comp.layers.clear();
+	comp.matched.clear();
+	comp.rows.clear();
+}
+
+bool BatchFoldJob::Matches(const std::string& name, const std::string& hierarchy) const
+{
+	if (!m_request.nameFilter.empty() && name.find(m_request.nameFilter) == std::string::npos) {
+		return false;
+	}
+	if (!m_request.hierarchyFilter.empty()) {
+		const std::string& filter = m_request.hierarchyFilter;
+		const bool exact = hierarchy == filter;
+		const bool below = hierarchy.compare(0, filter.length() + 1, filter + GROUP_HIERARCHY_SEP) == 0;
+		if (!exact && !below) return false;
+	}
+	return true;
+}
+
+A_Err BatchFoldJob::SnapshotStep(AEGP_SuiteHandler& suites, CompSnapshot& comp, double deadline, bool* outDone)
+{
+	A_Err err = A_Err_NONE;
+	*outDone = false;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(comp.compH, &numLayers));
+	if (err) return err;
+
+	// First step, or an insert/delete since the last one: start over
+	if (numLayers != comp.numLayers) {
+		RestartSnapshot(comp);
+		comp.numLayers = numLayers;
+		comp.layers.reserve((size_t)numLayers);
+
+		// A current divider index entry saves the identity probe on every
+		// layer that is not a divider
+		std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+		ERR(GetIndexedDividers(suites, comp.compH, dividers, &comp.indexed));
+		if (!err && comp.indexed) {
+			comp.knownDivider.assign((size_t)numLayers, false);
+			for (size_t d = 0; d < dividers.size(); d++) {
+				if (dividers[d].second >= 0 && dividers[d].second < numLayers) {
+					comp.knownDivider[(size_t)dividers[d].second] = true;
+				}
+			}
+		}
+	}
+
+	while (!err && comp.cursor < numLayers) {
+		FoldPlanLayer layer;
+		std::string hierarchy;
+		ERR(ReadFoldPlanLayer(suites, comp.compH, comp.cursor, !comp.indexed || comp.knownDivider[(size_t)comp.cursor],
+			layer, &hierarchy, comp.rows));
+		if (err) break;
+
+		if (layer.isDivider) {
+			std::string name;
+			ERR(GetLayerNameStr(suites, layer.layerH, name));
+			if (!err && Matches(GetDividerName(name), hierarchy)) {
+				comp.matched.push_back(comp.cursor);
+			}
+		}
+
+		comp.layers.push_back(layer);
+		comp.cursor++;
+
+		if (deadline > 0.0 && PerfNowSeconds() >= deadline) break;
+	}
+	if (err || comp.cursor < numLayers) return err;
+
+	// A full identity scan doubles as a fresh divider index entry
+	if (!comp.indexed) ERR(RecordFoldSnapshot(suites, comp.compH, comp.layers));
+
+	*outDone = true;
+	return err;
+}
+
+A_Err BatchFoldJob::Step(AEGP_SuiteHandler& suites, double budgetSeconds, bool* outDone)
+{
+	A_Err err = A_Err_NONE;
+	*outDone = false;
+	if (!m_running) return err;
+
+	// Item IDs from another project must never be looked up
+	uint64_t projectKey = 0;
+	ERR(GetProjectKey(suites, &projectKey));
+	if (err || projectKey != m_projectKey) {
+		Cancel();
+		return err;
+	}
+
+	const double start = PerfNowSeconds();
+	const double deadline = budgetSeconds > 0.0 ? start + budgetSeconds : 0.0;
+	m_result.slices++;
+
+	ERR(ResolveComps(suites));
+
+	while (!err && m_next < m_comps.size()) {
+		CompSnapshot& comp = m_comps[m_next];
+		bool compDone = false;
+		if (!comp.compH) {
+			// Deleted: nothing to plan, and Apply skips it
+			RestartSnapshot(comp);
+			compDone = true;
+		} else {
+			ERR(SnapshotStep(suites, comp, deadline, &compDone));
+		}
+		if (compDone) m_next++;
+		if (deadline > 0.0 && PerfNowSeconds() >= deadline) break;
+	}
+	m_result.planSeconds += PerfNowSeconds() - start;
+
+	if (!err && m_next == m_comps.size()) {
+		err = Apply(suites);
+		Cancel();
+		*outDone = true;
+	}
+	if (err) Cancel();
+	return err;
+}
+
+A_Err BatchFoldJob::ApplyComp(AEGP_SuiteHandler& suites, CompSnapshot& comp, bool fold)
+{
+	A_Err err = A_Err_NONE;
+	if (comp.matched.empty()) return err;
+	if (!comp.compH) {
+		m_result.compsSkipped++;
+		return err;
+	}
+
+	// Planning was spread over idle calls: the layer table must still be
+	// the one that was read
+	bool current = false;
+	ERR(FoldSnapshotCurrent(suites, comp.compH, comp.layers, &current));
+	if (err || !current) {
+		m_result.compsSkipped++;
+		return err;
+	}
+
+	for (size_t m = 0; m < comp.matched.size(); m++) {
+		comp.layers[(size_t)comp.matched[m]].target = fold ? FoldTarget_Fold : FoldTarget_Unfold;
+	}
+
+	FoldPlan plan;
+	PlanFold(comp.layers, comp.rows, plan);
+	ERR(ApplyFoldPlan(suites, comp.compH, comp.layers, plan));
+
+	if (!err && (!plan.dividers.empty() || !plan.shy.empty())) m_result.compsChanged++;
+	m_result.dividersChanged += (A_long)plan.dividers.size();
+	m_result.shyChanged += (A_long)plan.shy.size();
+	return err;
+}
+
+A_Err BatchFoldJob::Apply(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	const double start = PerfNowSeconds();
+
+	// Toggle decides over every matching group in scope, like Fold/Unfold
+	// does over the groups of one comp
+	bool fold = m_request.action == BatchFold_Fold;
+	if (m_request.action == BatchFold_Toggle) {
+		fold = true;
+		for (size_t c = 0; c < m_comps.size() && fold; c++) {
+			for (size_t m = 0; m < m_comps[c].matched.size(); m++) {
+				if (m_comps[c].layers[(size_t)m_comps[c].matched[m]].folded) {
+					fold = false;
+					break;
+				}
+			}
+		}
+	}
+
+	for (size_t c = 0; c < m_comps.size(); c++) {
+		m_result.dividersMatched += (A_long)m_comps[c].matched.size();
+	}
+	if (!m_result.dividersMatched) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Fold/Unfold Groups in Project"));
+	if (err) return err;
+
+	for (size_t c = 0; c < m_comps.size() && !err; c++) {
+		ERR(ApplyComp(suites, m_comps[c], fold));
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	m_result.applySeconds = PerfNowSeconds() - start;
+	PerfLog("batch fold: %d comps (%d changed, %d skipped), %d/%d groups, %d shy flags, %d slices, plan %.1f ms, apply %.1f ms",
+		(int)m_result.comps, (int)m_result.compsChanged, (int)m_result.compsSkipped,
+		(int)m_result.dividersChanged, (int)m_result.dividersMatched, (int)m_result.shyChanged,
+		(int)m_result.slices, m_result.planSeconds * 1e3, m_result.applySeconds * 1e3);
+	return err;
+}
+
+A_Err ReadBatchFoldScriptRequest(AEGP_SuiteHandler& suites, BatchFoldRequest* request, bool* outFromScript)
+{
+	A_Err err = A_Err_NONE;
+	*outFromScript = false;
+
+	// Read and clear the global in one go; fields come back one per line
+	const std::string script =
+		"(function(){var g=$.global,p=g." BATCH_FOLD_SCRIPT_GLOBAL ";if(!p){return '';}g." BATCH_FOLD_SCRIPT_GLOBAL "=undefined;"
+		"return ['1',p.action||'',p.scope||'',p.name||'',p.hierarchy||''].join('\\n');})();";
+
+	std::string result;
+	ERR(RunScript(suites, script, &result));
+	if (err || result.empty() || result[0] != '1') return err;
+
+	std::vector<std::string> fields;
+	size_t pos = 0;
+	for (;;) {
+		const size_t end = result.find('\n', pos);
+		fields.push_back(result.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+		if (end == std::string::npos) break;
+		pos = end + 1;
+	}
+	fields.resize(5);
+
+	request->action = fields[1] == "fold" ? BatchFold_Fold : fields[1] == "unfold" ? BatchFold_Unfold : BatchFold_Toggle;
+	request->scope = fields[2] == "project" ? BatchFoldScope_Project :
+					 fields[2] == "selected" ? BatchFoldScope_Selected : BatchFoldScope_Auto;
+	request->nameFilter = fields[3];
+	request->hierarchyFilter = fields[4];
+	*outFromScript = true;
+	return err;
+}
+
+static void ReportBatchFold(AEGP_SuiteHandler& suites, const BatchFoldResult& result)
+{
+	char msg[256];
+	if (!result.dividersMatched) {
+		snprintf(msg, sizeof(msg), "FoldLayers: No matching group layers in %d comps.", (int)result.comps);
+	} else if (result.compsSkipped) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Changed %d group layers in %d comps. %d comps changed or were deleted while planning and were left alone.",
+			(int)result.dividersChanged, (int)result.compsChanged, (int)result.compsSkipped);
+	} else {
+		return;  // The timeline shows it
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+}
+
+A_Err DoBatchFold(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+
+	if (S_batch_fold.Running()) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: A project-wide fold is still being prepared.");
+		return err;
+	}
+
+	BatchFoldRequest request;
+	request.action = BatchFold_Toggle;
+	request.scope = BatchFoldScope_Auto;
+	bool fromScript = false;
+	ERR(ReadBatchFoldScriptRequest(suites, &request, &fromScript));
+	ERR(S_batch_fold.Start(suites, request));
+	if (err) return err;
+
+	// The calling script waits for its result; the menu only waits a moment
+	bool done = false;
+	ERR(S_batch_fold.Step(suites, fromScript ? 0.0 : BATCH_FOLD_COMMAND_SECONDS, &done));
+
+	if (!err && done) {
+		const BatchFoldResult& result = S_batch_fold.Result();
+		if (fromScript) {
+			char script[256];
+			snprintf(script, sizeof(script), "$.global." BATCH_FOLD_SCRIPT_RESULT "={comps:%d,groups:%d,skipped:%d};",
+				(int)result.compsChanged, (int)result.dividersChanged, (int)result.compsSkipped);
+			RunScript(suites, script, NULL);
+		} else {
+			ReportBatchFold(suites, result);
+		}
+		EnsureShyModeEnabled(suites);
+	}
+
+	return err;
+}
+
+void TickBatchFold(AEGP_SuiteHandler& suites)
+{
+	if (!S_batch_fold.Running()) return;
+
+	bool done = false;
+	if (S_batch_fold.Step(suites, BATCH_FOLD_SLICE_SECONDS, &done) != A_Err_NONE) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Project-wide fold/unfold failed.");
+	} else if (done) {
+		ReportBatchFold(suites, S_batch_fold.Result());
+		EnsureShyModeEnabled(suites);
+	}
+}
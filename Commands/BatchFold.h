@@ -0,0 +1,130 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Batch Fold                                    */
+/*      Fold/unfold groups across many comps in one undo step      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef BATCHFOLD_H
+#define BATCHFOLD_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/FoldPlanner.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Planning time per idle call; the command itself plans this long before
+// handing the rest to idle (small projects finish right away)
+#define BATCH_FOLD_SLICE_SECONDS		0.008
+#define BATCH_FOLD_COMMAND_SECONDS		0.100
+
+// Scripts pass parameters in this ExtendScript global before running the
+// command, and get the outcome back in BATCH_FOLD_SCRIPT_RESULT:
+//   $.global.FoldLayersBatch = { action: "fold", scope: "project", name: "BG", hierarchy: "1" };
+//   app.executeCommand(app.findMenuCommandId("Fold/Unfold Groups in Project"));
+//   // $.global.FoldLayersBatchResult -> { comps: 12, groups: 30, skipped: 0 }
+// action: "fold" | "unfold" | "toggle"; scope: "project" | "selected" | "auto".
+// Script runs complete before the command returns.
+#define BATCH_FOLD_SCRIPT_GLOBAL		"FoldLayersBatch"
+#define BATCH_FOLD_SCRIPT_RESULT		"FoldLayersBatchResult"
+
+enum BatchFoldAction {
+	BatchFold_Toggle = 0,		// Fold if every matching group is unfolded, else unfold (as Fold/Unfold does)
+	BatchFold_Fold,
+	BatchFold_Unfold
+};
+
+enum BatchFoldScope {
+	BatchFoldScope_Auto = 0,	// Comps selected in the Project panel, else every comp
+	BatchFoldScope_Project,
+	BatchFoldScope_Selected
+};
+
+typedef struct {
+	A_long		action;				// BatchFoldAction
+	A_long		scope;				// BatchFoldScope
+	std::string	nameFilter;			// Substring of the group name; empty matches all
+	std::string	hierarchyFilter;	// Hierarchy path or an ancestor ("1" matches 1 and 1/A); empty matches all
+} BatchFoldRequest;
+
+typedef struct {
+	A_long		comps;				// Comps in scope
+	A_long		compsChanged;
+	A_long		compsSkipped;		// Edited or deleted between planning and applying: left alone
+	A_long		dividersMatched;
+	A_long		dividersChanged;
+	A_long		shyChanged;
+	A_long		slices;				// Planning steps
+	double		planSeconds;
+	double		applySeconds;
+} BatchFoldResult;
+
+// Snapshots every comp in scope a slice at a time, then applies all plans
+// in a single call inside one undo group. Planning only reads; a comp whose
+// layer table changed before the apply is skipped rather than guessed at.
+// Comps are kept by item ID and looked up again on every call, so a comp
+// deleted while planning is skipped too.
+class BatchFoldJob {
+public:
+	BatchFoldJob();
+
+	A_Err		Start(AEGP_SuiteHandler& suites, const BatchFoldRequest& request);
+
+	// Plan for up to budgetSeconds (<= 0: no limit). Applies once every comp
+	// is planned; *outDone is then true and Result() is final.
+	A_Err		Step(AEGP_SuiteHandler& suites, double budgetSeconds, bool* outDone);
+
+	bool		Running() const { return m_running; }
+	void		Cancel();
+
+	const BatchFoldResult&	Result() const { return m_result; }
+
+private:
+	BatchFoldJob(const BatchFoldJob&);
+	BatchFoldJob& operator=(const BatchFoldJob&);
+
+	typedef struct {
+		A_long						itemId;
+		AEGP_CompH					compH;		// Looked up from itemId this call; NULL once deleted
+		A_long						numLayers;	// -1 until the snapshot starts
+		A_long						cursor;
+		bool						indexed;	// Divider positions came from the divider index
+		std::vector<bool>			knownDivider;
+		std::vector<FoldPlanLayer>	layers;
+		std::vector<A_long>			matched;	// Indices of dividers the filters select
+		FoldPlanRows				rows;
+	} CompSnapshot;
+
+	A_Err		ResolveComps(AEGP_SuiteHandler& suites);
+	void		RestartSnapshot(CompSnapshot& comp);
+	A_Err		SnapshotStep(AEGP_SuiteHandler& suites, CompSnapshot& comp, double deadline, bool* outDone);
+	bool		Matches(const std::string& name, const std::string& hierarchy) const;
+	A_Err		Apply(AEGP_SuiteHandler& suites);
+	A_Err		ApplyComp(AEGP_SuiteHandler& suites, CompSnapshot& comp, bool fold);
+
+	BatchFoldRequest			m_request;
+	std::vector<CompSnapshot>	m_comps;
+	size_t						m_next;			// Comp being snapshotted
+	bool						m_running;
+	uint64_t					m_projectKey;	// Project the job was started in
+	double						m_started;
+	BatchFoldResult				m_result;
+};
+
+extern BatchFoldJob	S_batch_fold;
+
+// Parameters left by a script in BATCH_FOLD_SCRIPT_GLOBAL (consumed).
+// *outFromScript is false (request untouched) when there are none.
+A_Err ReadBatchFoldScriptRequest(AEGP_SuiteHandler& suites, BatchFoldRequest* request, bool* outFromScript);
+
+// "Fold/Unfold Groups in Project" command handler
+A_Err DoBatchFold(AEGP_SuiteHandler& suites);
+
+// Continue a running job from IdleHook; reports when it completes
+void TickBatchFold(AEGP_SuiteHandler& suites);
+
+#endif // BATCHFOLD_H
@@ -0,0 +1,266 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Duplicate Group                               */
+/*      Copies groups with fresh hierarchy paths and group IDs     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "DuplicateGroup.h"
+#include "FoldLayers.h"
+#include "Hierarchy/ReorderPlan.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+static LatencyHistogram	S_duplicate_group_cost;
+
+// Path the copy of a group at hierarchy takes: a free sibling path
+static std::string SiblingHierarchy(const std::string& hierarchy, const std::unordered_set<std::string>& used)
+{
+	if (hierarchy.empty()) return hierarchy;
+	const size_t sep = hierarchy.rfind(GROUP_HIERARCHY_SEP);
+	return FreeChildHierarchy(sep == std::string::npos ? std::string() : hierarchy.substr(0, sep), used);
+}
+
+// Explicit membership: each copied group gets the copies of its members as
+// its row, and a row listing original layers lists their copies after them
+static A_Err CopyMemberRows(AEGP_SuiteHandler& suites, const GroupTree& tree, const std::vector<A_long>& roots,
+							const std::vector<std::vector<AEGP_LayerH> >& originals,
+							const std::vector<std::vector<AEGP_LayerH> >& copies)
+{
+	A_Err err = A_Err_NONE;
+
+	std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal> copyOf;
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		for (size_t c = 0; c < originals[r].size() && !err; c++) {
+			AEGP_LayerIDVal originalId = 0;
+			AEGP_LayerIDVal copyId = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerID(originals[r][c], &originalId));
+			ERR(suites.LayerSuite9()->AEGP_GetLayerID(copies[r][c], &copyId));
+			if (!err) copyOf[originalId] = copyId;
+		}
+	}
+
+	std::vector<bool> copied((size_t)tree.Count(), false);
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		const A_long first = tree.Divider(roots[r]).index;
+		const A_long end = tree.End(roots[r]);
+		for (A_long d = roots[r]; d < tree.Count() && tree.Divider(d).index < end && !err; d++) {
+			copied[(size_t)d] = true;
+
+			std::vector<AEGP_LayerIDVal> row;
+			bool hasRow = false;
+			ERR(ReadGroupMembers(suites, tree.Divider(d).layerH, row, &hasRow));
+			if (err || !hasRow) continue;
+
+			std::vector<AEGP_LayerIDVal> copyRow;
+			copyRow.reserve(row.size());
+			for (size_t m = 0; m < row.size(); m++) {
+				std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = copyOf.find(row[m]);
+				if (it != copyOf.end()) copyRow.push_back(it->second);
+			}
+			ERR(WriteGroupMembers(suites, copies[r][(size_t)(tree.Divider(d).index - first)], copyRow));
+		}
+	}
+
+	for (A_long d = 0; d < tree.Count() && !err; d++) {
+		if (copied[(size_t)d]) continue;
+
+		std::vector<AEGP_LayerIDVal> row;
+		bool hasRow = false;
+		ERR(ReadGroupMembers(suites, tree.Divider(d).layerH, row, &hasRow));
+		if (err || !hasRow) continue;
+
+		std::vector<AEGP_LayerIDVal> copyIds;
+		size_t last = 0;
+		for (size_t m = 0; m < row.size(); m++) {
+			std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = copyOf.find(row[m]);
+			if (it == copyOf.end()) continue;
+			copyIds.push_back(it->second);
+			last = m + 1;
+		}
+		if (copyIds.empty()) continue;
+
+		row.insert(row.begin() + (std::ptrdiff_t)last, copyIds.begin(), copyIds.end());
+		ERR(WriteGroupMembers(suites, tree.Divider(d).layerH, row));
+	}
+
+	return err;
+}
+
+A_Err DoDuplicateGroup(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	// Selected dividers, by index
+	std::vector<A_long> selectedIndices;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+			if (!IsDividerLayer(suites, item.u.layer.layerH)) continue;
+
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &index));
+			if (!err) selectedIndices.push_back(index);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || selectedIndices.empty()) return err;
+
+	const double start = PerfNowSeconds();
+
+	GroupTree tree;
+	DuplicateGroupResult result;
+	memset(&result, 0, sizeof(result));
+	std::vector<A_long> roots;
+	bool live = false;
+	for (int attempt = 0; attempt < 2 && !live && !err; attempt++) {
+		ERR(ReadGroupTree(suites, compH, tree, &result.indexed, attempt > 0));
+		if (err) return err;
+
+		// Groups inside a selected group are copied with it
+		std::vector<bool> selected((size_t)tree.Count(), false);
+		for (size_t s = 0; s < selectedIndices.size(); s++) {
+			const A_long d = tree.AtIndex(selectedIndices[s]);
+			if (d >= 0) selected[(size_t)d] = true;
+		}
+		roots.clear();
+		for (A_long d = 0; d < tree.Count(); d++) {
+			if (!selected[(size_t)d]) continue;
+			bool nested = false;
+			for (A_long p = tree.Parent(d); p >= 0 && !nested; p = tree.Parent(p)) nested = selected[(size_t)p];
+			if (!nested) roots.push_back(d);
+		}
+
+		// The originals are read by index below: every copied range must
+		// still be where the tree says, else read the tree again by scan
+		live = true;
+		for (size_t r = 0; r < roots.size() && live; r++) live = GroupRangeIsLive(suites, compH, tree, roots[r]);
+	}
+	if (err || !live || roots.empty()) return err;
+
+	// Paths for every copied divider before anything is written: the root's
+	// copy is a free sibling path, each nested copy a free child path of its
+	// parent's copy (the old paths of the subtree stay in use)
+	std::unordered_set<std::string> used;
+	std::vector<std::string> hierarchies((size_t)tree.Count());
+	for (A_long d = 0; d < tree.Count(); d++) {
+		hierarchies[(size_t)d] = GetHierarchyFromHiddenGroup(suites, tree.Divider(d).layerH);
+		used.insert(hierarchies[(size_t)d]);
+	}
+
+	std::vector<std::string> copyHierarchies((size_t)tree.Count());
+	for (size_t r = 0; r < roots.size(); r++) {
+		const A_long end = tree.End(roots[r]);
+		for (A_long d = roots[r]; d < tree.Count() && tree.Divider(d).index < end; d++) {
+			std::string& path = copyHierarchies[(size_t)d];
+			path = (d == roots[r]) ? SiblingHierarchy(hierarchies[(size_t)d], used) :
+				FreeChildHierarchy(copyHierarchies[(size_t)tree.Parent(d)], used);
+			if (path.empty() && (d != roots[r] || !hierarchies[(size_t)d].empty())) {
+				suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level.");
+				return err;
+			}
+			used.insert(path);
+		}
+	}
+
+	// Original layer handles, read before any index moves
+	std::vector<std::vector<AEGP_LayerH> > originals(roots.size());
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		const A_long end = tree.End(roots[r]);
+		originals[r].reserve((size_t)(end - tree.Divider(roots[r]).index));
+		for (A_long i = tree.Divider(roots[r]).index; i < end && !err; i++) {
+			AEGP_LayerH layerH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+			if (!err) originals[r].push_back(layerH);
+		}
+		result.layers += end - tree.Divider(roots[r]).index;
+	}
+	if (err) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Duplicate Group"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	// Copy every layer (each copy lands above its original), then one plan
+	// moves the copies below the originals in a block
+	std::vector<std::vector<AEGP_LayerH> > copies(roots.size());
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		copies[r].reserve(originals[r].size());
+		for (size_t c = 0; c < originals[r].size() && !err; c++) {
+			AEGP_LayerH copyH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_DuplicateLayer(originals[r][c], &copyH));
+			if (!err) copies[r].push_back(copyH);
+		}
+	}
+
+	std::vector<std::vector<A_long> > copyIndices(roots.size());
+	std::vector<A_long> rootEnds(roots.size());
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		rootEnds[r] = tree.End(roots[r]);
+		copyIndices[r].resize(copies[r].size());
+		for (size_t c = 0; c < copies[r].size() && !err; c++) {
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(copies[r][c], &copyIndices[r][c]));
+		}
+	}
+
+	std::vector<ReorderMove> moves;
+	if (!err) {
+		std::vector<A_long> order;
+		PlanDuplicateOrder(tree.NumLayers() + result.layers, copyIndices, rootEnds, order);
+		PlanReorder(order, moves);
+		ERR(ApplyReorderPlan(suites, compH, moves));
+	}
+
+	// Identity records of the copied dividers, in one pass
+	for (size_t r = 0; r < roots.size() && !err; r++) {
+		const A_long first = tree.Divider(roots[r]).index;
+		const A_long end = tree.End(roots[r]);
+		for (A_long d = roots[r]; d < tree.Count() && tree.Divider(d).index < end && !err; d++) {
+			AEGP_LayerH copyH = copies[r][(size_t)(tree.Divider(d).index - first)];
+			ERR(SetDividerHierarchy(suites, copyH, copyHierarchies[(size_t)d], true));
+			if (!err) result.dividers++;
+		}
+	}
+
+	if (!err && S_settings.groupMembership == GroupMembership_Explicit) {
+		ERR(CopyMemberRows(suites, tree, roots, originals, copies));
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to duplicate the group");
+		return err;
+	}
+
+	result.groups = (A_long)roots.size();
+	result.reorders = (A_long)moves.size();
+
+	S_duplicate_group_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("duplicate group: %d groups, %d layers, %d group layers, %d reorders (%s), %s",
+		(int)result.groups, (int)result.layers, (int)result.dividers, (int)result.reorders,
+		result.indexed ? "index" : "scan", S_duplicate_group_cost.Summary("duplicate").c_str());
+#endif
+	return err;
+}
@@ -0,0 +1,29 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Duplicate Group                               */
+/*      Copies groups with fresh hierarchy paths and group IDs     */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef DUPLICATEGROUP_H
+#define DUPLICATEGROUP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/GroupPlans.h"
+#include <vector>
+
+typedef struct {
+	A_long		groups;				// Selected groups copied
+	A_long		layers;				// Layers copied, group layers included
+	A_long		dividers;			// Copied group layers given a new identity
+	A_long		reorders;			// AEGP_ReorderLayer calls made
+	bool		indexed;			// Structure came from the divider index
+} DuplicateGroupResult;
+
+// "Duplicate Group"
+A_Err DoDuplicateGroup(AEGP_SuiteHandler& suites);
+
+#endif // DUPLICATEGROUP_H
@@ -0,0 +1,67 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Explicit Membership                           */
+/*      Switches between positional and explicit group members     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "ExplicitMembership.h"
+#include "FoldLayers.h"
+
+A_Err SetGroupMembershipMode(AEGP_SuiteHandler& suites, A_long mode, A_long* outDividers)
+{
+	A_Err err = A_Err_NONE;
+	A_long dividers = 0;
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetProjectComps(suites, comps));
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(
+		mode == GroupMembership_Explicit ? "Track Group Members" : "Release Group Members"));
+
+	for (size_t c = 0; c < comps.size() && !err; c++) {
+		std::vector<std::pair<AEGP_LayerH, A_long> > compDividers;
+		ERR(GetAllDividers(suites, comps[c], compDividers));
+		for (size_t d = 0; d < compDividers.size() && !err; d++) {
+			if (mode == GroupMembership_Explicit) {
+				ERR(CaptureGroupMembers(suites, comps[c], compDividers[d].first));
+			} else {
+				ERR(RemoveLayerMarkerRecord(suites, compDividers[d].first, DIVIDER_MEMBERS_MARKER_PREFIX));
+			}
+			if (!err) dividers++;
+		}
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	// Only switch modes once every divider has been carried over
+	if (!err) {
+		S_settings.groupMembership = mode;
+		ERR(SaveSettings(suites));
+	}
+
+	if (outDividers) *outDividers = dividers;
+	return err;
+}
+
+A_Err DoToggleExplicitMembership(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	const A_long target = (S_settings.groupMembership == GroupMembership_Explicit)
+		? GroupMembership_Positional : GroupMembership_Explicit;
+
+	A_long dividers = 0;
+	err = SetGroupMembershipMode(suites, target, &dividers);
+
+	char msg[256];
+	if (err) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Group membership switch failed (Err: %d) - mode unchanged.", (int)err);
+	} else if (target == GroupMembership_Explicit) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Captured the members of %d group layers. Reordering layers no longer changes their group.", (int)dividers);
+	} else {
+		snprintf(msg, sizeof(msg), "FoldLayers: Group members follow layer order again (%d group layers released).", (int)dividers);
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+
+	return err;
+}
@@ -0,0 +1,25 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Explicit Membership                           */
+/*      Switches between positional and explicit group members     */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef EXPLICITMEMBERSHIP_H
+#define EXPLICITMEMBERSHIP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// Switch every divider in the project to the given GroupMembership (one undo
+// group), then make it the active mode. Explicit: each divider's current
+// positional members are captured into its row. Positional: rows are removed.
+// outDividers may be NULL.
+A_Err SetGroupMembershipMode(AEGP_SuiteHandler& suites, A_long mode, A_long* outDividers);
+
+// "Track Group Members Explicitly" command handler (toggles the mode)
+A_Err DoToggleExplicitMembership(AEGP_SuiteHandler& suites);
+
+#endif // EXPLICITMEMBERSHIP_H
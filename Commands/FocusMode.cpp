@@ -0,0 +1,283 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Focus Mode                                    */
+/*      Keeps only the groups around the selection unfolded       */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FocusMode.h"
+#include "FoldLayers.h"
+#include "Cache/CompChangeDetector.h"
+
+#include <algorithm>
+#include <cstring>
+
+FocusMode	S_focus_mode;
+
+FocusMode::FocusMode()
+	: m_enabled(false)
+	, m_comp(NULL)
+	, m_builtAgainst(0)
+	, m_haveBaseline(false)
+	, m_primed(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void FocusMode::Reset()
+{
+	m_comp = NULL;
+	m_layers.clear();
+	m_outline.Clear();
+	m_folded.clear();
+	m_focus.clear();
+	m_primed = false;
+	m_selection.clear();
+}
+
+void FocusMode::SetEnabled(bool enabled)
+{
+	m_enabled = enabled;
+
+	// Fold states may have been changed by hand in the meantime
+	Reset();
+}
+
+bool FocusMode::Current(AEGP_CompH compH) const
+{
+	if (compH != m_comp) return false;
+
+	// The detector's baseline moves with every confirmed layer table edit
+	if (S_comp_changes.Comp() != compH || !S_comp_changes.HasBaseline()) return true;
+	return m_haveBaseline && S_comp_changes.BaselineHash() == m_builtAgainst;
+}
+
+A_Err FocusMode::Build(AEGP_SuiteHandler& suites, AEGP_CompH compH)
+{
+	A_Err err = A_Err_NONE;
+	Reset();
+
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, m_layers, rows));
+	if (err) {
+		m_layers.clear();
+		return err;
+	}
+
+	m_outline.Build(m_layers, rows);
+	m_folded.resize(m_layers.size());
+	for (size_t i = 0; i < m_layers.size(); i++) {
+		m_folded[i] = m_layers[i].isDivider && m_layers[i].folded;
+	}
+
+	m_comp = compH;
+	m_haveBaseline = S_comp_changes.Comp() == compH && S_comp_changes.HasBaseline();
+	m_builtAgainst = m_haveBaseline ? S_comp_changes.BaselineHash() : 0;
+	m_stats.builds++;
+	return err;
+}
+
+A_Err FocusMode::Apply(AEGP_SuiteHandler& suites, const std::vector<A_long>& selected, bool* outStale)
+{
+	A_Err err = A_Err_NONE;
+	*outStale = false;
+
+	const A_long count = m_outline.Size();
+
+	// New focus: the selected dividers and every container of the selection
+	std::vector<bool> inFocus((size_t)count, false);
+	std::vector<A_long> focus;
+	for (size_t s = 0; s < selected.size(); s++) {
+		const A_long index = selected[s];
+		if (m_outline.IsDivider(index) && !inFocus[(size_t)index]) {
+			inFocus[(size_t)index] = true;
+			focus.push_back(index);
+		}
+		m_outline.AddAncestors(index, inFocus, focus);
+	}
+
+	// Only dividers entering or leaving the focus can change, except on the
+	// first update, which brings every divider in line
+	std::vector<A_long> candidates;
+	if (m_primed) {
+		candidates = focus;
+		for (size_t f = 0; f < m_focus.size(); f++) {
+			if (!inFocus[(size_t)m_focus[f]]) candidates.push_back(m_focus[f]);
+		}
+	} else {
+		candidates = m_outline.Dividers();
+	}
+
+	// Handles are only trusted where the layer is still at its snapshot index
+	FoldPlan plan;
+	for (size_t c = 0; c < candidates.size() && !err; c++) {
+		FoldPlanLayer& divider = m_layers[(size_t)candidates[c]];
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(m_comp, candidates[c], &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (err || id != divider.id) {
+			*outStale = true;
+			return err;
+		}
+
+		bool folded = false;
+		if (!ProbeDividerState(suites, divider.layerH, &folded)) {
+			*outStale = true;
+			return err;
+		}
+		divider.folded = folded;
+		m_folded[(size_t)candidates[c]] = folded;
+
+		const bool target = !inFocus[(size_t)candidates[c]];
+		if (folded != target) {
+			divider.target = target ? FoldTarget_Fold : FoldTarget_Unfold;
+			plan.dividers.push_back(candidates[c]);
+		}
+	}
+	if (err) return err;
+
+	m_focus.swap(focus);
+	m_primed = true;
+	if (plan.dividers.empty()) return err;
+
+	// Shy flags: only the groups of the changed dividers, against the fold
+	// states they end up with
+	for (size_t d = 0; d < plan.dividers.size(); d++) {
+		m_folded[(size_t)plan.dividers[d]] = m_layers[(size_t)plan.dividers[d]].target == FoldTarget_Fold;
+	}
+
+	std::vector<bool> mark((size_t)count, false);
+	std::vector<A_long> affected;
+	for (size_t d = 0; d < plan.dividers.size(); d++) {
+		m_outline.AddContained(plan.dividers[d], mark, affected);
+	}
+
+	// Nested dividers keep their state, which may have been set by hand
+	for (size_t a = 0; a < affected.size(); a++) {
+		FoldPlanLayer& layer = m_layers[(size_t)affected[a]];
+		if (!layer.isDivider || layer.target != FoldTarget_Keep) continue;
+
+		bool folded = false;
+		if (!ProbeDividerState(suites, layer.layerH, &folded)) {
+			*outStale = true;
+			return err;
+		}
+		layer.folded = folded;
+		m_folded[(size_t)affected[a]] = folded;
+	}
+
+	for (size_t a = 0; a < affected.size() && !err; a++) {
+		FoldPlanLayer& layer = m_layers[(size_t)affected[a]];
+		AEGP_LayerFlags flags = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(layer.layerH, &flags));
+		if (err) break;
+		layer.shy = (flags & AEGP_LayerFlag_SHY) != 0;
+
+		const bool hide = m_outline.Hidden(affected[a], m_folded);
+		if (hide != layer.shy) plan.shy.push_back(std::make_pair(affected[a], hide));
+	}
+	if (err) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Focus on Selected Group"));
+	if (err) return err;
+	ERR(ApplyFoldPlan(suites, m_comp, m_layers, plan));
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	// The snapshot follows what was written
+	for (size_t d = 0; d < plan.dividers.size(); d++) {
+		FoldPlanLayer& divider = m_layers[(size_t)plan.dividers[d]];
+		divider.folded = divider.target == FoldTarget_Fold;
+		divider.target = FoldTarget_Keep;
+	}
+	for (size_t s = 0; s < plan.shy.size(); s++) {
+		m_layers[(size_t)plan.shy[s].first].shy = plan.shy[s].second;
+	}
+
+	m_stats.updates++;
+	m_stats.dividersChanged += (uint32_t)plan.dividers.size();
+	m_stats.layersExamined += (uint32_t)affected.size();
+	m_stats.shyChanged += (uint32_t)plan.shy.size();
+	return err;
+}
+
+A_Err FocusMode::Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH)
+{
+	A_Err err = A_Err_NONE;
+	if (!m_enabled || !compH) return err;
+
+	// Selected layer IDs, sorted so that reordering the selection is no change
+	std::vector<AEGP_LayerIDVal> selection;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (!err && item.type == AEGP_CollectionItemType_LAYER) {
+				AEGP_LayerIDVal id = 0;
+				ERR(suites.LayerSuite9()->AEGP_GetLayerID(item.u.layer.layerH, &id));
+				if (!err) selection.push_back(id);
+			}
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || selection.empty()) return err;
+	std::sort(selection.begin(), selection.end());
+
+	// Inserts and deletes show in the count before the detector confirms them
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	const bool current = Current(compH) && numLayers == m_outline.Size();
+	if (current && selection == m_selection) return err;
+
+	const double start = PerfNowSeconds();
+
+	if (!current) {
+		ERR(Build(suites, compH));
+		if (err) return err;
+	}
+
+	// A selected layer missing from the outline: edited since the build
+	std::vector<A_long> selected;
+	bool stale = false;
+	for (size_t s = 0; s < selection.size() && !stale; s++) {
+		const A_long index = m_outline.IndexOf(selection[s]);
+		if (index < 0) stale = true;
+		selected.push_back(index);
+	}
+
+	if (!stale) ERR(Apply(suites, selected, &stale));
+	if (err || stale) {
+		// Rebuilt on the next tick
+		Reset();
+		return err;
+	}
+	m_selection.swap(selection);
+
+	m_updateCost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("focus: %u builds, %u updates, %u groups, %u layers examined, %u shy flags, %s",
+		m_stats.builds, m_stats.updates, m_stats.dividersChanged, m_stats.layersExamined, m_stats.shyChanged,
+		m_updateCost.Summary("update").c_str());
+#endif
+	return err;
+}
+
+A_Err DoToggleFocusMode(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+
+	S_focus_mode.SetEnabled(!S_focus_mode.Enabled());
+
+	// Focus works through shy flags, so they must be hidden to see it
+	if (S_focus_mode.Enabled() && EnsureShyModeEnabled(suites)) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Warning - Could not enable Hide Shy Layers mode. Please enable it manually in the composition panel.");
+	}
+
+	return err;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Focus Mode                                    */
+/*      Keeps only the groups around the selection unfolded       */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOCUSMODE_H
+#define FOCUSMODE_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/FoldOutline.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/PerfStats.h"
+#include <cstdint>
+#include <vector>
+
+typedef struct {
+	uint32_t	builds;				// Outline (re)built from a comp snapshot
+	uint32_t	updates;			// Selection changes that changed something
+	uint32_t	dividersChanged;
+	uint32_t	layersExamined;		// Layers in the subtrees of changed dividers
+	uint32_t	shyChanged;
+} FocusStats;
+
+// While enabled, every divider that does not contain the selected layers is
+// folded and every one that does is unfolded (a selected divider counts as
+// containing itself). An empty selection keeps the current focus.
+//
+// The comp is snapshotted once into a FoldOutline and reused until the layer
+// table changes (S_comp_changes baseline). A selection change then costs an
+// ancestor lookup per selected layer; only dividers entering or leaving the
+// focus are re-probed and written, and only the layers in their groups get
+// their shy flag recomputed. Moving between siblings touches two subtrees.
+class FocusMode {
+public:
+	FocusMode();
+
+	bool		Enabled() const { return m_enabled; }
+	void		SetEnabled(bool enabled);
+
+	// From IdleHook: follow the selection of the active comp (NULL: none)
+	A_Err		Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH);
+
+	const FocusStats&		Stats() const { return m_stats; }
+	const LatencyHistogram&	UpdateCost() const { return m_updateCost; }
+
+private:
+	FocusMode(const FocusMode&);
+	FocusMode& operator=(const FocusMode&);
+
+	void		Reset();
+	A_Err		Build(AEGP_SuiteHandler& suites, AEGP_CompH compH);
+	bool		Current(AEGP_CompH compH) const;
+	A_Err		Apply(AEGP_SuiteHandler& suites, const std::vector<A_long>& selected, bool* outStale);
+
+	bool						m_enabled;
+	AEGP_CompH					m_comp;
+	uint64_t					m_builtAgainst;		// S_comp_changes baseline when built
+	bool						m_haveBaseline;
+	std::vector<FoldPlanLayer>	m_layers;
+	FoldOutline					m_outline;
+	std::vector<bool>			m_folded;			// Fold state as last read or written
+	std::vector<A_long>			m_focus;			// Dividers kept unfolded
+	bool						m_primed;			// m_focus reflects the comp
+	std::vector<AEGP_LayerIDVal>	m_selection;	// Sorted IDs the focus was computed for
+
+	FocusStats					m_stats;
+	LatencyHistogram			m_updateCost;
+};
+
+extern FocusMode	S_focus_mode;
+
+// "Focus on Selected Group" command handler (toggle)
+A_Err DoToggleFocusMode(AEGP_SuiteHandler& suites);
+
+#endif // FOCUSMODE_H
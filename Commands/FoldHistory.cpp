@@ -0,0 +1,348 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold History                                  */
+/*      Back/forward through fold states, outside AE's undo stack  */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldHistory.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+#include "Cache/LayerIdMap.h"
+#include "Hierarchy/FoldPlanner.h"
+
+#include <algorithm>
+#include <cstring>
+
+FoldHistory	S_fold_history;
+
+static size_t StepBytes(const FoldHistoryStep& step)
+{
+	return sizeof(FoldHistoryStep) + step.ids.size() * sizeof(AEGP_LayerIDVal) + step.bits.size();
+}
+
+static bool StepBit(const FoldHistoryStep& step, size_t i)
+{
+	return ((step.bits[i >> 3] >> (i & 7)) & 1) != 0;
+}
+
+FoldHistory::FoldHistory()
+	: m_bytes(0)
+	, m_pendingComp(NULL)
+	, m_pendingBroken(false)
+	, m_activeComp(NULL)
+	, m_activeItemId(0)
+{
+}
+
+void FoldHistory::Note(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id, int kind, bool value)
+{
+	if (compH != m_pendingComp) {
+		Flush(suites);
+		m_pendingComp = compH;
+	}
+
+	// Flipped more than once by one command (nested groups): keep the first before
+	const uint64_t key = ((uint64_t)kind << 32) | (uint64_t)id;
+	std::unordered_map<uint64_t, size_t>::const_iterator it = m_pendingIndex.find(key);
+	if (it != m_pendingIndex.end()) {
+		m_pending[it->second].after = value;
+		return;
+	}
+
+	PendingChange change;
+	change.id = id;
+	change.kind = kind;
+	change.before = !value;
+	change.after = value;
+	m_pendingIndex[key] = m_pending.size();
+	m_pending.push_back(change);
+}
+
+void FoldHistory::NoteLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH layerH, int kind, bool value)
+{
+	AEGP_LayerIDVal id = 0;
+	if (suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id) == A_Err_NONE) {
+		Note(suites, compH, id, kind, value);
+		return;
+	}
+
+	// A step missing a change would be applied wrong later
+	if (compH != m_pendingComp) {
+		Flush(suites);
+		m_pendingComp = compH;
+	}
+	m_pendingBroken = true;
+}
+
+void FoldHistory::Flush(AEGP_SuiteHandler& suites)
+{
+	if (!m_pendingComp) return;
+
+	A_long itemId = 0;
+	if (GetCompItemId(suites, m_pendingComp, &itemId) == A_Err_NONE) {
+		if (m_pendingBroken) {
+			Drop(itemId);
+		} else {
+			FoldHistoryStep step;
+			step.dividers = 0;
+			for (int kind = FoldHistory_Fold; kind <= FoldHistory_Shy; kind++) {
+				for (size_t p = 0; p < m_pending.size(); p++) {
+					const PendingChange& change = m_pending[p];
+					if (change.kind != kind || change.before == change.after) continue;
+
+					const size_t bit = step.ids.size();
+					step.ids.push_back(change.id);
+					if ((bit >> 3) >= step.bits.size()) step.bits.push_back(0);
+					if (change.after) step.bits[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+					if (kind == FoldHistory_Fold) step.dividers++;
+				}
+			}
+			if (!step.ids.empty()) Commit(itemId, step);
+		}
+	}
+
+	m_pendingComp = NULL;
+	m_pending.clear();
+	m_pendingIndex.clear();
+	m_pendingBroken = false;
+}
+
+void FoldHistory::RemapLayerIds(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+								const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds)
+{
+	if (newIds.empty()) return;
+
+	if (compH == m_pendingComp) {
+		m_pendingIndex.clear();
+		for (size_t p = 0; p < m_pending.size(); p++) {
+			PendingChange& change = m_pending[p];
+			std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = newIds.find(change.id);
+			if (it != newIds.end()) change.id = it->second;
+			m_pendingIndex[((uint64_t)change.kind << 32) | (uint64_t)change.id] = p;
+		}
+	}
+
+	A_long itemId = 0;
+	if (GetCompItemId(suites, compH, &itemId) != A_Err_NONE) return;
+	CompHistory* comp = Find(itemId);
+	if (!comp) return;
+
+	for (size_t s = 0; s < comp->steps.size(); s++) {
+		std::vector<AEGP_LayerIDVal>& ids = comp->steps[s].ids;
+		for (size_t i = 0; i < ids.size(); i++) {
+			std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = newIds.find(ids[i]);
+			if (it != newIds.end()) ids[i] = it->second;
+		}
+	}
+}
+
+FoldHistory::CompHistory* FoldHistory::Find(A_long itemId)
+{
+	for (size_t c = 0; c < m_comps.size(); c++) {
+		if (m_comps[c].itemId == itemId) return &m_comps[c];
+	}
+	return NULL;
+}
+
+void FoldHistory::Drop(A_long itemId)
+{
+	for (size_t c = 0; c < m_comps.size(); c++) {
+		if (m_comps[c].itemId != itemId) continue;
+		for (size_t s = 0; s < m_comps[c].steps.size(); s++) m_bytes -= StepBytes(m_comps[c].steps[s]);
+		m_comps.erase(m_comps.begin() + (std::ptrdiff_t)c);
+		return;
+	}
+}
+
+void FoldHistory::Commit(A_long itemId, const FoldHistoryStep& step)
+{
+	CompHistory* found = Find(itemId);
+	if (found) {
+		std::rotate(m_comps.begin(), m_comps.begin() + (found - &m_comps[0]), m_comps.begin() + (found - &m_comps[0]) + 1);
+	} else {
+		CompHistory fresh;
+		fresh.itemId = itemId;
+		fresh.cursor = 0;
+		m_comps.insert(m_comps.begin(), fresh);
+	}
+	CompHistory& comp = m_comps.front();
+
+	// A new fold after stepping back replaces the steps ahead
+	while (comp.steps.size() > comp.cursor) {
+		m_bytes -= StepBytes(comp.steps.back());
+		comp.steps.pop_back();
+	}
+
+	comp.steps.push_back(step);
+	m_bytes += StepBytes(step);
+	if (comp.steps.size() > FOLD_HISTORY_DEPTH) {
+		m_bytes -= StepBytes(comp.steps.front());
+		comp.steps.pop_front();
+	}
+	comp.cursor = comp.steps.size();
+
+	Trim();
+}
+
+void FoldHistory::Trim()
+{
+	while (m_comps.size() > FOLD_HISTORY_MAX_COMPS) Drop(m_comps.back().itemId);
+
+	while (m_bytes > FOLD_HISTORY_MAX_BYTES && !m_comps.empty()) {
+		CompHistory& comp = m_comps.back();
+		// Only applied steps can go one at a time: the steps ahead must stay a chain
+		if (comp.cursor == 0) {
+			Drop(comp.itemId);
+			continue;
+		}
+		m_bytes -= StepBytes(comp.steps.front());
+		comp.steps.pop_front();
+		comp.cursor--;
+		if (comp.steps.empty()) m_comps.pop_back();
+	}
+}
+
+void FoldHistory::Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH)
+{
+	Flush(suites);
+
+	if (compH != m_activeComp) {
+		m_activeComp = compH;
+		m_activeItemId = 0;
+		if (compH && GetCompItemId(suites, compH, &m_activeItemId) != A_Err_NONE) m_activeItemId = 0;
+	}
+}
+
+bool FoldHistory::CanStep(bool forward) const
+{
+	if (!m_activeComp) return false;
+
+	// Notes from a command the idle hook has not closed yet
+	if (!forward && m_pendingComp == m_activeComp && !m_pending.empty()) return true;
+
+	for (size_t c = 0; c < m_comps.size(); c++) {
+		const CompHistory& comp = m_comps[c];
+		if (comp.itemId != m_activeItemId) continue;
+		return forward ? comp.cursor < comp.steps.size() : comp.cursor > 0;
+	}
+	return false;
+}
+
+A_Err FoldHistory::Step(AEGP_SuiteHandler& suites, AEGP_CompH compH, bool forward, FoldHistoryResult* outResult)
+{
+	A_Err err = A_Err_NONE;
+	memset(outResult, 0, sizeof(*outResult));
+
+	Flush(suites);
+
+	A_long itemId = 0;
+	ERR(GetCompItemId(suites, compH, &itemId));
+	CompHistory* comp = err ? NULL : Find(itemId);
+	if (!comp) return err;
+	if (forward ? comp->cursor >= comp->steps.size() : comp->cursor == 0) return err;
+
+	const double start = PerfNowSeconds();
+	const FoldHistoryStep& step = comp->steps[forward ? comp->cursor : comp->cursor - 1];
+
+	// Resolve everything and check the dividers before writing anything
+	std::vector<AEGP_LayerH> handles(step.ids.size(), (AEGP_LayerH)NULL);
+	bool stale = false;
+	for (size_t i = 0; i < step.ids.size() && !stale; i++) {
+		A_long index = 0;
+		stale = !S_layer_id_map.Resolve(suites, compH, step.ids[i], &handles[i], &index);
+		if (!stale && i < step.dividers) {
+			bool folded = false;
+			const bool expected = forward ? !StepBit(step, i) : StepBit(step, i);
+			stale = !ProbeDividerState(suites, handles[i], &folded) || folded != expected;
+		}
+	}
+	if (stale) {
+		Drop(itemId);
+		outResult->stale = true;
+		return err;
+	}
+
+	for (size_t i = 0; i < step.ids.size() && !err; i++) {
+		const bool value = forward ? StepBit(step, i) : !StepBit(step, i);
+		if (i < step.dividers) {
+			ERR(SetDividerFolded(suites, compH, handles[i], value));
+			if (!err) outResult->dividersChanged++;
+		} else {
+			ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(handles[i], AEGP_LayerFlag_SHY, value ? TRUE : FALSE));
+			if (!err) outResult->shyChanged++;
+		}
+	}
+
+	// Half written: the comp no longer matches either side of the step
+	if (err) {
+		Drop(itemId);
+		return err;
+	}
+	if (forward) {
+		comp->cursor++;
+	} else {
+		comp->cursor--;
+	}
+
+	m_stepCost.Record(PerfNowSeconds() - start);
+	return err;
+}
+
+void FoldHistory::Clear()
+{
+	m_comps.clear();
+	m_bytes = 0;
+	m_pendingComp = NULL;
+	m_pending.clear();
+	m_pendingIndex.clear();
+	m_pendingBroken = false;
+}
+
+A_Err DoFoldHistoryStep(AEGP_SuiteHandler& suites, bool forward)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	S_fold_history.Tick(suites, compH);
+	if (!S_fold_history.CanStep(forward)) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(forward ? "Next Fold State" : "Previous Fold State"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	FoldHistoryResult result;
+	ERR(S_fold_history.Step(suites, compH, forward, &result));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to restore the fold state");
+		return err;
+	}
+	if (result.stale) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Groups in this composition were changed outside the fold history, so its fold history was cleared.");
+		return err;
+	}
+
+	// After the undo group, as for Fold/Unfold
+	if (EnsureShyModeEnabled(suites)) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Warning - Could not enable Hide Shy Layers mode. Please enable it manually in the composition panel.");
+	}
+
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("fold history %s: %d groups, %d shy flags, %u bytes kept, %s",
+		forward ? "next" : "previous", (int)result.dividersChanged, (int)result.shyChanged,
+		(unsigned)S_fold_history.Bytes(), S_fold_history.StepCost().Summary("step").c_str());
+#endif
+	return err;
+}
@@ -0,0 +1,122 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold History                                  */
+/*      Back/forward through fold states, outside AE's undo stack  */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDHISTORY_H
+#define FOLDHISTORY_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Utils/PerfStats.h"
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// Bounds: steps kept per comp, comps with a history, and the memory all
+// steps may use together (oldest steps of the least recent comp go first)
+#define FOLD_HISTORY_DEPTH			64
+#define FOLD_HISTORY_MAX_COMPS		8
+#define FOLD_HISTORY_MAX_BYTES		(1024 * 1024)
+
+// What a noted change flipped
+enum FoldHistoryKind {
+	FoldHistory_Fold = 0,		// A divider's fold state
+	FoldHistory_Shy				// A layer's shy flag
+};
+
+// The net effect of one fold command on one comp: the dividers and layers
+// it flipped, with the value each ended up at. Going back writes the
+// complements, going forward the values; nothing is recomputed.
+typedef struct {
+	std::vector<AEGP_LayerIDVal>	ids;		// Fold states first, then shy flags
+	std::vector<uint8_t>			bits;		// Value after, one bit per id (LSB first)
+	uint32_t						dividers;	// ids[0, dividers) are fold states
+} FoldHistoryStep;
+
+typedef struct {
+	A_long		dividersChanged;
+	A_long		shyChanged;
+	bool		stale;				// The comp no longer matches: history dropped, nothing written
+} FoldHistoryResult;
+
+// Every fold write notes what it flipped; the notes made between two idle
+// calls (one command, or one focus change) become a single step of the
+// comp they were made in. Stepping is checked first: every divider of the
+// step must still be in the comp with the state the step left it in,
+// otherwise the comp was folded some other way (AE undo, hand edits) and
+// its history is dropped rather than applied over.
+class FoldHistory {
+public:
+	FoldHistory();
+
+	// From fold writes: layer id's flag of that kind flipped to value
+	void		Note(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerIDVal id, int kind, bool value);
+	void		NoteLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH layerH, int kind, bool value);
+
+	// From IdleHook: close the pending step, remember the active comp (NULL: none)
+	void		Tick(AEGP_SuiteHandler& suites, AEGP_CompH compH);
+
+	// For the menu: steps available in the active comp as of the last Tick
+	bool		CanStep(bool forward) const;
+
+	// Write the previous or next step of compH. The caller owns the undo group.
+	A_Err		Step(AEGP_SuiteHandler& suites, AEGP_CompH compH, bool forward, FoldHistoryResult* outResult);
+
+	// Layers of compH replaced by new ones (shape dividers converted to
+	// nulls): the comp's steps and pending changes follow the new IDs
+	void		RemapLayerIds(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+							  const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds);
+
+	void		Clear();
+	size_t		Bytes() const { return m_bytes; }
+
+	const LatencyHistogram&	StepCost() const { return m_stepCost; }
+
+private:
+	FoldHistory(const FoldHistory&);
+	FoldHistory& operator=(const FoldHistory&);
+
+	typedef struct {
+		A_long						itemId;
+		std::deque<FoldHistoryStep>	steps;
+		size_t						cursor;		// Steps before it are applied
+	} CompHistory;
+
+	typedef struct {
+		AEGP_LayerIDVal	id;
+		int				kind;
+		bool			before;
+		bool			after;
+	} PendingChange;
+
+	void			Flush(AEGP_SuiteHandler& suites);
+	void			Commit(A_long itemId, const FoldHistoryStep& step);
+	CompHistory*	Find(A_long itemId);
+	void			Drop(A_long itemId);
+	void			Trim();
+
+	std::vector<CompHistory>			m_comps;		// Most recently used first
+	size_t								m_bytes;
+
+	AEGP_CompH							m_pendingComp;
+	std::vector<PendingChange>			m_pending;
+	std::unordered_map<uint64_t, size_t>	m_pendingIndex;	// (kind, id) -> m_pending
+	bool								m_pendingBroken;	// A change could not be noted
+
+	AEGP_CompH							m_activeComp;
+	A_long								m_activeItemId;
+	LatencyHistogram					m_stepCost;
+};
+
+extern FoldHistory	S_fold_history;
+
+// "Previous Fold State" / "Next Fold State" command handler
+A_Err DoFoldHistoryStep(AEGP_SuiteHandler& suites, bool forward);
+
+#endif // FOLDHISTORY_H
@@ -0,0 +1,268 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Layouts                                  */
+/*      Save and restore named fold arrangements per comp          */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldLayouts.h"
+#include "FoldLayers.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/LayerMarkers.h"
+#include "Utils/PerfStats.h"
+#include "Utils/Scripting.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Prompt default: the layout last saved or restored this session
+static std::string		S_last_layout_name;
+
+static LatencyHistogram	S_layout_save_cost;
+static LatencyHistogram	S_layout_restore_cost;
+
+A_Err SaveFoldLayout(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::string& name,
+					 FoldLayoutResult* outResult)
+{
+	A_Err err = A_Err_NONE;
+	memset(outResult, 0, sizeof(*outResult));
+
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) return err;
+
+	FoldLayout layout;
+	layout.name = name;
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (!layers[i].isDivider) continue;
+		FoldLayoutEntry entry;
+		entry.id = layers[i].id;
+		entry.folded = layers[i].folded;
+		layout.entries.push_back(entry);
+	}
+	outResult->layers = (A_long)layers.size();
+	outResult->dividers = (A_long)layout.entries.size();
+
+	const std::string record = FormatFoldLayout(layout);
+	if (record.size() > FOLD_LAYOUT_MAX_CHARS) return A_Err_GENERIC;
+
+	ERR(WriteCompMarkerRecord(suites, compH, FoldLayoutRecordPrefix(name).c_str(), record));
+	return err;
+}
+
+A_Err RestoreFoldLayout(AEGP_SuiteHandler& suites, AEGP_CompH compH, const FoldLayout& layout,
+						FoldLayoutResult* outResult)
+{
+	A_Err err = A_Err_NONE;
+	memset(outResult, 0, sizeof(*outResult));
+
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) return err;
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		bool folded = false;
+		if (!layers[i].isDivider || !FindFoldLayoutState(layout, layers[i].id, &folded)) continue;
+		layers[i].target = folded ? FoldTarget_Fold : FoldTarget_Unfold;
+		outResult->dividers++;
+	}
+	outResult->layers = (A_long)layers.size();
+	outResult->missing = (A_long)layout.entries.size() - outResult->dividers;
+
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	ERR(ApplyFoldPlan(suites, compH, layers, plan));
+
+	outResult->dividersChanged = (A_long)plan.dividers.size();
+	outResult->shyChanged = (A_long)plan.shy.size();
+	return err;
+}
+
+A_Err RemapFoldLayouts(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+					   const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds)
+{
+	A_Err err = A_Err_NONE;
+	if (newIds.empty()) return err;
+
+	std::vector<std::string> records;
+	ERR(ListCompMarkerRecords(suites, compH, FOLD_LAYOUT_PREFIX, records));
+
+	for (size_t r = 0; r < records.size() && !err; r++) {
+		FoldLayout layout;
+		if (!ParseFoldLayout(records[r], &layout)) continue;
+
+		bool changed = false;
+		for (size_t e = 0; e < layout.entries.size(); e++) {
+			std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = newIds.find(layout.entries[e].id);
+			if (it == newIds.end()) continue;
+			layout.entries[e].id = it->second;
+			changed = true;
+		}
+		if (!changed) continue;
+
+		// Format re-sorts by the new IDs; larger deltas can lengthen the record
+		const std::string record = FormatFoldLayout(layout);
+		if (record.size() > FOLD_LAYOUT_MAX_CHARS) {
+			err = A_Err_GENERIC;
+			break;
+		}
+		ERR(WriteCompMarkerRecord(suites, compH, FoldLayoutRecordPrefix(layout.name).c_str(), record));
+	}
+
+	return err;
+}
+
+// Layout name from a script, else from a prompt. *outName is empty when cancelled.
+static A_Err ReadLayoutName(AEGP_SuiteHandler& suites, const std::string& message, const std::string& defaultName,
+							std::string* outName)
+{
+	A_Err err = A_Err_NONE;
+	outName->clear();
+
+	bool fromScript = false;
+	ERR(TakeScriptGlobal(suites, FOLD_LAYOUT_SCRIPT_GLOBAL, outName, &fromScript));
+	if (!err && !fromScript) {
+		bool cancelled = false;
+		ERR(PromptForText(suites, message, defaultName, outName, &cancelled));
+		if (err || cancelled) {
+			outName->clear();
+			return err;
+		}
+	}
+
+	if (!err && !IsValidFoldLayoutName(*outName)) {
+		char msg[160];
+		snprintf(msg, sizeof(msg), "FoldLayers: Layout names are 1-%d plain characters without '%c'.",
+			FOLD_LAYOUT_MAX_NAME, FOLD_LAYOUT_SEP);
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+		outName->clear();
+	}
+	return err;
+}
+
+A_Err DoSaveFoldLayout(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	std::string name;
+	ERR(ReadLayoutName(suites, "Save fold layout as:",
+		S_last_layout_name.empty() ? "Layout 1" : S_last_layout_name, &name));
+	if (err || name.empty()) return err;
+
+	const double start = PerfNowSeconds();
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Save Fold Layout"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	FoldLayoutResult result;
+	ERR(SaveFoldLayout(suites, compH, name, &result));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to save the fold layout (too many group layers?)");
+		return err;
+	}
+	S_last_layout_name = name;
+
+	S_layout_save_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("save fold layout: %d layers, %d groups, %s",
+		(int)result.layers, (int)result.dividers, S_layout_save_cost.Summary("save").c_str());
+#endif
+	return err;
+}
+
+A_Err DoRestoreFoldLayout(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	// The prompt lists what this comp has
+	std::vector<std::string> records;
+	ERR(ListCompMarkerRecords(suites, compH, FOLD_LAYOUT_PREFIX, records));
+	if (err) return err;
+
+	std::vector<FoldLayout> layouts(records.size());
+	std::string names;
+	std::string defaultName;
+	size_t valid = 0;
+	for (size_t r = 0; r < records.size(); r++) {
+		if (!ParseFoldLayout(records[r], &layouts[valid])) continue;
+		const std::string& name = layouts[valid].name;
+		names += (valid ? ", " : "") + name;
+		if (defaultName.empty() || name == S_last_layout_name) defaultName = name;
+		valid++;
+	}
+	layouts.resize(valid);
+	if (layouts.empty()) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: This composition has no saved fold layouts.");
+		return err;
+	}
+
+	std::string name;
+	ERR(ReadLayoutName(suites, "Restore fold layout (" + names + "):", defaultName, &name));
+	if (err || name.empty()) return err;
+
+	const FoldLayout* layout = NULL;
+	for (size_t l = 0; l < layouts.size() && !layout; l++) {
+		if (layouts[l].name == name) layout = &layouts[l];
+	}
+	if (!layout) {
+		const std::string msg = "FoldLayers: No fold layout named \"" + name + "\" in this composition.";
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg.c_str());
+		return err;
+	}
+
+	const double start = PerfNowSeconds();
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Restore Fold Layout"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	FoldLayoutResult result;
+	ERR(RestoreFoldLayout(suites, compH, *layout, &result));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to restore the fold layout");
+		return err;
+	}
+	S_last_layout_name = name;
+
+	// After the undo group, as for Fold/Unfold
+	if (EnsureShyModeEnabled(suites)) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Warning - Could not enable Hide Shy Layers mode. Please enable it manually in the composition panel.");
+	}
+
+	S_layout_restore_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("restore fold layout: %d layers, %d groups (%d gone), %d changed, %d shy flags, %s",
+		(int)result.layers, (int)result.dividers, (int)result.missing, (int)result.dividersChanged,
+		(int)result.shyChanged, S_layout_restore_cost.Summary("restore").c_str());
+#endif
+	return err;
+}
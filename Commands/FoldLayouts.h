@@ -0,0 +1,53 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Layouts                                  */
+/*      Save and restore named fold arrangements per comp          */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDLAYOUTS_H
+#define FOLDLAYOUTS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/FoldLayout.h"
+#include <string>
+#include <unordered_map>
+
+// Scripts name the layout here to skip the prompt:
+//   $.global.FoldLayersLayout = "Review";
+//   app.executeCommand(app.findMenuCommandId("Restore Fold Layout..."));
+#define FOLD_LAYOUT_SCRIPT_GLOBAL	"FoldLayersLayout"
+
+typedef struct {
+	A_long		layers;				// Layers read
+	A_long		dividers;			// Dividers saved, or dividers the layout covered
+	A_long		missing;			// Layout entries with no divider left in the comp
+	A_long		dividersChanged;
+	A_long		shyChanged;
+} FoldLayoutResult;
+
+// Record every divider's fold state in compH under name (replacing a
+// layout of the same name). One pass over the comp.
+A_Err SaveFoldLayout(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::string& name,
+					 FoldLayoutResult* outResult);
+
+// Apply a layout: dividers it lists get its fold state, others keep
+// theirs; only the fold states and shy flags that differ are written.
+// One pass over the comp. The caller owns the undo group.
+A_Err RestoreFoldLayout(AEGP_SuiteHandler& suites, AEGP_CompH compH, const FoldLayout& layout,
+						FoldLayoutResult* outResult);
+
+// Point compH's saved layouts at replacement layers (e.g. shape dividers
+// converted to nulls): entries whose ID is in newIds take the mapped ID.
+// Only layouts that change are rewritten. The caller owns the undo group.
+A_Err RemapFoldLayouts(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+					   const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds);
+
+// "Save Fold Layout..." / "Restore Fold Layout..." command handlers
+A_Err DoSaveFoldLayout(AEGP_SuiteHandler& suites);
+A_Err DoRestoreFoldLayout(AEGP_SuiteHandler& suites);
+
+#endif // FOLDLAYOUTS_H
@@ -0,0 +1,124 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold State Storage                            */
+/*      Switches and migrates where fold state is kept             */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldStateStorage.h"
+#include "FoldLayers.h"
+
+// Rewrite one divider's state into targetStore. The FD- group stays in
+// place either way: it is the divider's identity, only its record changes.
+// The record's store field follows, so the project says where to read.
+static A_Err MigrateDivider(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, A_long targetStore, bool* outChanged)
+{
+	A_Err err = A_Err_NONE;
+	*outChanged = false;
+
+	AEGP_StreamRefH dataH = NULL;
+	bool groupFolded = true;
+	bool markerStore = false;
+	if (GetFoldGroupDataStream(suites, layerH, &dataH, &groupFolded, &markerStore) != A_Err_NONE || !dataH) {
+		return A_Err_NONE;  // Not a divider
+	}
+	suites.StreamSuite4()->AEGP_DisposeStream(dataH);
+
+	// The state as read now: the marker only counts if the record says so
+	bool markerFolded = groupFolded;
+	const bool hasMarker = GetMarkerFoldState(suites, layerH, &markerFolded);
+	const bool folded = (markerStore && hasMarker) ? markerFolded : groupFolded;
+
+	if (targetStore == FoldStateStore_Marker) {
+		if (!hasMarker || markerFolded != folded) {
+			ERR(WriteLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX, folded ? "FD-S:1" : "FD-S:0"));
+			*outChanged = !err;
+		}
+		if (!err && !markerStore) {
+			DividerRecord record;
+			ERR(ReadDividerRecord(suites, layerH, &record));
+			record.markerStore = true;
+			ERR(WriteDividerRecord(suites, layerH, record));
+			*outChanged = !err;
+		}
+	} else {
+		if (markerStore || folded != groupFolded) {
+			// Rewrite the whole record so the group ID and hierarchy survive
+			DividerRecord record;
+			ERR(ReadDividerRecord(suites, layerH, &record));
+			record.folded = folded;
+			record.markerStore = false;
+			ERR(WriteDividerRecord(suites, layerH, record));
+			*outChanged = !err;
+		}
+		if (!err && hasMarker) {
+			ERR(RemoveLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX));
+			*outChanged = !err;
+		}
+	}
+
+	return err;
+}
+
+A_Err MigrateFoldStateStore(AEGP_SuiteHandler& suites, A_long targetStore, A_long* outMigrated)
+{
+	A_Err err = A_Err_NONE;
+	A_long migrated = 0;
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetProjectComps(suites, comps));
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Migrate Fold State"));
+
+	for (size_t c = 0; c < comps.size() && !err; c++) {
+		A_long numLayers = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(comps[c], &numLayers));
+		for (A_long i = 0; i < numLayers && !err; i++) {
+			AEGP_LayerH layerH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(comps[c], i, &layerH));
+			if (!err && layerH) {
+				bool changed = false;
+				ERR(MigrateDivider(suites, layerH, targetStore, &changed));
+				if (changed) migrated++;
+			}
+		}
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	// Only switch stores once every divider has been carried over
+	if (!err) {
+		S_settings.foldStateStore = targetStore;
+		ERR(SaveSettings(suites));
+	}
+
+	if (outMigrated) *outMigrated = migrated;
+	return err;
+}
+
+A_Err DoToggleFoldStateStore(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	const A_long target = (S_settings.foldStateStore == FoldStateStore_Marker)
+		? FoldStateStore_Contents : FoldStateStore_Marker;
+
+	A_long migrated = 0;
+	err = MigrateFoldStateStore(suites, target, &migrated);
+
+	char msg[256];
+	if (err) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Fold state migration failed (Err: %d) - storage unchanged.", (int)err);
+	} else {
+		snprintf(msg, sizeof(msg), "FoldLayers: Fold state is now stored in %s (%d group layers migrated).",
+			target == FoldStateStore_Marker ? "layer markers" : "shape contents", (int)migrated);
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+
+	return err;
+}
+
+A_Err DoToggleNamePrefix(AEGP_SuiteHandler& suites)
+{
+	S_settings.syncNamePrefix = !S_settings.syncNamePrefix;
+	return SaveSettings(suites);
+}
@@ -0,0 +1,26 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold State Storage                            */
+/*      Switches and migrates where fold state is kept             */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDSTATESTORAGE_H
+#define FOLDSTATESTORAGE_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// Move every divider in the project to the given FoldStateStore in one pass
+// (one undo group), then make it the active store. outMigrated may be NULL.
+A_Err MigrateFoldStateStore(AEGP_SuiteHandler& suites, A_long targetStore, A_long* outMigrated);
+
+// "Store Group Fold State in Markers" command handler (toggles the store)
+A_Err DoToggleFoldStateStore(AEGP_SuiteHandler& suites);
+
+// "Show Group Fold State in Layer Names" command handler
+A_Err DoToggleNamePrefix(AEGP_SuiteHandler& suites);
+
+#endif // FOLDSTATESTORAGE_H
@@ -0,0 +1,112 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold to Level                                 */
+/*      Sets every group's fold state from its hierarchy level     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldToLevel.h"
+#include "FoldLayers.h"
+#include "Utils/PerfStats.h"
+#include "Utils/Scripting.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Level from a script, else from a prompt seeded with the last one used.
+// *outLevel is 0 when cancelled or out of range.
+static A_Err ReadFoldLevel(AEGP_SuiteHandler& suites, bool expand, A_long* outLevel, bool* outFromScript)
+{
+	A_Err err = A_Err_NONE;
+	*outLevel = 0;
+
+	std::string value;
+	ERR(TakeScriptGlobal(suites, FOLD_LEVEL_SCRIPT_GLOBAL, &value, outFromScript));
+	if (err) return err;
+
+	A_long level = 0;
+	if (*outFromScript) {
+		level = (A_long)strtol(value.c_str(), NULL, 10);
+	} else {
+		bool cancelled = false;
+		ERR(PromptForNumber(suites,
+			expand ? "Expand groups down to level (1 = top level):" : "Fold groups from level (1 = top level):",
+			S_settings.foldLevel, &level, &cancelled));
+		if (err || cancelled) return err;
+	}
+
+	if (level < FOLD_LEVEL_MIN || level > FOLD_LEVEL_MAX) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "FoldLayers: Level must be between %d and %d.", FOLD_LEVEL_MIN, FOLD_LEVEL_MAX);
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+		return err;
+	}
+	*outLevel = level;
+	return err;
+}
+
+A_Err DoFoldToLevel(AEGP_SuiteHandler& suites, bool expand)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	A_long level = 0;
+	bool fromScript = false;
+	ERR(ReadFoldLevel(suites, expand, &level, &fromScript));
+	if (err || !level) return err;
+
+	// Remember what was typed as the next prompt's default
+	if (!fromScript && level != S_settings.foldLevel) {
+		S_settings.foldLevel = level;
+		SaveSettings(suites);
+	}
+
+	const double start = PerfNowSeconds();
+
+	// One read of the comp, one planning pass, then only the writes that
+	// change something
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to read group layers");
+		return err;
+	}
+
+	SetFoldLevelTargets(layers, level, expand);
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	if (plan.dividers.empty() && plan.shy.empty()) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(expand ? "Expand to Level" : "Fold to Level"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	ERR(ApplyFoldPlan(suites, compH, layers, plan));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to set group fold states");
+		return err;
+	}
+
+	// After the undo group, as for Fold/Unfold
+	if (EnsureShyModeEnabled(suites)) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Warning - Could not enable Hide Shy Layers mode. Please enable it manually in the composition panel.");
+	}
+
+	PerfLog("%s level %d: %d layers, %d groups changed, %d shy flags, %.2f ms",
+		expand ? "expand to" : "fold to", (int)level, (int)layers.size(),
+		(int)plan.dividers.size(), (int)plan.shy.size(), (PerfNowSeconds() - start) * 1e3);
+	return err;
+}
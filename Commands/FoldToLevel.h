@@ -0,0 +1,27 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold to Level                                 */
+/*      Sets every group's fold state from its hierarchy level     */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDTOLEVEL_H
+#define FOLDTOLEVEL_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/FoldPlanner.h"
+#include <vector>
+
+// Scripts set the level here to skip the prompt:
+//   $.global.FoldLayersLevel = 2;
+//   app.executeCommand(app.findMenuCommandId("Fold to Level..."));
+#define FOLD_LEVEL_SCRIPT_GLOBAL	"FoldLayersLevel"
+
+// "Fold to Level..." / "Expand to Level..." command handlers (active comp,
+// one undo group)
+A_Err DoFoldToLevel(AEGP_SuiteHandler& suites, bool expand);
+
+#endif // FOLDTOLEVEL_H
@@ -0,0 +1,218 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Selection                               */
+/*      Gathers the selected layers into a new group               */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupSelection.h"
+#include "FoldLayers.h"
+#include "Hierarchy/ReorderPlan.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+static LatencyHistogram	S_group_selection_cost;
+
+// Explicit membership: the new group's row is its gathered layers, which
+// leave the rows of the groups they came from; the groups around the new
+// one list it instead. Rows of moved groups travel with them unchanged.
+static A_Err AdoptGatheredRows(AEGP_SuiteHandler& suites, AEGP_CompH compH, const GroupTree& tree,
+							   const GroupSelectionPlan& plan, AEGP_LayerH groupH)
+{
+	A_Err err = A_Err_NONE;
+
+	ERR(CaptureGroupMembers(suites, compH, groupH));
+
+	std::vector<AEGP_LayerIDVal> members;
+	bool hasRow = false;
+	AEGP_LayerIDVal groupId = 0;
+	ERR(ReadGroupMembers(suites, groupH, members, &hasRow));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(groupH, &groupId));
+	if (err) return err;
+	const std::unordered_set<AEGP_LayerIDVal> gathered(members.begin(), members.end());
+
+	std::vector<bool> ancestor((size_t)tree.Count(), false);
+	for (A_long p = plan.parent; p >= 0; p = tree.Parent(p)) ancestor[(size_t)p] = true;
+
+	for (A_long d = 0; d < tree.Count() && !err; d++) {
+		bool moved = false;
+		for (size_t r = 0; r < plan.roots.size() && !moved; r++) moved = tree.Encloses(plan.roots[r], d);
+		if (moved) continue;
+
+		std::vector<AEGP_LayerIDVal> row;
+		bool dividerHasRow = false;
+		ERR(ReadGroupMembers(suites, tree.Divider(d).layerH, row, &dividerHasRow));
+		if (err || !dividerHasRow) continue;
+
+		bool changed = false;
+		if (ancestor[(size_t)d]) {
+			if (std::find(row.begin(), row.end(), groupId) == row.end()) {
+				std::vector<AEGP_LayerIDVal>::iterator at = row.begin();
+				while (at != row.end() && !gathered.count(*at)) ++at;
+				row.insert(at, groupId);
+				changed = true;
+			}
+		} else {
+			const size_t before = row.size();
+			row.erase(std::remove_if(row.begin(), row.end(),
+				[&gathered](AEGP_LayerIDVal id) { return gathered.count(id) != 0; }), row.end());
+			changed = row.size() != before;
+		}
+		if (changed) ERR(WriteGroupMembers(suites, tree.Divider(d).layerH, row));
+	}
+
+	return err;
+}
+
+static void ReportLabelLimit(AEGP_SuiteHandler& suites, const std::string& hierarchy)
+{
+	char msg[256];
+	if (GetHierarchyDepth(hierarchy) >= MAX_HIERARCHY_DEPTH) {
+#ifdef AE_OS_WIN
+		sprintf_s(msg, sizeof(msg), "FoldLayers: Maximum nesting depth (%d) reached. Cannot group the selection.", MAX_HIERARCHY_DEPTH);
+#else
+		snprintf(msg, sizeof(msg), "FoldLayers: Maximum nesting depth (%d) reached. Cannot group the selection.", MAX_HIERARCHY_DEPTH);
+#endif
+	} else {
+#ifdef AE_OS_WIN
+		sprintf_s(msg, sizeof(msg), "FoldLayers: Too many groups at this level.");
+#else
+		snprintf(msg, sizeof(msg), "FoldLayers: Too many groups at this level.");
+#endif
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+}
+
+A_Err DoGroupSelection(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	std::vector<A_long> selectedIndices;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &index));
+			if (!err) selectedIndices.push_back(index);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || selectedIndices.empty()) return err;
+
+	const double start = PerfNowSeconds();
+
+	GroupTree tree;
+	GroupSelectionResult result;
+	memset(&result, 0, sizeof(result));
+	ERR(ReadGroupTree(suites, compH, tree, &result.indexed));
+	if (err) return err;
+
+	GroupSelectionPlan plan;
+	PlanGroupSelection(tree, selectedIndices, plan);
+	if (plan.order.empty()) return err;
+
+	// Hierarchy paths: the new group takes the first free child path of its
+	// parent, and every moved group is labelled again below it, parents first
+	std::vector<std::string> hierarchies((size_t)tree.Count());
+	std::unordered_set<std::string> used;
+	for (A_long d = 0; d < tree.Count(); d++) {
+		hierarchies[(size_t)d] = GetHierarchyFromHiddenGroup(suites, tree.Divider(d).layerH);
+		used.insert(hierarchies[(size_t)d]);
+	}
+
+	std::string groupHierarchy;
+	if (plan.parent >= 0) {
+		const std::string& parentHierarchy = hierarchies[(size_t)plan.parent];
+		groupHierarchy = FreeChildHierarchy(parentHierarchy, used);
+		if (groupHierarchy.empty() || GetHierarchyDepth(groupHierarchy) > MAX_HIERARCHY_DEPTH) {
+			ReportLabelLimit(suites, parentHierarchy);
+			return err;
+		}
+		used.insert(groupHierarchy);
+	}
+
+	std::vector<std::string> relabels((size_t)tree.Count());
+	std::vector<bool> moved((size_t)tree.Count(), false);
+	for (A_long d = 0; d < tree.Count(); d++) {
+		for (size_t r = 0; r < plan.roots.size() && !moved[(size_t)d]; r++) {
+			moved[(size_t)d] = tree.Encloses(plan.roots[r], d);
+		}
+		if (!moved[(size_t)d]) continue;
+
+		const A_long p = tree.Parent(d);
+		const std::string& above = (p >= 0 && moved[(size_t)p]) ? relabels[(size_t)p] : groupHierarchy;
+		relabels[(size_t)d] = FreeChildHierarchy(above, used);
+		if (relabels[(size_t)d].empty() || GetHierarchyDepth(relabels[(size_t)d]) > MAX_HIERARCHY_DEPTH) {
+			ReportLabelLimit(suites, above);
+			return err;
+		}
+		used.insert(relabels[(size_t)d]);
+	}
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Group Selection"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	AEGP_LayerH groupH = NULL;
+	ERR(CreateDividerLayer(suites, compH, groupHierarchy, plan.insertAt, &groupH));
+
+	std::vector<ReorderMove> moves;
+	if (!err && groupH) {
+		PlanReorder(plan.order, moves);
+		ERR(ApplyReorderPlan(suites, compH, moves));
+	}
+
+	// Identity writes only where the path changed
+	for (A_long d = 0; d < tree.Count() && !err && groupH; d++) {
+		if (!moved[(size_t)d] || relabels[(size_t)d] == hierarchies[(size_t)d]) continue;
+		ERR(SetDividerHierarchy(suites, tree.Divider(d).layerH, relabels[(size_t)d]));
+		if (!err) result.relabeled++;
+	}
+
+	if (!err && groupH && S_settings.groupMembership == GroupMembership_Explicit) {
+		ERR(AdoptGatheredRows(suites, compH, tree, plan, groupH));
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to group the selection");
+		return err;
+	}
+
+	result.layers = plan.layers;
+	result.reorders = (A_long)moves.size();
+
+	S_group_selection_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("group selection: %d layers, %d reorders, %d relabeled (%s), %s",
+		(int)result.layers, (int)result.reorders, (int)result.relabeled, result.indexed ? "index" : "scan",
+		S_group_selection_cost.Summary("group").c_str());
+#endif
+
+	// Enable shy mode after creating group (outside UndoGroup for reliable script execution)
+	ERR(EnsureShyModeEnabled(suites));
+
+	return err;
+}
@@ -0,0 +1,28 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Selection                               */
+/*      Gathers the selected layers into a new group               */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef GROUPSELECTION_H
+#define GROUPSELECTION_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/GroupPlans.h"
+#include <vector>
+
+typedef struct {
+	A_long		layers;				// Layers gathered, those of selected groups included
+	A_long		relabeled;			// Group layers whose hierarchy path changed
+	A_long		reorders;			// AEGP_ReorderLayer calls made
+	bool		indexed;			// Structure came from the divider index
+} GroupSelectionResult;
+
+// "Group Selection"
+A_Err DoGroupSelection(AEGP_SuiteHandler& suites);
+
+#endif // GROUPSELECTION_H
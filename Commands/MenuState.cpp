@@ -0,0 +1,199 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Menu State                                    */
+/*      Cached selection summary for cheap menu updates            */
+/*                                                                 */
+/*******************************************************************/
+
+#include "MenuState.h"
+#include "FoldLayers.h"
+
+static SelectionSummary	S_selection_summary	= { false, 0, 0, 0, 0 };
+
+// String ID currently shown for the Fold/Unfold command (avoids renaming on every update)
+static int				S_fold_menu_label	= StrID_Menu_ToggleFold;
+
+A_Err BuildSelectionSummary(AEGP_SuiteHandler& suites, AEGP_CompH compH, SelectionSummary* outSummary)
+{
+	A_Err err = A_Err_NONE;
+
+	outSummary->hasComp = (compH != NULL);
+	outSummary->selectedLayers = 0;
+	outSummary->selectedDividers = 0;
+	outSummary->selectedFolded = 0;
+	outSummary->generation = S_selection_summary.generation;
+
+	if (!compH) return A_Err_NONE;
+
+	AEGP_Collection2H collectionH = NULL;
+	A_u_long numSelected = 0;
+
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (!err && item.type == AEGP_CollectionItemType_LAYER) {
+				outSummary->selectedLayers++;
+
+				// Identity and fold state in a single probe
+				bool folded = true;
+				if (ProbeDividerState(suites, item.u.layer.layerH, &folded)) {
+					outSummary->selectedDividers++;
+					if (folded) outSummary->selectedFolded++;
+				}
+			}
+		}
+
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+
+	return err;
+}
+
+void PublishSelectionSummary(const SelectionSummary& summary)
+{
+	const bool changed =
+		summary.hasComp != S_selection_summary.hasComp ||
+		summary.selectedLayers != S_selection_summary.selectedLayers ||
+		summary.selectedDividers != S_selection_summary.selectedDividers ||
+		summary.selectedFolded != S_selection_summary.selectedFolded;
+
+	const A_u_long generation = S_selection_summary.generation;
+	S_selection_summary = summary;
+	S_selection_summary.generation = changed ? generation + 1 : generation;
+}
+
+const SelectionSummary& CachedSelectionSummary()
+{
+	return S_selection_summary;
+}
+
+A_Err ApplyMenuState(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	const SelectionSummary& summary = S_selection_summary;
+
+	// Storage options are project-wide and always available
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_state_in_markers));
+	ERR(suites.CommandSuite1()->AEGP_CheckMarkMenuCommand(S_cmd_state_in_markers,
+		S_settings.foldStateStore == FoldStateStore_Marker ? TRUE : FALSE));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_name_prefix));
+	ERR(suites.CommandSuite1()->AEGP_CheckMarkMenuCommand(S_cmd_name_prefix,
+		S_settings.syncNamePrefix ? TRUE : FALSE));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_null_dividers));
+	ERR(suites.CommandSuite1()->AEGP_CheckMarkMenuCommand(S_cmd_null_dividers,
+		S_settings.dividerLayerType == DividerLayer_Null ? TRUE : FALSE));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_convert_to_nulls));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_normalize));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_explicit_members));
+	ERR(suites.CommandSuite1()->AEGP_CheckMarkMenuCommand(S_cmd_explicit_members,
+		S_settings.groupMembership == GroupMembership_Explicit ? TRUE : FALSE));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_focus_mode));
+	ERR(suites.CommandSuite1()->AEGP_CheckMarkMenuCommand(S_cmd_focus_mode,
+		S_focus_mode.Enabled() ? TRUE : FALSE));
+
+	// Project-wide fold: one at a time
+	if (S_batch_fold.Running()) {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_batch_fold));
+	} else {
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_batch_fold));
+	}
+
+	// Without a composition none of the group commands can do anything
+	if (!summary.hasComp) {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_create_divider));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_fold_unfold));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_fold_to_level));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_expand_to_level));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_reveal));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_fold_recursive));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_save_layout));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_restore_layout));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_history_back));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_history_forward));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_select_group));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_select_nested));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_up));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_down));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_to));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_group_selection));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_duplicate_group));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_ungroup));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_delete_group));
+		return err;
+	}
+
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_create_divider));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_fold_unfold));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_fold_to_level));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_expand_to_level));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_save_layout));
+	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_restore_layout));
+
+	// Fold history of the active comp (O(1): kept by IdleHook)
+	if (S_fold_history.CanStep(false)) {
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_history_back));
+	} else {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_history_back));
+	}
+	if (S_fold_history.CanStep(true)) {
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_history_forward));
+	} else {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_history_forward));
+	}
+
+	// Reveal and grouping need something to work on
+	if (summary.selectedLayers > 0) {
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_reveal));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_group_selection));
+	} else {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_reveal));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_group_selection));
+	}
+
+	// Recursive fold, group selection, moves, copies and removal start from selected group layers
+	if (summary.selectedDividers > 0) {
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_fold_recursive));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_select_group));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_select_nested));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_move_up));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_move_down));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_move_to));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_duplicate_group));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_ungroup));
+		ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_delete_group));
+	} else {
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_fold_recursive));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_select_group));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_select_nested));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_up));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_down));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_move_to));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_duplicate_group));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_ungroup));
+		ERR(suites.CommandSuite1()->AEGP_DisableCommand(S_cmd_delete_group));
+	}
+
+	// Selected dividers all share one state -> say what will happen.
+	// Mixed state, or no divider selected (toggle all) -> generic label.
+	int label = StrID_Menu_ToggleFold;
+	if (summary.selectedDividers > 0) {
+		if (summary.selectedFolded == summary.selectedDividers) {
+			label = StrID_Menu_UnfoldGroup;
+		} else if (summary.selectedFolded == 0) {
+			label = StrID_Menu_FoldGroup;
+		}
+	}
+
+	if (!err && label != S_fold_menu_label) {
+		ERR(suites.CommandSuite1()->AEGP_SetMenuCommandName(S_cmd_fold_unfold, FLSTR(label)));
+		if (!err) {
+			S_fold_menu_label = label;
+		}
+	}
+
+	return err;
+}
@@ -0,0 +1,40 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Menu State                                    */
+/*      Cached selection summary for cheap menu updates            */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef MENUSTATE_H
+#define MENUSTATE_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// What the menu needs to know about the current selection.
+// Built by IdleHook (one pass over the selection), read by UpdateMenuHook.
+typedef struct {
+	bool		hasComp;			// A composition is the active item
+	A_u_long	selectedLayers;		// Layers in the comp selection
+	A_u_long	selectedDividers;	// Selected layers with divider identity
+	A_u_long	selectedFolded;		// Selected dividers currently folded
+	A_u_long	generation;			// Bumped whenever the summary changes
+} SelectionSummary;
+
+// Walk the comp selection once, probing each selected layer's identity and
+// fold state with a single stream scan. compH may be NULL (no active comp).
+A_Err BuildSelectionSummary(AEGP_SuiteHandler& suites, AEGP_CompH compH, SelectionSummary* outSummary);
+
+// Replace the cached summary (main thread only)
+void PublishSelectionSummary(const SelectionSummary& summary);
+
+// Last summary published by IdleHook
+const SelectionSummary& CachedSelectionSummary();
+
+// Enable/disable and relabel the plugin's menu commands from the cached
+// summary. O(1): no collections, no stream probing, no fold execution.
+A_Err ApplyMenuState(AEGP_SuiteHandler& suites);
+
+#endif // MENUSTATE_H
@@ -0,0 +1,147 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Move Group                                    */
+/*      Moves groups as blocks among their sibling groups          */
+/*                                                                 */
+/*******************************************************************/
+
+#include "MoveGroup.h"
+#include "FoldLayers.h"
+#include "Hierarchy/ReorderPlan.h"
+#include "Utils/PerfStats.h"
+#include "Utils/Scripting.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static LatencyHistogram	S_move_group_cost;
+
+// 1-based target index from a script, else from a prompt. 0 when cancelled.
+static A_Err ReadTargetIndex(AEGP_SuiteHandler& suites, A_long current, A_long* outIndex)
+{
+	A_Err err = A_Err_NONE;
+	*outIndex = 0;
+
+	std::string value;
+	bool fromScript = false;
+	ERR(TakeScriptGlobal(suites, MOVE_GROUP_SCRIPT_GLOBAL, &value, &fromScript));
+	if (err) return err;
+
+	if (fromScript) {
+		*outIndex = (A_long)strtol(value.c_str(), NULL, 10);
+	} else {
+		bool cancelled = false;
+		ERR(PromptForNumber(suites, "Move the group to layer index:", current, outIndex, &cancelled));
+		if (cancelled) *outIndex = 0;
+	}
+	return err;
+}
+
+A_Err DoMoveGroup(AEGP_SuiteHandler& suites, int direction)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	// Selected dividers, by index
+	std::vector<A_long> selectedIndices;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+			if (!IsDividerLayer(suites, item.u.layer.layerH)) continue;
+
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &index));
+			if (!err) selectedIndices.push_back(index);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || selectedIndices.empty()) return err;
+
+	A_long targetIndex = 0;
+	if (direction == MoveGroup_ToIndex) {
+		std::sort(selectedIndices.begin(), selectedIndices.end());
+		ERR(ReadTargetIndex(suites, selectedIndices[0] + 1, &targetIndex));
+		if (err || targetIndex <= 0) return err;
+		targetIndex--;
+	}
+
+	const double start = PerfNowSeconds();
+
+	GroupTree tree;
+	MoveGroupResult result;
+	memset(&result, 0, sizeof(result));
+	ERR(ReadGroupTree(suites, compH, tree, &result.indexed));
+	if (err) return err;
+
+	// Groups inside a selected group move with it
+	std::vector<bool> selected((size_t)tree.Count(), false);
+	for (size_t s = 0; s < selectedIndices.size(); s++) {
+		const A_long d = tree.AtIndex(selectedIndices[s]);
+		if (d >= 0) selected[(size_t)d] = true;
+	}
+	std::vector<A_long> roots;
+	for (A_long d = 0; d < tree.Count(); d++) {
+		if (!selected[(size_t)d]) continue;
+		bool nested = false;
+		for (A_long p = tree.Parent(d); p >= 0 && !nested; p = tree.Parent(p)) nested = selected[(size_t)p];
+		if (!nested) roots.push_back(d);
+	}
+	if (roots.empty()) return err;
+	if (direction == MoveGroup_ToIndex) roots.resize(1);
+
+	std::vector<A_long> order;
+	PlanGroupMove(tree, roots, direction, targetIndex, order);
+	if (order.empty()) return err;
+
+	std::vector<ReorderMove> moves;
+	PlanReorder(order, moves);
+
+	const char* undoName = direction == MoveGroup_Up ? "Move Group Up" :
+		(direction == MoveGroup_Down ? "Move Group Down" : "Move Group");
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(undoName));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	ERR(ApplyReorderPlan(suites, compH, moves));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to move the group");
+		return err;
+	}
+
+	// Moved groups, and what moving them layer by layer would have cost
+	for (size_t r = 0; r < roots.size(); r++) {
+		const A_long d = roots[r];
+		if (order[(size_t)tree.Divider(d).index] == tree.Divider(d).index) continue;
+		result.groups++;
+		result.layers += tree.End(d) - tree.Divider(d).index;
+	}
+	result.reorders = (A_long)moves.size();
+
+	S_move_group_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("move group: %d groups, %d reorders (%d layer by layer, %s), %s",
+		(int)result.groups, (int)result.reorders, (int)result.layers, result.indexed ? "index" : "scan",
+		S_move_group_cost.Summary("move").c_str());
+#endif
+	return err;
+}
@@ -0,0 +1,33 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Move Group                                    */
+/*      Moves groups as blocks among their sibling groups          */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef MOVEGROUP_H
+#define MOVEGROUP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/GroupPlans.h"
+#include <vector>
+
+// Scripts pass the 1-based layer index here to skip the prompt:
+//   $.global.FoldLayersMoveTo = 12;
+//   app.executeCommand(app.findMenuCommandId("Move Group to Index..."));
+#define MOVE_GROUP_SCRIPT_GLOBAL	"FoldLayersMoveTo"
+
+typedef struct {
+	A_long		groups;				// Groups that moved
+	A_long		layers;				// Layers in them: what moving layer by layer costs
+	A_long		reorders;			// AEGP_ReorderLayer calls made
+	bool		indexed;			// Structure came from the divider index
+} MoveGroupResult;
+
+// "Move Group Up" / "Move Group Down" / "Move Group to Index..."
+A_Err DoMoveGroup(AEGP_SuiteHandler& suites, int direction);
+
+#endif // MOVEGROUP_H
@@ -0,0 +1,154 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Normalize Dividers                            */
+/*      Pins FD- groups and upgrades them to version 2 records     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "NormalizeDividers.h"
+#include "FoldLayers.h"
+
+// Kind of FD- group, from its stream name
+enum {
+	FDGroup_None = 0,
+	FDGroup_State,		// FD-0 / FD-1
+	FDGroup_Hierarchy	// FD-H:<path>
+};
+
+static int ClassifyGroup(AEGP_SuiteHandler& suites, AEGP_StreamRefH streamH)
+{
+	int kind = FDGroup_None;
+
+	AEGP_MemHandle nameH = NULL;
+	if (suites.StreamSuite4()->AEGP_GetStreamName(S_my_id, streamH, FALSE, &nameH) == A_Err_NONE && nameH) {
+		void* dataP = NULL;
+		if (suites.MemorySuite1()->AEGP_LockMemHandle(nameH, &dataP) == A_Err_NONE && dataP) {
+			const A_u_short* name16 = (const A_u_short*)dataP;
+			if (name16[0] == 'F' && name16[1] == 'D' && name16[2] == '-') {
+				if (name16[3] == 'H' && name16[4] == ':') {
+					kind = FDGroup_Hierarchy;
+				} else if (name16[3] == '0' || name16[3] == '1') {
+					kind = FDGroup_State;
+				}
+			}
+			suites.MemorySuite1()->AEGP_UnlockMemHandle(nameH);
+		}
+		suites.MemorySuite1()->AEGP_FreeMemHandle(nameH);
+	}
+
+	return kind;
+}
+
+// Index of the first child of the given kind, or -1 (full scan, no cap)
+static A_long FindGroupIndex(AEGP_SuiteHandler& suites, AEGP_StreamRefH contentsH, int kind)
+{
+	A_long numStreams = 0;
+	if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsH, &numStreams) != A_Err_NONE) {
+		return -1;
+	}
+
+	for (A_long i = 0; i < numStreams; i++) {
+		AEGP_StreamRefH childH = NULL;
+		if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsH, i, &childH) == A_Err_NONE && childH) {
+			const int childKind = ClassifyGroup(suites, childH);
+			suites.StreamSuite4()->AEGP_DisposeStream(childH);
+			if (childKind == kind) return i;
+		}
+	}
+	return -1;
+}
+
+// Move the first group of kind to target. Stream refs are re-fetched by index
+// because a reorder can invalidate refs to siblings.
+static A_Err PinGroup(AEGP_SuiteHandler& suites, AEGP_StreamRefH contentsH, int kind, A_long target, bool* outMoved)
+{
+	A_Err err = A_Err_NONE;
+
+	const A_long index = FindGroupIndex(suites, contentsH, kind);
+	if (index < 0 || index == target) return A_Err_NONE;
+
+	AEGP_StreamRefH groupH = NULL;
+	ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsH, index, &groupH));
+	if (!err && groupH) {
+		ERR(suites.DynamicStreamSuite4()->AEGP_ReorderStream(groupH, target));
+		if (!err) *outMoved = true;
+		suites.StreamSuite4()->AEGP_DisposeStream(groupH);
+	}
+
+	return err;
+}
+
+A_Err NormalizeDividerLayout(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outMoved)
+{
+	A_Err err = A_Err_NONE;
+	*outMoved = false;
+
+	AEGP_ObjectType layerType = AEGP_ObjectType_NONE;
+	if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE || layerType != AEGP_ObjectType_VECTOR) {
+		return A_Err_NONE;
+	}
+
+	AEGP_StreamRefH rootStreamH = NULL;
+	ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(S_my_id, layerH, &rootStreamH));
+	if (err || !rootStreamH) return err;
+
+	AEGP_StreamRefH contentsStreamH = NULL;
+	if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH) == A_Err_NONE && contentsStreamH) {
+		// Only layers that carry a state group are dividers
+		if (FindGroupIndex(suites, contentsStreamH, FDGroup_State) >= 0) {
+			ERR(PinGroup(suites, contentsStreamH, FDGroup_State, DIVIDER_STATE_GROUP_INDEX, outMoved));
+			ERR(PinGroup(suites, contentsStreamH, FDGroup_Hierarchy, DIVIDER_HIER_GROUP_INDEX, outMoved));
+		}
+		suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
+	}
+	suites.StreamSuite4()->AEGP_DisposeStream(rootStreamH);
+
+	// With both legacy groups pinned, fold them into a single current record.
+	// Older records have no store field: contents stores drop FD-S: markers,
+	// so one that is present means the marker store wrote last.
+	DividerRecord record;
+	if (!err && ReadDividerRecord(suites, layerH, &record) == A_Err_NONE && record.version < DIVIDER_RECORD_VERSION) {
+		if (GetMarkerFoldState(suites, layerH, NULL)) record.markerStore = true;
+		ERR(WriteDividerRecord(suites, layerH, record));
+		if (!err) *outMoved = true;
+	}
+
+	return err;
+}
+
+A_Err DoNormalizeDividers(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	A_long normalized = 0;
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetProjectComps(suites, comps));
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Normalize Group Layers"));
+
+	for (size_t c = 0; c < comps.size() && !err; c++) {
+		A_long numLayers = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(comps[c], &numLayers));
+		for (A_long i = 0; i < numLayers && !err; i++) {
+			AEGP_LayerH layerH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(comps[c], i, &layerH));
+			if (!err && layerH) {
+				bool moved = false;
+				ERR(NormalizeDividerLayout(suites, layerH, &moved));
+				if (moved) normalized++;
+			}
+		}
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	char msg[256];
+	if (err) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Normalize stopped (Err: %d) after %d group layers.", (int)err, (int)normalized);
+	} else {
+		snprintf(msg, sizeof(msg), "FoldLayers: Normalized %d group layers.", (int)normalized);
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+
+	return err;
+}
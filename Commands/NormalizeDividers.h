@@ -0,0 +1,25 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Normalize Dividers                            */
+/*      Moves FD- groups into their pinned Contents positions      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef NORMALIZEDIVIDERS_H
+#define NORMALIZEDIVIDERS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// Full Contents scan of one shape layer: move the state group (FD-0/FD-1)
+// to DIVIDER_STATE_GROUP_INDEX and the FD-H: group to DIVIDER_HIER_GROUP_INDEX,
+// then upgrade legacy layers to a version 2 record (Hierarchy/DividerRecord.h).
+// *outMoved is true if anything was reordered or rewritten. Non-dividers are left alone.
+A_Err NormalizeDividerLayout(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outMoved);
+
+// "Normalize Group Layers" command handler (whole project, one undo group)
+A_Err DoNormalizeDividers(AEGP_SuiteHandler& suites);
+
+#endif // NORMALIZEDIVIDERS_H
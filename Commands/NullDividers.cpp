@@ -0,0 +1,181 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Null Dividers                                 */
+/*      Null/guide layer dividers and bulk conversion              */
+/*                                                                 */
+/*******************************************************************/
+
+#include "NullDividers.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+// Swap one shape divider for a null divider at the same index. The null
+// gets a new layer ID: the pair goes into newIds for the caller to remap.
+static A_Err ConvertDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH shapeH,
+							std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds)
+{
+	A_Err err = A_Err_NONE;
+
+	// Capture everything the null needs before touching the comp
+	const std::string hierarchy = GetHierarchyFromHiddenGroup(suites, shapeH);
+	const bool folded = IsDividerFolded(suites, shapeH);
+
+	std::string name;
+	A_long index = 0;
+	AEGP_LayerFlags flags = 0;
+	AEGP_LabelID label = 0;
+	AEGP_LayerIDVal shapeId = 0;
+	ERR(GetLayerNameStr(suites, shapeH, name));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(shapeH, &shapeId));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(shapeH, &index));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(shapeH, &flags));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerLabel(shapeH, &label));
+	if (err) return err;
+
+	AEGP_LayerH nullH = NULL;
+	A_UTF16Char nullName16[] = {'G','r','o','u','p', 0};
+	ERR(suites.CompSuite11()->AEGP_CreateNullLayerInComp(nullName16, compH, NULL, &nullH));
+	if (err || !nullH) return err ? err : A_Err_GENERIC;
+
+	// New layers land on top; moving to the old index puts the null
+	// directly above the shape divider, which then shifts down by one
+	ERR(suites.LayerSuite9()->AEGP_ReorderLayer(nullH, index));
+	ERR(SetLayerNameStr(suites, nullH, name));
+	ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(nullH, AEGP_LayerFlag_VIDEO_ACTIVE, FALSE));
+	ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(nullH, AEGP_LayerFlag_GUIDE_LAYER, TRUE));
+	ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(nullH, AEGP_LayerFlag_SHY, (flags & AEGP_LayerFlag_SHY) ? TRUE : FALSE));
+	ERR(suites.LayerSuite9()->AEGP_SetLayerLabel(nullH, label));
+	ERR(AddDividerIdentity(suites, nullH, hierarchy));
+	if (!err && folded) {
+		ERR(WriteLayerMarkerRecord(suites, nullH, DIVIDER_STATE_MARKER_PREFIX, "FD-S:1"));
+	}
+
+	// The shape's own member row moves with it (kept in either membership
+	// mode, like the rows themselves)
+	AEGP_LayerIDVal nullId = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(nullH, &nullId));
+	std::vector<AEGP_LayerIDVal> ownRow;
+	bool hasOwnRow = false;
+	ERR(ReadGroupMembers(suites, shapeH, ownRow, &hasOwnRow));
+	if (!err && hasOwnRow) {
+		ERR(WriteGroupMembers(suites, nullH, ownRow));
+	}
+
+	if (err) {
+		// Keep the original divider; drop the half-built null
+		suites.LayerSuite9()->AEGP_DeleteLayer(nullH);
+		return err;
+	}
+
+	ERR(suites.LayerSuite9()->AEGP_DeleteLayer(shapeH));
+	if (!err) newIds[shapeId] = nullId;
+	return err;
+}
+
+// Everything that names dividers by layer ID follows the converted ones:
+// member rows, saved fold layouts, fold history and the divider index
+static A_Err RemapConvertedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+									const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds)
+{
+	A_Err err = A_Err_NONE;
+	if (newIds.empty()) return err;
+
+	// First, so the row pass below scans the converted comp
+	A_long itemId = 0;
+	if (GetCompItemId(suites, compH, &itemId) == A_Err_NONE) S_divider_index.Invalidate(itemId);
+
+	ERR(RemapGroupMembers(suites, compH, newIds));
+	ERR(RemapFoldLayouts(suites, compH, newIds));
+	S_fold_history.RemapLayerIds(suites, compH, newIds);
+	return err;
+}
+
+A_Err ConvertDividersToNulls(AEGP_SuiteHandler& suites, A_long* outConverted, A_long* outSkipped)
+{
+	A_Err err = A_Err_NONE;
+	A_long converted = 0;
+	A_long skipped = 0;
+
+	std::vector<AEGP_CompH> comps;
+	ERR(GetProjectComps(suites, comps));
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Convert Group Layers to Nulls"));
+
+	for (size_t c = 0; c < comps.size() && !err; c++) {
+		AEGP_CompH compH = comps[c];
+		A_long numLayers = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+
+		// One pass: shape dividers to convert, and every layer used as a parent
+		std::vector<AEGP_LayerH> shapeDividers;
+		std::vector<AEGP_LayerH> parents;
+		for (A_long i = 0; i < numLayers && !err; i++) {
+			AEGP_LayerH layerH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+			if (err || !layerH) continue;
+
+			AEGP_LayerH parentH = NULL;
+			if (suites.LayerSuite9()->AEGP_GetLayerParent(layerH, &parentH) == A_Err_NONE && parentH) {
+				parents.push_back(parentH);
+			}
+
+			AEGP_ObjectType layerType = AEGP_ObjectType_NONE;
+			if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) == A_Err_NONE &&
+				layerType == AEGP_ObjectType_VECTOR && HasDividerIdentity(suites, layerH)) {
+				shapeDividers.push_back(layerH);
+			}
+		}
+
+		// Deleting a parent would unparent (and move) its children
+		std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal> newIds;
+		for (size_t i = 0; i < shapeDividers.size() && !err; i++) {
+			if (std::find(parents.begin(), parents.end(), shapeDividers[i]) != parents.end()) {
+				skipped++;
+				continue;
+			}
+			ERR(ConvertDivider(suites, compH, shapeDividers[i], newIds));
+			if (!err) converted++;
+		}
+
+		// Also after a failed conversion: the ones done so far stay converted
+		A_Err remapErr = RemapConvertedDividers(suites, compH, newIds);
+		if (!err) err = remapErr;
+	}
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (outConverted) *outConverted = converted;
+	if (outSkipped) *outSkipped = skipped;
+	return err;
+}
+
+A_Err DoToggleNullDividers(AEGP_SuiteHandler& suites)
+{
+	S_settings.dividerLayerType = (S_settings.dividerLayerType == DividerLayer_Null)
+		? DividerLayer_Shape : DividerLayer_Null;
+	return SaveSettings(suites);
+}
+
+A_Err DoConvertDividersToNulls(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	A_long converted = 0;
+	A_long skipped = 0;
+
+	err = ConvertDividersToNulls(suites, &converted, &skipped);
+
+	char msg[256];
+	if (err) {
+		snprintf(msg, sizeof(msg), "FoldLayers: Conversion stopped (Err: %d) after %d group layers. Use Undo to revert.",
+			(int)err, (int)converted);
+	} else {
+		snprintf(msg, sizeof(msg), "FoldLayers: Converted %d group layers to nulls (%d skipped: used as parent).",
+			(int)converted, (int)skipped);
+	}
+	suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+
+	return err;
+}
@@ -0,0 +1,27 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Null Dividers                                 */
+/*      Null/guide layer dividers and bulk conversion              */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef NULLDIVIDERS_H
+#define NULLDIVIDERS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// Replace every shape divider in the project with an equivalent null
+// divider (same index, name, hierarchy, fold state, shy flag and label).
+// Shape dividers that other layers are parented to are left alone.
+A_Err ConvertDividersToNulls(AEGP_SuiteHandler& suites, A_long* outConverted, A_long* outSkipped);
+
+// "Create Groups as Null Layers" command handler (toggles the setting)
+A_Err DoToggleNullDividers(AEGP_SuiteHandler& suites);
+
+// "Convert Group Layers to Nulls" command handler
+A_Err DoConvertDividersToNulls(AEGP_SuiteHandler& suites);
+
+#endif // NULLDIVIDERS_H
@@ -0,0 +1,116 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Recursive Fold                                */
+/*      Folds/unfolds groups together with all their sub groups    */
+/*                                                                 */
+/*******************************************************************/
+
+#include "RecursiveFold.h"
+#include "FoldLayers.h"
+#include "Hierarchy/FoldOutline.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/PerfStats.h"
+
+A_Err FoldSubtrees(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+				   const std::vector<AEGP_LayerIDVal>& roots, bool fold)
+{
+	A_Err err = A_Err_NONE;
+
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) return err;
+
+	FoldOutline outline;
+	outline.Build(layers, rows);
+
+	// Every divider reachable from a root through the groups it contains
+	std::vector<bool> mark(layers.size(), false);
+	std::vector<A_long> pending;
+	for (size_t r = 0; r < roots.size(); r++) {
+		const A_long index = outline.IndexOf(roots[r]);
+		if (index < 0 || !outline.IsDivider(index) || mark[(size_t)index]) continue;
+		mark[(size_t)index] = true;
+		pending.push_back(index);
+	}
+
+	A_long subtree = 0;
+	while (!pending.empty()) {
+		const A_long divider = pending.back();
+		pending.pop_back();
+		layers[(size_t)divider].target = fold ? FoldTarget_Fold : FoldTarget_Unfold;
+		subtree++;
+
+		std::vector<A_long> contained;
+		outline.AddContained(divider, mark, contained);
+		for (size_t c = 0; c < contained.size(); c++) {
+			if (outline.IsDivider(contained[c])) pending.push_back(contained[c]);
+		}
+	}
+
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	ERR(ApplyFoldPlan(suites, compH, layers, plan));
+
+	PerfLog("%s recursively: %d groups in the trees, %d changed, %d shy flags",
+		fold ? "fold" : "unfold", (int)subtree, (int)plan.dividers.size(), (int)plan.shy.size());
+	return err;
+}
+
+A_Err DoFoldRecursive(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	// Selected dividers; unfold priority, as for Fold/Unfold of all groups
+	std::vector<AEGP_LayerIDVal> roots;
+	bool anyFolded = false;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+
+			bool folded = false;
+			if (!ProbeDividerState(suites, item.u.layer.layerH, &folded)) continue;
+			AEGP_LayerIDVal id = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerID(item.u.layer.layerH, &id));
+			if (!err) roots.push_back(id);
+			anyFolded = anyFolded || folded;
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || roots.empty()) return err;
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(anyFolded ? "Unfold Recursively" : "Fold Recursively"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	ERR(FoldSubtrees(suites, compH, roots, !anyFolded));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to fold/unfold recursively");
+		return err;
+	}
+
+	// After the undo group, as for Fold/Unfold
+	if (EnsureShyModeEnabled(suites)) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Warning - Could not enable Hide Shy Layers mode. Please enable it manually in the composition panel.");
+	}
+	return err;
+}
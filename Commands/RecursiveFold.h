@@ -0,0 +1,27 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Recursive Fold                                */
+/*      Folds/unfolds groups together with all their sub groups    */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef RECURSIVEFOLD_H
+#define RECURSIVEFOLD_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <vector>
+
+// Set the fold state of each root divider and of every divider it contains,
+// directly or through sub groups, as one plan: one batch of state and name
+// writes and one shy diff. The caller owns the undo group.
+A_Err FoldSubtrees(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+				   const std::vector<AEGP_LayerIDVal>& roots, bool fold);
+
+// "Fold/Unfold Group Recursively" command and Alt+double-click: unfolds the
+// selected groups' trees if any selected group is folded, else folds them
+A_Err DoFoldRecursive(AEGP_SuiteHandler& suites);
+
+#endif // RECURSIVEFOLD_H
@@ -0,0 +1,229 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Remove Group                                  */
+/*      Ungroup, or delete a group with its layers                 */
+/*                                                                 */
+/*******************************************************************/
+
+#include "RemoveGroup.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+#include "Hierarchy/HierarchyRepair.h"
+#include "Hierarchy/ReorderPlan.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+#include <utility>
+
+static LatencyHistogram	S_remove_group_cost;
+
+// Explicit membership: rows no longer list the deleted layers
+static A_Err DropFromRows(AEGP_SuiteHandler& suites, const GroupTree& tree, const std::vector<bool>& deleted,
+						  const std::unordered_set<AEGP_LayerIDVal>& ids)
+{
+	A_Err err = A_Err_NONE;
+
+	for (A_long d = 0; d < tree.Count() && !err; d++) {
+		if (deleted[(size_t)d]) continue;
+
+		std::vector<AEGP_LayerIDVal> row;
+		bool hasRow = false;
+		ERR(ReadGroupMembers(suites, tree.Divider(d).layerH, row, &hasRow));
+		if (err || !hasRow) continue;
+
+		const size_t before = row.size();
+		row.erase(std::remove_if(row.begin(), row.end(),
+			[&ids](AEGP_LayerIDVal id) { return ids.count(id) != 0; }), row.end());
+		if (row.size() != before) ERR(WriteGroupMembers(suites, tree.Divider(d).layerH, row));
+	}
+	return err;
+}
+
+A_Err DoRemoveGroup(AEGP_SuiteHandler& suites, bool withContents)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	// Selected dividers, by index
+	std::vector<A_long> selectedIndices;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+			if (!IsDividerLayer(suites, item.u.layer.layerH)) continue;
+
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &index));
+			if (!err) selectedIndices.push_back(index);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || selectedIndices.empty()) return err;
+
+	const double start = PerfNowSeconds();
+
+	GroupTree tree;
+	RemoveGroupResult result;
+	memset(&result, 0, sizeof(result));
+	std::vector<bool> removed;
+	std::vector<std::pair<A_long, A_long> > ranges;	// Deleted index ranges
+	bool live = false;
+	for (int attempt = 0; attempt < 2 && !live && !err; attempt++) {
+		ERR(ReadGroupTree(suites, compH, tree, &result.indexed, attempt > 0));
+		if (err) return err;
+
+		// removed: group layers that go away. Deleting a group takes every
+		// group inside it along.
+		removed.assign((size_t)tree.Count(), false);
+		ranges.clear();
+		for (size_t s = 0; s < selectedIndices.size(); s++) {
+			const A_long d = tree.AtIndex(selectedIndices[s]);
+			if (d >= 0) removed[(size_t)d] = true;
+		}
+
+		// Layers are deleted and moved by the indices of this tree: each
+		// removed group must still span the layers the tree says, else read
+		// the tree again by scan
+		live = true;
+		for (A_long d = 0; d < tree.Count() && live; d++) {
+			if (removed[(size_t)d]) live = GroupRangeIsLive(suites, compH, tree, d);
+		}
+	}
+	if (err || !live) return err;
+
+	if (withContents) {
+		for (A_long d = 0; d < tree.Count(); d++) {
+			if (!removed[(size_t)d]) continue;
+			if (!ranges.empty() && tree.Divider(d).index < ranges.back().second) continue;
+			ranges.push_back(std::make_pair(tree.Divider(d).index, tree.End(d)));
+		}
+		for (A_long d = 0; d < tree.Count(); d++) {
+			for (size_t r = 0; r < ranges.size() && !removed[(size_t)d]; r++) {
+				removed[(size_t)d] = ranges[r].first <= tree.Divider(d).index && tree.Divider(d).index < ranges[r].second;
+			}
+		}
+	}
+	for (A_long d = 0; d < tree.Count(); d++) {
+		if (removed[(size_t)d]) result.groups++;
+	}
+
+	// Ungroup: new paths for the groups that move up, before anything is written
+	std::vector<std::string> paths;
+	std::vector<std::string> repaired;
+	if (!withContents) {
+		paths.resize((size_t)tree.Count());
+		for (A_long d = 0; d < tree.Count(); d++) {
+			paths[(size_t)d] = GetHierarchyFromHiddenGroup(suites, tree.Divider(d).layerH);
+		}
+		if (!RepairHierarchy(tree, paths, removed, repaired)) {
+			suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level.");
+			return err;
+		}
+	}
+
+	// Handles of every layer to delete, read before any index moves
+	std::vector<AEGP_LayerH> doomed;
+	if (withContents) {
+		for (size_t r = 0; r < ranges.size() && !err; r++) {
+			for (A_long i = ranges[r].first; i < ranges[r].second && !err; i++) {
+				AEGP_LayerH layerH = NULL;
+				ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+				if (!err) doomed.push_back(layerH);
+			}
+		}
+	} else {
+		for (A_long d = 0; d < tree.Count(); d++) {
+			if (removed[(size_t)d]) doomed.push_back(tree.Divider(d).layerH);
+		}
+	}
+	if (err) return err;
+	result.layers = (A_long)doomed.size();
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup(withContents ? "Delete Group with Contents" : "Ungroup"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	// A folded group's layers are shy: unfold it first (outer groups first)
+	// unless a surviving group above keeps them hidden anyway
+	for (A_long d = 0; d < tree.Count() && !err && !withContents; d++) {
+		if (!removed[(size_t)d] || !IsDividerFolded(suites, tree.Divider(d).layerH)) continue;
+		bool hidden = false;
+		for (A_long p = SurvivingGroup(tree, removed, d); p >= 0 && !hidden;
+			 p = SurvivingGroup(tree, removed, tree.Parent(p))) {
+			hidden = IsDividerFolded(suites, tree.Divider(p).layerH);
+		}
+		if (!hidden) ERR(FoldDivider(suites, compH, tree.Divider(d).layerH, tree.Divider(d).index, false));
+	}
+
+	if (!err && S_settings.groupMembership == GroupMembership_Explicit) {
+		std::unordered_set<AEGP_LayerIDVal> ids;
+		for (size_t i = 0; i < doomed.size() && !err; i++) {
+			AEGP_LayerIDVal id = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerID(doomed[i], &id));
+			if (!err) ids.insert(id);
+		}
+		ERR(DropFromRows(suites, tree, removed, ids));
+	}
+
+	for (size_t i = 0; i < doomed.size() && !err; i++) {
+		ERR(suites.LayerSuite9()->AEGP_DeleteLayer(doomed[i]));
+	}
+
+	// Ungroup: direct members stay with the group above, and the groups
+	// that moved up get their new paths (only the ones that changed). The
+	// direct members of an ungrouped top-level group have no group above:
+	// they move to the top of the comp, above the first group, since left
+	// in place they would fall into the group before them.
+	std::vector<ReorderMove> moves;
+	if (!err && !withContents) {
+		std::vector<A_long> order;
+		PlanUngroupOrder(tree, removed, order);
+		PlanReorder(order, moves);
+		ERR(ApplyReorderPlan(suites, compH, moves));
+
+		for (A_long d = 0; d < tree.Count() && !err; d++) {
+			if (removed[(size_t)d] || repaired[(size_t)d] == paths[(size_t)d]) continue;
+			ERR(SetDividerHierarchy(suites, tree.Divider(d).layerH, repaired[(size_t)d]));
+			if (!err) result.relabeled++;
+		}
+	}
+
+	// Deleted group layers must not be served from the index
+	A_long itemId = 0;
+	if (GetCompItemId(suites, compH, &itemId) == A_Err_NONE) S_divider_index.Invalidate(itemId);
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, withContents ?
+			"FoldLayers: Failed to delete the group" : "FoldLayers: Failed to ungroup");
+		return err;
+	}
+
+	result.reorders = (A_long)moves.size();
+
+	S_remove_group_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("%s: %d groups, %d layers deleted, %d relabeled, %d reorders (%s), %s",
+		withContents ? "delete group" : "ungroup", (int)result.groups, (int)result.layers,
+		(int)result.relabeled, (int)result.reorders, result.indexed ? "index" : "scan",
+		S_remove_group_cost.Summary("remove").c_str());
+#endif
+	return err;
+}
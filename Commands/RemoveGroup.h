@@ -0,0 +1,30 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Remove Group                                  */
+/*      Ungroup, or delete a group with its layers                 */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef REMOVEGROUP_H
+#define REMOVEGROUP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/GroupPlans.h"
+#include <vector>
+
+typedef struct {
+	A_long		groups;				// Group layers removed
+	A_long		layers;				// Layers deleted, group layers included
+	A_long		relabeled;			// Group layers whose hierarchy path changed
+	A_long		reorders;			// AEGP_ReorderLayer calls made
+	bool		indexed;			// Structure came from the divider index
+} RemoveGroupResult;
+
+// "Ungroup" (withContents false) / "Delete Group with Contents". Ungrouping
+// a top-level group moves its direct members to the top of the comp.
+A_Err DoRemoveGroup(AEGP_SuiteHandler& suites, bool withContents);
+
+#endif // REMOVEGROUP_H
@@ -0,0 +1,290 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Reveal                                        */
+/*      Unfolds only the groups that hide the selected layers      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "Reveal.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+#include "Hierarchy/FoldOutline.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstring>
+
+static bool DividerBeforeIndex(const IndexedDivider& divider, A_long index)
+{
+	return divider.index < index;
+}
+
+static A_Err ShowLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH layerH, RevealResult* result)
+{
+	A_Err err = A_Err_NONE;
+
+	AEGP_LayerFlags flags = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags));
+	result->layersVisited++;
+	if (!err && (flags & AEGP_LayerFlag_SHY)) {
+		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(layerH, AEGP_LayerFlag_SHY, FALSE));
+		if (!err) {
+			S_fold_history.NoteLayer(suites, compH, layerH, FoldHistory_Shy, false);
+			result->shyChanged++;
+		}
+	}
+	return err;
+}
+
+// Index path: group structure from the divider index, AE calls only for
+// the containing groups and the layers that become visible.
+// *outServed is false (nothing written) when the entry cannot be trusted.
+static A_Err RevealFromIndex(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+							 const std::vector<A_long>& targets, RevealResult* result, bool* outServed)
+{
+	A_Err err = A_Err_NONE;
+	*outServed = false;
+
+	std::vector<IndexedDivider> dividers;
+	bool served = false;
+	ERR(GetIndexedStructure(suites, compH, dividers, &served));
+	if (err || !served) return err;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	// Containing divider and group end of each divider, from depths alone
+	const size_t count = dividers.size();
+	std::vector<A_long> parent(count, -1);
+	std::vector<A_long> groupEnd(count, numLayers);
+	std::vector<A_long> open;
+	for (size_t d = 0; d < count; d++) {
+		while (!open.empty() && dividers[(size_t)open.back()].depth >= dividers[d].depth) {
+			groupEnd[(size_t)open.back()] = dividers[d].index;
+			open.pop_back();
+		}
+		if (!open.empty()) parent[d] = open.back();
+		open.push_back((A_long)d);
+	}
+
+	// Ancestor chains: the nearest divider above a layer contains it (the
+	// divider itself when the target is one, whose chain starts above it)
+	std::vector<bool> inChain(count, false);
+	std::vector<A_long> chain;
+	for (size_t t = 0; t < targets.size(); t++) {
+		std::vector<IndexedDivider>::const_iterator above =
+			std::lower_bound(dividers.begin(), dividers.end(), targets[t] + 1, DividerBeforeIndex);
+		if (above == dividers.begin()) continue;
+
+		A_long d = (A_long)(above - dividers.begin()) - 1;
+		if (dividers[(size_t)d].index == targets[t]) d = parent[(size_t)d];
+		for (; d >= 0 && !inChain[(size_t)d]; d = parent[(size_t)d]) {
+			inChain[(size_t)d] = true;
+			chain.push_back(d);
+		}
+	}
+
+	// Confirm what is about to be written: still this divider at this index
+	std::vector<bool> unfold(count, false);
+	std::vector<A_long> toUnfold;
+	for (size_t c = 0; c < chain.size() && !err; c++) {
+		const IndexedDivider& divider = dividers[(size_t)chain[c]];
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		bool folded = false;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, divider.index, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		if (err || id != divider.id || !ProbeDividerState(suites, layerH, &folded)) return err;
+		if (folded) {
+			unfold[(size_t)chain[c]] = true;
+			toUnfold.push_back(chain[c]);
+		}
+	}
+	if (err) return err;
+	*outServed = true;
+	result->indexed = true;
+	result->chain = (A_long)chain.size();
+	result->unfolded = (A_long)toUnfold.size();
+
+	for (size_t u = 0; u < toUnfold.size() && !err; u++) {
+		const IndexedDivider& divider = dividers[(size_t)toUnfold[u]];
+		ERR(SetDividerFolded(suites, compH, divider.layerH, false));
+		if (!err) S_fold_history.Note(suites, compH, divider.id, FoldHistory_Fold, false);
+	}
+
+	// The outermost unfolded groups, in order: walking their ranges visits
+	// every layer that becomes visible, jumping over folded groups that stay
+	std::vector<A_long> tops;
+	for (size_t u = 0; u < toUnfold.size(); u++) {
+		bool nested = false;
+		for (A_long p = parent[(size_t)toUnfold[u]]; p >= 0 && !nested; p = parent[(size_t)p]) {
+			nested = unfold[(size_t)p];
+		}
+		if (!nested) tops.push_back(toUnfold[u]);
+	}
+	std::sort(tops.begin(), tops.end());
+
+	std::vector<bool> covered(targets.size(), false);
+	for (size_t t = 0; t < tops.size() && !err; t++) {
+		const A_long top = tops[t];
+		size_t next = (size_t)top + 1;
+		A_long i = dividers[(size_t)top].index + 1;
+		while (i < groupEnd[(size_t)top] && !err) {
+			AEGP_LayerH layerH = NULL;
+			ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+			ERR(ShowLayer(suites, compH, layerH, result));
+			if (err) break;
+
+			while (next < count && dividers[next].index < i) next++;
+			if (next < count && dividers[next].index == i && !unfold[next]) {
+				bool folded = false;
+				ProbeDividerState(suites, layerH, &folded);
+				if (folded) {
+					i = groupEnd[next];
+					continue;
+				}
+			}
+			i++;
+		}
+
+		for (size_t g = 0; g < targets.size(); g++) {
+			if (targets[g] > dividers[(size_t)top].index && targets[g] < groupEnd[(size_t)top]) covered[g] = true;
+		}
+	}
+
+	// Targets no folded group was hiding (shy set by hand)
+	for (size_t g = 0; g < targets.size() && !err; g++) {
+		if (covered[g]) continue;
+		AEGP_LayerH layerH = NULL;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, targets[g], &layerH));
+		ERR(ShowLayer(suites, compH, layerH, result));
+	}
+	return err;
+}
+
+// Snapshot path: explicit member rows, or no current index entry
+static A_Err RevealFromSnapshot(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+								const std::vector<A_long>& targets, RevealResult* result)
+{
+	A_Err err = A_Err_NONE;
+
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) return err;
+
+	FoldOutline outline;
+	outline.Build(layers, rows);
+
+	std::vector<bool> mark(layers.size(), false);
+	std::vector<A_long> chain;
+	for (size_t t = 0; t < targets.size(); t++) {
+		if (targets[t] >= 0 && targets[t] < outline.Size()) outline.AddAncestors(targets[t], mark, chain);
+	}
+
+	std::vector<bool> folded(layers.size(), false);
+	for (size_t i = 0; i < layers.size(); i++) folded[i] = layers[i].isDivider && layers[i].folded;
+	for (size_t c = 0; c < chain.size(); c++) {
+		if (!folded[(size_t)chain[c]]) continue;
+		layers[(size_t)chain[c]].target = FoldTarget_Unfold;
+		folded[(size_t)chain[c]] = false;
+		result->unfolded++;
+	}
+	result->chain = (A_long)chain.size();
+
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+
+	// Targets no folded group was hiding (shy set by hand)
+	for (size_t t = 0; t < targets.size(); t++) {
+		const A_long index = targets[t];
+		if (index < 0 || index >= outline.Size() || !layers[(size_t)index].shy) continue;
+
+		bool planned = false;
+		for (size_t s = 0; s < plan.shy.size() && !planned; s++) planned = plan.shy[s].first == index;
+		if (!planned && !outline.Hidden(index, folded)) plan.shy.push_back(std::make_pair(index, false));
+	}
+
+	result->layersVisited = (A_long)layers.size();
+	result->shyChanged = (A_long)plan.shy.size();
+	ERR(ApplyFoldPlan(suites, compH, layers, plan));
+	return err;
+}
+
+A_Err RevealLayers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+				   const std::vector<AEGP_LayerH>& targets, RevealResult* outResult)
+{
+	A_Err err = A_Err_NONE;
+	memset(outResult, 0, sizeof(*outResult));
+
+	std::vector<A_long> indices;
+	for (size_t t = 0; t < targets.size() && !err; t++) {
+		A_long index = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(targets[t], &index));
+		if (!err) indices.push_back(index);
+	}
+	if (err || indices.empty()) return err;
+
+	// Member rows are not in the index; neither are comps it has not seen
+	bool served = false;
+	if (S_settings.groupMembership != GroupMembership_Explicit) {
+		ERR(RevealFromIndex(suites, compH, indices, outResult, &served));
+	}
+	if (!err && !served) {
+		ERR(RevealFromSnapshot(suites, compH, indices, outResult));
+	}
+	return err;
+}
+
+A_Err DoRevealLayers(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	std::vector<AEGP_LayerH> targets;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (!err && item.type == AEGP_CollectionItemType_LAYER) targets.push_back(item.u.layer.layerH);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || targets.empty()) return err;
+
+	const double start = PerfNowSeconds();
+
+	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Reveal Layers"));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to start undo group");
+		return err;
+	}
+
+	RevealResult result;
+	ERR(RevealLayers(suites, compH, targets, &result));
+
+	suites.UtilitySuite6()->AEGP_EndUndoGroup();
+
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to reveal layers");
+		return err;
+	}
+
+	PerfLog("reveal (%s): %d containing groups, %d unfolded, %d layers visited, %d shy flags, %.2f ms",
+		result.indexed ? "index" : "snapshot", (int)result.chain, (int)result.unfolded,
+		(int)result.layersVisited, (int)result.shyChanged, (PerfNowSeconds() - start) * 1e3);
+	return err;
+}
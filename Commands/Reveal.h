@@ -0,0 +1,37 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Reveal                                        */
+/*      Unfolds only the groups that hide the selected layers      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef REVEAL_H
+#define REVEAL_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <vector>
+
+typedef struct {
+	bool		indexed;			// Served from the divider index (no comp scan)
+	A_long		chain;				// Containing groups of the targets
+	A_long		unfolded;			// Of those, the ones that were folded
+	A_long		layersVisited;		// Layers whose shy flag was checked
+	A_long		shyChanged;
+} RevealResult;
+
+// Unfold every folded group containing one of the target layers (which are
+// in compH) and clear the shy flag of the layers that become visible.
+// Sibling groups stay folded. With a current divider index entry and
+// positional membership this costs O(depth + revealed layers) AE calls;
+// otherwise the comp is snapshotted and planned like Fold to Level.
+// The caller owns the undo group.
+A_Err RevealLayers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+				   const std::vector<AEGP_LayerH>& targets, RevealResult* outResult);
+
+// "Reveal Selected Layers" command handler
+A_Err DoRevealLayers(AEGP_SuiteHandler& suites);
+
+#endif // REVEAL_H
@@ -0,0 +1,194 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Select Group                                  */
+/*      Selects the layers of the selected groups in one call      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "SelectGroup.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+#include "Hierarchy/FoldOutline.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstring>
+
+static LatencyHistogram	S_select_group_cost;
+
+static bool DividerBeforeIndex(const IndexedDivider& divider, A_long index)
+{
+	return divider.index < index;
+}
+
+// Live index of a served divider matches what the entry says
+static bool DividerStillAt(AEGP_SuiteHandler& suites, const IndexedDivider& divider)
+{
+	A_long index = -1;
+	return suites.LayerSuite9()->AEGP_GetLayerIndex(divider.layerH, &index) == A_Err_NONE &&
+		index == divider.index;
+}
+
+// Index path: each group is one index range. *outServed is false when a
+// root is not where the entry has a divider, or a divider bounding a range
+// has moved since (the entry is behind).
+static A_Err RangesFromIndex(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<A_long>& roots,
+							 bool nested, std::vector<std::pair<A_long, A_long> >& outRanges, bool* outServed)
+{
+	A_Err err = A_Err_NONE;
+	*outServed = false;
+
+	std::vector<IndexedDivider> dividers;
+	bool served = false;
+	ERR(GetIndexedStructure(suites, compH, dividers, &served));
+	if (err || !served) return err;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	for (size_t r = 0; r < roots.size(); r++) {
+		std::vector<IndexedDivider>::const_iterator it =
+			std::lower_bound(dividers.begin(), dividers.end(), roots[r], DividerBeforeIndex);
+		if (it == dividers.end() || it->index != roots[r] || !DividerStillAt(suites, *it)) return err;
+
+		// Contents stop at the first divider; the subtree at the first one
+		// of the same or a higher level
+		A_long end = numLayers;
+		for (std::vector<IndexedDivider>::const_iterator next = it + 1; next != dividers.end(); ++next) {
+			if (!nested || next->depth <= it->depth) {
+				if (!DividerStillAt(suites, *next)) return err;
+				end = next->index;
+				break;
+			}
+		}
+		outRanges.push_back(std::make_pair(roots[r], end));
+	}
+
+	*outServed = true;
+	return err;
+}
+
+// Snapshot path: member rows, or no current index entry
+static A_Err LayersFromSnapshot(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<A_long>& roots,
+								bool nested, std::vector<AEGP_LayerH>& outLayers)
+{
+	A_Err err = A_Err_NONE;
+
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	ERR(SnapshotCompForPlan(suites, compH, layers, rows));
+	if (err) return err;
+
+	FoldOutline outline;
+	outline.Build(layers, rows);
+
+	std::vector<bool> selected;
+	outline.SelectGroups(roots, nested, selected);
+
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (selected[i]) outLayers.push_back(layers[i].layerH);
+	}
+	return err;
+}
+
+A_Err SelectGroupLayers(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<A_long>& roots,
+						bool nested, SelectGroupResult* outResult)
+{
+	A_Err err = A_Err_NONE;
+	memset(outResult, 0, sizeof(*outResult));
+	outResult->groups = (A_long)roots.size();
+
+	std::vector<AEGP_LayerH> layers;
+	bool served = false;
+	if (S_settings.groupMembership != GroupMembership_Explicit) {
+		std::vector<std::pair<A_long, A_long> > ranges;
+		ERR(RangesFromIndex(suites, compH, roots, nested, ranges, &served));
+
+		if (!err && served) {
+			// Overlapping roots (a group and its sub group) select once
+			std::sort(ranges.begin(), ranges.end());
+			A_long next = 0;
+			for (size_t r = 0; r < ranges.size() && !err; r++) {
+				for (A_long i = std::max(ranges[r].first, next); i < ranges[r].second && !err; i++) {
+					AEGP_LayerH layerH = NULL;
+					ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+					if (!err) layers.push_back(layerH);
+				}
+				next = std::max(next, ranges[r].second);
+			}
+		}
+	}
+	if (!err && !served) {
+		ERR(LayersFromSnapshot(suites, compH, roots, nested, layers));
+	}
+	if (err || layers.empty()) return err;
+	outResult->indexed = served;
+
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CollectionSuite2()->AEGP_NewCollection(S_my_id, &collectionH));
+	for (size_t l = 0; l < layers.size() && !err; l++) {
+		AEGP_CollectionItemV2 item;
+		memset(&item, 0, sizeof(item));
+		item.type = AEGP_CollectionItemType_LAYER;
+		item.u.layer.layerH = layers[l];
+		ERR(suites.CollectionSuite2()->AEGP_CollectionPushBack(collectionH, &item));
+	}
+	ERR(suites.CompSuite11()->AEGP_SetSelection(compH, collectionH));
+	if (collectionH) suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+
+	if (!err) outResult->layers = (A_long)layers.size();
+	return err;
+}
+
+A_Err DoSelectGroup(AEGP_SuiteHandler& suites, bool nested)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_CompH compH = NULL;
+
+	ERR(GetActiveComp(suites, &compH));
+	if (!compH) return A_Err_NONE;
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to get active composition");
+		return err;
+	}
+
+	const double start = PerfNowSeconds();
+
+	// Selected dividers, by index
+	std::vector<A_long> roots;
+	AEGP_Collection2H collectionH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCollectionFromCompSelection(S_my_id, compH, &collectionH));
+	if (!err && collectionH) {
+		A_u_long numSelected = 0;
+		ERR(suites.CollectionSuite2()->AEGP_GetCollectionNumItems(collectionH, &numSelected));
+		for (A_u_long i = 0; i < numSelected && !err; i++) {
+			AEGP_CollectionItemV2 item;
+			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, i, &item));
+			if (err || item.type != AEGP_CollectionItemType_LAYER) continue;
+			if (!IsDividerLayer(suites, item.u.layer.layerH)) continue;
+
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &index));
+			if (!err) roots.push_back(index);
+		}
+		suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+	}
+	if (err || roots.empty()) return err;
+
+	SelectGroupResult result;
+	ERR(SelectGroupLayers(suites, compH, roots, nested, &result));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Failed to select the group layers");
+		return err;
+	}
+
+	S_select_group_cost.Record(PerfNowSeconds() - start);
+#if FOLDLAYERS_PERF_LOG
+	PerfLog("select group%s: %d groups, %d layers (%s), %s", nested ? " with nested" : "",
+		(int)result.groups, (int)result.layers, result.indexed ? "index" : "snapshot",
+		S_select_group_cost.Summary("select").c_str());
+#endif
+	return err;
+}
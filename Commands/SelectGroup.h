@@ -0,0 +1,33 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Select Group                                  */
+/*      Selects the layers of the selected groups in one call      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef SELECTGROUP_H
+#define SELECTGROUP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <vector>
+
+typedef struct {
+	A_long		groups;				// Group layers the selection started from
+	A_long		layers;				// Layers selected, group layers included
+	bool		indexed;			// Extents came from the divider index
+} SelectGroupResult;
+
+// Select each divider in roots (comp indices) with its layers: up to its
+// first sub group, or (nested) its whole subtree. The extents come from the
+// divider index when it is current, else from one snapshot; the selection
+// is replaced with a single collection.
+A_Err SelectGroupLayers(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<A_long>& roots,
+						bool nested, SelectGroupResult* outResult);
+
+// "Select Group Contents" / "Select Group Including Nested Groups"
+A_Err DoSelectGroup(AEGP_SuiteHandler& suites, bool nested);
+
+#endif // SELECTGROUP_H
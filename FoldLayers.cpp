@@ -8,7 +8,7 @@
 /*      Hybrid fold state management:                              */
 /*      - Layer names show visual prefix (▸ folded, ▾ unfolded)    */
 /*      - Fold state stored in hidden stream groups: FD-0 (unfolded)*/
-/*        and FD-1 (folded)                                        */
+/*        and FD-1 (folded), or optionally in an FD-S: layer marker */
 /*      - Hierarchy stored in FD-H: group for nesting             */
 /*      - Visual prefixes update on fold/unfold operations         */
 /*                                                                 */
@@ -21,9 +21,15 @@
 #endif
 #define _CRT_SECURE_NO_WARNINGS
 #include "FoldLayers.h"
+#include "Input/FoldDispatcher.h"
+#include "Cache/LayerIdMap.h"
+#include "Cache/CompChangeDetector.h"
+#include "Cache/DividerIndex.h"
+#include "Cache/DividerPrefetch.h"
 
 #ifdef AE_OS_WIN
 #include <windows.h>
+#include "Platform/WindowsHook.h"
 #endif
 
 #ifdef AE_OS_MAC
@@ -39,16 +45,37 @@ SPBasicSuite		*sP					= NULL;
 // Menu command IDs
 AEGP_Command		S_cmd_create_divider	= 0;
 AEGP_Command		S_cmd_fold_unfold		= 0;
+AEGP_Command		S_cmd_state_in_markers	= 0;
+AEGP_Command		S_cmd_name_prefix		= 0;
+AEGP_Command		S_cmd_null_dividers		= 0;
+AEGP_Command		S_cmd_convert_to_nulls	= 0;
+AEGP_Command		S_cmd_normalize			= 0;
+AEGP_Command		S_cmd_explicit_members	= 0;
+AEGP_Command		S_cmd_batch_fold		= 0;
+AEGP_Command		S_cmd_fold_to_level		= 0;
+AEGP_Command		S_cmd_expand_to_level	= 0;
+AEGP_Command		S_cmd_focus_mode		= 0;
+AEGP_Command		S_cmd_reveal			= 0;
+AEGP_Command		S_cmd_fold_recursive	= 0;
+AEGP_Command		S_cmd_save_layout		= 0;
+AEGP_Command		S_cmd_restore_layout	= 0;
+AEGP_Command		S_cmd_history_back		= 0;
+AEGP_Command		S_cmd_history_forward	= 0;
+AEGP_Command		S_cmd_select_group		= 0;
+AEGP_Command		S_cmd_select_nested		= 0;
+AEGP_Command		S_cmd_move_up			= 0;
+AEGP_Command		S_cmd_move_down			= 0;
+AEGP_Command		S_cmd_move_to			= 0;
+AEGP_Command		S_cmd_group_selection	= 0;
+AEGP_Command		S_cmd_duplicate_group	= 0;
+AEGP_Command		S_cmd_ungroup			= 0;
+AEGP_Command		S_cmd_delete_group		= 0;
 
 #ifdef AE_OS_WIN
 // Windows: Mouse hook for double-click detection
 // Variables are extern in WindowsHook.cpp, so must have external linkage here
 HHOOK			S_mouse_hook			= NULL;
-bool				S_double_click_pending	= false;
 bool				S_suppress_next_action	= false;
-CRITICAL_SECTION	S_cs;
-bool				S_cs_initialized		= false;
-bool				S_is_divider_selected	= false; // Track selection state for hook
 #endif
 
 // Idle hook state
@@ -198,73 +225,256 @@ A_Err FindStreamByMatchName(AEGP_SuiteHandler& suites, AEGP_StreamRefH parentH,
     return *outStreamH ? A_Err_NONE : A_Err_GENERIC;
 }
 
-// Get hierarchy from hidden FD-H: group for rename recovery
-// CRITICAL FIX: Added bounds checking to prevent infinite loops and buffer overflows
-std::string GetHierarchyFromHiddenGroup(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
+//=============================================================================
+// Divider Record I/O
+//=============================================================================
+
+// Get a shape layer's Contents group; caller disposes *outContentsH
+static A_Err GetContentsStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP_StreamRefH* outContentsH)
 {
-    if (!layerH) return "";
+    A_Err err = A_Err_NONE;
+    *outContentsH = NULL;
 
-    // Check layer type
     AEGP_ObjectType layerType;
     if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE || layerType != AEGP_ObjectType_VECTOR) {
-        return "";
+        return A_Err_GENERIC;
     }
 
     AEGP_StreamRefH rootStreamH = NULL;
-    if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(S_my_id, layerH, &rootStreamH) != A_Err_NONE) {
-        return "";
+    ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(S_my_id, layerH, &rootStreamH));
+    if (!err && rootStreamH) {
+        ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", outContentsH));
+        suites.StreamSuite4()->AEGP_DisposeStream(rootStreamH);
+    }
+    return (!err && *outContentsH) ? A_Err_NONE : A_Err_GENERIC;
+}
+
+// ASCII name of a Contents child (FD- names are plugin-written ASCII)
+static bool GetChildName(AEGP_SuiteHandler& suites, AEGP_StreamRefH contentsH, A_long index, std::string& name)
+{
+    bool ok = false;
+    name.clear();
+
+    AEGP_StreamRefH childH = NULL;
+    if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsH, index, &childH) == A_Err_NONE && childH) {
+        AEGP_MemHandle nameH = NULL;
+        if (suites.StreamSuite4()->AEGP_GetStreamName(S_my_id, childH, FALSE, &nameH) == A_Err_NONE && nameH) {
+            void* dataP = NULL;
+            if (suites.MemorySuite1()->AEGP_LockMemHandle(nameH, &dataP) == A_Err_NONE && dataP) {
+                const A_u_short* name16 = (const A_u_short*)dataP;
+                const int MAX_NAME_CHARS = 512;
+                for (int i = 0; name16[i] && i < MAX_NAME_CHARS; i++) {
+                    name += (name16[i] < 0x80) ? (char)name16[i] : '?';
+                }
+                ok = true;
+                suites.MemorySuite1()->AEGP_UnlockMemHandle(nameH);
+            }
+            suites.MemorySuite1()->AEGP_FreeMemHandle(nameH);
+        }
+        suites.StreamSuite4()->AEGP_DisposeStream(childH);
+    }
+    return ok;
+}
+
+// Bare legacy state group name: "FD-0" / "FD-1" (no record fields)
+static bool IsLegacyStateName(const std::string& name)
+{
+    return name.length() == 4 && name.compare(0, 3, DIVIDER_ID_PREFIX) == 0 && (name[3] == '0' || name[3] == '1');
+}
+
+// Any state group name: legacy or record ("FD-0", "FD-1|2|...")
+static bool IsStateGroupName(const std::string& name)
+{
+    return name.length() >= 4 && name.compare(0, 3, DIVIDER_ID_PREFIX) == 0 &&
+           (name[3] == '0' || name[3] == '1') && (name.length() == 4 || name[4] == DIVIDER_RECORD_SEP);
+}
+
+// Legacy FD-H: path anywhere in Contents. Older AddDividerIdentity calls
+// appended extra FD-0 groups, which can push FD-H: past the pinned slots.
+static bool FindLegacyHierarchy(AEGP_SuiteHandler& suites, AEGP_StreamRefH contentsH, std::string* outHierarchy)
+{
+    A_long numStreams = 0;
+    if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsH, &numStreams) != A_Err_NONE) return false;
+
+    std::string name;
+    for (A_long i = 0; i < numStreams; i++) {
+        if (GetChildName(suites, contentsH, i, name) &&
+            name.compare(0, DIVIDER_HIERARCHY_PREFIX_LEN, DIVIDER_HIERARCHY_PREFIX) == 0) {
+            *outHierarchy = name.substr(DIVIDER_HIERARCHY_PREFIX_LEN);
+            return true;
+        }
     }
+    return false;
+}
+
+A_Err ReadDividerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, DividerRecord* outRecord)
+{
+    if (!layerH) return A_Err_STRUCT;
+
+    AEGP_StreamRefH contentsStreamH = NULL;
+    if (GetContentsStream(suites, layerH, &contentsStreamH) != A_Err_NONE) return A_Err_GENERIC;
 
+    A_long numStreams = 0;
+    suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams);
+    if (numStreams > DIVIDER_PINNED_GROUP_COUNT) numStreams = DIVIDER_PINNED_GROUP_COUNT;
+
+    bool haveState = false;
+    bool haveRecord = false;
+    bool folded = true;
     std::string hierarchy;
-    if (rootStreamH) {
-        AEGP_StreamRefH contentsStreamH = NULL;
-        if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH) == A_Err_NONE && contentsStreamH) {
-            A_long numStreams = 0;
-            if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams) == A_Err_NONE) {
-                // CRITICAL FIX: Limit iteration count to prevent excessive processing
-                const A_long MAX_STREAMS_TO_SCAN = 1000;
-                A_long streamsToScan = (numStreams < MAX_STREAMS_TO_SCAN) ? numStreams : MAX_STREAMS_TO_SCAN;
-
-                for (A_long i = 0; i < streamsToScan && hierarchy.empty(); i++) {
-                    AEGP_StreamRefH childH = NULL;
-                    if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, i, &childH) == A_Err_NONE && childH) {
-                        AEGP_MemHandle nameH = NULL;
-                        if (suites.StreamSuite4()->AEGP_GetStreamName(S_my_id, childH, FALSE, &nameH) == A_Err_NONE && nameH) {
-                            void* dataP = NULL;
-                            if (suites.MemorySuite1()->AEGP_LockMemHandle(nameH, &dataP) == A_Err_NONE && dataP) {
-                                const A_u_short* name16 = (const A_u_short*)dataP;
-                                // Check for "FD-H:" prefix (FD-H:xxx)
-                                // CRITICAL FIX: Add bounds checking before array access
-                                if (name16[0] == 'F' && name16[1] == 'D' && name16[2] == '-' &&
-                                    name16[3] == 'H' && name16[4] == ':') {
-                                    // Extract hierarchy after "FD-H:"
-                                    // CRITICAL FIX: Add safety limit to UTF-16 loop
-                                    const int MAX_HIERARCHY_CHARS = 256;  // Reasonable limit
-                                    std::string hierStr;
-                                    int j = 5; // Skip "FD-H:"
-                                    while (name16[j] && j < MAX_HIERARCHY_CHARS + 5) {
-                                        hierStr += (char)name16[j];
-                                        j++;
-                                    }
-                                    // CRITICAL FIX: Only use hierarchy if we found proper termination
-                                    if (!name16[j]) {  // Proper null-termination
-                                        hierarchy = hierStr;
-                                    }
-                                }
-                                suites.MemorySuite1()->AEGP_UnlockMemHandle(nameH);
-                            }
-                            suites.MemorySuite1()->AEGP_FreeMemHandle(nameH);
-                        }
-                        suites.StreamSuite4()->AEGP_DisposeStream(childH);
-                    }
+    std::string name;
+    for (A_long i = 0; i < numStreams && !haveRecord; i++) {
+        if (!GetChildName(suites, contentsStreamH, i, name)) continue;
+
+        if (ParseDividerRecord(name, outRecord)) {
+            haveRecord = true;  // Version 2: everything in one string
+        } else if (!haveState && IsStateGroupName(name)) {
+            haveState = true;   // Legacy, or a record whose checksum failed
+            folded = (name[3] == '1');
+        } else if (name.compare(0, DIVIDER_HIERARCHY_PREFIX_LEN, DIVIDER_HIERARCHY_PREFIX) == 0) {
+            hierarchy = name.substr(DIVIDER_HIERARCHY_PREFIX_LEN);
+        }
+    }
+    // Unnormalized legacy layer: the path may sit behind extra FD-0 groups
+    if (!haveRecord && haveState && hierarchy.empty()) {
+        FindLegacyHierarchy(suites, contentsStreamH, &hierarchy);
+    }
+    suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
+
+    // Records older than the store field: the active store decides, as
+    // for ProbeDividerState
+    if (haveRecord) {
+        if (outRecord->version < DIVIDER_RECORD_VERSION) {
+            outRecord->markerStore = (S_settings.foldStateStore == FoldStateStore_Marker);
+        }
+        return A_Err_NONE;
+    }
+    if (!haveState) return A_Err_GENERIC;
+
+    outRecord->version = 1;
+    outRecord->folded = folded;
+    outRecord->markerStore = (S_settings.foldStateStore == FoldStateStore_Marker);
+    outRecord->groupId = 0;
+    outRecord->hierarchy = hierarchy;
+    return A_Err_NONE;
+}
+
+A_Err WriteDividerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const DividerRecord& record)
+{
+    A_Err err = A_Err_NONE;
+    if (!layerH) return A_Err_STRUCT;
+
+    AEGP_StreamRefH contentsStreamH = NULL;
+    if (GetContentsStream(suites, layerH, &contentsStreamH) != A_Err_NONE) return A_Err_GENERIC;
+
+    // Locate the pinned state group
+    A_long numStreams = 0;
+    ERR(suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams));
+    A_long stateIndex = -1;
+    bool upgrading = true;
+    std::string name;
+    for (A_long i = 0; i < numStreams && i < DIVIDER_PINNED_GROUP_COUNT && stateIndex < 0; i++) {
+        if (GetChildName(suites, contentsStreamH, i, name) && IsStateGroupName(name)) {
+            stateIndex = i;
+            upgrading = !ParseDividerRecord(name, NULL);
+        }
+    }
+
+    AEGP_StreamRefH stateH = NULL;
+    if (!err && stateIndex >= 0) {
+        ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, stateIndex, &stateH));
+    } else if (!err) {
+        ERR(suites.DynamicStreamSuite4()->AEGP_AddStream(S_my_id, contentsStreamH, "ADBE Vector Group", &stateH));
+        if (!err && stateH) {
+            ERR(suites.DynamicStreamSuite4()->AEGP_ReorderStream(stateH, DIVIDER_STATE_GROUP_INDEX));
+        }
+    }
+
+    if (!err && stateH) {
+        DividerRecord toWrite = record;
+        if (!toWrite.groupId) toWrite.groupId = NewDividerGroupId();
+
+        // The upgrade below deletes every FD-H: group: a record written
+        // without a path takes it along first rather than losing it
+        if (upgrading && toWrite.hierarchy.empty()) {
+            FindLegacyHierarchy(suites, contentsStreamH, &toWrite.hierarchy);
+        }
+
+        const std::string text = FormatDividerRecord(toWrite);
+        std::vector<A_UTF16Char> text16(text.begin(), text.end());
+        text16.push_back(0);
+        ERR(suites.DynamicStreamSuite4()->AEGP_SetStreamName(stateH, text16.data()));
+        suites.StreamSuite4()->AEGP_DisposeStream(stateH);
+    }
+
+    // One-time upgrade: drop FD-H: groups and extra bare FD-0/FD-1 groups
+    // (older AddDividerIdentity calls could append several). Full scan, back
+    // to front so deletions don't shift the indices still to visit.
+    if (!err && upgrading) {
+        ERR(suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams));
+        for (A_long i = numStreams - 1; i >= 0 && !err; i--) {
+            if (!GetChildName(suites, contentsStreamH, i, name)) continue;
+            if (IsLegacyStateName(name) || name.compare(0, DIVIDER_HIERARCHY_PREFIX_LEN, DIVIDER_HIERARCHY_PREFIX) == 0) {
+                AEGP_StreamRefH legacyH = NULL;
+                ERR(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, i, &legacyH));
+                if (!err && legacyH) {
+                    ERR(suites.DynamicStreamSuite4()->AEGP_DeleteStream(legacyH));
+                    suites.StreamSuite4()->AEGP_DisposeStream(legacyH);
                 }
             }
-            suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
         }
-        suites.StreamSuite4()->AEGP_DisposeStream(rootStreamH);
     }
 
-    return hierarchy;
+    suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
+    return err;
+}
+
+// Get hierarchy from the divider record (or legacy FD-H: group) for rename recovery
+std::string GetHierarchyFromHiddenGroup(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
+{
+    if (!layerH) return "";
+
+    // Check layer type
+    AEGP_ObjectType layerType;
+    if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE) {
+        return "";
+    }
+    if (layerType != AEGP_ObjectType_VECTOR) {
+        // Null dividers keep their hierarchy in the FD-D: marker
+        std::string nullHierarchy;
+        IsNullDivider(suites, layerH, &nullHierarchy);
+        return nullHierarchy;
+    }
+
+    // Version 2 record, or the legacy FD-H: group
+    DividerRecord record;
+    if (ReadDividerRecord(suites, layerH, &record) != A_Err_NONE) {
+        return "";
+    }
+    return record.hierarchy;
+}
+
+// Null dividers: one flags read rejects every non-null layer, then a short
+// marker scan (no stream tree) confirms the FD-D: record
+bool IsNullDivider(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, std::string* outHierarchy)
+{
+	if (!layerH) return false;
+
+	AEGP_LayerFlags flags = 0;
+	if (suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags) != A_Err_NONE || !(flags & AEGP_LayerFlag_NULL_LAYER)) {
+		return false;
+	}
+
+	AEGP_KeyframeIndex index = -1;
+	std::string record;
+	if (FindLayerMarkerRecord(suites, layerH, DIVIDER_NULL_MARKER_PREFIX, &index, &record) != A_Err_NONE || index < 0) {
+		return false;
+	}
+
+	if (outHierarchy) {
+		*outHierarchy = record.substr(strlen(DIVIDER_NULL_MARKER_PREFIX));
+	}
+	return true;
 }
 
 // Check if layer has specific stream/group "FoldGroupData"
@@ -274,9 +484,12 @@ bool HasDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
     
     // Check layer type: only Vector layers have "ADBE Root Vectors Group"
     AEGP_ObjectType layerType;
-    if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE || layerType != AEGP_ObjectType_VECTOR) {
+    if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE) {
         return false;
     }
+    if (layerType != AEGP_ObjectType_VECTOR) {
+        return IsNullDivider(suites, layerH);
+    }
 	
 	bool hasIdentity = false;
 	
@@ -292,11 +505,12 @@ bool HasDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
 		AEGP_StreamRefH contentsStreamH = NULL;
 		if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH) == A_Err_NONE && contentsStreamH) {
 			
-			// Search inside Contents
-            // Contents usually stores groups directly.
+			// Pinned layout: a divider always has an FD- group at child 0,
+			// so one name read decides (no walk over user shape groups)
 			A_long numStreams = 0;
 			if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams) == A_Err_NONE) {
-				for (A_long i = 0; i < numStreams && !hasIdentity; i++) {
+				if (numStreams > DIVIDER_STATE_GROUP_INDEX + 1) numStreams = DIVIDER_STATE_GROUP_INDEX + 1;
+				for (A_long i = DIVIDER_STATE_GROUP_INDEX; i < numStreams && !hasIdentity; i++) {
 					AEGP_StreamRefH childStreamH = NULL;
 					if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, i, &childStreamH) == A_Err_NONE && childStreamH) {
 						AEGP_StreamGroupingType groupType;
@@ -337,7 +551,7 @@ bool HasDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
 }
 
 // Add identification group to layer
-// If hierarchy is provided, stores it in a separate group "FD-H:xxx" for rename recovery
+// Shape layers get a version 2 record (fold bit, group ID, hierarchy) in one hidden group
 A_Err AddDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const std::string& hierarchy = "")
 {
 	A_Err err = A_Err_NONE;
@@ -345,116 +559,88 @@ A_Err AddDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const st
 
     // Check layer type: only Vector layers have "ADBE Root Vectors Group"
     AEGP_ObjectType layerType;
-    if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE || layerType != AEGP_ObjectType_VECTOR) {
+    if (suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &layerType) != A_Err_NONE) {
         return A_Err_NONE;
     }
+    if (layerType != AEGP_ObjectType_VECTOR) {
+        // Null dividers: identity, hierarchy and fold state all live in markers
+        AEGP_LayerFlags flags = 0;
+        ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags));
+        if (!err && (flags & AEGP_LayerFlag_NULL_LAYER)) {
+            InvalidateIndexedComp(suites, layerH);
+            ERR(WriteLayerMarkerRecord(suites, layerH, DIVIDER_NULL_MARKER_PREFIX, DIVIDER_NULL_MARKER_PREFIX + hierarchy));
+            ERR(WriteLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX, "FD-S:0"));
+        }
+        return err;
+    }
 
-	AEGP_StreamRefH rootStreamH = NULL;
-	// Use DynamicStreamSuite to get layer root
-	err = suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(S_my_id, layerH, &rootStreamH);
+	// The layer table is unchanged, so the comp's index entry would miss it
+	InvalidateIndexedComp(suites, layerH);
+
+	// Re-identifying an existing divider keeps its group ID and fold state
+	// (older builds appended another FD-0 group here on every call)
+	DividerRecord record;
+	if (ReadDividerRecord(suites, layerH, &record) != A_Err_NONE) {
+		record.folded = false;
+		record.markerStore = (S_settings.foldStateStore == FoldStateStore_Marker);
+		record.groupId = 0;
+	}
+	record.version = DIVIDER_RECORD_VERSION;
+	record.hierarchy = hierarchy;
+
+	err = WriteDividerRecord(suites, layerH, record);
 	if (err) {
 		char errBuf[128];
 #ifdef AE_OS_WIN
-		sprintf_s(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to get Layer Stream (Err: %d)", err);
+		sprintf_s(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to write divider record (Err: %d)", err);
 #else
-		snprintf(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to get Layer Stream (Err: %d)", err);
+		snprintf(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to write divider record (Err: %d)", err);
 #endif
 		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, errBuf);
-		return err;
 	}
 
-	if (!err && rootStreamH) {
-        // Get Contents Group safely
-        AEGP_StreamRefH contentsStreamH = NULL;
-        err = suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH);
-
-        if (!err && contentsStreamH) {
-            // 1. Create/Update fold state group "FD-0" (Unfolded)
-            AEGP_StreamRefH newGroupH = NULL;
-            ERR(suites.DynamicStreamSuite4()->AEGP_AddStream(S_my_id, contentsStreamH, "ADBE Vector Group", &newGroupH));
+	return err;
+}
 
-            if (!err && newGroupH) {
-                // Rename it to "FD-0" (Unfolded) using UTF-16
-                A_UTF16Char name16[] = {'F','D','-','0', 0};
-                ERR(suites.DynamicStreamSuite4()->AEGP_SetStreamName(newGroupH, name16));
 
-                suites.StreamSuite4()->AEGP_DisposeStream(newGroupH);
-            } else {
-                suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers Debug: Failed to add stream to Contents");
-            }
+// Move an existing divider to another hierarchy path. Unlike
+// AddDividerIdentity this never touches the fold state (null dividers keep
+// their FD-S: marker); the name follows when name prefixes are synced.
+// freshGroupId gives a copied shape divider a group ID of its own.
+A_Err SetDividerHierarchy(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const std::string& hierarchy, bool freshGroupId)
+{
+	A_Err err = A_Err_NONE;
+	if (!layerH) return A_Err_STRUCT;
 
-            // 2. Create/Update hierarchy group "FD-H:xxx" for rename recovery
-            if (!hierarchy.empty()) {
-                bool foundHierGroup = false;
-                // First, try to find existing hierarchy group
-                A_long numStreams = 0;
-                if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams) == A_Err_NONE) {
-                    for (A_long i = 0; i < numStreams && !foundHierGroup; i++) {
-                        AEGP_StreamRefH childH = NULL;
-                        if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, i, &childH) == A_Err_NONE && childH) {
-                            AEGP_MemHandle nameH = NULL;
-                            if (suites.StreamSuite4()->AEGP_GetStreamName(S_my_id, childH, FALSE, &nameH) == A_Err_NONE && nameH) {
-                                void* dataP = NULL;
-                                if (suites.MemorySuite1()->AEGP_LockMemHandle(nameH, &dataP) == A_Err_NONE && dataP) {
-                                    const A_u_short* name16 = (const A_u_short*)dataP;
-                                    // Check for "FD-H:" prefix
-                                    if (name16[0] == 'F' && name16[1] == 'D' && name16[2] == '-' &&
-                                        name16[3] == 'H' && name16[4] == ':') {
-                                        // Found existing hierarchy group - update it
-                                        std::string newName = "FD-H:" + hierarchy;
-                                        std::vector<A_UTF16Char> newName16;
-                                        for (char c : newName) newName16.push_back(c);
-                                        newName16.push_back(0);
-                                        suites.DynamicStreamSuite4()->AEGP_SetStreamName(childH, newName16.data());
-                                        foundHierGroup = true;
-                                    }
-                                    suites.MemorySuite1()->AEGP_UnlockMemHandle(nameH);
-                                }
-                                suites.MemorySuite1()->AEGP_FreeMemHandle(nameH);
-                            }
-                            if (!foundHierGroup) {
-                                suites.StreamSuite4()->AEGP_DisposeStream(childH);
-                            } else {
-                                suites.StreamSuite4()->AEGP_DisposeStream(childH);
-                            }
-                        }
-                    }
-                }
+	bool folded = false;
+	if (!ProbeDividerState(suites, layerH, &folded)) return A_Err_GENERIC;
 
-                // If not found, create new hierarchy group
-                if (!foundHierGroup) {
-                    AEGP_StreamRefH newHierGroupH = NULL;
-                    ERR(suites.DynamicStreamSuite4()->AEGP_AddStream(S_my_id, contentsStreamH, "ADBE Vector Group", &newHierGroupH));
-                    if (!err && newHierGroupH) {
-                        std::string newName = "FD-H:" + hierarchy;
-                        std::vector<A_UTF16Char> newName16;
-                        for (char c : newName) newName16.push_back(c);
-                        newName16.push_back(0);
-                        ERR(suites.DynamicStreamSuite4()->AEGP_SetStreamName(newHierGroupH, newName16.data()));
-                        suites.StreamSuite4()->AEGP_DisposeStream(newHierGroupH);
-                    }
-                }
-            }
+	InvalidateIndexedComp(suites, layerH);
 
-            suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
-        } else {
-             // If Contents not found, maybe report debug info?
-             char errBuf[128];
-#ifdef AE_OS_WIN
-             sprintf_s(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to find Contents group (Err: %d)", err);
-#else
-             snprintf(errBuf, sizeof(errBuf), "FoldLayers Debug: Failed to find Contents group (Err: %d)", err);
-#endif
-             suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, errBuf);
-        }
+	if (IsNullDivider(suites, layerH)) {
+		ERR(WriteLayerMarkerRecord(suites, layerH, DIVIDER_NULL_MARKER_PREFIX, DIVIDER_NULL_MARKER_PREFIX + hierarchy));
+	} else {
+		DividerRecord record;
+		ERR(ReadDividerRecord(suites, layerH, &record));
+		if (!err) {
+			record.version = DIVIDER_RECORD_VERSION;
+			record.hierarchy = hierarchy;
+			if (freshGroupId) record.groupId = NewDividerGroupId();
+			ERR(WriteDividerRecord(suites, layerH, record));
+		}
+	}
 
-		suites.StreamSuite4()->AEGP_DisposeStream(rootStreamH);
+	if (!err && S_settings.syncNamePrefix) {
+		std::string currentName;
+		ERR(GetLayerNameStr(suites, layerH, currentName));
+		if (!err) {
+			ERR(SetLayerNameStr(suites, layerH, BuildDividerName(folded, hierarchy, GetDividerName(currentName))));
+		}
 	}
 
 	return err;
 }
 
-
 // Check if layer is a group divider
 // Only layers with FD- identity (hidden stream groups) are recognized as groups
 // This ensures only layers created by this plugin can be folded/unfolded
@@ -479,10 +665,13 @@ bool IsDividerLayerWithKnownName(AEGP_SuiteHandler& suites, AEGP_LayerH layerH,
 // State Management via Hidden Streams
 // ----------------------------------------------------------------------------
 
-A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP_StreamRefH* outStreamH, bool* outIsFolded)
+A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP_StreamRefH* outStreamH, bool* outIsFolded,
+                             bool* outMarkerStore)
 {
     *outStreamH = NULL;
     if (outIsFolded) *outIsFolded = true; // Default to folded if found (legacy support)
+    // Records without a store field (version 1 and 2) follow the active store
+    if (outMarkerStore) *outMarkerStore = (S_settings.foldStateStore == FoldStateStore_Marker);
     
     // Check layer type: only Vector layers have "ADBE Root Vectors Group"
     AEGP_ObjectType layerType;
@@ -499,6 +688,9 @@ A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP
         if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH) == A_Err_NONE && contentsStreamH) {
              A_long numStreams = 0;
              if (suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(contentsStreamH, &numStreams) == A_Err_NONE) {
+                 // Pinned layout: the state group is at index 0 (FD-H: may precede it
+                 // only in layouts NormalizeDividerLayout has not fixed yet)
+                 if (numStreams > DIVIDER_PINNED_GROUP_COUNT) numStreams = DIVIDER_PINNED_GROUP_COUNT;
                  for (A_long i = 0; i < numStreams && !*outStreamH; i++) {
                      AEGP_StreamRefH childStreamH = NULL;
                      if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(S_my_id, contentsStreamH, i, &childStreamH) == A_Err_NONE && childStreamH) {
@@ -514,6 +706,10 @@ A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP
                                          match = false; break;
                                      }
                                  }
+                                 // State group only: never treat FD-H: as FD-0/FD-1
+                                 if (match && name16[3] == (A_u_short)'H') {
+                                     match = false;
+                                 }
                                  if (match) {
                                      *outStreamH = childStreamH; 
                                      if (outIsFolded) {
@@ -522,6 +718,18 @@ A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP
                                              *outIsFolded = false;
                                          }
                                      }
+                                     // Record (not legacy FD-0/FD-1): where the state lives
+                                     if (outMarkerStore && name16[3] && name16[4] == (A_u_short)DIVIDER_RECORD_SEP) {
+                                         std::string name;
+                                         const int MAX_NAME_CHARS = 512;
+                                         for (int k = 0; name16[k] && k < MAX_NAME_CHARS; k++) {
+                                             name += (name16[k] < 0x80) ? (char)name16[k] : '?';
+                                         }
+                                         DividerRecord record;
+                                         if (ParseDividerRecord(name, &record) && record.version == DIVIDER_RECORD_VERSION) {
+                                             *outMarkerStore = record.markerStore;
+                                         }
+                                     }
                                  }
                                  suites.MemorySuite1()->AEGP_UnlockMemHandle(nameH);
                              }
@@ -540,41 +748,59 @@ A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP
     return *outStreamH ? A_Err_NONE : A_Err_GENERIC;
 }
 
+bool GetMarkerFoldState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outFolded)
+{
+    AEGP_KeyframeIndex index = -1;
+    std::string record;
+    if (FindLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX, &index, &record) != A_Err_NONE || index < 0) {
+        return false;
+    }
+    // "FD-S:1" = folded, anything else = unfolded
+    if (outFolded) {
+        *outFolded = (record.size() > strlen(DIVIDER_STATE_MARKER_PREFIX) &&
+                      record[strlen(DIVIDER_STATE_MARKER_PREFIX)] == '1');
+    }
+    return true;
+}
+
 A_Err SetGroupState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool setFolded)
 {
+    // Null dividers only have the layer marker
+    if (IsNullDivider(suites, layerH)) {
+        return WriteLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX, setFolded ? "FD-S:1" : "FD-S:0");
+    }
+
     A_Err err = A_Err_NONE;
-    AEGP_StreamRefH groupDataH = NULL;
-    GetFoldGroupDataStream(suites, layerH, &groupDataH);
-    
-    AEGP_StreamRefH targetStreamH = groupDataH;
-    
-    if (!targetStreamH) {
-        // Create FoldGroupData if not exists
-        AEGP_StreamRefH rootStreamH = NULL;
-        if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(S_my_id, layerH, &rootStreamH) == A_Err_NONE) {
-             AEGP_StreamRefH contentsStreamH = NULL;
-             if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(S_my_id, rootStreamH, "ADBE Root Vectors Group", &contentsStreamH) == A_Err_NONE) {
-                 AEGP_StreamRefH newGroupH = NULL;
-                 ERR(suites.DynamicStreamSuite4()->AEGP_AddStream(S_my_id, contentsStreamH, "ADBE Vector Group", &newGroupH));
-                 if (!err && newGroupH) {
-                     targetStreamH = newGroupH;
-                 }
-                 suites.StreamSuite4()->AEGP_DisposeStream(contentsStreamH);
-             }
-             suites.StreamSuite4()->AEGP_DisposeStream(rootStreamH);
-        }
+
+    // Lazy migration: legacy FD-0/FD-1 + FD-H: layers and version 2
+    // records become a current record on their first state write
+    DividerRecord record;
+    if (ReadDividerRecord(suites, layerH, &record) != A_Err_NONE) {
+        record.version = 1;
+        record.markerStore = false;
+        record.groupId = 0;
+        record.hierarchy.clear();
     }
-    
-    if (targetStreamH) {
-        // Set Name based on state
-        if (setFolded) {
-             A_UTF16Char name16[] = {'F','D','-','1', 0};
-             ERR(suites.DynamicStreamSuite4()->AEGP_SetStreamName(targetStreamH, name16));
-        } else {
-             A_UTF16Char name16[] = {'F','D','-','0', 0};
-             ERR(suites.DynamicStreamSuite4()->AEGP_SetStreamName(targetStreamH, name16));
+
+    // Marker store: only the layer marker changes. Contents are written
+    // once, to note the store in the record (a divider from a project
+    // saved with the contents store, or not migrated yet).
+    if (S_settings.foldStateStore == FoldStateStore_Marker) {
+        ERR(WriteLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX, setFolded ? "FD-S:1" : "FD-S:0"));
+        if (!err && (!record.markerStore || record.version < DIVIDER_RECORD_VERSION)) {
+            record.markerStore = true;
+            ERR(WriteDividerRecord(suites, layerH, record));
         }
-        suites.StreamSuite4()->AEGP_DisposeStream(targetStreamH);
+        return err;
+    }
+
+    record.folded = setFolded;
+    record.markerStore = false;
+    ERR(WriteDividerRecord(suites, layerH, record));
+
+    // A stale marker would be taken over by the next move to the marker store
+    if (!err) {
+        RemoveLayerMarkerRecord(suites, layerH, DIVIDER_STATE_MARKER_PREFIX);
     }
     
     return err;
@@ -582,16 +808,12 @@ A_Err SetGroupState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool setFolde
 
 A_Err SyncLayerName(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
 {
-    // Sync layer name with current fold state from FD-0/FD-1
+    // Sync layer name with current fold state (FD-S: marker or FD-0/FD-1)
     // This function can be used to recover visual prefix if layer name was manually edited
     A_Err err = A_Err_NONE;
 
-    // Get current fold state from hidden stream
-    AEGP_StreamRefH dataH = NULL;
     bool isFolded = true;
-    if (GetFoldGroupDataStream(suites, layerH, &dataH, &isFolded) == A_Err_NONE && dataH) {
-        suites.StreamSuite4()->AEGP_DisposeStream(dataH);
-
+    if (ProbeDividerState(suites, layerH, &isFolded)) {
         // Get current name and strip existing prefix
         std::string currentName;
         ERR(GetLayerNameStr(suites, layerH, currentName));
@@ -605,16 +827,43 @@ A_Err SyncLayerName(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
     return err;
 }
 
-bool IsDividerFolded(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
+bool ProbeDividerState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outFolded)
 {
-    // Pure ID-based: only check FD-0/FD-1 state, no name fallback
+    // Shape dividers: the FD- state stream doubles as the identity check,
+    // and its record says whether the FD-S: marker holds the state (set by
+    // the marker store on whichever machine wrote it). The marker scan
+    // reads every marker comment, so it is skipped for contents records.
     AEGP_StreamRefH dataH = NULL;
-    bool folded = true;  // Default to folded for safety
-    if (GetFoldGroupDataStream(suites, layerH, &dataH, &folded) == A_Err_NONE && dataH) {
+    bool folded = true;
+    bool markerStore = false;
+    if (GetFoldGroupDataStream(suites, layerH, &dataH, &folded, &markerStore) == A_Err_NONE && dataH) {
         suites.StreamSuite4()->AEGP_DisposeStream(dataH);
+        if (markerStore) {
+            GetMarkerFoldState(suites, layerH, &folded);
+        }
+        if (outFolded) *outFolded = folded;
+        return true;
+    }
+
+    // Null dividers: state only in the FD-S: marker (created unfolded)
+    if (IsNullDivider(suites, layerH)) {
+        folded = false;
+        GetMarkerFoldState(suites, layerH, &folded);
+        if (outFolded) *outFolded = folded;
+        return true;
+    }
+
+    return false;
+}
+
+bool IsDividerFolded(AEGP_SuiteHandler& suites, AEGP_LayerH layerH)
+{
+    // Pure ID-based (see ProbeDividerState), no name fallback
+    bool folded = true;  // Default to folded for safety
+    if (ProbeDividerState(suites, layerH, &folded)) {
         return folded;
     }
-    // No FD data stream found - default to folded state
+    // No divider identity found - default to folded state
     return true;
 }
 
@@ -648,6 +897,36 @@ A_Err GetActiveComp(AEGP_SuiteHandler& suites, AEGP_CompH* compH)
 	return err;
 }
 
+A_Err GetProjectComps(AEGP_SuiteHandler& suites, std::vector<AEGP_CompH>& comps)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_ProjectH projH = NULL;
+
+	ERR(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projH));
+	if (err || !projH) return err;
+
+	AEGP_ItemH itemH = NULL;
+	ERR(suites.ItemSuite9()->AEGP_GetFirstProjItem(projH, &itemH));
+
+	while (!err && itemH) {
+		AEGP_ItemType itemType = AEGP_ItemType_NONE;
+		ERR(suites.ItemSuite9()->AEGP_GetItemType(itemH, &itemType));
+		if (!err && itemType == AEGP_ItemType_COMP) {
+			AEGP_CompH compH = NULL;
+			ERR(suites.CompSuite11()->AEGP_GetCompFromItem(itemH, &compH));
+			if (!err && compH) {
+				comps.push_back(compH);
+			}
+		}
+
+		AEGP_ItemH nextH = NULL;
+		ERR(suites.ItemSuite9()->AEGP_GetNextProjItem(projH, itemH, &nextH));
+		itemH = nextH;
+	}
+
+	return err;
+}
+
 // Get layers that belong to this divider's group
 // Considers hierarchy - stops at same or higher level divider
 // Pure ID-based: uses FD-H: group for hierarchy information
@@ -723,17 +1002,30 @@ A_Err FoldDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 		return stateErr;
 	}
 
-	// Update layer name to show visual fold state (▸ for folded, ▾ for unfolded)
-	std::string currentName;
-	ERR(GetLayerNameStr(suites, dividerLayer, currentName));
-	std::string baseName = GetDividerName(currentName); // Strip existing prefix if any
-	std::string originalName = currentName; // Store for rollback
-	std::string newName = BuildDividerName(fold, hierarchy, baseName); // Include hierarchy in name
-	ERR(SetLayerNameStr(suites, dividerLayer, newName));
+	// Update layer name to show visual fold state (▸ for folded, ▾ for unfolded).
+	// Optional: renaming is an edit to the layer, so render-cache-sensitive
+	// setups can turn it off and keep the marker store fully non-renderable.
+	std::string originalName; // Store for rollback
+	const bool renameLayer = S_settings.syncNamePrefix;
+	if (renameLayer) {
+		std::string currentName;
+		ERR(GetLayerNameStr(suites, dividerLayer, currentName));
+		std::string baseName = GetDividerName(currentName); // Strip existing prefix if any
+		originalName = currentName;
+		std::string newName = BuildDividerName(fold, hierarchy, baseName); // Include hierarchy in name
+		ERR(SetLayerNameStr(suites, dividerLayer, newName));
+	}
 
-	// Get group layers
+	// Get group layers: the divider's member row in explicit mode (no scan),
+	// otherwise (or for dividers without a row) by position
 	std::vector<AEGP_LayerH> groupLayers;
-	ERR(GetGroupLayers(suites, compH, dividerIndex, hierarchy, groupLayers));
+	bool explicitMembers = false;
+	if (S_settings.groupMembership == GroupMembership_Explicit) {
+		ERR(ResolveGroupMembers(suites, compH, dividerLayer, groupLayers, &explicitMembers));
+	}
+	if (!err && !explicitMembers) {
+		ERR(GetGroupLayers(suites, compH, dividerIndex, hierarchy, groupLayers));
+	}
 	if (err) {
 		// Failed to get group layers - rollback state
 		SetGroupState(suites, dividerLayer, !fold);
@@ -744,6 +1036,9 @@ A_Err FoldDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 	// Track modified layers for rollback
 	std::vector<AEGP_LayerH> modifiedLayers;
 	std::vector<A_Boolean> originalShyStates;
+	// Shy flag before (-1: unknown) and after, by groupLayers index, for the fold history
+	std::vector<signed char> shyBefore(groupLayers.size(), -1);
+	std::vector<signed char> shyAfter(groupLayers.size(), -1);
 
 	// Store original shy states for rollback
 	for (size_t i = 0; i < groupLayers.size(); i++) {
@@ -754,14 +1049,27 @@ A_Err FoldDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 				A_Boolean shyFlag = (flags & AEGP_LayerFlag_SHY) != 0;
 				modifiedLayers.push_back(subLayer);
 				originalShyStates.push_back(shyFlag);
+				shyBefore[i] = shyFlag ? 1 : 0;
 			}
 		}
 	}
 
+	// Explicit members: unfolding keeps the members of folded nested groups
+	// hidden, looked up through their own rows rather than by position
+	std::unordered_set<AEGP_LayerH> keepHidden;
+	if (explicitMembers && !fold) {
+		ERR(CollectFoldedNestedMembers(suites, compH, groupLayers, keepHidden));
+	}
+	for (size_t i = 0; explicitMembers && i < groupLayers.size() && !err; i++) {
+		const bool shouldHide = fold || keepHidden.count(groupLayers[i]) > 0;
+		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(groupLayers[i], AEGP_LayerFlag_SHY, shouldHide ? TRUE : FALSE));
+		shyAfter[i] = shouldHide ? 1 : 0;
+	}
+
 	// Apply fold/unfold to group layers
 	int skipUntilDepth = -1; // -1 means do not skip
 
-	for (size_t i = 0; i < groupLayers.size() && !err; i++) {
+	for (size_t i = 0; !explicitMembers && i < groupLayers.size() && !err; i++) {
 		AEGP_LayerH subLayer = groupLayers[i];
 
 		std::string subName;
@@ -809,6 +1117,7 @@ A_Err FoldDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 		}
 
 		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(subLayer, AEGP_LayerFlag_SHY, shouldHide ? TRUE : FALSE));
+		shyAfter[i] = shouldHide ? 1 : 0;
 	}
 
 	// If error occurred, rollback all changes
@@ -821,8 +1130,18 @@ A_Err FoldDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 		}
 		// Rollback state and layer name
 		SetGroupState(suites, dividerLayer, !fold);
-		SetLayerNameStr(suites, dividerLayer, originalName); // Restore original name
+		if (renameLayer) {
+			SetLayerNameStr(suites, dividerLayer, originalName); // Restore original name
+		}
 		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Error during fold/unfold - all changes rolled back.");
+	} else {
+		NoteIndexedFold(suites, compH, dividerLayer, fold);
+
+		S_fold_history.NoteLayer(suites, compH, dividerLayer, FoldHistory_Fold, fold);
+		for (size_t i = 0; i < groupLayers.size(); i++) {
+			if (shyAfter[i] < 0 || shyBefore[i] < 0 || shyAfter[i] == shyBefore[i]) continue;
+			S_fold_history.NoteLayer(suites, compH, groupLayers[i], FoldHistory_Shy, shyAfter[i] != 0);
+		}
 	}
 
 	return err;
@@ -849,16 +1168,34 @@ A_Err GetAllDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 	A_Err err = A_Err_NONE;
 	A_long numLayers = 0;
 
+	// Warm start: the persisted index skips the identity scan while the
+	// comp's layer table still matches its fingerprint
+	bool served = false;
+	ERR(GetIndexedDividers(suites, compH, dividers, &served));
+	if (err || served) return err;
+
 	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
 
+	std::vector<AEGP_LayerIDVal> layerIds;
+	std::vector<std::pair<AEGP_LayerH, A_long> > found;
+	layerIds.reserve((size_t)numLayers);
 	for (A_long i = 0; i < numLayers && !err; i++) {
 		AEGP_LayerH layer = NULL;
+		AEGP_LayerIDVal id = 0;
 		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layer));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layer, &id));
+		layerIds.push_back(id);
 		if (!err && layer && IsDividerLayer(suites, layer)) {
-			dividers.push_back(std::make_pair(layer, i));
+			found.push_back(std::make_pair(layer, i));
 		}
 	}
 
+	// Rebuild this comp's entry from the scan
+	if (!err) {
+		ERR(RecordIndexedDividers(suites, compH, layerIds, found));
+		dividers.insert(dividers.end(), found.begin(), found.end());
+	}
+
 	return err;
 }
 
@@ -961,6 +1298,63 @@ A_Err ToggleAllDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH)
 // Command Handlers
 //=============================================================================
 
+// Create an unfolded divider layer for hierarchy at index: a SHAPE layer,
+// or a NULL layer in null divider mode (no Contents tree). The caller owns
+// the undo group.
+A_Err CreateDividerLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::string& hierarchy,
+						 A_long index, AEGP_LayerH* outLayerH)
+{
+	A_Err err = A_Err_NONE;
+	*outLayerH = NULL;
+
+	AEGP_LayerH newLayer = NULL;
+	const bool nullDivider = (S_settings.dividerLayerType == DividerLayer_Null);
+	if (nullDivider) {
+		A_UTF16Char nullName16[] = {'G','r','o','u','p', 0};
+		ERR(suites.CompSuite11()->AEGP_CreateNullLayerInComp(nullName16, compH, NULL, &newLayer));
+	} else {
+		ERR(suites.CompSuite11()->AEGP_CreateVectorLayerInComp(compH, &newLayer));
+	}
+	if (err || !newLayer) return err;
+
+	// Set layer name with prefix to show unfolded state and hierarchy
+	// New groups are always created in unfolded state
+	// Include parent hierarchy if present (e.g., "▾(1/A) Group" for nested groups)
+	std::string dividerName = BuildDividerName(false, hierarchy, "Group");
+	ERR(SetLayerNameStr(suites, newLayer, dividerName));
+	if (err) return err;
+
+	ERR(suites.LayerSuite9()->AEGP_ReorderLayer(newLayer, index));
+	if (err) return err;
+
+	// CRITICAL FIX: After reorder operation, verify handle is still valid
+	// by attempting a basic operation. If it fails, we need to report an error.
+	AEGP_LayerFlags flags;
+	A_Err verifyErr = suites.LayerSuite9()->AEGP_GetLayerFlags(newLayer, &flags);
+	(void)flags; // Suppress unused variable warning
+	if (verifyErr) {
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Layer handle became invalid after reorder - operation failed.");
+		return verifyErr;
+	}
+
+	// Set VIDEO OFF (invisible)
+	ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(newLayer, AEGP_LayerFlag_VIDEO_ACTIVE, FALSE));
+
+	// Null dividers are also guide layers so they never reach a render
+	if (nullDivider) {
+		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(newLayer, AEGP_LayerFlag_GUIDE_LAYER, TRUE));
+	}
+
+	// Set label to 0 (None)
+	ERR(suites.LayerSuite9()->AEGP_SetLayerLabel(newLayer, 0));
+
+	// Add identity group with hierarchy info
+	ERR(AddDividerIdentity(suites, newLayer, hierarchy));
+
+	*outLayerH = newLayer;
+	return err;
+}
+
 A_Err DoCreateDivider(AEGP_SuiteHandler& suites)
 {
 	A_Err err = A_Err_NONE;
@@ -975,6 +1369,7 @@ A_Err DoCreateDivider(AEGP_SuiteHandler& suites)
 	// If nothing is selected, create at the very top (index 0).
 	// This matches the "apply to all" intention when no layer is selected.
 	A_long insertIndex = -1;
+	AEGP_LayerH anchorLayer = NULL;
 	std::string parentHierarchy = "";
 	
 	// Find insert position and parent hierarchy
@@ -990,6 +1385,7 @@ A_Err DoCreateDivider(AEGP_SuiteHandler& suites)
 			ERR(suites.CollectionSuite2()->AEGP_GetCollectionItemByIndex(collectionH, 0, &item));
 			if (!err && item.type == AEGP_CollectionItemType_LAYER) {
 				ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(item.u.layer.layerH, &insertIndex));
+				anchorLayer = item.u.layer.layerH;
 				
 				// Check if selected layer is a divider - if so, nest under it
 				if (!err && IsDividerLayer(suites, item.u.layer.layerH)) {
@@ -1017,83 +1413,23 @@ A_Err DoCreateDivider(AEGP_SuiteHandler& suites)
 						return A_Err_NONE;
 					}
 
-					// Find next available sub-level
-					// Count existing children at this level
+					// Next free sub-level label. Counting the existing children
+					// gave a label already in use once a sibling was deleted or
+					// ungrouped; the smallest free one fills such gaps instead.
 					std::vector<std::pair<AEGP_LayerH, A_long> > allDividers;
 					ERR(GetAllDividers(suites, compH, allDividers));
 
-					int childCount = 0;
-					std::string prefix = selHierarchy.empty() ? "" : selHierarchy + "/";
-
+					std::unordered_set<std::string> usedHierarchies;
 					for (auto& div : allDividers) {
-						// Pure ID-based: get hierarchy from FD-H: group, not from name
-						std::string divHier = GetHierarchyFromHiddenGroup(suites, div.first);
-						// Check if it's a direct child
-						if (!prefix.empty() && divHier.length() >= prefix.length() && divHier.substr(0, prefix.length()) == prefix) {
-							// Count only direct children (no additional /)
-							std::string remainder = divHier.substr(prefix.length());
-							if (remainder.find('/') == std::string::npos) {
-								childCount++;
-							}
-						} else if (prefix.empty() && !divHier.empty() && divHier.find('/') == std::string::npos) {
-							childCount++;
-						}
+						// Pure ID-based: get hierarchy from the divider record, not from name
+						usedHierarchies.insert(GetHierarchyFromHiddenGroup(suites, div.first));
 					}
 
-					// Build new hierarchy with overflow checks
-					childCount++;  // Next number
-					if (selHierarchy.empty()) {
-						// Check for integer overflow
-						if (childCount > 999) {
-							suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level.");
-							suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-							return A_Err_NONE;
-						}
-						parentHierarchy = std::to_string(childCount);
-					} else {
-						// Use letters for deeper nesting: 1, 1/A, 1/A/a, 1/A/a/i...
-						int depth = GetHierarchyDepth(selHierarchy);
-						if (depth < 0) {
-							suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Invalid hierarchy depth detected.");
-							suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-							return A_Err_NONE;
-						}
-
-						char nextChar;
-						if (depth == 0) {
-							// Numeric level (0-9)
-							if (childCount > 9) {
-								suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level (max 9).");
-								suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-								return A_Err_NONE;
-							}
-							nextChar = '0' + childCount;
-						} else if (depth == 1) {
-							// Uppercase letters (A-Z)
-							if (childCount > 26) {
-								suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level (max 26).");
-								suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-								return A_Err_NONE;
-							}
-							nextChar = 'A' + (childCount - 1);
-						} else if (depth == 2) {
-							// Lowercase letters (a-z)
-							if (childCount > 26) {
-								suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level (max 26).");
-								suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-								return A_Err_NONE;
-							}
-							nextChar = 'a' + (childCount - 1);
-						} else {
-							// i, ii, iii style approximation (limited to 20)
-							if (childCount > 20) {
-								suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level (max 20).");
-								suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
-								return A_Err_NONE;
-							}
-							nextChar = 'i' + (childCount - 1);
-						}
-						parentHierarchy = selHierarchy + "/" + nextChar;
+					parentHierarchy = FreeChildHierarchy(selHierarchy, usedHierarchies);
+					if (parentHierarchy.empty()) {
+						suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Too many groups at this level.");
+						suites.CollectionSuite2()->AEGP_DisposeCollection(collectionH);
+						return A_Err_NONE;
 					}
 				}
 			}
@@ -1105,51 +1441,21 @@ A_Err DoCreateDivider(AEGP_SuiteHandler& suites)
 	
 	ERR(suites.UtilitySuite6()->AEGP_StartUndoGroup("Create Group Layer"));
 
-	// Create SHAPE layer
+	// Move to insert position.
+	// - If a layer is selected: place the divider directly below it.
+	// - If nothing is selected: place the divider at the top (index 0).
+	// Note: This project treats layer indices as 0-based (see GetCompLayerByIndex loops).
+	const A_long targetIndex = (insertIndex >= 0) ? (insertIndex + 1) : 0;
 	AEGP_LayerH newLayer = NULL;
-	ERR(suites.CompSuite11()->AEGP_CreateVectorLayerInComp(compH, &newLayer));
-
-	if (!err && newLayer) {
-		// Set layer name with prefix to show unfolded state and hierarchy
-		// New groups are always created in unfolded state
-		// Include parent hierarchy if present (e.g., "▾(1/A) Group" for nested groups)
-		std::string dividerName = BuildDividerName(false, parentHierarchy, "Group");
-		ERR(SetLayerNameStr(suites, newLayer, dividerName));
-		if (err) {
-			suites.UtilitySuite6()->AEGP_EndUndoGroup();
-			return err;
-		}
-
-		// Move to insert position.
-		// - If a layer is selected: place the divider directly below it.
-		// - If nothing is selected: place the divider at the top (index 0).
-		// Note: This project treats layer indices as 0-based (see GetCompLayerByIndex loops).
-		const A_long targetIndex = (insertIndex >= 0) ? (insertIndex + 1) : 0;
-		ERR(suites.LayerSuite9()->AEGP_ReorderLayer(newLayer, targetIndex));
-		if (err) {
-			suites.UtilitySuite6()->AEGP_EndUndoGroup();
-			return err;
-		}
-
-		// CRITICAL FIX: After reorder operation, verify handle is still valid
-		// by attempting a basic operation. If it fails, we need to report an error.
-		AEGP_LayerFlags flags;
-		A_Err verifyErr = suites.LayerSuite9()->AEGP_GetLayerFlags(newLayer, &flags);
-		(void)flags; // Suppress unused variable warning
-		if (verifyErr) {
-			suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, "FoldLayers: Layer handle became invalid after reorder - operation failed.");
-			suites.UtilitySuite6()->AEGP_EndUndoGroup();
-			return verifyErr;
-		}
-
-		// Set VIDEO OFF (invisible)
-		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(newLayer, AEGP_LayerFlag_VIDEO_ACTIVE, FALSE));
-
-		// Set label to 0 (None)
-		ERR(suites.LayerSuite9()->AEGP_SetLayerLabel(newLayer, 0));
+	ERR(CreateDividerLayer(suites, compH, parentHierarchy, targetIndex, &newLayer));
+	if (err) {
+		suites.UtilitySuite6()->AEGP_EndUndoGroup();
+		return err;
+	}
 
-		// Add identity group with hierarchy info
-		ERR(AddDividerIdentity(suites, newLayer, parentHierarchy));
+	// Explicit membership: the new group takes over its positional members
+	if (newLayer && S_settings.groupMembership == GroupMembership_Explicit) {
+		ERR(AdoptNewDivider(suites, compH, anchorLayer, newLayer, parentHierarchy));
 	}
 
 	ERR(suites.UtilitySuite6()->AEGP_EndUndoGroup());
@@ -1270,28 +1576,7 @@ A_Err DoFoldUnfold(AEGP_SuiteHandler& suites)
 
 #ifdef AE_OS_WIN
 
-// Forward declaration
-A_Err ProcessDoubleClick();
-
-static LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam)
-{
-	if (nCode >= 0 && wParam == WM_LBUTTONDBLCLK) {
-		// Only suppress if we believe a divider is selected
-		bool should_suppress = false;
-		
-		EnterCriticalSection(&S_cs);
-		if (S_is_divider_selected) {
-			S_double_click_pending = true;
-			should_suppress = true;
-		}
-		LeaveCriticalSection(&S_cs);
-		
-		if (should_suppress) {
-			return 1; // Block message -> No sound!
-		}
-	}
-	return CallNextHookEx(S_mouse_hook, nCode, wParam, lParam);
-}
+// MouseProc lives in Platform/WindowsHook.cpp and publishes through S_input_channel
 
 A_Err ProcessDoubleClick()
 {
@@ -1341,6 +1626,38 @@ A_Err ProcessDoubleClick()
 // Idle Hook - Process pending double-clicks
 //=============================================================================
 
+// Runs on the main thread for each recognized double-click, either straight
+// from the platform wake (timer / run loop source) or from IdleHook.
+// The selection is re-checked here: the hook only saw the published snapshot.
+static bool HandleFoldIntent(void* refcon, const FoldIntent& intent)
+{
+	(void)refcon;   // Unused parameter
+
+	AEGP_SuiteHandler suites(sP);
+	S_layer_id_map.BeginResolveBatch();
+
+	AEGP_CompH compH = NULL;
+	if (GetActiveComp(suites, &compH) != A_Err_NONE || !compH) {
+		return false;
+	}
+
+	bool dividerSelected = false;
+	if (IsDividerSelected(suites, compH, &dividerSelected) != A_Err_NONE || !dividerSelected) {
+		return false;
+	}
+
+	// Alt+double-click takes the whole tree along
+	if (intent.modifiers & InputModifier_Alt) {
+		return DoFoldRecursive(suites) == A_Err_NONE;
+	}
+
+#ifdef AE_OS_WIN
+	return ProcessDoubleClick() == A_Err_NONE;
+#else
+	return DoFoldUnfold(suites) == A_Err_NONE;
+#endif
+}
+
 static A_Err IdleHook(
 	AEGP_GlobalRefcon	plugin_refconPV,
 	AEGP_IdleRefcon		refconPV,
@@ -1352,62 +1669,89 @@ static A_Err IdleHook(
 	S_idle_counter++;
 
 	AEGP_SuiteHandler suites(sP);
+	S_layer_id_map.BeginResolveBatch();
+
+	// A project-wide fold plans a slice per idle call, with or without a comp
+	TickBatchFold(suites);
 	
 	AEGP_CompH compH = NULL;
 	if (GetActiveComp(suites, &compH) != A_Err_NONE || !compH) {
+		SelectionSummary none;
+		BuildSelectionSummary(suites, NULL, &none);
+		PublishSelectionSummary(none);
+		S_input_channel.PublishSelection(false);
+		TickDividerIndex(suites, NULL, 0);
+		S_divider_prefetch.Tick(suites, NULL);
+		S_fold_history.Tick(suites, NULL);
          *max_sleepPL = 200;
          return A_Err_NONE;
     }
 
-	// Default to not selected
-	bool dividerSelected = false;
-	IsDividerSelected(suites, compH, &dividerSelected);
-	
-#ifdef AE_OS_WIN
-	// Update shared state
-	EnterCriticalSection(&S_cs);
-	S_is_divider_selected = dividerSelected;
-	
-	// Check if a double-click is pending
-	bool dblclick = false;
-	if (S_double_click_pending) {
-		dblclick = true;
-		S_double_click_pending = false;
+	// Close the fold history step of the last command (and of a batch fold above)
+	S_fold_history.Tick(suites, compH);
+
+	// One pass over the selection feeds both the menu cache and the input hooks
+	SelectionSummary summary;
+	if (BuildSelectionSummary(suites, compH, &summary) == A_Err_NONE) {
+		PublishSelectionSummary(summary);
 	}
-	LeaveCriticalSection(&S_cs);
-	
+	const bool dividerSelected = CachedSelectionSummary().selectedDividers > 0;
 
+	// Publish selection for the input hooks (lock-free, no critical section)
+	S_input_channel.PublishSelection(dividerSelected);
 
-	if (dblclick) {
-		ProcessDoubleClick();
+	// Bounded walk of the layer table; confirmed edits become change events
+	// and refresh the layer ID map
+#if FOLDLAYERS_PERF_LOG
+	const uint32_t diffsBefore = S_comp_changes.Stats().diffs;
+#endif
+	const uint64_t hashBefore = S_comp_changes.BaselineHash();
+	S_comp_changes.Tick(suites, compH);
+#if FOLDLAYERS_PERF_LOG
+	if (S_comp_changes.Stats().diffs != diffsBefore) {
+		const CompChangeStats& changeStats = S_comp_changes.Stats();
+		PerfLog("comp changes: %u passes, %u diffs, %u events, max %u layers/tick, %s",
+			changeStats.passes, changeStats.diffs, changeStats.eventsEmitted, changeStats.maxExaminedPerTick,
+			S_comp_changes.TickCost().Summary("tick cost").c_str());
 	}
 #endif
 
-#ifdef AE_OS_MAC
-	// Cache selected divider name for hit-testing in the event tap.
-	pthread_mutex_lock(&S_mac_state_mutex);
-	S_mac_divider_selected_for_input = dividerSelected;
-	pthread_mutex_unlock(&S_mac_state_mutex);
+	// Keep the persisted divider index in step with those edits
+	TickDividerIndex(suites, compH, hashBefore);
+
+	// Warm the index entry of a newly activated (or edited) comp
+	S_divider_prefetch.Tick(suites, compH);
 
+	// Focus mode follows the selection (after the detector, which tells it
+	// when its outline is out of date)
+	S_focus_mode.Tick(suites, compH);
+
+#ifdef AE_OS_MAC
 	// Install event tap (may fail if Accessibility permissions not granted)
 	InstallMacEventTap();
 
 	// Poll for mouse state as fallback when event tap is not available
-	// This detects double-clicks based on mouse event timing
+	// (returns at once while it is). This detects double-clicks based on
+	// mouse event timing.
 	PollMouseState();
+#endif
 
-	// Process pending fold action from double-click
-	if (S_pending_fold_action) {
-		S_pending_fold_action = false;
+	// Fallback drain: the platform wake normally pumps before we get here
+	S_fold_dispatcher.Pump();
 
-		if (dividerSelected) {
-			DoFoldUnfold(suites);
-		}
-    }
+	*max_sleepPL = 50;
+	return A_Err_NONE;
+}
 
-#endif
+static A_Err DeathHook(
+	AEGP_GlobalRefcon	plugin_refconPV,
+	AEGP_DeathRefcon	refconPV)
+{
+	(void)plugin_refconPV;  // Unused parameter
+	(void)refconPV;         // Unused parameter
 
-	*max_sleepPL = 50;
+	// Flush whatever the idle throttle has not written yet
+	S_divider_index.Save();
 	return A_Err_NONE;
 }
 
@@ -1424,29 +1768,10 @@ static A_Err UpdateMenuHook(
 	(void)refconPV;         // Unused parameter
 	(void)active_window;    // Unused parameter
 
-	A_Err err = A_Err_NONE;
-#ifdef AE_OS_MAC
-	InstallMacEventTap();
-    PollMouseState();
-    if (S_pending_fold_action) {
-        S_pending_fold_action = false;
-        // Try executing immediately
-        AEGP_SuiteHandler suites(sP);
-        AEGP_CompH compH = NULL;
-        if (GetActiveComp(suites, &compH) == A_Err_NONE && compH) {
-             bool sel = false;
-             if (IsDividerSelected(suites, compH, &sel) == A_Err_NONE && sel) {
-                 DoFoldUnfold(suites);
-             }
-        }
-    }
-#endif
+	// Runs on every menu update: read the summary IdleHook keeps current.
+	// Input polling and folds happen in IdleHook / the fold dispatcher.
 	AEGP_SuiteHandler suites(sP);
-	
-	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_create_divider));
-	ERR(suites.CommandSuite1()->AEGP_EnableCommand(S_cmd_fold_unfold));
-	
-	return err;
+	return ApplyMenuState(suites);
 }
 
 static A_Err CommandHook(
@@ -1464,6 +1789,7 @@ static A_Err CommandHook(
 
 	A_Err err = A_Err_NONE;
 	AEGP_SuiteHandler suites(sP);
+	S_layer_id_map.BeginResolveBatch();
 	
 	try {
 		if (command == S_cmd_create_divider) {
@@ -1474,6 +1800,106 @@ static A_Err CommandHook(
 			err = DoFoldUnfold(suites);
 			*handledPB = TRUE;
 		}
+		else if (command == S_cmd_state_in_markers) {
+			err = DoToggleFoldStateStore(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_name_prefix) {
+			err = DoToggleNamePrefix(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_null_dividers) {
+			err = DoToggleNullDividers(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_convert_to_nulls) {
+			err = DoConvertDividersToNulls(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_normalize) {
+			err = DoNormalizeDividers(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_explicit_members) {
+			err = DoToggleExplicitMembership(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_batch_fold) {
+			err = DoBatchFold(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_fold_to_level) {
+			err = DoFoldToLevel(suites, false);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_expand_to_level) {
+			err = DoFoldToLevel(suites, true);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_focus_mode) {
+			err = DoToggleFocusMode(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_reveal) {
+			err = DoRevealLayers(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_fold_recursive) {
+			err = DoFoldRecursive(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_save_layout) {
+			err = DoSaveFoldLayout(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_restore_layout) {
+			err = DoRestoreFoldLayout(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_history_back) {
+			err = DoFoldHistoryStep(suites, false);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_history_forward) {
+			err = DoFoldHistoryStep(suites, true);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_select_group) {
+			err = DoSelectGroup(suites, false);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_select_nested) {
+			err = DoSelectGroup(suites, true);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_move_up) {
+			err = DoMoveGroup(suites, MoveGroup_Up);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_move_down) {
+			err = DoMoveGroup(suites, MoveGroup_Down);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_move_to) {
+			err = DoMoveGroup(suites, MoveGroup_ToIndex);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_group_selection) {
+			err = DoGroupSelection(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_duplicate_group) {
+			err = DoDuplicateGroup(suites);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_ungroup) {
+			err = DoRemoveGroup(suites, false);
+			*handledPB = TRUE;
+		}
+		else if (command == S_cmd_delete_group) {
+			err = DoRemoveGroup(suites, true);
+			*handledPB = TRUE;
+		}
 	}
 	catch (...) {
 		err = A_Err_GENERIC;
@@ -1499,15 +1925,13 @@ extern "C" DllExport A_Err EntryPointFunc(
 	S_my_id = aegp_plugin_id;
 	
 	S_idle_counter = 0;
+
+	// Folds triggered by double-click run through the dispatcher
+	S_fold_dispatcher.SetHandler(HandleFoldIntent, NULL);
 	
 #ifdef AE_OS_WIN
-	// Initialize critical section and mouse hook
-	InitializeCriticalSection(&S_cs);
-	S_cs_initialized = true;
-	S_double_click_pending = false;
-	
 	// Install mouse hook to detect double-clicks
-	S_mouse_hook = SetWindowsHookEx(WH_MOUSE, MouseProc, NULL, GetCurrentThreadId());
+	InitWindowsHook();
 #endif
 
 #ifdef AE_OS_MAC
@@ -1519,17 +1943,195 @@ extern "C" DllExport A_Err EntryPointFunc(
 	
 	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_create_divider));
 	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_fold_unfold));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_state_in_markers));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_name_prefix));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_null_dividers));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_convert_to_nulls));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_normalize));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_explicit_members));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_batch_fold));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_fold_to_level));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_expand_to_level));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_focus_mode));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_reveal));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_fold_recursive));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_save_layout));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_restore_layout));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_history_back));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_history_forward));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_select_group));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_select_nested));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_move_up));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_move_down));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_move_to));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_group_selection));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_duplicate_group));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_ungroup));
+	ERR(suites.CommandSuite1()->AEGP_GetUniqueCommand(&S_cmd_delete_group));
+
+	// Missing prefs are not fatal: the defaults match the legacy behavior
+	LoadSettings(suites);
 	
 	if (!err) {
 		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
 			S_cmd_create_divider,
-			"Create Group Layer",
+			FLSTR(StrID_Menu_CreateDivider),
 			AEGP_Menu_LAYER,
 			AEGP_MENU_INSERT_SORTED));
 		
 		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
 			S_cmd_fold_unfold,
-			"Fold/Unfold",
+			FLSTR(StrID_Menu_ToggleFold),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_state_in_markers,
+			FLSTR(StrID_Menu_StateInMarkers),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_name_prefix,
+			FLSTR(StrID_Menu_NamePrefix),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_null_dividers,
+			FLSTR(StrID_Menu_NullDividers),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_convert_to_nulls,
+			FLSTR(StrID_Menu_ConvertToNulls),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_normalize,
+			FLSTR(StrID_Menu_Normalize),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_explicit_members,
+			FLSTR(StrID_Menu_ExplicitMembers),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_batch_fold,
+			FLSTR(StrID_Menu_BatchFold),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_fold_to_level,
+			FLSTR(StrID_Menu_FoldToLevel),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_expand_to_level,
+			FLSTR(StrID_Menu_ExpandToLevel),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_focus_mode,
+			FLSTR(StrID_Menu_FocusMode),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_reveal,
+			FLSTR(StrID_Menu_Reveal),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_fold_recursive,
+			FLSTR(StrID_Menu_FoldRecursive),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_save_layout,
+			FLSTR(StrID_Menu_SaveLayout),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_restore_layout,
+			FLSTR(StrID_Menu_RestoreLayout),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_history_back,
+			FLSTR(StrID_Menu_HistoryBack),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_history_forward,
+			FLSTR(StrID_Menu_HistoryForward),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_select_group,
+			FLSTR(StrID_Menu_SelectGroup),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_select_nested,
+			FLSTR(StrID_Menu_SelectNested),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_move_up,
+			FLSTR(StrID_Menu_MoveUp),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_move_down,
+			FLSTR(StrID_Menu_MoveDown),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_move_to,
+			FLSTR(StrID_Menu_MoveTo),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_group_selection,
+			FLSTR(StrID_Menu_GroupSelection),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_duplicate_group,
+			FLSTR(StrID_Menu_DuplicateGroup),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_ungroup,
+			FLSTR(StrID_Menu_Ungroup),
+			AEGP_Menu_LAYER,
+			AEGP_MENU_INSERT_SORTED));
+		
+		ERR(suites.CommandSuite1()->AEGP_InsertMenuCommand(
+			S_cmd_delete_group,
+			FLSTR(StrID_Menu_DeleteGroup),
 			AEGP_Menu_LAYER,
 			AEGP_MENU_INSERT_SORTED));
 		
@@ -1549,6 +2151,11 @@ extern "C" DllExport A_Err EntryPointFunc(
 			S_my_id,
 			IdleHook,
 			NULL));
+		
+		ERR(suites.RegisterSuite5()->AEGP_RegisterDeathHook(
+			S_my_id,
+			DeathHook,
+			NULL));
 	}
 	
 	return err;
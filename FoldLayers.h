@@ -67,6 +67,15 @@
 #define DIVIDER_ID_PREFIX_LEN		3			// Length of "FD-"
 #define DIVIDER_HIERARCHY_PREFIX	"FD-H:"		// Hierarchy storage prefix
 #define DIVIDER_HIERARCHY_PREFIX_LEN	5		// Length of "FD-H:"
+#define DIVIDER_STATE_MARKER_PREFIX	"FD-S:"		// Fold state layer marker ("FD-S:0" / "FD-S:1")
+#define DIVIDER_NULL_MARKER_PREFIX	"FD-D:"		// Null divider identity marker ("FD-D:<hierarchy>")
+#define DIVIDER_MEMBERS_MARKER_PREFIX	"FD-M:"	// Explicit member row ("FD-M:<owner>|<id>,<id>,...")
+
+// Pinned layout: the state group (FD-0/FD-1) sits at Contents index 0 and the
+// FD-H: group right after it, so probes read at most this many children
+#define DIVIDER_STATE_GROUP_INDEX	0
+#define DIVIDER_HIER_GROUP_INDEX	1
+#define DIVIDER_PINNED_GROUP_COUNT	2
 
 // Buffer sizes
 #define ERROR_BUFFER_SIZE		128			// Size of error message buffer
@@ -103,6 +112,38 @@ extern A_long			S_idle_counter;
 // Menu command IDs
 extern AEGP_Command		S_cmd_create_divider;
 extern AEGP_Command		S_cmd_fold_unfold;
+extern AEGP_Command		S_cmd_state_in_markers;
+extern AEGP_Command		S_cmd_name_prefix;
+extern AEGP_Command		S_cmd_null_dividers;
+extern AEGP_Command		S_cmd_convert_to_nulls;
+extern AEGP_Command		S_cmd_normalize;
+extern AEGP_Command		S_cmd_explicit_members;
+extern AEGP_Command		S_cmd_batch_fold;
+extern AEGP_Command		S_cmd_fold_to_level;
+extern AEGP_Command		S_cmd_expand_to_level;
+extern AEGP_Command		S_cmd_focus_mode;
+extern AEGP_Command		S_cmd_reveal;
+extern AEGP_Command		S_cmd_fold_recursive;
+extern AEGP_Command		S_cmd_save_layout;
+extern AEGP_Command		S_cmd_restore_layout;
+extern AEGP_Command		S_cmd_history_back;
+extern AEGP_Command		S_cmd_history_forward;
+extern AEGP_Command		S_cmd_select_group;
+extern AEGP_Command		S_cmd_select_nested;
+extern AEGP_Command		S_cmd_move_up;
+extern AEGP_Command		S_cmd_move_down;
+extern AEGP_Command		S_cmd_move_to;
+extern AEGP_Command		S_cmd_group_selection;
+extern AEGP_Command		S_cmd_duplicate_group;
+extern AEGP_Command		S_cmd_ungroup;
+extern AEGP_Command		S_cmd_delete_group;
+
+//=============================================================================
+// Utils - Settings & Layer Marker Records
+//=============================================================================
+
+#include "Utils/Settings.h"
+#include "Utils/LayerMarkers.h"
 
 //=============================================================================
 // Utils - StringConv
@@ -116,6 +157,8 @@ extern AEGP_Command		S_cmd_fold_unfold;
 
 #include "Hierarchy/GroupParser.h"
 #include "Hierarchy/GroupBuilder.h"
+#include "Hierarchy/DividerRecord.h"
+#include "Hierarchy/GroupMembership.h"
 
 //=============================================================================
 // Divider Identity & State Management
@@ -124,30 +167,60 @@ extern AEGP_Command		S_cmd_fold_unfold;
 // Helper to find child by match name (safe for all group types)
 A_Err FindStreamByMatchName(AEGP_SuiteHandler& suites, AEGP_StreamRefH parentH, const char* matchName, AEGP_StreamRefH* outStreamH);
 
+// Read a shape divider's record from its pinned Contents groups: one name read
+// for a version 2 record, or the legacy FD-0/FD-1 + FD-H: pair (version 1;
+// an FD-H: pushed past the pinned slots is found by a full scan).
+// Returns A_Err_GENERIC if the layer is not a shape divider. Never writes.
+A_Err ReadDividerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, DividerRecord* outRecord);
+
+// Write a version 2 record into the pinned state group (assigning a group ID
+// if it has none). Legacy layers are upgraded here: stray FD-H: and bare
+// FD-0/FD-1 groups are removed in the same pass, after a record without a
+// hierarchy has taken the FD-H: path.
+A_Err WriteDividerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const DividerRecord& record);
+
 // Get hierarchy from hidden FD-H: group for rename recovery
 std::string GetHierarchyFromHiddenGroup(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 
-// Check if layer has divider identity (FD- prefix in stream)
+// Check if layer is a null divider (NULL_LAYER flag + FD-D: marker); optionally return its hierarchy
+bool IsNullDivider(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, std::string* outHierarchy = NULL);
+
+// Check if layer has divider identity (FD- prefix in stream, or null divider marker)
 bool HasDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 
 // Add identification group to layer with optional hierarchy
 A_Err AddDividerIdentity(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const std::string& hierarchy);
 
+// Change an existing divider's hierarchy path, keeping its fold state (and
+// its group ID unless freshGroupId)
+A_Err SetDividerHierarchy(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const std::string& hierarchy,
+						  bool freshGroupId = false);
+
 // Check if layer is a divider layer
 bool IsDividerLayer(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 
 // Check if layer is a divider with known name (optimized version)
 bool IsDividerLayerWithKnownName(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const std::string& name);
 
-// Get fold state data stream from layer
-A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP_StreamRefH* outStreamH, bool* outIsFolded = NULL);
+// Get fold state data stream from layer. *outMarkerStore: the divider's
+// record says its state lives in the FD-S: marker (records older than the
+// store field follow S_settings.foldStateStore).
+A_Err GetFoldGroupDataStream(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, AEGP_StreamRefH* outStreamH, bool* outIsFolded = NULL,
+                             bool* outMarkerStore = NULL);
+
+// Read fold state from the FD-S: layer marker; returns false if the layer has none
+bool GetMarkerFoldState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outFolded);
 
-// Set group fold state
+// Set group fold state (FD-0/FD-1 group or FD-S: marker, per S_settings.foldStateStore;
+// the divider's record notes which one holds it)
 A_Err SetGroupState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool setFolded);
 
 // Sync layer name with current fold state
 A_Err SyncLayerName(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 
+// Identity and fold state in one probe (shape and null dividers); false if not a divider
+bool ProbeDividerState(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, bool* outFolded);
+
 // Check if divider is folded
 bool IsDividerFolded(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 
@@ -158,7 +231,11 @@ bool IsDividerFolded(AEGP_SuiteHandler& suites, AEGP_LayerH layerH);
 // Get active composition
 A_Err GetActiveComp(AEGP_SuiteHandler& suites, AEGP_CompH* compH);
 
-// Get layers that belong to this divider's group
+// Get every composition in the open project
+A_Err GetProjectComps(AEGP_SuiteHandler& suites, std::vector<AEGP_CompH>& comps);
+
+// Get layers that belong to this divider's group by position (see
+// ResolveGroupMembers for explicit membership)
 A_Err GetGroupLayers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
 					A_long dividerIndex, const std::string& dividerHierarchy,
 					std::vector<AEGP_LayerH>& groupLayers);
@@ -184,6 +261,10 @@ A_Err ToggleSelectedDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH);
 // Toggle all dividers - unfold priority, fold if all unfolded
 A_Err ToggleAllDividers(AEGP_SuiteHandler& suites, AEGP_CompH compH);
 
+// Create an unfolded divider for hierarchy at layer index (caller owns the undo group)
+A_Err CreateDividerLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::string& hierarchy,
+						 A_long index, AEGP_LayerH* outLayerH);
+
 //=============================================================================
 // Commands
 //=============================================================================
@@ -198,18 +279,47 @@ A_Err DoFoldUnfold(AEGP_SuiteHandler& suites);
 // Returns A_Err_NONE on success, error code otherwise
 A_Err EnsureShyModeEnabled(AEGP_SuiteHandler& suites);
 
+// Cached selection summary read by UpdateMenuHook
+#include "Commands/MenuState.h"
+
+// Fold state storage options and migration
+#include "Commands/FoldStateStorage.h"
+
+// Null layer dividers and bulk conversion
+#include "Commands/NullDividers.h"
+
+// Pinned FD- group layout normalizer
+#include "Commands/NormalizeDividers.h"
+
+// Explicit group membership option
+#include "Commands/ExplicitMembership.h"
+
+// Project-wide fold/unfold (menu and scripts)
+#include "Commands/BatchFold.h"
+#include "Commands/FoldToLevel.h"
+#include "Commands/FocusMode.h"
+#include "Commands/Reveal.h"
+#include "Commands/RecursiveFold.h"
+#include "Commands/FoldLayouts.h"
+#include "Commands/FoldHistory.h"
+#include "Commands/SelectGroup.h"
+#include "Commands/MoveGroup.h"
+#include "Commands/GroupSelection.h"
+#include "Commands/DuplicateGroup.h"
+#include "Commands/RemoveGroup.h"
+
 //=============================================================================
 // Platform-specific hooks
 //=============================================================================
 
+// Input hooks publish double-clicks and read the divider selection through
+// the lock-free S_input_channel; IdleHook is the single consumer.
+#include "Input/InputChannel.h"
+
 #ifdef AE_OS_WIN
 	// Windows: Mouse hook for double-click detection
 	extern HHOOK			S_mouse_hook;
-	extern bool				S_double_click_pending;
 	extern bool				S_suppress_next_action;
-	extern CRITICAL_SECTION	S_cs;
-	extern bool				S_cs_initialized;
-	extern bool				S_is_divider_selected;
 
 	// Process pending double-click
 	A_Err ProcessDoubleClick();
@@ -217,12 +327,9 @@ A_Err EnsureShyModeEnabled(AEGP_SuiteHandler& suites);
 
 #ifdef AE_OS_MAC
 	// macOS: Event tap for double-click detection
-	extern bool				S_pending_fold_action;
 	extern CFMachPortRef	S_event_tap;
 	extern CFRunLoopSourceRef S_event_tap_source;
 	extern bool				S_event_tap_active;
-	extern pthread_mutex_t	S_mac_state_mutex;
-	extern bool				S_mac_divider_selected_for_input;
 	extern bool				S_mac_should_warn_ax;
 	extern bool				S_mac_warned_ax;
 
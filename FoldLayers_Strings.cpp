@@ -14,7 +14,34 @@ static TableString g_strs[StrID_NUMTYPES] = {
 	
 	// Menu items
 	{StrID_Menu_CreateDivider,		"Create Group Layer"},
-	{StrID_Menu_ToggleFold,			"Fold/Unfold Groups"},
+	{StrID_Menu_ToggleFold,			"Fold/Unfold"},
+	{StrID_Menu_FoldGroup,			"Fold Group"},
+	{StrID_Menu_UnfoldGroup,		"Unfold Group"},
+	{StrID_Menu_StateInMarkers,		"Store Group Fold State in Markers"},
+	{StrID_Menu_NamePrefix,			"Show Group Fold State in Layer Names"},
+	{StrID_Menu_NullDividers,		"Create Groups as Null Layers"},
+	{StrID_Menu_ConvertToNulls,		"Convert Group Layers to Nulls"},
+	{StrID_Menu_Normalize,			"Normalize Group Layers"},
+	{StrID_Menu_ExplicitMembers,	"Track Group Members Explicitly"},
+	{StrID_Menu_BatchFold,			"Fold/Unfold Groups in Project"},
+	{StrID_Menu_FoldToLevel,		"Fold to Level..."},
+	{StrID_Menu_ExpandToLevel,		"Expand to Level..."},
+	{StrID_Menu_FocusMode,			"Focus on Selected Group"},
+	{StrID_Menu_Reveal,				"Reveal Selected Layers"},
+	{StrID_Menu_FoldRecursive,		"Fold/Unfold Group Recursively"},
+	{StrID_Menu_SaveLayout,			"Save Fold Layout..."},
+	{StrID_Menu_RestoreLayout,		"Restore Fold Layout..."},
+	{StrID_Menu_HistoryBack,		"Previous Fold State"},
+	{StrID_Menu_HistoryForward,		"Next Fold State"},
+	{StrID_Menu_SelectGroup,		"Select Group Contents"},
+	{StrID_Menu_SelectNested,		"Select Group Including Nested Groups"},
+	{StrID_Menu_MoveUp,				"Move Group Up"},
+	{StrID_Menu_MoveDown,			"Move Group Down"},
+	{StrID_Menu_MoveTo,				"Move Group to Index..."},
+	{StrID_Menu_GroupSelection,		"Group Selection"},
+	{StrID_Menu_DuplicateGroup,		"Duplicate Group"},
+	{StrID_Menu_Ungroup,				"Ungroup"},
+	{StrID_Menu_DeleteGroup,			"Delete Group with Contents"},
 	
 	// Status messages
 	{StrID_DividerCreated,			"Group Divider created."},
@@ -9,6 +9,33 @@ typedef enum {
 	// Menu items
 	StrID_Menu_CreateDivider,
 	StrID_Menu_ToggleFold,
+	StrID_Menu_FoldGroup,
+	StrID_Menu_UnfoldGroup,
+	StrID_Menu_StateInMarkers,
+	StrID_Menu_NamePrefix,
+	StrID_Menu_NullDividers,
+	StrID_Menu_ConvertToNulls,
+	StrID_Menu_Normalize,
+	StrID_Menu_ExplicitMembers,
+	StrID_Menu_BatchFold,
+	StrID_Menu_FoldToLevel,
+	StrID_Menu_ExpandToLevel,
+	StrID_Menu_FocusMode,
+	StrID_Menu_Reveal,
+	StrID_Menu_FoldRecursive,
+	StrID_Menu_SaveLayout,
+	StrID_Menu_RestoreLayout,
+	StrID_Menu_HistoryBack,
+	StrID_Menu_HistoryForward,
+	StrID_Menu_SelectGroup,
+	StrID_Menu_SelectNested,
+	StrID_Menu_MoveUp,
+	StrID_Menu_MoveDown,
+	StrID_Menu_MoveTo,
+	StrID_Menu_GroupSelection,
+	StrID_Menu_DuplicateGroup,
+	StrID_Menu_Ungroup,
+	StrID_Menu_DeleteGroup,
 	
 	// Status messages
 	StrID_DividerCreated,
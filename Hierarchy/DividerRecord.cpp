@@ -0,0 +1,142 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Record                                */
+/*      Versioned single-string divider metadata                   */
+/*                                                                 */
+/*******************************************************************/
+
+#include "DividerRecord.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// Upper bound on record length (AE stream names are short)
+static const size_t	MAX_RECORD_LENGTH	= 512;
+
+// Group ID generator state (xorshift32), seeded on first use
+static uint32_t		S_group_id_state	= 0;
+
+uint32_t DividerRecordChecksum(const char* data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < length; i++) {
+		crc ^= (unsigned char)data[i];
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+		}
+	}
+	return ~crc;
+}
+
+uint32_t NewDividerGroupId()
+{
+	if (!S_group_id_state) {
+		S_group_id_state = (uint32_t)time(NULL) ^ ((uint32_t)clock() << 16) ^ (uint32_t)(uintptr_t)&S_group_id_state;
+		if (!S_group_id_state) S_group_id_state = 0x9E3779B9u;
+	}
+
+	uint32_t id = 0;
+	while (!id) {
+		S_group_id_state ^= S_group_id_state << 13;
+		S_group_id_state ^= S_group_id_state >> 17;
+		S_group_id_state ^= S_group_id_state << 5;
+		id = S_group_id_state;
+	}
+	return id;
+}
+
+static bool ParseHex32(const std::string& text, uint32_t* outValue)
+{
+	if (text.length() != 8) return false;
+	uint32_t value = 0;
+	for (size_t i = 0; i < text.length(); i++) {
+		const char c = text[i];
+		value <<= 4;
+		if (c >= '0' && c <= '9')		value |= (uint32_t)(c - '0');
+		else if (c >= 'a' && c <= 'f')	value |= (uint32_t)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')	value |= (uint32_t)(c - 'A' + 10);
+		else return false;
+	}
+	*outValue = value;
+	return true;
+}
+
+static bool IsValidHierarchy(const std::string& hierarchy)
+{
+	for (size_t i = 0; i < hierarchy.length(); i++) {
+		const char c = hierarchy[i];
+		if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '/')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ParseDividerRecord(const std::string& text, DividerRecord* outRecord)
+{
+	if (text.length() > MAX_RECORD_LENGTH || text.length() < 5) return false;
+	if (text.compare(0, 3, "FD-") != 0 || (text[3] != '0' && text[3] != '1') || text[4] != DIVIDER_RECORD_SEP) {
+		return false;
+	}
+
+	// Checksum covers everything before the last separator
+	const size_t crcSep = text.rfind(DIVIDER_RECORD_SEP);
+	uint32_t storedCrc = 0;
+	if (crcSep == std::string::npos || !ParseHex32(text.substr(crcSep + 1), &storedCrc)) return false;
+	if (DividerRecordChecksum(text.data(), crcSep) != storedCrc) return false;
+
+	// FD-<fold> | version [| store] | id | hierarchy
+	const size_t versionStart = 5;
+	const size_t versionEnd = text.find(DIVIDER_RECORD_SEP, versionStart);
+	if (versionEnd == std::string::npos || versionEnd >= crcSep) return false;
+
+	const std::string versionText = text.substr(versionStart, versionEnd - versionStart);
+	const int version = atoi(versionText.c_str());
+	if (version != 2 && version != DIVIDER_RECORD_VERSION) return false;
+
+	bool markerStore = false;
+	size_t idStart = versionEnd + 1;
+	if (version == DIVIDER_RECORD_VERSION) {
+		if (idStart + 2 > crcSep || text[idStart + 1] != DIVIDER_RECORD_SEP) return false;
+		if (text[idStart] == DIVIDER_STORE_MARKER)			markerStore = true;
+		else if (text[idStart] != DIVIDER_STORE_CONTENTS)	return false;
+		idStart += 2;
+	}
+
+	const size_t idEnd = text.find(DIVIDER_RECORD_SEP, idStart);
+	if (idEnd == std::string::npos || idEnd >= crcSep) return false;
+
+	uint32_t groupId = 0;
+	if (!ParseHex32(text.substr(idStart, idEnd - idStart), &groupId)) return false;
+
+	const std::string hierarchy = text.substr(idEnd + 1, crcSep - idEnd - 1);
+	if (!IsValidHierarchy(hierarchy)) return false;
+
+	if (outRecord) {
+		outRecord->version = version;
+		outRecord->folded = (text[3] == '1');
+		outRecord->markerStore = markerStore;
+		outRecord->groupId = groupId;
+		outRecord->hierarchy = hierarchy;
+	}
+	return true;
+}
+
+std::string FormatDividerRecord(const DividerRecord& record)
+{
+	char head[32];
+	snprintf(head, sizeof(head), "FD-%c%c%d%c%c%c%08x%c",
+		record.folded ? '1' : '0', DIVIDER_RECORD_SEP,
+		DIVIDER_RECORD_VERSION, DIVIDER_RECORD_SEP,
+		record.markerStore ? DIVIDER_STORE_MARKER : DIVIDER_STORE_CONTENTS, DIVIDER_RECORD_SEP,
+		(unsigned)record.groupId, DIVIDER_RECORD_SEP);
+
+	std::string body = head;
+	body += IsValidHierarchy(record.hierarchy) ? record.hierarchy : std::string();
+
+	char tail[16];
+	snprintf(tail, sizeof(tail), "%c%08x", DIVIDER_RECORD_SEP,
+		(unsigned)DividerRecordChecksum(body.data(), body.length()));
+	return body + tail;
+}
@@ -0,0 +1,52 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Record                                */
+/*      Versioned single-string divider metadata                   */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef DIVIDER_RECORD_H
+#define DIVIDER_RECORD_H
+
+#include "AEConfig.h"
+#include <cstdint>
+#include <string>
+
+// Record layout (one hidden group name at Contents index 0):
+//   FD-<fold>|<version>|<store>|<group id, 8 hex>|<hierarchy>|<crc32, 8 hex>
+//   e.g. "FD-1|3|C|3fa90c12|1/A|9b0e44d1"
+// The leading "FD-0"/"FD-1" keeps older builds reading the fold state.
+// store: 'C' = the fold bit is the state, 'M' = the FD-S: layer marker is
+// (the fold bit is then stale). It travels with the project, so the state
+// is read from the right place whatever store this machine writes to.
+// Version 2 is the same without the store field (always contents).
+// Version 1 is the legacy layout: bare FD-0/FD-1 plus an FD-H:<path> group.
+#define DIVIDER_RECORD_VERSION		3
+#define DIVIDER_RECORD_SEP			'|'
+#define DIVIDER_STORE_CONTENTS		'C'
+#define DIVIDER_STORE_MARKER		'M'
+
+typedef struct {
+	int				version;		// 1 = legacy groups, 2 and 3 = this record
+	bool			folded;			// Fold bit
+	bool			markerStore;	// State lives in the FD-S: marker
+	uint32_t		groupId;		// Stable group ID (0 = not assigned yet)
+	std::string		hierarchy;		// e.g. "1", "1/A"
+} DividerRecord;
+
+// Parse a version 2 or 3 record. Returns false for legacy names ("FD-0",
+// "FD-H:..."), other versions, malformed fields or a checksum mismatch.
+bool ParseDividerRecord(const std::string& text, DividerRecord* outRecord);
+
+// Format a record as version 3 (record.version is ignored)
+std::string FormatDividerRecord(const DividerRecord& record);
+
+// CRC-32 (IEEE) used for the record checksum
+uint32_t DividerRecordChecksum(const char* data, size_t length);
+
+// New non-zero group ID
+uint32_t NewDividerGroupId();
+
+#endif // DIVIDER_RECORD_H
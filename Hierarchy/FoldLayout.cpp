@@ -0,0 +1,139 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Layout                                   */
+/*      Named fold states of a comp's dividers, as one record      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldLayout.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static bool EntryBefore(const FoldLayoutEntry& a, const FoldLayoutEntry& b)
+{
+	return a.id < b.id;
+}
+
+static int HexDigit(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+bool IsValidFoldLayoutName(const std::string& name)
+{
+	if (name.empty() || name.size() > FOLD_LAYOUT_MAX_NAME) return false;
+	for (size_t i = 0; i < name.size(); i++) {
+		if (name[i] < 0x20 || name[i] > 0x7E || name[i] == FOLD_LAYOUT_SEP) return false;
+	}
+	return true;
+}
+
+std::string FoldLayoutRecordPrefix(const std::string& name)
+{
+	return std::string(FOLD_LAYOUT_PREFIX) + name + FOLD_LAYOUT_SEP;
+}
+
+std::string FormatFoldLayout(FoldLayout& layout)
+{
+	std::sort(layout.entries.begin(), layout.entries.end(), EntryBefore);
+
+	char buf[32];
+	std::string text = FoldLayoutRecordPrefix(layout.name);
+	snprintf(buf, sizeof(buf), "%d%c%u%c", FOLD_LAYOUT_VERSION, FOLD_LAYOUT_SEP,
+		(unsigned)layout.entries.size(), FOLD_LAYOUT_SEP);
+	text += buf;
+	text.reserve(text.size() + layout.entries.size() * 3);
+
+	AEGP_LayerIDVal previous = 0;
+	for (size_t i = 0; i < layout.entries.size(); i++) {
+		snprintf(buf, sizeof(buf), i ? ".%x" : "%x", (unsigned)(layout.entries[i].id - previous));
+		text += buf;
+		previous = layout.entries[i].id;
+	}
+
+	text += FOLD_LAYOUT_SEP;
+	static const char kHex[] = "0123456789abcdef";
+	for (size_t i = 0; i < layout.entries.size(); i += 4) {
+		int nibble = 0;
+		for (size_t b = 0; b < 4 && i + b < layout.entries.size(); b++) {
+			if (layout.entries[i + b].folded) nibble |= 1 << b;
+		}
+		text += kHex[nibble];
+	}
+	return text;
+}
+
+bool ParseFoldLayout(const std::string& text, FoldLayout* outLayout)
+{
+	const size_t prefixLen = sizeof(FOLD_LAYOUT_PREFIX) - 1;
+	if (text.compare(0, prefixLen, FOLD_LAYOUT_PREFIX) != 0) return false;
+
+	// name|version|count|ids|bits
+	std::vector<std::string> fields;
+	size_t pos = prefixLen;
+	for (;;) {
+		const size_t end = text.find(FOLD_LAYOUT_SEP, pos);
+		fields.push_back(text.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+		if (end == std::string::npos) break;
+		pos = end + 1;
+	}
+	if (fields.size() != 5 || atoi(fields[1].c_str()) != FOLD_LAYOUT_VERSION) return false;
+
+	const long count = strtol(fields[2].c_str(), NULL, 10);
+	if (count < 0 || (size_t)count > text.size()) return false;
+	if (fields[4].size() != ((size_t)count + 3) / 4) return false;
+
+	std::vector<FoldLayoutEntry> entries;
+	entries.reserve((size_t)count);
+	const std::string& ids = fields[3];
+	AEGP_LayerIDVal previous = 0;
+	size_t start = 0;
+	while (count > 0 && start <= ids.size()) {
+		size_t end = ids.find('.', start);
+		if (end == std::string::npos) end = ids.size();
+		if (end == start) return false;
+
+		unsigned long delta = 0;
+		for (size_t c = start; c < end; c++) {
+			const int digit = HexDigit(ids[c]);
+			if (digit < 0 || c - start >= 8) return false;
+			delta = (delta << 4) | (unsigned long)digit;
+		}
+		if (!entries.empty() && delta == 0) return false;	// IDs are unique
+
+		FoldLayoutEntry entry;
+		entry.id = previous + (AEGP_LayerIDVal)delta;
+		entry.folded = false;
+		entries.push_back(entry);
+		previous = entry.id;
+		start = end + 1;
+	}
+	if (entries.size() != (size_t)count) return false;
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		const int nibble = HexDigit(fields[4][i / 4]);
+		if (nibble < 0) return false;
+		entries[i].folded = (nibble >> (i % 4)) & 1;
+	}
+
+	outLayout->name = fields[0];
+	outLayout->entries.swap(entries);
+	return true;
+}
+
+bool FindFoldLayoutState(const FoldLayout& layout, AEGP_LayerIDVal id, bool* outFolded)
+{
+	FoldLayoutEntry key;
+	key.id = id;
+	key.folded = false;
+	std::vector<FoldLayoutEntry>::const_iterator it =
+		std::lower_bound(layout.entries.begin(), layout.entries.end(), key, EntryBefore);
+	if (it == layout.entries.end() || it->id != id) return false;
+	*outFolded = it->folded;
+	return true;
+}
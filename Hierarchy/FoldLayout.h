@@ -0,0 +1,59 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Layout                                   */
+/*      Named fold states of a comp's dividers, as one record      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLD_LAYOUT_H
+#define FOLD_LAYOUT_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Record layout (one comp marker comment per layout):
+//   FL-LAYOUT:<name>|<version>|<count>|<ids>|<bits>
+//   e.g. "FL-LAYOUT:Review|1|3|4.2.1a|5"
+// ids: divider layer IDs in ascending order, the first in hex and the rest
+// as hex deltas, '.'-separated. bits: fold bit of the i-th ID at bit i % 4
+// of hex digit i / 4. Layer IDs survive reordering, renaming and saving;
+// a duplicated divider gets a new one and so is not in older layouts.
+#define FOLD_LAYOUT_PREFIX		"FL-LAYOUT:"
+#define FOLD_LAYOUT_VERSION		1
+#define FOLD_LAYOUT_SEP			'|'
+
+// Longest record that round-trips through a marker comment
+#define FOLD_LAYOUT_MAX_CHARS	32000
+
+typedef struct {
+	AEGP_LayerIDVal	id;
+	bool			folded;
+} FoldLayoutEntry;
+
+typedef struct {
+	std::string						name;
+	std::vector<FoldLayoutEntry>	entries;	// Ascending ID order after Parse/Format
+} FoldLayout;
+
+// Names: printable ASCII without the separator, at most this long
+#define FOLD_LAYOUT_MAX_NAME	64
+bool IsValidFoldLayoutName(const std::string& name);
+
+// Record prefix identifying one layout ("FL-LAYOUT:<name>|")
+std::string FoldLayoutRecordPrefix(const std::string& name);
+
+// Sorts layout.entries, then formats
+std::string FormatFoldLayout(FoldLayout& layout);
+
+// false for other versions or malformed records
+bool ParseFoldLayout(const std::string& text, FoldLayout* outLayout);
+
+// Fold bit for id (binary search); false if id is not in the layout
+bool FindFoldLayoutState(const FoldLayout& layout, AEGP_LayerIDVal id, bool* outFolded);
+
+#endif // FOLD_LAYOUT_H
@@ -0,0 +1,189 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Outline                                  */
+/*      Flattened group tree of a comp snapshot                    */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldOutline.h"
+
+FoldOutline::FoldOutline()
+{
+}
+
+void FoldOutline::Clear()
+{
+	m_parent.clear();
+	m_end.clear();
+	m_isDivider.clear();
+	m_hasRow.clear();
+	m_dividers.clear();
+	m_index.clear();
+	m_rowMembers.clear();
+	m_rowOwners.clear();
+}
+
+void FoldOutline::Build(const std::vector<FoldPlanLayer>& layers, const FoldPlanRows& rows)
+{
+	Clear();
+
+	const size_t count = layers.size();
+	m_parent.assign(count, -1);
+	m_end.resize(count);
+	m_isDivider.assign(count, false);
+	m_hasRow.assign(count, false);
+	m_index.reserve(count);
+
+	// Same walk as PlanFold: a divider closes the open groups of its level
+	// and deeper, and row owners stay open only to be closed
+	std::vector<A_long> open;
+	for (size_t i = 0; i < count; i++) {
+		const FoldPlanLayer& layer = layers[i];
+		m_index[layer.id] = (A_long)i;
+		m_end[i] = (A_long)i + 1;
+
+		if (layer.isDivider) {
+			while (!open.empty() && layers[(size_t)open.back()].depth >= layer.depth) {
+				m_end[(size_t)open.back()] = (A_long)i;
+				open.pop_back();
+			}
+		}
+
+		for (size_t o = open.size(); o > 0; o--) {
+			if (!m_hasRow[(size_t)open[o - 1]]) {
+				m_parent[i] = open[o - 1];
+				break;
+			}
+		}
+
+		if (layer.isDivider) {
+			m_isDivider[i] = true;
+			m_hasRow[i] = layer.hasRow;
+			m_dividers.push_back((A_long)i);
+			open.push_back((A_long)i);
+		}
+	}
+	for (size_t o = 0; o < open.size(); o++) {
+		m_end[(size_t)open[o]] = (A_long)count;
+	}
+
+	// Rows by index; members no longer in the comp are dropped
+	for (size_t d = 0; d < m_dividers.size(); d++) {
+		const A_long owner = m_dividers[d];
+		if (!m_hasRow[(size_t)owner]) continue;
+
+		FoldPlanRows::const_iterator row = rows.find(layers[(size_t)owner].id);
+		if (row == rows.end()) continue;
+
+		std::vector<A_long>& members = m_rowMembers[owner];
+		for (size_t m = 0; m < row->second.size(); m++) {
+			const A_long member = IndexOf(row->second[m]);
+			if (member < 0) continue;
+			members.push_back(member);
+			m_rowOwners[member].push_back(owner);
+		}
+	}
+}
+
+A_long FoldOutline::IndexOf(AEGP_LayerIDVal id) const
+{
+	std::unordered_map<AEGP_LayerIDVal, A_long>::const_iterator it = m_index.find(id);
+	return it == m_index.end() ? -1 : it->second;
+}
+
+void FoldOutline::AddAncestors(A_long index, std::vector<bool>& mark, std::vector<A_long>& out) const
+{
+	std::vector<A_long> pending(1, index);
+	while (!pending.empty()) {
+		const A_long current = pending.back();
+		pending.pop_back();
+
+		const A_long parent = m_parent[(size_t)current];
+		if (parent >= 0 && !mark[(size_t)parent]) {
+			mark[(size_t)parent] = true;
+			out.push_back(parent);
+			pending.push_back(parent);
+		}
+
+		std::unordered_map<A_long, std::vector<A_long> >::const_iterator owners = m_rowOwners.find(current);
+		if (owners == m_rowOwners.end()) continue;
+		for (size_t o = 0; o < owners->second.size(); o++) {
+			const A_long owner = owners->second[o];
+			if (mark[(size_t)owner]) continue;
+			mark[(size_t)owner] = true;
+			out.push_back(owner);
+			pending.push_back(owner);
+		}
+	}
+}
+
+void FoldOutline::AddContained(A_long divider, std::vector<bool>& mark, std::vector<A_long>& out) const
+{
+	if (m_hasRow[(size_t)divider]) {
+		std::unordered_map<A_long, std::vector<A_long> >::const_iterator row = m_rowMembers.find(divider);
+		if (row == m_rowMembers.end()) return;
+		for (size_t m = 0; m < row->second.size(); m++) {
+			const A_long member = row->second[m];
+			if (mark[(size_t)member]) continue;
+			mark[(size_t)member] = true;
+			out.push_back(member);
+		}
+		return;
+	}
+
+	for (A_long i = divider + 1; i < m_end[(size_t)divider]; i++) {
+		if (mark[(size_t)i]) continue;
+		mark[(size_t)i] = true;
+		out.push_back(i);
+	}
+}
+
+bool FoldOutline::Hidden(A_long index, const std::vector<bool>& folded) const
+{
+	// Rows hide their members directly; position hides through every
+	// enclosing group
+	std::unordered_map<A_long, std::vector<A_long> >::const_iterator owners = m_rowOwners.find(index);
+	if (owners != m_rowOwners.end()) {
+		for (size_t o = 0; o < owners->second.size(); o++) {
+			if (folded[(size_t)owners->second[o]]) return true;
+		}
+	}
+
+	for (A_long p = m_parent[(size_t)index]; p >= 0; p = m_parent[(size_t)p]) {
+		if (folded[(size_t)p]) return true;
+	}
+	return false;
+}
+
+void FoldOutline::SelectGroups(const std::vector<A_long>& roots, bool nested, std::vector<bool>& outSelected) const
+{
+	outSelected.assign(m_parent.size(), false);
+	for (size_t r = 0; r < roots.size(); r++) {
+		const A_long root = roots[r];
+		if (root < 0 || root >= Size() || !IsDivider(root)) continue;
+		outSelected[(size_t)root] = true;
+
+		std::vector<bool> mark(m_parent.size(), false);
+		std::vector<A_long> contained;
+		mark[(size_t)root] = true;
+		AddContained(root, mark, contained);
+
+		// Trees of the sub groups, by their own containment
+		std::vector<bool> inSubgroup(m_parent.size(), false);
+		std::vector<A_long> subtree;
+		for (size_t c = 0; c < contained.size(); c++) {
+			if (!IsDivider(contained[c]) || inSubgroup[(size_t)contained[c]]) continue;
+			inSubgroup[(size_t)contained[c]] = true;
+			subtree.push_back(contained[c]);
+		}
+		for (size_t s = 0; s < subtree.size(); s++) {
+			if (IsDivider(subtree[s])) AddContained(subtree[s], inSubgroup, subtree);
+		}
+
+		// Nested: everything; contents: what no sub group contains
+		for (size_t c = 0; c < contained.size(); c++) {
+			if (nested || !inSubgroup[(size_t)contained[c]]) outSelected[(size_t)contained[c]] = true;
+		}
+		for (size_t s = 0; nested && s < subtree.size(); s++) outSelected[(size_t)subtree[s]] = true;
+	}
+}
@@ -0,0 +1,70 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Outline                                  */
+/*      Flattened group tree of a comp snapshot                    */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLD_OUTLINE_H
+#define FOLD_OUTLINE_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "FoldPlanner.h"
+#include <unordered_map>
+#include <vector>
+
+// Containment links of a snapshot (see PlanFold for the rules), built in one
+// pass so that ancestor and subtree lookups never rescan the comp:
+//   Parent(i)     innermost divider containing i by position (-1: none)
+//   RowOwners(i)  dividers listing i in their member row
+//   group of d    (d, GroupEnd(d)) by position, or its row members
+// Row owners contain only their row, so they are never a Parent.
+class FoldOutline {
+public:
+	FoldOutline();
+
+	void		Build(const std::vector<FoldPlanLayer>& layers, const FoldPlanRows& rows);
+	void		Clear();
+
+	A_long		Size() const { return (A_long)m_parent.size(); }
+	A_long		IndexOf(AEGP_LayerIDVal id) const;		// -1 if not in the snapshot
+	A_long		Parent(A_long index) const { return m_parent[(size_t)index]; }
+	A_long		GroupEnd(A_long divider) const { return m_end[(size_t)divider]; }
+	bool		IsDivider(A_long index) const { return m_isDivider[(size_t)index]; }
+	const std::vector<A_long>&	Dividers() const { return m_dividers; }
+
+	// Append every divider that contains index, directly or through its
+	// own containers, skipping those already marked (marks them)
+	void		AddAncestors(A_long index, std::vector<bool>& mark, std::vector<A_long>& out) const;
+
+	// Append the layers a divider contains (positional range or row),
+	// skipping those already marked (marks them)
+	void		AddContained(A_long divider, std::vector<bool>& mark, std::vector<A_long>& out) const;
+
+	// Mark each root divider with its layers: the ones no sub group
+	// contains, or (nested) its whole tree. Roots that are not dividers
+	// are skipped.
+	void		SelectGroups(const std::vector<A_long>& roots, bool nested, std::vector<bool>& outSelected) const;
+
+	// True when a folded divider contains index, given each layer's fold
+	// state (only divider entries are read). O(depth).
+	bool		Hidden(A_long index, const std::vector<bool>& folded) const;
+
+private:
+	FoldOutline(const FoldOutline&);
+	FoldOutline& operator=(const FoldOutline&);
+
+	std::vector<A_long>			m_parent;
+	std::vector<A_long>			m_end;			// Dividers: one past the last positional member
+	std::vector<bool>			m_isDivider;
+	std::vector<bool>			m_hasRow;
+	std::vector<A_long>			m_dividers;		// Divider indices in order
+	std::unordered_map<AEGP_LayerIDVal, A_long>				m_index;
+	std::unordered_map<A_long, std::vector<A_long> >		m_rowMembers;	// By owner index
+	std::unordered_map<A_long, std::vector<A_long> >		m_rowOwners;	// By member index
+};
+
+#endif // FOLD_OUTLINE_H
@@ -0,0 +1,95 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Plan                                     */
+/*      Planning over a snapshot, apart from the reads and writes  */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldPlanner.h"
+
+#include <unordered_set>
+
+// A divider still open while walking down: it contains the layers below it
+// until a divider of the same or a higher level closes it
+typedef struct {
+	int		depth;
+	bool	hides;		// Folded once the plan is applied (positional members only)
+	bool	changes;	// Fold state flips
+} OpenGroup;
+
+bool FinalFolded(const FoldPlanLayer& layer)
+{
+	return layer.target == FoldTarget_Keep ? layer.folded : layer.target == FoldTarget_Fold;
+}
+
+void PlanFold(const std::vector<FoldPlanLayer>& layers, const FoldPlanRows& rows, FoldPlan& outPlan)
+{
+	outPlan.dividers.clear();
+	outPlan.shy.clear();
+
+	// Row owners hide / touch their members wherever those are
+	std::unordered_set<AEGP_LayerIDVal> rowHidden;
+	std::unordered_set<AEGP_LayerIDVal> rowTouched;
+	for (size_t i = 0; i < layers.size(); i++) {
+		const FoldPlanLayer& layer = layers[i];
+		if (!layer.isDivider || !layer.hasRow) continue;
+
+		FoldPlanRows::const_iterator row = rows.find(layer.id);
+		if (row == rows.end()) continue;
+
+		const bool folded = FinalFolded(layer);
+		const bool changes = folded != layer.folded;
+		for (size_t m = 0; m < row->second.size(); m++) {
+			if (folded) rowHidden.insert(row->second[m]);
+			if (changes) rowTouched.insert(row->second[m]);
+		}
+	}
+
+	std::vector<OpenGroup> open;
+	int hiding = 0;
+	int changing = 0;
+	for (size_t i = 0; i < layers.size(); i++) {
+		const FoldPlanLayer& layer = layers[i];
+
+		if (layer.isDivider) {
+			while (!open.empty() && open.back().depth >= layer.depth) {
+				if (open.back().hides) hiding--;
+				if (open.back().changes) changing--;
+				open.pop_back();
+			}
+		}
+
+		// A divider is itself a member of the groups around it
+		if (changing > 0 || rowTouched.count(layer.id)) {
+			const bool hide = hiding > 0 || rowHidden.count(layer.id) > 0;
+			if (hide != layer.shy) {
+				outPlan.shy.push_back(std::make_pair((A_long)i, hide));
+			}
+		}
+
+		if (layer.isDivider) {
+			const bool folded = FinalFolded(layer);
+			const bool changes = folded != layer.folded;
+			if (changes) outPlan.dividers.push_back((A_long)i);
+
+			// Row owners do not hide by position (but still end the groups above)
+			OpenGroup group;
+			group.depth = layer.depth;
+			group.hides = !layer.hasRow && folded;
+			group.changes = !layer.hasRow && changes;
+			if (group.hides) hiding++;
+			if (group.changes) changing++;
+			open.push_back(group);
+		}
+	}
+}
+
+void SetFoldLevelTargets(std::vector<FoldPlanLayer>& layers, A_long level, bool expand)
+{
+	// Expanding to N is folding to N + 1
+	const int firstFolded = (int)(expand ? level + 1 : level);
+	for (size_t i = 0; i < layers.size(); i++) {
+		if (!layers[i].isDivider) continue;
+		layers[i].target = layers[i].depth + 1 >= firstFolded ? FoldTarget_Fold : FoldTarget_Unfold;
+	}
+}
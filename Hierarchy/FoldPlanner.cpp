@@ -0,0 +1,150 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Planner                                  */
+/*      Target fold states -> minimal shy / state changes          */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldPlanner.h"
+#include "FoldLayers.h"
+#include "Cache/DividerIndex.h"
+
+#include <cstring>
+
+A_Err ReadFoldPlanLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long index, bool probeIdentity,
+						FoldPlanLayer& outLayer, std::string* outHierarchy, FoldPlanRows& rows)
+{
+	A_Err err = A_Err_NONE;
+
+	memset(&outLayer, 0, sizeof(outLayer));
+	outLayer.target = FoldTarget_Keep;
+
+	AEGP_LayerFlags flags = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, index, &outLayer.layerH));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(outLayer.layerH, &outLayer.id));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerFlags(outLayer.layerH, &flags));
+	if (err) return err;
+	outLayer.shy = (flags & AEGP_LayerFlag_SHY) != 0;
+
+	// Identity and fold state in one probe
+	if (probeIdentity) {
+		outLayer.isDivider = ProbeDividerState(suites, outLayer.layerH, &outLayer.folded);
+	}
+	if (!outLayer.isDivider) return err;
+
+	const std::string hierarchy = GetHierarchyFromHiddenGroup(suites, outLayer.layerH);
+	outLayer.depth = GetHierarchyDepth(hierarchy);
+	if (outHierarchy) *outHierarchy = hierarchy;
+
+	if (S_settings.groupMembership == GroupMembership_Explicit) {
+		std::vector<AEGP_LayerIDVal> members;
+		ERR(ReadGroupMembers(suites, outLayer.layerH, members, &outLayer.hasRow));
+		if (!err && outLayer.hasRow) rows[outLayer.id].swap(members);
+	}
+	return err;
+}
+
+A_Err SnapshotCompForPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  std::vector<FoldPlanLayer>& outLayers, FoldPlanRows& outRows)
+{
+	A_Err err = A_Err_NONE;
+	outLayers.clear();
+	outRows.clear();
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	// A current divider index entry saves the identity probe on every
+	// layer that is not a divider
+	std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+	bool indexed = false;
+	ERR(GetIndexedDividers(suites, compH, dividers, &indexed));
+	if (err) return err;
+
+	std::vector<bool> knownDivider;
+	if (indexed) {
+		knownDivider.assign((size_t)numLayers, false);
+		for (size_t d = 0; d < dividers.size(); d++) {
+			if (dividers[d].second >= 0 && dividers[d].second < numLayers) {
+				knownDivider[(size_t)dividers[d].second] = true;
+			}
+		}
+	}
+
+	outLayers.resize((size_t)numLayers);
+	for (A_long i = 0; i < numLayers && !err; i++) {
+		ERR(ReadFoldPlanLayer(suites, compH, i, !indexed || knownDivider[(size_t)i],
+			outLayers[(size_t)i], NULL, outRows));
+	}
+
+	if (!err && !indexed) ERR(RecordFoldSnapshot(suites, compH, outLayers));
+	return err;
+}
+
+A_Err RecordFoldSnapshot(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<FoldPlanLayer>& layers)
+{
+	std::vector<AEGP_LayerIDVal> ids;
+	std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+	ids.reserve(layers.size());
+	for (size_t i = 0; i < layers.size(); i++) {
+		ids.push_back(layers[i].id);
+		if (layers[i].isDivider) dividers.push_back(std::make_pair(layers[i].layerH, (A_long)i));
+	}
+	return RecordIndexedDividers(suites, compH, ids, dividers);
+}
+
+A_Err FoldSnapshotCurrent(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  const std::vector<FoldPlanLayer>& layers, bool* outCurrent)
+{
+	A_Err err = A_Err_NONE;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	*outCurrent = !err && numLayers == (A_long)layers.size();
+	for (A_long i = 0; *outCurrent && i < numLayers && !err; i++) {
+		AEGP_LayerH layerH = NULL;
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+		*outCurrent = !err && id == layers[(size_t)i].id;
+	}
+	return err;
+}
+
+A_Err SetDividerFolded(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH, bool fold)
+{
+	A_Err err = A_Err_NONE;
+
+	ERR(SetGroupState(suites, dividerH, fold));
+	if (!err && S_settings.syncNamePrefix) {
+		std::string currentName;
+		ERR(GetLayerNameStr(suites, dividerH, currentName));
+		if (!err) {
+			const std::string hierarchy = GetHierarchyFromHiddenGroup(suites, dividerH);
+			ERR(SetLayerNameStr(suites, dividerH, BuildDividerName(fold, hierarchy, GetDividerName(currentName))));
+		}
+	}
+	if (!err) NoteIndexedFold(suites, compH, dividerH, fold);
+	return err;
+}
+
+A_Err ApplyFoldPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+					const std::vector<FoldPlanLayer>& layers, const FoldPlan& plan)
+{
+	A_Err err = A_Err_NONE;
+
+	for (size_t d = 0; d < plan.dividers.size() && !err; d++) {
+		const FoldPlanLayer& divider = layers[(size_t)plan.dividers[d]];
+		const bool fold = FinalFolded(divider);
+		ERR(SetDividerFolded(suites, compH, divider.layerH, fold));
+		if (!err) S_fold_history.Note(suites, compH, divider.id, FoldHistory_Fold, fold);
+	}
+
+	for (size_t s = 0; s < plan.shy.size() && !err; s++) {
+		const FoldPlanLayer& layer = layers[(size_t)plan.shy[s].first];
+		ERR(suites.LayerSuite9()->AEGP_SetLayerFlag(layer.layerH, AEGP_LayerFlag_SHY, plan.shy[s].second ? TRUE : FALSE));
+		if (!err) S_fold_history.Note(suites, compH, layer.id, FoldHistory_Shy, plan.shy[s].second);
+	}
+	return err;
+}
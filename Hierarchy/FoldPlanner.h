@@ -0,0 +1,94 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Planner                                  */
+/*      Target fold states -> minimal shy / state changes          */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLD_PLANNER_H
+#define FOLD_PLANNER_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Target for one divider in a plan
+enum FoldTarget {
+	FoldTarget_Keep = -1,
+	FoldTarget_Unfold = 0,
+	FoldTarget_Fold = 1
+};
+
+// One layer of a comp snapshot, in index order
+typedef struct {
+	AEGP_LayerH		layerH;
+	AEGP_LayerIDVal	id;
+	bool			shy;
+	bool			isDivider;
+	// Dividers only
+	bool			folded;
+	bool			hasRow;		// Owns an explicit member row (see GroupMembership.h)
+	int				depth;		// GetHierarchyDepth
+	int				target;		// FoldTarget
+} FoldPlanLayer;
+
+// Explicit member rows by divider layer ID
+typedef std::unordered_map<AEGP_LayerIDVal, std::vector<AEGP_LayerIDVal> >	FoldPlanRows;
+
+// What applying the targets changes, as indices into the snapshot
+typedef struct {
+	std::vector<A_long>						dividers;	// Fold state flips to its target
+	std::vector<std::pair<A_long, bool> >	shy;		// New shy flag, only where it differs
+} FoldPlan;
+
+// Fold state a divider ends up in: its target, or its state under Keep
+bool FinalFolded(const FoldPlanLayer& layer);
+
+// One linear pass over the snapshot (plus the rows of dividers that have
+// them). A layer is visible when no folded divider contains it, where a
+// divider contains the layers below it up to the next divider of the same
+// or a higher level, or the members of its row. Only layers contained by a
+// divider whose state changes get a shy entry, so layers outside the
+// affected groups (and shy flags set by hand there) are left alone. The
+// result does not depend on the order the dividers change in.
+void PlanFold(const std::vector<FoldPlanLayer>& layers, const FoldPlanRows& rows, FoldPlan& outPlan);
+
+// Targets for every divider of a snapshot. Level = hierarchy depth + 1, so
+// top-level groups are level 1. Fold to level N folds groups at level N and
+// deeper and unfolds the ones above, leaving levels 1..N visible; Expand to
+// level N unfolds levels 1..N and folds everything deeper.
+void SetFoldLevelTargets(std::vector<FoldPlanLayer>& layers, A_long level, bool expand);
+
+// Read layer `index` of a comp (target Keep). probeIdentity false skips the
+// identity probe for a layer the divider index says is not a divider.
+// *outHierarchy (may be NULL) gets a divider's hierarchy path; its member
+// row goes into rows in explicit membership mode.
+A_Err ReadFoldPlanLayer(AEGP_SuiteHandler& suites, AEGP_CompH compH, A_long index, bool probeIdentity,
+						FoldPlanLayer& outLayer, std::string* outHierarchy, FoldPlanRows& rows);
+
+// Whole-comp snapshot in one call, using the divider index when it is
+// current (and refreshing it when it is not)
+A_Err SnapshotCompForPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  std::vector<FoldPlanLayer>& outLayers, FoldPlanRows& outRows);
+
+// Record a full snapshot as the comp's divider index entry
+A_Err RecordFoldSnapshot(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<FoldPlanLayer>& layers);
+
+// True when the comp still has the snapshot's layers in the same order
+A_Err FoldSnapshotCurrent(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						  const std::vector<FoldPlanLayer>& layers, bool* outCurrent);
+
+// Set one divider's fold state and name prefix, and tell the divider index
+A_Err SetDividerFolded(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH, bool fold);
+
+// Write a plan: fold state (and name prefix) of each changed divider, then
+// the shy flags, noting them in the fold history. The caller owns the undo group.
+A_Err ApplyFoldPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+					const std::vector<FoldPlanLayer>& layers, const FoldPlan& plan);
+
+#endif // FOLD_PLANNER_H
@@ -0,0 +1,67 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Member Rows                             */
+/*      FD-M: row text, apart from the marker I/O                  */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupMembership.h"
+#include "FoldLayers.h"
+
+#include <cstdio>
+#include <cstring>
+
+// 1-8 lowercase hex digits at *pos; advances *pos past them
+static bool ParseHexField(const std::string& text, size_t* pos, AEGP_LayerIDVal* outValue)
+{
+	AEGP_LayerIDVal value = 0;
+	size_t digits = 0;
+	while (*pos < text.length() && digits < 8) {
+		const char c = text[*pos];
+		int digit = -1;
+		if (c >= '0' && c <= '9') digit = c - '0';
+		else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+		if (digit < 0) break;
+
+		value = (value << 4) | (AEGP_LayerIDVal)digit;
+		digits++;
+		(*pos)++;
+	}
+	*outValue = value;
+	return digits > 0;
+}
+
+bool ParseGroupMemberRow(const std::string& text, AEGP_LayerIDVal* outOwner, std::vector<AEGP_LayerIDVal>& outMembers)
+{
+	outMembers.clear();
+
+	size_t pos = strlen(DIVIDER_MEMBERS_MARKER_PREFIX);
+	if (text.compare(0, pos, DIVIDER_MEMBERS_MARKER_PREFIX) != 0) return false;
+
+	if (!ParseHexField(text, &pos, outOwner) || pos >= text.length() || text[pos] != '|') return false;
+	pos++;
+	if (pos == text.length()) return true;  // Empty group
+
+	for (;;) {
+		AEGP_LayerIDVal id = 0;
+		if (!ParseHexField(text, &pos, &id) || outMembers.size() >= (size_t)GROUP_MEMBERS_MAX) return false;
+		outMembers.push_back(id);
+
+		if (pos == text.length()) return true;
+		if (text[pos] != ',') return false;
+		pos++;
+	}
+}
+
+std::string FormatGroupMemberRow(AEGP_LayerIDVal owner, const std::vector<AEGP_LayerIDVal>& members)
+{
+	std::string text = DIVIDER_MEMBERS_MARKER_PREFIX;
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%lx|", (unsigned long)owner);
+	text += buf;
+	for (size_t i = 0; i < members.size(); i++) {
+		snprintf(buf, sizeof(buf), i ? ",%lx" : "%lx", (unsigned long)members[i]);
+		text += buf;
+	}
+	return text;
+}
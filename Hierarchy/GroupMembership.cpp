@@ -0,0 +1,213 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Membership                              */
+/*      Explicit member tables keyed by stable layer IDs           */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupMembership.h"
+#include "FoldLayers.h"
+#include "Cache/LayerIdMap.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Members that fit in one marker record at the longest ID (",ffffffff"
+// each, after "FD-M:ffffffff|")
+static const size_t	MAX_ROW_MEMBERS		= (LAYER_MARKER_MAX_CHARS - 14) / 9;
+
+A_Err ReadGroupMembers(AEGP_SuiteHandler& suites, AEGP_LayerH dividerH,
+					   std::vector<AEGP_LayerIDVal>& outMembers, bool* outHasRow)
+{
+	A_Err err = A_Err_NONE;
+	*outHasRow = false;
+	outMembers.clear();
+
+	AEGP_KeyframeIndex index = -1;
+	std::string row;
+	ERR(FindLayerMarkerRecord(suites, dividerH, DIVIDER_MEMBERS_MARKER_PREFIX, &index, &row));
+	if (err || index < 0) return err;
+
+	AEGP_LayerIDVal owner = 0;
+	AEGP_LayerIDVal selfId = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(dividerH, &selfId));
+	if (!err && ParseGroupMemberRow(row, &owner, outMembers) && owner == selfId) {
+		*outHasRow = true;
+	} else {
+		outMembers.clear();
+	}
+	return err;
+}
+
+A_Err WriteGroupMembers(AEGP_SuiteHandler& suites, AEGP_LayerH dividerH,
+						const std::vector<AEGP_LayerIDVal>& members)
+{
+	A_Err err = A_Err_NONE;
+
+	AEGP_LayerIDVal selfId = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(dividerH, &selfId));
+	if (err) return err;
+
+	// A row that ParseGroupMemberRow or the marker reader would reject (or
+	// cut short) is never written: the old row stays and the caller fails
+	const std::string row = FormatGroupMemberRow(selfId, members);
+	if (members.size() > (size_t)GROUP_MEMBERS_MAX || row.size() > (size_t)LAYER_MARKER_MAX_CHARS) {
+		char msg[256];
+		snprintf(msg, sizeof(msg), "FoldLayers: A group can list at most %d layers in explicit membership mode (%d requested).",
+			(int)std::min((size_t)GROUP_MEMBERS_MAX, MAX_ROW_MEMBERS), (int)members.size());
+		suites.UtilitySuite6()->AEGP_ReportInfo(S_my_id, msg);
+		return A_Err_PARAMETER;
+	}
+
+	ERR(WriteLayerMarkerRecord(suites, dividerH, DIVIDER_MEMBERS_MARKER_PREFIX, row));
+	return err;
+}
+
+A_Err CaptureGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH)
+{
+	A_Err err = A_Err_NONE;
+
+	A_long dividerIndex = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(dividerH, &dividerIndex));
+
+	std::vector<AEGP_LayerH> layers;
+	ERR(GetGroupLayers(suites, compH, dividerIndex, GetHierarchyFromHiddenGroup(suites, dividerH), layers));
+
+	std::vector<AEGP_LayerIDVal> members;
+	members.reserve(layers.size());
+	for (size_t i = 0; i < layers.size() && !err; i++) {
+		AEGP_LayerIDVal id = 0;
+		ERR(suites.LayerSuite9()->AEGP_GetLayerID(layers[i], &id));
+		if (!err) members.push_back(id);
+	}
+
+	ERR(WriteGroupMembers(suites, dividerH, members));
+	return err;
+}
+
+A_Err ResolveGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH,
+						  std::vector<AEGP_LayerH>& outLayers, bool* outExplicit)
+{
+	A_Err err = A_Err_NONE;
+	*outExplicit = false;
+
+	std::vector<AEGP_LayerIDVal> members;
+	bool hasRow = false;
+	ERR(ReadGroupMembers(suites, dividerH, members, &hasRow));
+	if (err || !hasRow) return err;
+
+	outLayers.reserve(outLayers.size() + members.size());
+	for (size_t i = 0; i < members.size(); i++) {
+		AEGP_LayerH layerH = NULL;
+		if (S_layer_id_map.Resolve(suites, compH, members[i], &layerH, NULL) && layerH != dividerH) {
+			outLayers.push_back(layerH);
+		}
+	}
+
+	*outExplicit = true;
+	return err;
+}
+
+A_Err CollectFoldedNestedMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+								 const std::vector<AEGP_LayerH>& members,
+								 std::unordered_set<AEGP_LayerH>& outHidden)
+{
+	A_Err err = A_Err_NONE;
+
+	for (size_t i = 0; i < members.size() && !err; i++) {
+		bool folded = false;
+		if (!ProbeDividerState(suites, members[i], &folded) || !folded) continue;
+
+		std::vector<AEGP_LayerH> nested;
+		bool isExplicit = false;
+		ERR(ResolveGroupMembers(suites, compH, members[i], nested, &isExplicit));
+		if (!err && !isExplicit) {
+			// Nested divider without a row of its own: positional fallback
+			A_long index = 0;
+			ERR(suites.LayerSuite9()->AEGP_GetLayerIndex(members[i], &index));
+			ERR(GetGroupLayers(suites, compH, index, GetHierarchyFromHiddenGroup(suites, members[i]), nested));
+		}
+		outHidden.insert(nested.begin(), nested.end());
+	}
+
+	return err;
+}
+
+A_Err AdoptNewDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH anchorH,
+					  AEGP_LayerH newDividerH, const std::string& newHierarchy)
+{
+	A_Err err = A_Err_NONE;
+
+	ERR(CaptureGroupMembers(suites, compH, newDividerH));
+	if (err || !anchorH) return err;
+
+	std::vector<AEGP_LayerIDVal> newMembers;
+	bool hasRow = false;
+	AEGP_LayerIDVal anchorId = 0;
+	AEGP_LayerIDVal newId = 0;
+	ERR(ReadGroupMembers(suites, newDividerH, newMembers, &hasRow));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(anchorH, &anchorId));
+	ERR(suites.LayerSuite9()->AEGP_GetLayerID(newDividerH, &newId));
+
+	std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+	ERR(GetAllDividers(suites, compH, dividers));
+
+	for (size_t d = 0; d < dividers.size() && !err; d++) {
+		AEGP_LayerH dividerH = dividers[d].first;
+		if (dividerH == newDividerH) continue;
+
+		std::vector<AEGP_LayerIDVal> row;
+		bool dividerHasRow = false;
+		ERR(ReadGroupMembers(suites, dividerH, row, &dividerHasRow));
+		if (err || !dividerHasRow) continue;
+
+		std::vector<AEGP_LayerIDVal>::iterator anchorPos = std::find(row.begin(), row.end(), anchorId);
+		if (dividerH != anchorH && anchorPos == row.end()) continue;
+
+		const std::string hierarchy = GetHierarchyFromHiddenGroup(suites, dividerH);
+		const std::string parentPrefix = hierarchy + GROUP_HIERARCHY_SEP;
+		const bool nested = !hierarchy.empty() && newHierarchy.compare(0, parentPrefix.length(), parentPrefix) == 0;
+
+		if (nested) {
+			// The new divider sits right below the anchor inside this group
+			row.insert(dividerH == anchorH ? row.begin() : anchorPos + 1, newId);
+		} else {
+			// Same or higher level: the new group takes its members with it
+			for (size_t m = 0; m < newMembers.size(); m++) {
+				row.erase(std::remove(row.begin(), row.end(), newMembers[m]), row.end());
+			}
+		}
+		ERR(WriteGroupMembers(suites, dividerH, row));
+	}
+
+	return err;
+}
+
+A_Err RemapGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds)
+{
+	A_Err err = A_Err_NONE;
+	if (newIds.empty()) return err;
+
+	std::vector<std::pair<AEGP_LayerH, A_long> > dividers;
+	ERR(GetAllDividers(suites, compH, dividers));
+
+	for (size_t d = 0; d < dividers.size() && !err; d++) {
+		std::vector<AEGP_LayerIDVal> row;
+		bool hasRow = false;
+		ERR(ReadGroupMembers(suites, dividers[d].first, row, &hasRow));
+		if (err || !hasRow) continue;
+
+		bool changed = false;
+		for (size_t m = 0; m < row.size(); m++) {
+			std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>::const_iterator it = newIds.find(row[m]);
+			if (it == newIds.end()) continue;
+			row[m] = it->second;
+			changed = true;
+		}
+		if (changed) ERR(WriteGroupMembers(suites, dividers[d].first, row));
+	}
+
+	return err;
+}
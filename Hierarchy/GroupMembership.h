@@ -0,0 +1,75 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Membership                              */
+/*      Explicit member tables keyed by stable layer IDs           */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef GROUP_MEMBERSHIP_H
+#define GROUP_MEMBERSHIP_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Positional membership (the default) is "every layer below the divider up
+// to the next divider of the same or a higher level". In explicit mode each
+// divider instead carries its own member row in an "FD-M:" layer marker:
+//   FD-M:<divider layer id>|<member id>,<member id>,...   (hex, comp order)
+// Layer IDs survive reorders and renames, so moving layers around no longer
+// changes which group they belong to. The owner ID detects rows copied onto
+// another layer (duplicate / paste); such rows are ignored.
+// Together the rows of a comp's dividers form its membership table.
+
+// Upper bound on members per row (keeps a corrupt row from exploding)
+#define GROUP_MEMBERS_MAX	4096
+
+// Parse / format one row (GroupMemberRow.cpp). ParseGroupMemberRow fails on malformed rows.
+bool ParseGroupMemberRow(const std::string& text, AEGP_LayerIDVal* outOwner, std::vector<AEGP_LayerIDVal>& outMembers);
+std::string FormatGroupMemberRow(AEGP_LayerIDVal owner, const std::vector<AEGP_LayerIDVal>& members);
+
+// Member IDs of one divider. *outHasRow is false when the divider has no
+// valid row of its own (positional membership applies).
+A_Err ReadGroupMembers(AEGP_SuiteHandler& suites, AEGP_LayerH dividerH,
+					   std::vector<AEGP_LayerIDVal>& outMembers, bool* outHasRow);
+
+// Replace the divider's row. A row over the member limit or the marker
+// record length is refused with a report (A_Err_PARAMETER; old row kept).
+A_Err WriteGroupMembers(AEGP_SuiteHandler& suites, AEGP_LayerH dividerH,
+						const std::vector<AEGP_LayerIDVal>& members);
+
+// Snapshot the divider's positional members into its row
+A_Err CaptureGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH);
+
+// Members of dividerH as layer handles, in row order, resolved through
+// S_layer_id_map (Cache/LayerIdMap.h): O(members), no comp scan. IDs of
+// deleted layers are skipped. *outExplicit is false (and outLayers
+// untouched) without a row.
+A_Err ResolveGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH dividerH,
+						  std::vector<AEGP_LayerH>& outLayers, bool* outExplicit);
+
+// Members of every folded divider among members (unfold keeps these hidden)
+A_Err CollectFoldedNestedMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+								 const std::vector<AEGP_LayerH>& members,
+								 std::unordered_set<AEGP_LayerH>& outHidden);
+
+// Give a newly created divider its row and update the rows of the groups
+// around anchorH (the layer it was created below; may be NULL): a nested
+// divider joins its parent's row, a same-level divider takes its members
+// out of the neighbouring group's row.
+A_Err AdoptNewDivider(AEGP_SuiteHandler& suites, AEGP_CompH compH, AEGP_LayerH anchorH,
+					  AEGP_LayerH newDividerH, const std::string& newHierarchy);
+
+// Point every row of compH at replacement layers (e.g. shape dividers
+// converted to nulls): member IDs found in newIds are swapped for their
+// mapped IDs. One pass over the comp's dividers; only changed rows are
+// written. The replacements' own rows are the caller's to move.
+A_Err RemapGroupMembers(AEGP_SuiteHandler& suites, AEGP_CompH compH,
+						const std::unordered_map<AEGP_LayerIDVal, AEGP_LayerIDVal>& newIds);
+
+#endif // GROUP_MEMBERSHIP_H
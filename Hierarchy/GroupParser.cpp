@@ -91,3 +91,36 @@ std::string GetDividerName(const std::string& fullName)
 	if (pos == 0) return fullName;
 	return fullName.substr(pos);
 }
+
+std::string ChildHierarchy(const std::string& parentHierarchy, int ordinal)
+{
+	if (ordinal < 1) return "";
+
+	if (parentHierarchy.empty()) {
+		if (ordinal > 999) return "";
+		return std::to_string(ordinal);
+	}
+
+	// Labels past 'z' would not survive GetHierarchy's character check
+	const int depth = GetHierarchyDepth(parentHierarchy);
+	char label;
+	if (depth == 1) {
+		if (ordinal > 26) return "";
+		label = (char)('A' + ordinal - 1);
+	} else if (depth == 2) {
+		if (ordinal > 26) return "";
+		label = (char)('a' + ordinal - 1);
+	} else {
+		if (ordinal > 'z' - 'i' + 1) return "";
+		label = (char)('i' + ordinal - 1);
+	}
+	return parentHierarchy + GROUP_HIERARCHY_SEP + label;
+}
+
+std::string FreeChildHierarchy(const std::string& parentHierarchy, const std::unordered_set<std::string>& used)
+{
+	for (int ordinal = 1; ; ordinal++) {
+		const std::string child = ChildHierarchy(parentHierarchy, ordinal);
+		if (child.empty() || !used.count(child)) return child;
+	}
+}
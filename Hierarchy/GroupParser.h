@@ -12,6 +12,7 @@
 
 #include "AEConfig.h"
 #include <string>
+#include <unordered_set>
 
 // Parse hierarchy from name like "▾(1/B) Group" -> "1/B"
 std::string GetHierarchy(const std::string& name);
@@ -23,4 +24,12 @@ int GetHierarchyDepth(const std::string& hierarchy);
 // Example: "▾(1/B) My Group" -> "My Group"
 std::string GetDividerName(const std::string& fullName);
 
+// Path of the ordinal-th (1-based) child group of parentHierarchy, in the
+// scheme Create Group uses: 1-999 below an unnumbered top-level group, then
+// A-Z, a-z and i-z. Empty when the level has no such label.
+std::string ChildHierarchy(const std::string& parentHierarchy, int ordinal);
+
+// Smallest child path of parentHierarchy not in used (empty: level full)
+std::string FreeChildHierarchy(const std::string& parentHierarchy, const std::unordered_set<std::string>& used);
+
 #endif // GROUP_PARSER_H
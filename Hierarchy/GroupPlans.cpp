@@ -0,0 +1,245 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Plans                                   */
+/*      Layer orders for the group commands, from a group tree     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupPlans.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+static bool SameLevel(const GroupTree& tree, A_long a, A_long b)
+{
+	return tree.Divider(a).depth == tree.Divider(b).depth;
+}
+
+void PlanGroupMove(const GroupTree& tree, const std::vector<A_long>& roots, int direction,
+				   A_long targetIndex, std::vector<A_long>& outOrder)
+{
+	outOrder.clear();
+
+	std::vector<bool> selected((size_t)tree.Count(), false);
+	for (size_t r = 0; r < roots.size(); r++) selected[(size_t)roots[r]] = true;
+
+	// Parents whose children move, each once
+	std::vector<A_long> parents;
+	for (size_t r = 0; r < roots.size(); r++) {
+		const A_long parent = tree.Parent(roots[r]);
+		if (std::find(parents.begin(), parents.end(), parent) == parents.end()) parents.push_back(parent);
+	}
+
+	bool moved = false;
+	std::vector<A_long> order((size_t)tree.NumLayers());
+	for (A_long i = 0; i < tree.NumLayers(); i++) order[(size_t)i] = i;
+
+	for (size_t p = 0; p < parents.size(); p++) {
+		const std::vector<A_long>& children = tree.Children(parents[p]);
+		std::vector<A_long> sorted(children);
+
+		if (direction == MoveGroup_Up) {
+			// A run of selected groups moves up together past the group above it
+			for (size_t c = 1; c < sorted.size(); c++) {
+				if (!selected[(size_t)sorted[c]] || selected[(size_t)sorted[c - 1]]) continue;
+				if (!SameLevel(tree, sorted[c], sorted[c - 1])) continue;
+				std::swap(sorted[c], sorted[c - 1]);
+				moved = true;
+			}
+		} else if (direction == MoveGroup_Down) {
+			for (size_t c = sorted.size(); c-- > 1; ) {
+				if (!selected[(size_t)sorted[c - 1]] || selected[(size_t)sorted[c]]) continue;
+				if (!SameLevel(tree, sorted[c], sorted[c - 1])) continue;
+				std::swap(sorted[c], sorted[c - 1]);
+				moved = true;
+			}
+		} else {
+			// The slot of the sibling holding the target layer (clamped to the siblings)
+			const A_long root = roots[0];
+			const size_t from = (size_t)(std::find(sorted.begin(), sorted.end(), root) - sorted.begin());
+			size_t to = 0;
+			while (to + 1 < sorted.size() && tree.End(sorted[to]) <= targetIndex) to++;
+
+			bool level = true;
+			for (size_t c = std::min(from, to); c <= std::max(from, to) && level; c++) {
+				level = SameLevel(tree, sorted[c], root);
+			}
+			if (level && to != from) {
+				sorted.erase(sorted.begin() + (std::ptrdiff_t)from);
+				sorted.insert(sorted.begin() + (std::ptrdiff_t)to, root);
+				moved = true;
+			}
+		}
+
+		// The children's blocks tile [first child, parent end): lay them out again
+		A_long at = children.empty() ? 0 : tree.Divider(children[0]).index;
+		for (size_t c = 0; c < sorted.size(); c++) {
+			for (A_long i = tree.Divider(sorted[c]).index; i < tree.End(sorted[c]); i++) order[(size_t)at++] = i;
+		}
+	}
+
+	if (moved) outOrder.swap(order);
+}
+
+void PlanGroupSelection(const GroupTree& tree, const std::vector<A_long>& selectedIndices,
+						GroupSelectionPlan& outPlan)
+{
+	outPlan.parent = -1;
+	outPlan.insertAt = 0;
+	outPlan.roots.clear();
+	outPlan.order.clear();
+	outPlan.layers = 0;
+
+	const A_long numLayers = tree.NumLayers();
+	std::vector<A_long> selected(selectedIndices);
+	std::sort(selected.begin(), selected.end());
+	selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+
+	// Units: single layers, and selected groups with their subtree (which
+	// swallows anything selected inside them). Each unit's container.
+	std::vector<bool> gathered((size_t)numLayers, false);
+	std::vector<A_long> containers;
+	A_long coveredEnd = 0;
+	for (size_t s = 0; s < selected.size(); s++) {
+		const A_long index = selected[s];
+		if (index < coveredEnd || index < 0 || index >= numLayers) continue;
+
+		const A_long d = tree.AtIndex(index);
+		A_long end = index + 1;
+		if (d >= 0) {
+			outPlan.roots.push_back(d);
+			containers.push_back(tree.Parent(d));
+			end = tree.End(d);
+		} else {
+			containers.push_back(tree.Container(index));
+		}
+		for (A_long i = index; i < end; i++) gathered[(size_t)i] = true;
+		outPlan.layers += end - index;
+		coveredEnd = end;
+	}
+	if (containers.empty()) return;
+
+	// Innermost group holding every unit
+	A_long parent = containers[0];
+	for (size_t c = 1; c < containers.size(); c++) {
+		while (!tree.Encloses(parent, containers[c])) parent = tree.Parent(parent);
+	}
+	outPlan.parent = parent;
+
+	// The first unit's group among the parent's children: the new group goes
+	// right above it. A first unit among the parent's direct members puts
+	// the new group after them, at the top of the child groups.
+	const A_long first = selected[0];
+	A_long child = tree.AtIndex(first) >= 0 ? tree.AtIndex(first) : tree.Container(first);
+	while (child != parent && tree.Parent(child) != parent) child = tree.Parent(child);
+
+	A_long key = 0;
+	if (child != parent) {
+		key = tree.Divider(child).index;
+	} else {
+		const std::vector<A_long>& children = tree.Children(parent);
+		if (!children.empty()) {
+			key = tree.Divider(children[0]).index;
+		} else {
+			key = parent >= 0 ? tree.End(parent) : numLayers;
+		}
+	}
+	A_long insertAt = key;
+	while (insertAt < numLayers && gathered[(size_t)insertAt]) insertAt++;
+	outPlan.insertAt = insertAt;
+
+	// Order once the divider exists at insertAt: the layers that stay, with
+	// the divider and the units (in their order) spliced in at insertAt
+	std::vector<A_long>& order = outPlan.order;
+	order.reserve((size_t)numLayers + 1);
+	for (A_long i = 0; i < insertAt; i++) {
+		if (!gathered[(size_t)i]) order.push_back(i);
+	}
+	order.push_back(insertAt);
+	for (A_long i = 0; i < numLayers; i++) {
+		if (gathered[(size_t)i]) order.push_back(i < insertAt ? i : i + 1);
+	}
+	for (A_long i = insertAt; i < numLayers; i++) {
+		if (!gathered[(size_t)i]) order.push_back(i + 1);
+	}
+}
+
+void PlanDuplicateOrder(A_long numLayers, const std::vector<std::vector<A_long> >& copyIndices,
+						const std::vector<A_long>& rootEnds, std::vector<A_long>& outOrder)
+{
+	outOrder.clear();
+
+	std::vector<bool> isCopy((size_t)numLayers, false);
+	for (size_t r = 0; r < copyIndices.size(); r++) {
+		for (size_t c = 0; c < copyIndices[r].size(); c++) isCopy[(size_t)copyIndices[r][c]] = true;
+	}
+
+	// Old index -> root whose subtree ends there
+	std::unordered_map<A_long, size_t> blockAfter;
+	for (size_t r = 0; r < rootEnds.size(); r++) blockAfter[rootEnds[r] - 1] = r;
+
+	outOrder.reserve((size_t)numLayers);
+	A_long original = 0;
+	for (A_long i = 0; i < numLayers; i++) {
+		if (isCopy[(size_t)i]) continue;
+		outOrder.push_back(i);
+
+		std::unordered_map<A_long, size_t>::const_iterator block = blockAfter.find(original++);
+		if (block != blockAfter.end()) {
+			const std::vector<A_long>& copies = copyIndices[block->second];
+			outOrder.insert(outOrder.end(), copies.begin(), copies.end());
+		}
+	}
+}
+
+A_long SurvivingGroup(const GroupTree& tree, const std::vector<bool>& removed, A_long d)
+{
+	while (d >= 0 && removed[(size_t)d]) d = tree.Parent(d);
+	return d;
+}
+
+void PlanUngroupOrder(const GroupTree& tree, const std::vector<bool>& removed, std::vector<A_long>& outOrder)
+{
+	outOrder.clear();
+
+	const A_long numLayers = tree.NumLayers();
+	std::vector<A_long> newIndex((size_t)numLayers, -1);
+	A_long remaining = 0;
+
+	// Direct members and child groups of each surviving group (shifted by
+	// one: [0] is the top level), in index order
+	std::vector<std::vector<A_long> > members((size_t)tree.Count() + 1);
+	std::vector<std::vector<A_long> > children((size_t)tree.Count() + 1);
+	for (A_long i = 0; i < numLayers; i++) {
+		const A_long d = tree.AtIndex(i);
+		if (d >= 0 && removed[(size_t)d]) continue;
+		newIndex[(size_t)i] = remaining++;
+
+		if (d < 0) {
+			members[(size_t)(SurvivingGroup(tree, removed, tree.Container(i)) + 1)].push_back(i);
+		} else {
+			children[(size_t)(SurvivingGroup(tree, removed, tree.Parent(d)) + 1)].push_back(d);
+		}
+	}
+
+	outOrder.reserve((size_t)remaining);
+	for (size_t m = 0; m < members[0].size(); m++) outOrder.push_back(newIndex[(size_t)members[0][m]]);
+
+	// Depth first: a group, its direct members, then its child groups
+	std::vector<std::pair<A_long, size_t> > open(1, std::make_pair((A_long)-1, (size_t)0));
+	while (!open.empty()) {
+		const A_long group = open.back().first;
+		const std::vector<A_long>& kids = children[(size_t)(group + 1)];
+		if (open.back().second >= kids.size()) {
+			open.pop_back();
+			continue;
+		}
+
+		const A_long child = kids[open.back().second++];
+		outOrder.push_back(newIndex[(size_t)tree.Divider(child).index]);
+		const std::vector<A_long>& direct = members[(size_t)(child + 1)];
+		for (size_t m = 0; m < direct.size(); m++) outOrder.push_back(newIndex[(size_t)direct[m]]);
+		open.push_back(std::make_pair(child, (size_t)0));
+	}
+}
@@ -0,0 +1,73 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Plans                                   */
+/*      Layer orders for the group commands, from a group tree     */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef GROUP_PLANS_H
+#define GROUP_PLANS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "GroupTree.h"
+#include <vector>
+
+// The plans the group commands run through PlanReorder. They read only the
+// tree or layer indices, so they run (and are tested) without After Effects.
+
+enum MoveGroupDirection {
+	MoveGroup_Up = 0,
+	MoveGroup_Down,
+	MoveGroup_ToIndex
+};
+
+// New layer order (see PlanReorder) after moving each root group (tree
+// indices) one place up or down among the groups of its parent, or the
+// single root to the sibling slot holding targetIndex. A group and the
+// sibling it passes must be at the same level. order is empty when nothing
+// can move.
+void PlanGroupMove(const GroupTree& tree, const std::vector<A_long>& roots, int direction,
+				   A_long targetIndex, std::vector<A_long>& outOrder);
+
+typedef struct {
+	A_long				parent;		// Tree index of the group the new one nests in (-1: top level)
+	A_long				insertAt;	// Index the new divider is created at, before any move
+	std::vector<A_long>	roots;		// Selected groups that move in whole (tree indices)
+	std::vector<A_long>	order;		// Layer order after creating the divider (see PlanReorder)
+	A_long				layers;		// Layers that end up in the new group
+} GroupSelectionPlan;
+
+// Where a new group for the selected layers (comp indices) goes and the
+// order that makes them its contiguous members, in their relative order.
+// A selected group layer brings its whole subtree. The new group nests in
+// the innermost group holding every selected layer, and is placed at a
+// boundary between that group's child groups (after its own direct
+// members), so no layer that stays joins or leaves a group by position.
+// order is empty when nothing is selected.
+void PlanGroupSelection(const GroupTree& tree, const std::vector<A_long>& selectedIndices,
+						GroupSelectionPlan& outPlan);
+
+// Order (see PlanReorder) that puts each root's copies right below the
+// root's subtree, in subtree order. numLayers counts the copies;
+// copyIndices[r] are the current indices of root r's copies; every other
+// layer is an original, in its old relative order. rootEnds[r] is the old
+// End() of root r.
+void PlanDuplicateOrder(A_long numLayers, const std::vector<std::vector<A_long> >& copyIndices,
+						const std::vector<A_long>& rootEnds, std::vector<A_long>& outOrder);
+
+// Nearest group at or above d that is not removed (-1: top level)
+A_long SurvivingGroup(const GroupTree& tree, const std::vector<bool>& removed, A_long d);
+
+// Order (see PlanReorder) of the comp once the dividers flagged in removed
+// are deleted (indices as they are then). Each surviving group lists its
+// direct members, including those of removed groups it takes over, before
+// its child groups, so layers that were directly in a removed group stay
+// direct members of the group above it rather than join a sibling group.
+// Layers left in no group (the direct members of removed top-level groups
+// included) go first, to the top of the comp, above every group.
+void PlanUngroupOrder(const GroupTree& tree, const std::vector<bool>& removed, std::vector<A_long>& outOrder);
+
+#endif // GROUP_PLANS_H
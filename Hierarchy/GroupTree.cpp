@@ -0,0 +1,66 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Tree                                    */
+/*      Positional group structure from divider depths alone       */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupTree.h"
+
+#include <algorithm>
+
+static bool DividerBeforeIndex(const IndexedDivider& divider, A_long index)
+{
+	return divider.index < index;
+}
+
+GroupTree::GroupTree()
+	: m_numLayers(0)
+{
+}
+
+void GroupTree::Build(const std::vector<IndexedDivider>& dividers, A_long numLayers)
+{
+	const size_t count = dividers.size();
+	m_numLayers = numLayers;
+	m_dividers = dividers;
+	m_parent.assign(count, -1);
+	m_end.assign(count, numLayers);
+	m_children.assign(count + 1, std::vector<A_long>());
+
+	std::vector<A_long> open;
+	for (size_t d = 0; d < count; d++) {
+		while (!open.empty() && m_dividers[(size_t)open.back()].depth >= m_dividers[d].depth) {
+			m_end[(size_t)open.back()] = m_dividers[d].index;
+			open.pop_back();
+		}
+		m_parent[d] = open.empty() ? -1 : open.back();
+		m_children[(size_t)(m_parent[d] + 1)].push_back((A_long)d);
+		open.push_back((A_long)d);
+	}
+}
+
+A_long GroupTree::AtIndex(A_long layerIndex) const
+{
+	std::vector<IndexedDivider>::const_iterator it =
+		std::lower_bound(m_dividers.begin(), m_dividers.end(), layerIndex, DividerBeforeIndex);
+	return (it != m_dividers.end() && it->index == layerIndex) ? (A_long)(it - m_dividers.begin()) : -1;
+}
+
+A_long GroupTree::Container(A_long layerIndex) const
+{
+	// Nearest divider above, then out to the first group still open here
+	std::vector<IndexedDivider>::const_iterator it =
+		std::lower_bound(m_dividers.begin(), m_dividers.end(), layerIndex, DividerBeforeIndex);
+	A_long d = (A_long)(it - m_dividers.begin()) - 1;
+	while (d >= 0 && m_end[(size_t)d] <= layerIndex) d = m_parent[(size_t)d];
+	return d;
+}
+
+bool GroupTree::Encloses(A_long a, A_long b) const
+{
+	if (a < 0) return true;
+	if (b < 0) return false;
+	const A_long index = m_dividers[(size_t)b].index;
+	return m_dividers[(size_t)a].index <= index && index < m_end[(size_t)a];
+}
@@ -0,0 +1,71 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Tree                                    */
+/*      Positional group structure from divider depths alone       */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef GROUP_TREE_H
+#define GROUP_TREE_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Cache/DividerIndex.h"
+#include <vector>
+
+// The groups of a comp by position: a divider's subtree runs from the
+// divider to the next divider of the same or a higher level, and a group's
+// child groups tile the end of that range. Built in one pass over the
+// dividers; layer handles and indices are as of the read.
+class GroupTree {
+public:
+	GroupTree();
+
+	void		Build(const std::vector<IndexedDivider>& dividers, A_long numLayers);
+
+	A_long		NumLayers() const { return m_numLayers; }
+	A_long		Count() const { return (A_long)m_dividers.size(); }
+
+	const IndexedDivider&		Divider(A_long d) const { return m_dividers[(size_t)d]; }
+	A_long						Parent(A_long d) const { return m_parent[(size_t)d]; }
+	// One past the last layer index of d's subtree
+	A_long						End(A_long d) const { return m_end[(size_t)d]; }
+	// Child groups in order; d = -1 for the top-level groups
+	const std::vector<A_long>&	Children(A_long d) const { return m_children[(size_t)(d + 1)]; }
+
+	// Divider at a layer index (-1: not a divider)
+	A_long		AtIndex(A_long layerIndex) const;
+	// Innermost divider whose subtree holds the layer, the layer's own divider excluded (-1: none)
+	A_long		Container(A_long layerIndex) const;
+	// a is b or one of its ancestors (-1: the top level holds everything)
+	bool		Encloses(A_long a, A_long b) const;
+
+private:
+	GroupTree(const GroupTree&);
+	GroupTree& operator=(const GroupTree&);
+
+	A_long								m_numLayers;
+	std::vector<IndexedDivider>			m_dividers;		// In index order
+	std::vector<A_long>					m_parent;
+	std::vector<A_long>					m_end;
+	std::vector<std::vector<A_long> >	m_children;		// Shifted by one: [0] is the top level
+};
+
+// Defined in GroupTreeReader.cpp: the class above runs without After
+// Effects, these read the comp.
+
+// Tree of compH from the divider index when it is current and every
+// divider is confirmed at its live index (*outIndexed), else (or with
+// forceScan) from a divider scan, which also records a fresh index entry
+A_Err ReadGroupTree(AEGP_SuiteHandler& suites, AEGP_CompH compH, GroupTree& outTree, bool* outIndexed,
+					bool forceScan = false);
+
+// d's subtree still spans the same layers of compH: its divider is at its
+// live index and the layer at End(d) is the divider the tree has there (or
+// End(d) is still the layer count). Checked before handles are read by
+// index for a whole range.
+bool GroupRangeIsLive(AEGP_SuiteHandler& suites, AEGP_CompH compH, const GroupTree& tree, A_long d);
+
+#endif // GROUP_TREE_H
@@ -0,0 +1,89 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Tree Reader                             */
+/*      Group trees of live comps, and range checks against them   */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GroupTree.h"
+#include "FoldLayers.h"
+
+// Every divider still at the index it was served with. The plans built on
+// a tree fetch handles by index, so a tree that lags a reorder would move
+// or delete the wrong layers.
+static bool DividersAtLiveIndices(AEGP_SuiteHandler& suites, const std::vector<IndexedDivider>& dividers)
+{
+	for (size_t d = 0; d < dividers.size(); d++) {
+		A_long index = -1;
+		if (suites.LayerSuite9()->AEGP_GetLayerIndex(dividers[d].layerH, &index) != A_Err_NONE ||
+			index != dividers[d].index) {
+			return false;
+		}
+	}
+	return true;
+}
+
+A_Err ReadGroupTree(AEGP_SuiteHandler& suites, AEGP_CompH compH, GroupTree& outTree, bool* outIndexed,
+					bool forceScan)
+{
+	A_Err err = A_Err_NONE;
+	*outIndexed = false;
+
+	A_long numLayers = 0;
+	ERR(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+	if (err) return err;
+
+	std::vector<IndexedDivider> dividers;
+	if (!forceScan) ERR(GetIndexedStructure(suites, compH, dividers, outIndexed));
+	if (err) return err;
+
+	if (*outIndexed && !DividersAtLiveIndices(suites, dividers)) {
+		A_long itemId = 0;
+		if (GetCompItemId(suites, compH, &itemId) == A_Err_NONE) S_divider_index.Invalidate(itemId);
+		*outIndexed = false;
+	}
+
+	if (!*outIndexed) {
+		dividers.clear();
+		std::vector<std::pair<AEGP_LayerH, A_long> > found;
+		ERR(GetAllDividers(suites, compH, found));
+		for (size_t f = 0; f < found.size() && !err; f++) {
+			IndexedDivider divider;
+			divider.layerH = found[f].first;
+			divider.index = found[f].second;
+			divider.depth = GetHierarchyDepth(GetHierarchyFromHiddenGroup(suites, divider.layerH));
+			divider.folded = false;
+			ProbeDividerState(suites, divider.layerH, &divider.folded);
+			ERR(suites.LayerSuite9()->AEGP_GetLayerID(divider.layerH, &divider.id));
+			dividers.push_back(divider);
+		}
+		if (err) return err;
+	}
+
+	outTree.Build(dividers, numLayers);
+	return err;
+}
+
+bool GroupRangeIsLive(AEGP_SuiteHandler& suites, AEGP_CompH compH, const GroupTree& tree, A_long d)
+{
+	const IndexedDivider& divider = tree.Divider(d);
+	A_long index = -1;
+	if (suites.LayerSuite9()->AEGP_GetLayerIndex(divider.layerH, &index) != A_Err_NONE || index != divider.index) {
+		return false;
+	}
+
+	const A_long end = tree.End(d);
+	if (end >= tree.NumLayers()) {
+		A_long numLayers = 0;
+		return suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers) == A_Err_NONE &&
+			numLayers == tree.NumLayers();
+	}
+
+	const A_long next = tree.AtIndex(end);
+	AEGP_LayerH layerH = NULL;
+	AEGP_LayerIDVal id = 0;
+	return next >= 0 &&
+		suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, end, &layerH) == A_Err_NONE &&
+		suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id) == A_Err_NONE &&
+		id == tree.Divider(next).id;
+}
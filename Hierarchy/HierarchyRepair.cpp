@@ -0,0 +1,54 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Hierarchy Repair                              */
+/*      New hierarchy paths after group layers are removed         */
+/*                                                                 */
+/*******************************************************************/
+
+#include "HierarchyRepair.h"
+#include "FoldLayers.h"
+
+#include <unordered_set>
+
+bool RepairHierarchy(const GroupTree& tree, const std::vector<std::string>& paths,
+					 const std::vector<bool>& removed, std::vector<std::string>& outPaths)
+{
+	const A_long count = tree.Count();
+	outPaths = paths;
+
+	// Dividers inside a removed group's range move; every other survivor
+	// keeps its path, which stays taken
+	std::vector<bool> moving((size_t)count, false);
+	std::unordered_set<std::string> used;
+	A_long removedEnd = 0;
+	for (A_long d = 0; d < count; d++) {
+		if (removed[(size_t)d]) {
+			if (tree.End(d) > removedEnd) removedEnd = tree.End(d);
+			continue;
+		}
+		moving[(size_t)d] = tree.Divider(d).index < removedEnd;
+		if (!moving[(size_t)d]) used.insert(paths[(size_t)d]);
+	}
+
+	// survivor[d]: d itself, or for a removed divider its nearest surviving ancestor
+	std::vector<A_long> survivor((size_t)count, -1);
+	std::vector<A_long> open;
+	for (A_long d = 0; d < count; d++) {
+		while (!open.empty() && tree.End(open.back()) <= tree.Divider(d).index) open.pop_back();
+		const A_long above = open.empty() ? -1 : survivor[(size_t)open.back()];
+		survivor[(size_t)d] = removed[(size_t)d] ? above : d;
+
+		if (moving[(size_t)d]) {
+			// Parents come first, so the new parent's path is already final
+			std::string path;
+			if (above >= 0) {
+				path = FreeChildHierarchy(outPaths[(size_t)above], used);
+				if (path.empty()) return false;
+			}
+			outPaths[(size_t)d] = path;
+			used.insert(path);
+		}
+		open.push_back(d);
+	}
+	return true;
+}
@@ -0,0 +1,29 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Hierarchy Repair                              */
+/*      New hierarchy paths after group layers are removed         */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef HIERARCHY_REPAIR_H
+#define HIERARCHY_REPAIR_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include "Hierarchy/GroupTree.h"
+#include <string>
+#include <vector>
+
+// Paths once the dividers flagged in removed are gone and the groups below
+// them move up to their nearest surviving ancestor. paths[d] is divider d's
+// current path. One pass in index order over a stack of open groups: only
+// dividers below a removed group get a new path, the first free child path
+// of their new parent (the old paths of the moving groups count as free),
+// so outPaths[d] differs from paths[d] only where a record must be written.
+// Returns false when a level runs out of labels.
+bool RepairHierarchy(const GroupTree& tree, const std::vector<std::string>& paths,
+					 const std::vector<bool>& removed, std::vector<std::string>& outPaths);
+
+#endif // HIERARCHY_REPAIR_H
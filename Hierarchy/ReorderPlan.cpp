@@ -0,0 +1,93 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Reorder Plan                                  */
+/*      Fewest AEGP_ReorderLayer calls for a new layer order       */
+/*                                                                 */
+/*******************************************************************/
+
+#include "ReorderPlan.h"
+#include "FoldLayers.h"
+
+#include <algorithm>
+
+void PlanReorder(const std::vector<A_long>& order, std::vector<ReorderMove>& outMoves)
+{
+	outMoves.clear();
+
+	const A_long count = (A_long)order.size();
+	A_long lo = 0;
+	while (lo < count && order[(size_t)lo] == lo) lo++;
+	if (lo == count) return;
+	A_long hi = count - 1;
+	while (order[(size_t)hi] == hi) hi--;
+
+	// Target position of each layer in the span, walked in current order
+	const A_long span = hi - lo + 1;
+	std::vector<A_long> target((size_t)span);
+	for (A_long t = lo; t <= hi; t++) target[(size_t)(order[(size_t)t] - lo)] = t - lo;
+
+	// Longest increasing run of targets (patience sorting, with links back)
+	std::vector<A_long> tails;			// Span position ending the best run of each length
+	std::vector<A_long> previous((size_t)span, -1);
+	for (A_long p = 0; p < span; p++) {
+		A_long low = 0;
+		A_long high = (A_long)tails.size();
+		while (low < high) {
+			const A_long mid = (low + high) / 2;
+			if (target[(size_t)tails[(size_t)mid]] < target[(size_t)p]) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		if (low > 0) previous[(size_t)p] = tails[(size_t)low - 1];
+		if (low == (A_long)tails.size()) {
+			tails.push_back(p);
+		} else {
+			tails[(size_t)low] = p;
+		}
+	}
+	std::vector<bool> keep((size_t)span, false);
+	for (A_long p = tails.empty() ? -1 : tails.back(); p >= 0; p = previous[(size_t)p]) keep[(size_t)p] = true;
+
+	// Place the others in target order, each right after its predecessor,
+	// which by then is either kept or already placed
+	std::vector<A_long> list((size_t)span);
+	for (A_long p = 0; p < span; p++) list[(size_t)p] = p;
+	outMoves.reserve((size_t)(span - (A_long)tails.size()));
+
+	for (A_long t = 0; t < span; t++) {
+		const A_long layer = order[(size_t)(lo + t)] - lo;
+		if (keep[(size_t)layer]) continue;
+
+		list.erase(std::find(list.begin(), list.end(), layer));
+		A_long to = 0;
+		if (t > 0) {
+			const A_long before = order[(size_t)(lo + t - 1)] - lo;
+			to = (A_long)(std::find(list.begin(), list.end(), before) - list.begin()) + 1;
+		}
+		list.insert(list.begin() + to, layer);
+
+		ReorderMove move;
+		move.layer = lo + layer;
+		move.to = lo + to;
+		outMoves.push_back(move);
+	}
+}
+
+A_Err ApplyReorderPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<ReorderMove>& moves)
+{
+	A_Err err = A_Err_NONE;
+
+	// Indices shift with every move: take the handles from AE while they
+	// still match (a cached index can lag a reorder)
+	std::vector<AEGP_LayerH> handles(moves.size(), (AEGP_LayerH)NULL);
+	for (size_t m = 0; m < moves.size() && !err; m++) {
+		ERR(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, moves[m].layer, &handles[m]));
+	}
+
+	for (size_t m = 0; m < moves.size() && !err; m++) {
+		ERR(suites.LayerSuite9()->AEGP_ReorderLayer(handles[m], moves[m].to));
+	}
+	return err;
+}
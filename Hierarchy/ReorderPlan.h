@@ -0,0 +1,36 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Reorder Plan                                  */
+/*      Fewest AEGP_ReorderLayer calls for a new layer order       */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef REORDER_PLAN_H
+#define REORDER_PLAN_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <vector>
+
+// One AEGP_ReorderLayer call, in order: the layer that was at index `layer`
+// before the first move goes to index `to` (as the comp is at that point)
+typedef struct {
+	A_long		layer;
+	A_long		to;
+} ReorderMove;
+
+// order[i] is the current index of the layer that should end up at index i
+// (a permutation of 0..n-1). The layers on a longest increasing subsequence
+// stay put and every other layer moves once, which is the fewest single-layer
+// moves that reach the order: swapping two blocks moves the smaller one.
+// Only the span between the first and last misplaced layer is examined.
+void PlanReorder(const std::vector<A_long>& order, std::vector<ReorderMove>& outMoves);
+
+// Run a plan on compH: every moving layer's handle is read by index first,
+// then one AEGP_ReorderLayer per move.
+// The caller owns the undo group.
+A_Err ApplyReorderPlan(AEGP_SuiteHandler& suites, AEGP_CompH compH, const std::vector<ReorderMove>& moves);
+
+#endif // REORDER_PLAN_H
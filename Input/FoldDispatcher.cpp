@@ -0,0 +1,123 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Dispatcher                               */
+/*      Wakes the main thread as soon as a fold gesture arrives    */
+/*                                                                 */
+/*******************************************************************/
+
+#include "FoldDispatcher.h"
+
+#include <cstring>
+
+FoldDispatcher	S_fold_dispatcher;
+
+FoldDispatcher::FoldDispatcher()
+	: m_wakePending(false)
+	, m_wakeRequests(0)
+	, m_wakesCoalesced(0)
+	, m_inPump(false)
+	, m_handler(NULL)
+	, m_handlerRefcon(NULL)
+	, m_wake(NULL)
+	, m_wakeRefcon(NULL)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void FoldDispatcher::SetHandler(FoldIntentHandler handler, void* refcon)
+{
+	m_handler = handler;
+	m_handlerRefcon = refcon;
+}
+
+void FoldDispatcher::SetWake(FoldWakeFunc wake, void* refcon)
+{
+	m_wake = wake;
+	m_wakeRefcon = refcon;
+}
+
+void FoldDispatcher::ResetStats()
+{
+	m_latency.Reset();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_wakeRequests.store(0, std::memory_order_relaxed);
+	m_wakesCoalesced.store(0, std::memory_order_relaxed);
+}
+
+FoldDispatchStats FoldDispatcher::Stats() const
+{
+	FoldDispatchStats stats = m_stats;
+	stats.wakeRequests = m_wakeRequests.load(std::memory_order_relaxed);
+	stats.wakesCoalesced = m_wakesCoalesced.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void FoldDispatcher::NotifyInput()
+{
+	// One outstanding wake is enough; Pump drains everything queued so far
+	if (m_wakePending.exchange(true, std::memory_order_acq_rel)) {
+		m_wakesCoalesced.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	m_wakeRequests.fetch_add(1, std::memory_order_relaxed);
+	if (m_wake) {
+		m_wake(m_wakeRefcon);
+	}
+}
+
+int FoldDispatcher::Pump()
+{
+	// Folds can spin nested message loops (undo groups, ExtendScript), which
+	// may deliver another wake. Leave the events queued for the outer call.
+	if (m_inPump) {
+		m_stats.reentrantPumps++;
+		return 0;
+	}
+
+	m_wakePending.store(false, std::memory_order_release);
+	if (!S_input_channel.PendingClicks()) {
+		return 0;
+	}
+
+	m_inPump = true;
+	m_stats.pumps++;
+
+	// Several completed gestures in one pump collapse into a single toggle
+	const double now = InputNowSeconds();
+	bool haveIntent = false;
+	FoldIntent intent;
+	InputClickEvent ev;
+	while (S_input_channel.PopClick(&ev)) {
+		FoldIntent candidate;
+		if (m_recognizer.Consume(ev, now, &candidate) && candidate.kind != FoldIntent_None) {
+			if (haveIntent) {
+				m_stats.intentsCoalesced++;
+			}
+			intent = candidate;
+			haveIntent = true;
+		}
+	}
+
+	int folds = 0;
+	if (haveIntent && m_handler) {
+		if (m_handler(m_handlerRefcon, intent)) {
+			m_latency.Record(InputNowSeconds() - intent.inputTimestamp);
+			folds = 1;
+#if FOLDLAYERS_PERF_LOG
+			PerfLog("%s", m_latency.Summary("fold latency").c_str());
+#endif
+		}
+	}
+
+	m_inPump = false;
+
+	// A wake delivered during the fold hit the re-entrant return and left
+	// m_wakePending set, so later clicks would only coalesce into it. Clear
+	// it, and wake again for clicks that arrived meanwhile (pushed before
+	// their NotifyInput, so none is missed between the two steps).
+	m_wakePending.store(false, std::memory_order_release);
+	if (S_input_channel.PendingClicks()) {
+		NotifyInput();
+	}
+	return folds;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Dispatcher                               */
+/*      Wakes the main thread as soon as a fold gesture arrives    */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLD_DISPATCHER_H
+#define FOLD_DISPATCHER_H
+
+// Platform-neutral: the platform layer supplies the wake function and the
+// plugin supplies the fold handler, so the whole input -> fold path can be
+// driven by a simulated event source without After Effects.
+#include "InputChannel.h"
+#include "GestureRecognizer.h"
+#include "Utils/PerfStats.h"
+
+// Runs on the main thread for each recognized intent; returns true if a fold ran
+typedef bool (*FoldIntentHandler)(void* refcon, const FoldIntent& intent);
+
+// Asks the main thread to call FoldDispatcher::Pump() as soon as possible.
+// Called from the input hook; must not block.
+typedef void (*FoldWakeFunc)(void* refcon);
+
+// Counters alongside the latency histogram
+typedef struct {
+	uint32_t	wakeRequests;		// NotifyInput calls that scheduled a wake
+	uint32_t	wakesCoalesced;		// NotifyInput calls folded into a pending wake
+	uint32_t	pumps;				// Pump calls that drained at least one event
+	uint32_t	reentrantPumps;		// Pump calls skipped because a fold was running
+	uint32_t	intentsCoalesced;	// Extra intents dropped within one pump
+} FoldDispatchStats;
+
+// Input layer -> main thread bridge.
+// Producer: push the click into S_input_channel, then call NotifyInput().
+// Main thread: Pump() from the wake callback, with IdleHook as the fallback.
+class FoldDispatcher {
+public:
+	FoldDispatcher();
+
+	void		SetHandler(FoldIntentHandler handler, void* refcon);
+	void		SetWake(FoldWakeFunc wake, void* refcon);
+
+	// Producer side: request an immediate main-thread pump (coalesced)
+	void		NotifyInput();
+
+	// Main thread: drain the channel, recognize, run the handler.
+	// Returns the number of folds that ran (0 or 1).
+	int			Pump();
+
+	GestureRecognizer&			Recognizer() { return m_recognizer; }
+
+	// Input timestamp -> fold handler returned
+	const LatencyHistogram&		Latency() const { return m_latency; }
+	FoldDispatchStats			Stats() const;
+	void						ResetStats();
+
+private:
+	FoldDispatcher(const FoldDispatcher&);
+	FoldDispatcher& operator=(const FoldDispatcher&);
+
+	std::atomic<bool>	m_wakePending;
+	std::atomic<uint32_t>	m_wakeRequests;		// Producer-side counters stay atomic
+	std::atomic<uint32_t>	m_wakesCoalesced;
+	bool				m_inPump;
+	FoldIntentHandler	m_handler;
+	void*				m_handlerRefcon;
+	FoldWakeFunc		m_wake;
+	void*				m_wakeRefcon;
+	GestureRecognizer	m_recognizer;
+	LatencyHistogram	m_latency;
+	FoldDispatchStats	m_stats;
+};
+
+// Process-wide dispatcher used by the platform hooks, IdleHook and menu hooks
+extern FoldDispatcher	S_fold_dispatcher;
+
+#endif // FOLD_DISPATCHER_H
@@ -0,0 +1,138 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Gesture Recognizer                            */
+/*      Turns timestamped clicks into fold intents                 */
+/*                                                                 */
+/*******************************************************************/
+
+#include "GestureRecognizer.h"
+
+#include <cstring>
+
+GestureConfig DefaultGestureConfig()
+{
+	GestureConfig config;
+	// - Minimum: 30ms to avoid false positives from very rapid clicks
+	// - Maximum: 700ms to accommodate macOS system double-click setting (default 500ms)
+	// - Cooldown: 200ms so one physical double-click never fires twice
+	config.minInterval = 0.03;
+	config.maxInterval = 0.7;
+	config.cooldown = 0.2;
+	config.acceptOsDoubleClick = true;
+	return config;
+}
+
+GestureRecognizer::GestureRecognizer()
+{
+	m_config = DefaultGestureConfig();
+	Reset();
+}
+
+GestureRecognizer::GestureRecognizer(const GestureConfig& config)
+{
+	m_config = config;
+	Reset();
+}
+
+void GestureRecognizer::SetConfig(const GestureConfig& config)
+{
+	m_config = config;
+}
+
+void GestureRecognizer::Reset()
+{
+	memset(m_history, 0, sizeof(m_history));
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_pairAnchor = -1.0;
+	m_lastIntentAt = -1.0;
+	m_lastDoubleAt = -1.0;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+const InputClickEvent& GestureRecognizer::HistoryAt(size_t age) const
+{
+	if (age >= m_historyCount) age = m_historyCount ? m_historyCount - 1 : 0;
+	const size_t slot = (m_historyNext + kHistorySize - 1 - age) % kHistorySize;
+	return m_history[slot];
+}
+
+void GestureRecognizer::Remember(const InputClickEvent& ev)
+{
+	m_history[m_historyNext] = ev;
+	m_historyNext = (m_historyNext + 1) % kHistorySize;
+	if (m_historyCount < kHistorySize) m_historyCount++;
+}
+
+bool GestureRecognizer::Emit(const InputClickEvent& ev, double now, FoldIntent* outIntent)
+{
+	// Cooldown is measured between input timestamps, not arrival times, so a
+	// late-polled press and an early event-tap double-click still dedup.
+	if (m_lastIntentAt >= 0.0) {
+		double since = ev.timestamp - m_lastIntentAt;
+		if (since < 0.0) since = -since;
+		if (since < m_config.cooldown) {
+			m_stats.suppressedByCooldown++;
+			return false;
+		}
+	}
+
+	m_lastIntentAt = ev.timestamp;
+	m_stats.intentsEmitted++;
+
+	if (outIntent) {
+		outIntent->kind = FoldIntent_Toggle;
+		outIntent->inputTimestamp = ev.timestamp;
+		outIntent->recognizedAt = now;
+		outIntent->modifiers = ev.modifiers;
+	}
+	return true;
+}
+
+bool GestureRecognizer::Consume(const InputClickEvent& ev, double now, FoldIntent* outIntent)
+{
+	m_stats.eventsSeen++;
+	Remember(ev);
+
+	if (ev.kind == InputClick_Double) {
+		// The OS already paired the presses; a pending anchor belongs to this gesture
+		m_pairAnchor = -1.0;
+		if (ev.timestamp > m_lastDoubleAt) m_lastDoubleAt = ev.timestamp;
+		if (!m_config.acceptOsDoubleClick) {
+			return false;
+		}
+		return Emit(ev, now, outIntent);
+	}
+
+	if (ev.kind != InputClick_Down) {
+		return false;
+	}
+
+	// The second press of an OS double-click, polled after the double-click
+	// arrived: re-anchoring on it would pair the next single click
+	if (m_lastDoubleAt >= 0.0 && ev.timestamp <= m_lastDoubleAt) {
+		m_stats.coveredByDouble++;
+		return false;
+	}
+
+	if (m_pairAnchor < 0.0) {
+		m_pairAnchor = ev.timestamp;
+		return false;
+	}
+
+	const double interval = ev.timestamp - m_pairAnchor;
+	if (interval <= m_config.minInterval) {
+		// Bounce: keep the original anchor
+		m_stats.rejectedTooFast++;
+		return false;
+	}
+	if (interval >= m_config.maxInterval) {
+		// Too slow: this press starts a new potential pair
+		m_pairAnchor = ev.timestamp;
+		return false;
+	}
+
+	// Completed pair. A third press must start a fresh pair (no triple-triggering).
+	m_pairAnchor = -1.0;
+	return Emit(ev, now, outIntent);
+}
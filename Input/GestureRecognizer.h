@@ -0,0 +1,92 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Gesture Recognizer                            */
+/*      Turns timestamped clicks into fold intents                 */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+// Platform-neutral: all time comes from event timestamps and the caller's
+// "now", never from a clock, so behaviour is deterministic under a fake clock.
+#include "InputChannel.h"
+
+// Thresholds shared by every input path (seconds)
+typedef struct {
+	double	minInterval;		// Two presses closer than this are bounce, not a double-click
+	double	maxInterval;		// Two presses within this pair up into a double-click
+	double	cooldown;			// No second intent within this window (one per physical double-click)
+	bool	acceptOsDoubleClick;	// Trust InputClick_Double events reported by the OS
+} GestureConfig;
+
+// Defaults match the previous per-platform heuristics (0.03-0.7 s window, 0.2 s cooldown)
+GestureConfig DefaultGestureConfig();
+
+enum FoldIntentKind {
+	FoldIntent_None = 0,
+	FoldIntent_Toggle				// Toggle the selected divider(s)
+};
+
+// What the recognizer asks the main thread to do
+typedef struct {
+	int			kind;				// FoldIntentKind
+	double		inputTimestamp;		// Timestamp of the click that completed the gesture
+	double		recognizedAt;		// Caller's "now" when the intent was emitted
+	unsigned	modifiers;			// InputModifier bits of the completing click
+} FoldIntent;
+
+// Counters for diagnosing missed or duplicate triggers
+typedef struct {
+	uint32_t	eventsSeen;
+	uint32_t	intentsEmitted;
+	uint32_t	suppressedByCooldown;
+	uint32_t	rejectedTooFast;
+	uint32_t	coveredByDouble;	// Raw presses already paired by an OS double-click
+} GestureStats;
+
+// Single recognizer for Windows (WM_LBUTTONDBLCLK), the macOS event tap
+// (clickState == 2) and the macOS polling fallback (raw presses).
+// OS double-clicks and paired presses feed the same cooldown, so a physical
+// double-click seen by two paths yields exactly one intent. A raw press
+// stamped at or before the last OS double-click is one of that gesture's
+// presses reported late by the polling path and never anchors a new pair.
+class GestureRecognizer {
+public:
+	enum { kHistorySize = 8 };		// Recent events kept for pairing and diagnostics
+
+	GestureRecognizer();
+	explicit GestureRecognizer(const GestureConfig& config);
+
+	void					SetConfig(const GestureConfig& config);
+	const GestureConfig&	Config() const { return m_config; }
+
+	// Feed one event. Returns true and fills outIntent when a gesture completes.
+	bool					Consume(const InputClickEvent& ev, double now, FoldIntent* outIntent);
+
+	// Forget history and cooldown (e.g. when the active comp changes)
+	void					Reset();
+
+	// Recent events, 0 = newest
+	size_t					HistoryCount() const { return m_historyCount; }
+	const InputClickEvent&	HistoryAt(size_t age) const;
+
+	const GestureStats&		Stats() const { return m_stats; }
+
+private:
+	void					Remember(const InputClickEvent& ev);
+	bool					Emit(const InputClickEvent& ev, double now, FoldIntent* outIntent);
+
+	GestureConfig		m_config;
+	InputClickEvent		m_history[kHistorySize];
+	size_t				m_historyNext;
+	size_t				m_historyCount;
+	double				m_pairAnchor;		// Timestamp of the press waiting for a partner (< 0: none)
+	double				m_lastIntentAt;		// Input timestamp of the last emitted intent (< 0: none)
+	double				m_lastDoubleAt;		// Input timestamp of the last OS double-click (< 0: none)
+	GestureStats		m_stats;
+};
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,119 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Input Channel                                 */
+/*      Lock-free state shared between input hooks and IdleHook    */
+/*                                                                 */
+/*******************************************************************/
+
+#include "InputChannel.h"
+
+#include <chrono>
+
+InputChannel	S_input_channel;
+
+InputChannel::InputChannel()
+	: m_head(0)
+	, m_tail(0)
+	, m_selection(0)
+	, m_dropped(0)
+{
+}
+
+bool InputChannel::PushClick(const InputClickEvent& ev)
+{
+	const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	const uint32_t head = m_head.load(std::memory_order_acquire);
+
+	// Counters wrap freely; the unsigned difference is the fill level
+	if (tail - head >= (uint32_t)kRingCapacity) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_ring[tail & (kRingCapacity - 1)] = ev;
+	m_tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputChannel::PopClick(InputClickEvent* outEv)
+{
+	const uint32_t head = m_head.load(std::memory_order_relaxed);
+	const uint32_t tail = m_tail.load(std::memory_order_acquire);
+
+	if (head == tail) {
+		return false;
+	}
+
+	if (outEv) {
+		*outEv = m_ring[head & (kRingCapacity - 1)];
+	}
+	m_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+size_t InputChannel::DrainClicks(InputClickEvent* outEvents, size_t maxEvents)
+{
+	size_t count = 0;
+	while (count < maxEvents && PopClick(outEvents ? &outEvents[count] : NULL)) {
+		count++;
+	}
+	return count;
+}
+
+void InputChannel::DiscardClicks()
+{
+	// Consumer-side only: jump the head to the currently published tail
+	m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t InputChannel::PendingClicks() const
+{
+	const uint32_t head = m_head.load(std::memory_order_acquire);
+	const uint32_t tail = m_tail.load(std::memory_order_acquire);
+	return (size_t)(tail - head);
+}
+
+void InputChannel::PublishSelection(bool dividerSelected)
+{
+	// Single writer (idle hook), so a load/store pair is enough.
+	// The generation only advances when the selection actually changes.
+	const uint32_t current = m_selection.load(std::memory_order_relaxed);
+	const bool currentSelected = (current & 1u) != 0;
+	if (currentSelected == dividerSelected && current != 0) {
+		return;
+	}
+	const uint32_t generation = (current >> 1) + 1;
+	m_selection.store((generation << 1) | (dividerSelected ? 1u : 0u), std::memory_order_release);
+}
+
+bool InputChannel::IsDividerSelected() const
+{
+	return (m_selection.load(std::memory_order_acquire) & 1u) != 0;
+}
+
+uint32_t InputChannel::SelectionGeneration() const
+{
+	return m_selection.load(std::memory_order_acquire) >> 1;
+}
+
+uint32_t InputChannel::DroppedClicks() const
+{
+	return m_dropped.load(std::memory_order_relaxed);
+}
+
+double InputNowSeconds()
+{
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+InputClickEvent InputMakeClickEvent(InputClickKind kind, int clickCount, unsigned modifiers)
+{
+	InputClickEvent ev;
+	ev.timestamp = InputNowSeconds();
+	ev.kind = kind;
+	ev.clickCount = clickCount;
+	ev.modifiers = modifiers;
+	ev.selectionGeneration = S_input_channel.SelectionGeneration();
+	return ev;
+}
@@ -0,0 +1,91 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Input Channel                                 */
+/*      Lock-free state shared between input hooks and IdleHook    */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef INPUT_CHANNEL_H
+#define INPUT_CHANNEL_H
+
+// Platform-neutral: no AE SDK or OS headers, so the channel can be
+// exercised on its own (e.g. a multi-threaded stress run on Linux).
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Kind of click reported by a platform hook
+enum InputClickKind {
+	InputClick_Down = 0,		// Plain left-button press
+	InputClick_Double			// OS-reported double-click (WM_LBUTTONDBLCLK / clickState == 2)
+};
+
+// Modifier keys held while the click happened
+enum InputModifier {
+	InputModifier_None	= 0,
+	InputModifier_Alt	= 1 << 0,
+	InputModifier_Shift	= 1 << 1,
+	InputModifier_Ctrl	= 1 << 2
+};
+
+// One timestamped click, written by the producer hook and read by IdleHook
+typedef struct {
+	double		timestamp;			// Seconds on the InputNowSeconds() clock
+	int			kind;				// InputClickKind
+	int			clickCount;			// Click count reported by the OS (1 if unknown)
+	unsigned	modifiers;			// InputModifier bitmask
+	uint32_t	selectionGeneration;	// Selection generation seen by the producer
+} InputClickEvent;
+
+// Single-producer/single-consumer channel between the input hook (producer)
+// and the idle hook (consumer). Neither side ever blocks: the hook publishes
+// clicks into a fixed ring, and the idle hook publishes divider selection
+// state through one atomic word. A full ring drops the newest click.
+class InputChannel {
+public:
+	enum { kRingCapacity = 64 };	// Must be a power of two
+
+	InputChannel();
+
+	// Producer side (mouse hook / event tap)
+	bool		PushClick(const InputClickEvent& ev);
+
+	// Consumer side (idle hook)
+	bool		PopClick(InputClickEvent* outEv);
+	size_t		DrainClicks(InputClickEvent* outEvents, size_t maxEvents);
+	void		DiscardClicks();
+	size_t		PendingClicks() const;
+
+	// Selection state: written by the idle hook, read by the input hook
+	void		PublishSelection(bool dividerSelected);
+	bool		IsDividerSelected() const;
+	uint32_t	SelectionGeneration() const;
+
+	// Number of clicks dropped because the ring was full
+	uint32_t	DroppedClicks() const;
+
+private:
+	InputChannel(const InputChannel&);
+	InputChannel& operator=(const InputChannel&);
+
+	// Head and tail live on separate cache lines so producer and consumer
+	// do not false-share while the other side is busy.
+	alignas(64) std::atomic<uint32_t>	m_head;			// Next slot to read (consumer-owned)
+	alignas(64) std::atomic<uint32_t>	m_tail;			// Next slot to write (producer-owned)
+	alignas(64) std::atomic<uint32_t>	m_selection;	// (generation << 1) | dividerSelected
+	std::atomic<uint32_t>				m_dropped;
+	InputClickEvent						m_ring[kRingCapacity];
+};
+
+// Monotonic clock used for all click timestamps (seconds)
+double InputNowSeconds();
+
+// Build a click event stamped with the current time and selection generation
+InputClickEvent InputMakeClickEvent(InputClickKind kind, int clickCount, unsigned modifiers);
+
+// Process-wide channel shared by the platform hooks and IdleHook
+extern InputChannel		S_input_channel;
+
+#endif // INPUT_CHANNEL_H
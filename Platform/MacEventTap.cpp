@@ -10,7 +10,8 @@
 #ifdef AE_OS_MAC
 
 #include "FoldLayers.h"
-#include <pthread.h>
+#include "Input/InputChannel.h"
+#include "Input/FoldDispatcher.h"
 #include <unistd.h>
 #include <stdio.h>
 
@@ -36,21 +37,59 @@ static void DebugLog(const char* fmt, ...) {
 #endif
 
 // Global variables
-bool				S_pending_fold_action = false;
 CFMachPortRef		S_event_tap = NULL;
 CFRunLoopSourceRef S_event_tap_source = NULL;
 bool				S_event_tap_active = false;
-pthread_mutex_t		S_mac_state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-// Static state for polling fallback
+// Static state for polling fallback (CFAbsoluteTime of the last press seen)
 static double		S_last_click_time = 0.0;
-static double		S_last_event_timestamp = 0.0;
-bool				S_mac_divider_selected_for_input = false;
 bool				S_mac_should_warn_ax = false;
 bool				S_mac_warned_ax = false;
 static bool			S_ax_trusted = false;
 static bool			S_ax_trusted_checked = false;
 
+// Main run loop timer used to pump the dispatcher as soon as the tap returns.
+// Parked far in the future; a wake just moves its fire date to "now".
+static CFRunLoopTimerRef	S_wake_timer = NULL;
+static const double		kWakeTimerParkInterval = 1.0e8;
+
+static void WakeTimerCallback(CFRunLoopTimerRef timer, void* info)
+{
+	(void)timer;
+	(void)info;
+
+	S_fold_dispatcher.Pump();
+}
+
+// FoldWakeFunc: the tap runs on the main run loop, so this only reschedules
+static void WakeMainThread(void* refcon)
+{
+	(void)refcon;
+
+	if (S_wake_timer) {
+		CFRunLoopTimerSetNextFireDate(S_wake_timer, CFAbsoluteTimeGetCurrent());
+		CFRunLoopWakeUp(CFRunLoopGetMain());
+	}
+}
+
+static void InstallWakeTimer()
+{
+	if (S_wake_timer) return;
+
+	S_wake_timer = CFRunLoopTimerCreate(
+		kCFAllocatorDefault,
+		CFAbsoluteTimeGetCurrent() + kWakeTimerParkInterval,
+		kWakeTimerParkInterval,
+		0,
+		0,
+		WakeTimerCallback,
+		NULL);
+	if (S_wake_timer) {
+		CFRunLoopAddTimer(CFRunLoopGetMain(), S_wake_timer, kCFRunLoopCommonModes);
+		S_fold_dispatcher.SetWake(WakeMainThread, NULL);
+	}
+}
+
 bool MacAXTrusted()
 {
 	if (!S_ax_trusted_checked) {
@@ -88,6 +127,16 @@ bool MacAXTrusted()
 	return S_ax_trusted;
 }
 
+// Map CoreGraphics modifier flags onto InputModifier bits
+static unsigned ModifiersFromFlags(CGEventFlags flags)
+{
+	unsigned modifiers = InputModifier_None;
+	if (flags & kCGEventFlagMaskAlternate)	modifiers |= InputModifier_Alt;
+	if (flags & kCGEventFlagMaskShift)		modifiers |= InputModifier_Shift;
+	if (flags & kCGEventFlagMaskCommand)	modifiers |= InputModifier_Ctrl;
+	return modifiers;
+}
+
 static CGEventRef EventTapCallback(CGEventTapProxy proxy, CGEventType type, CGEventRef event, void* refcon)
 {
 	(void)proxy;
@@ -105,32 +154,19 @@ static CGEventRef EventTapCallback(CGEventTapProxy proxy, CGEventType type, CGEv
 
 	if (type == kCGEventLeftMouseDown) {
 		const int64_t clickState = CGEventGetIntegerValueField(event, kCGMouseEventClickState);
-		pthread_mutex_lock(&S_mac_state_mutex);
-		const bool selected = S_mac_divider_selected_for_input;
-		pthread_mutex_unlock(&S_mac_state_mutex);
+		const bool selected = S_input_channel.IsDividerSelected();
 
 		DEBUG_LOG("EventTap: LeftMouseDown clickState=%lld selected=%d",
 			clickState, selected);
 
-		// Only act on true double-click when a divider is selected
+		// Only act on true double-click when a divider is selected.
+		// Cooldown happens in the GestureRecognizer on the consumer side;
+		// the polling fallback stays off while the tap is active.
 		if (clickState == 2 && selected) {
-			// Check cooldown to prevent double-triggering from both mechanisms
-			const double now = CFAbsoluteTimeGetCurrent();
-			pthread_mutex_lock(&S_mac_state_mutex);
-			const double timeSinceLastAction = now - S_last_event_timestamp;
-			pthread_mutex_unlock(&S_mac_state_mutex);
-
-			// Only process if enough time has passed since last action (0.2s cooldown)
-			if (timeSinceLastAction > 0.2) {
-				DEBUG_LOG("EventTap: Double-click on selected divider - setting pending fold action");
-				pthread_mutex_lock(&S_mac_state_mutex);
-				S_last_event_timestamp = now;
-				pthread_mutex_unlock(&S_mac_state_mutex);
-				S_pending_fold_action = true;
-				return NULL;  // Suppress the event
-			} else {
-				DEBUG_LOG("EventTap: Double-click ignored due to cooldown (%.2fs since last action)", timeSinceLastAction);
-			}
+			DEBUG_LOG("EventTap: Double-click on selected divider - publishing click");
+			S_input_channel.PushClick(InputMakeClickEvent(InputClick_Double, (int)clickState, ModifiersFromFlags(CGEventGetFlags(event))));
+			S_fold_dispatcher.NotifyInput();
+			return NULL;  // Suppress the event
 		}
 	}
 
@@ -148,6 +184,9 @@ void InstallMacEventTap()
 		return;
 	}
 
+	// The wake timer also serves the polling fallback, so install it first
+	InstallWakeTimer();
+
 	DEBUG_LOG("Attempting to install EventTap...");
 
 	// Check Accessibility permissions first
@@ -189,10 +228,14 @@ void InstallMacEventTap()
 
 void PollMouseState()
 {
+	// Fallback only: while the tap runs it reports every double-click itself,
+	// and polled presses would only re-report its presses late
+	if (S_event_tap_active) {
+		return;
+	}
+
 	// Check if a divider is currently selected
-	pthread_mutex_lock(&S_mac_state_mutex);
-	const bool dividerSelected = S_mac_divider_selected_for_input;
-	pthread_mutex_unlock(&S_mac_state_mutex);
+	const bool dividerSelected = S_input_channel.IsDividerSelected();
 
 	if (!dividerSelected) {
 		return;  // No divider selected, skip double-click detection
@@ -216,34 +259,19 @@ void PollMouseState()
 
 	// Detect a new mouse down event (with some tolerance for timing variations)
 	if (event_ts > S_last_click_time + 0.01) {
-		const double diff = event_ts - S_last_click_time;
 		S_last_click_time = event_ts;
 
-#if FOLDLAYERS_DEBUG_MAC
-		DEBUG_LOG("PollMouseState: click detected, diff=%.3f seconds", diff);
-#endif
-
-		// Double click threshold (0.03s to 0.7s)
-		// - Minimum: 30ms to avoid false positives from very rapid clicks
-		// - Maximum: 700ms to accommodate macOS system double-click setting (default 500ms)
-		if (diff > 0.03 && diff < 0.7) {
-			// Check cooldown to prevent double-triggering from both mechanisms
-			pthread_mutex_lock(&S_mac_state_mutex);
-			const double timeSinceLastAction = now - S_last_event_timestamp;
-			pthread_mutex_unlock(&S_mac_state_mutex);
-
-			// Only process if enough time has passed since last action (0.2s cooldown)
-			if (timeSinceLastAction > 0.2) {
-#if FOLDLAYERS_DEBUG_MAC
-				DEBUG_LOG("PollMouseState: DOUBLE-CLICK DETECTED!");
-#endif
-				pthread_mutex_lock(&S_mac_state_mutex);
-				S_last_event_timestamp = now;
-				pthread_mutex_unlock(&S_mac_state_mutex);
-				S_pending_fold_action = true;
-				S_last_click_time = 0.0;  // Prevent consecutive triggering
-			}
-		}
+		DEBUG_LOG("PollMouseState: press detected %.3f seconds ago", since);
+
+		// Publish the raw press, re-stamped on the channel clock.
+		// Pairing into a double-click (0.03s to 0.7s window) is done by the
+		// GestureRecognizer, which also ignores presses an OS double-click
+		// already covered.
+		InputClickEvent ev = InputMakeClickEvent(InputClick_Down, 1,
+			ModifiersFromFlags(CGEventSourceFlagsState(kCGEventSourceStateCombinedSessionState)));
+		ev.timestamp -= since;
+		S_input_channel.PushClick(ev);
+		S_fold_dispatcher.NotifyInput();
 	}
 }
 
@@ -265,6 +293,13 @@ void ShutdownMacEventTap()
 		S_event_tap = NULL;
 	}
 	S_event_tap_active = false;
+
+	S_fold_dispatcher.SetWake(NULL, NULL);
+	if (S_wake_timer) {
+		CFRunLoopTimerInvalidate(S_wake_timer);
+		CFRelease(S_wake_timer);
+		S_wake_timer = NULL;
+	}
 }
 
 #endif // AE_OS_MAC
@@ -17,15 +17,12 @@
 
 #include <CoreFoundation/CoreFoundation.h>
 #include <ApplicationServices/ApplicationServices.h>
-#include <pthread.h>
 
 // Global variables for macOS event handling
-extern bool				S_pending_fold_action;
+// Selection state and double-clicks travel through S_input_channel (Input/InputChannel.h)
 extern CFMachPortRef	S_event_tap;
 extern CFRunLoopSourceRef S_event_tap_source;
 extern bool				S_event_tap_active;
-extern pthread_mutex_t	S_mac_state_mutex;
-extern bool				S_mac_divider_selected_for_input;
 extern std::string		S_mac_selected_divider_full_name;
 extern bool				S_mac_selected_divider_valid;
 extern double			S_mac_selected_divider_cached_at;
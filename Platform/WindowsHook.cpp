@@ -10,30 +10,59 @@
 #ifdef AE_OS_WIN
 
 #include "FoldLayers.h"
+#include "Input/InputChannel.h"
+#include "Input/FoldDispatcher.h"
 
 // Global variables defined in FoldLayers.cpp
 extern HHOOK			S_mouse_hook;
-extern bool				S_double_click_pending;
-extern bool				S_suppress_next_action;
-extern CRITICAL_SECTION	S_cs;
-extern bool				S_cs_initialized;
-extern bool				S_is_divider_selected;
+
+// Zero-delay thread timer used to pump the dispatcher right after the hook returns
+static UINT_PTR			S_wake_timer = 0;
+
+static void CALLBACK WakeTimerProc(HWND hwnd, UINT msg, UINT_PTR id, DWORD time)
+{
+	(void)hwnd;
+	(void)msg;
+	(void)time;
+
+	KillTimer(NULL, id);
+	if (id == S_wake_timer) {
+		S_wake_timer = 0;
+	}
+	S_fold_dispatcher.Pump();
+}
+
+// FoldWakeFunc: WM_TIMER is dispatched by AE's own message loop on this
+// thread, so the fold runs on the next loop iteration instead of the next idle tick
+static void WakeMainThread(void* refcon)
+{
+	(void)refcon;
+
+	if (!S_wake_timer) {
+		S_wake_timer = SetTimer(NULL, 0, 0, WakeTimerProc);
+	}
+}
+
+// Modifier keys held at the time of the hook callback
+static unsigned CurrentModifiers()
+{
+	unsigned modifiers = InputModifier_None;
+	if (GetKeyState(VK_MENU) & 0x8000)		modifiers |= InputModifier_Alt;
+	if (GetKeyState(VK_SHIFT) & 0x8000)		modifiers |= InputModifier_Shift;
+	if (GetKeyState(VK_CONTROL) & 0x8000)	modifiers |= InputModifier_Ctrl;
+	return modifiers;
+}
 
 // MouseProc - handles double-click detection for Windows
+// Lock-free: reads the selection published by IdleHook, pushes the click
+// into S_input_channel and asks the dispatcher to pump immediately.
 static LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
 	if (nCode >= 0 && wParam == WM_LBUTTONDBLCLK) {
 		// Only suppress if we believe a divider is selected
-		bool should_suppress = false;
-
-		EnterCriticalSection(&S_cs);
-		if (S_is_divider_selected) {
-			S_double_click_pending = true;
-			should_suppress = true;
-		}
-		LeaveCriticalSection(&S_cs);
-
-		if (should_suppress) {
+		if (S_input_channel.IsDividerSelected()) {
+			S_input_channel.PushClick(InputMakeClickEvent(InputClick_Double, 2, CurrentModifiers()));
+			S_fold_dispatcher.NotifyInput();
 			return 1; // Block message -> No sound!
 		}
 	}
@@ -44,10 +73,9 @@ static LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 
 void InitWindowsHook()
 {
-	// Initialize critical section
-	InitializeCriticalSection(&S_cs);
-	S_cs_initialized = true;
-	S_double_click_pending = false;
+	// Start from a clean channel
+	S_input_channel.DiscardClicks();
+	S_fold_dispatcher.SetWake(WakeMainThread, NULL);
 
 	// Install mouse hook to detect double-clicks
 	S_mouse_hook = SetWindowsHookEx(WH_MOUSE, MouseProc, NULL, GetCurrentThreadId());
@@ -59,10 +87,11 @@ void ShutdownWindowsHook()
 		UnhookWindowsHookEx(S_mouse_hook);
 		S_mouse_hook = NULL;
 	}
-	if (S_cs_initialized) {
-		DeleteCriticalSection(&S_cs);
-		S_cs_initialized = false;
+	if (S_wake_timer) {
+		KillTimer(NULL, S_wake_timer);
+		S_wake_timer = 0;
 	}
+	S_fold_dispatcher.SetWake(NULL, NULL);
 }
 
 #endif // AE_OS_WIN
@@ -0,0 +1,219 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Index Tests                           */
+/*      Sidecar image, change events and load time                 */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Cache/DividerIndex.h"
+#include "Utils/PerfStats.h"
+
+#include <cstring>
+#include <vector>
+
+static const uint64_t	TEST_PROJECT_KEY	= 0x0123456789abcdefULL;
+
+static std::vector<DividerIndexEntry> MakeEntries(uint32_t firstId, size_t count)
+{
+	std::vector<DividerIndexEntry> entries(count);
+	for (size_t i = 0; i < count; i++) {
+		memset(&entries[i], 0, sizeof(entries[i]));
+		entries[i].layerId = firstId + (uint32_t)i * 2;
+		entries[i].depth = (uint8_t)(1 + i % 3);
+		entries[i].folded = (uint8_t)(i % 2);
+		entries[i].kind = (uint8_t)((i % 5 == 0) ? DividerIndexKind_Null : DividerIndexKind_Shape);
+	}
+	return entries;
+}
+
+static bool SameEntries(const std::vector<DividerIndexEntry>& a, const std::vector<DividerIndexEntry>& b)
+{
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].layerId != b[i].layerId || a[i].depth != b[i].depth ||
+			a[i].folded != b[i].folded || a[i].kind != b[i].kind) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void ImageRoundTrip()
+{
+	DividerIndex index;
+	CHECK(index.BindProject(TEST_PROJECT_KEY));
+	CHECK(!index.BindProject(TEST_PROJECT_KEY));
+
+	index.Store(7, 120, 0x1111ULL, MakeEntries(100, 12));
+	index.Store(8, 3, 0x2222ULL, std::vector<DividerIndexEntry>());
+	index.Store(-4, 900, 0x3333ULL, MakeEntries(5000, 300));
+	index.SetFolded(7, 100, true);
+	CHECK(index.Dirty());
+
+	std::vector<uint8_t> image;
+	index.Serialize(image);
+	CHECK(image.size() == sizeof(DividerIndexFileHeader) + 3 * sizeof(DividerIndexCompHeader) +
+		  312 * sizeof(DividerIndexEntry));
+
+	DividerIndex loaded;
+	loaded.BindProject(TEST_PROJECT_KEY);
+	CHECK(loaded.Deserialize(&image[0], image.size()));
+	CHECK(loaded.Size() == 3);
+
+	const A_long ids[] = { 7, 8, -4 };
+	for (size_t c = 0; c < 3; c++) {
+		const DividerIndexComp* a = index.Find(ids[c]);
+		const DividerIndexComp* b = loaded.Find(ids[c]);
+		CHECK(a && b);
+		if (!a || !b) continue;
+		CHECK(b->numLayers == a->numLayers);
+		CHECK(b->layerHash == a->layerHash);
+		CHECK(!b->stale);
+		CHECK(SameEntries(a->entries, b->entries));
+	}
+	CHECK(loaded.Find(7)->entries[0].folded == 1);
+}
+
+// A damaged or foreign image loads nothing
+static void ImageRejects()
+{
+	DividerIndex index;
+	index.BindProject(TEST_PROJECT_KEY);
+	index.Store(1, 10, 0xaULL, MakeEntries(1, 4));
+	index.Store(2, 20, 0xbULL, MakeEntries(50, 6));
+	std::vector<uint8_t> image;
+	index.Serialize(image);
+
+	DividerIndex loaded;
+	CHECK(!loaded.Deserialize(NULL, 0));
+
+	// Bound to another project (or none)
+	CHECK(!loaded.Deserialize(&image[0], image.size()));
+	loaded.BindProject(TEST_PROJECT_KEY + 1);
+	CHECK(!loaded.Deserialize(&image[0], image.size()));
+	CHECK(loaded.Size() == 0);
+
+	loaded.BindProject(TEST_PROJECT_KEY);
+	for (size_t size = 0; size < image.size(); size++) {
+		CHECK(!loaded.Deserialize(&image[0], size));
+		CHECK(loaded.Size() == 0);
+	}
+
+	std::vector<uint8_t> damaged(image);
+	damaged[0] ^= 1;
+	CHECK(!loaded.Deserialize(&damaged[0], damaged.size()));
+
+	DividerIndexFileHeader header;
+	damaged = image;
+	memcpy(&header, &damaged[0], sizeof(header));
+	header.version = DIVIDER_INDEX_VERSION + 1;
+	memcpy(&damaged[0], &header, sizeof(header));
+	CHECK(!loaded.Deserialize(&damaged[0], damaged.size()));
+
+	damaged = image;
+	header.version = DIVIDER_INDEX_VERSION;
+	header.compCount = DIVIDER_INDEX_MAX_COMPS + 1;
+	memcpy(&damaged[0], &header, sizeof(header));
+	CHECK(!loaded.Deserialize(&damaged[0], damaged.size()));
+
+	// An entry count past the limit stops the read, so nothing is kept
+	damaged = image;
+	DividerIndexCompHeader comp;
+	memcpy(&comp, &damaged[sizeof(DividerIndexFileHeader)], sizeof(comp));
+	comp.entryCount = DIVIDER_INDEX_MAX_ENTRIES + 1;
+	memcpy(&damaged[sizeof(DividerIndexFileHeader)], &comp, sizeof(comp));
+	CHECK(!loaded.Deserialize(&damaged[0], damaged.size()));
+	CHECK(loaded.Size() == 0);
+
+	CHECK(loaded.Deserialize(&image[0], image.size()));
+	CHECK(loaded.Size() == 2);
+}
+
+static CompChangeEvent MakeEvent(A_long type, AEGP_LayerIDVal id)
+{
+	CompChangeEvent e;
+	e.type = type;
+	e.id = id;
+	e.oldIndex = -1;
+	e.newIndex = -1;
+	return e;
+}
+
+// Deletes are folded in; an insert makes the entry stale (and it is not
+// saved); events recorded against another fingerprint are ignored
+static void ChangeEvents()
+{
+	DividerIndex index;
+	index.BindProject(TEST_PROJECT_KEY);
+	index.Store(3, 40, 0x10ULL, MakeEntries(20, 5));
+
+	std::vector<CompChangeEvent> events;
+	events.push_back(MakeEvent(CompChange_Deleted, 22));
+	events.push_back(MakeEvent(CompChange_Moved, 26));
+	index.ApplyEvents(3, events, 0x99ULL, 0x11ULL, 39);
+	CHECK(index.Find(3)->entries.size() == 5);
+
+	index.ApplyEvents(3, events, 0x10ULL, 0x11ULL, 39);
+	const DividerIndexComp* comp = index.Find(3);
+	CHECK(comp->entries.size() == 4);
+	CHECK(comp->entries[1].layerId == 24);
+	CHECK(comp->layerHash == 0x11ULL && comp->numLayers == 39);
+	CHECK(!comp->stale);
+
+	events.clear();
+	events.push_back(MakeEvent(CompChange_Deleted, 24));
+	events.push_back(MakeEvent(CompChange_Reset, 0));
+	index.ApplyEvents(3, events, 0x11ULL, 0x12ULL, 38);
+	CHECK(index.Find(3)->entries.size() == 4);
+
+	events.clear();
+	events.push_back(MakeEvent(CompChange_Inserted, 500));
+	index.ApplyEvents(3, events, 0x11ULL, 0x13ULL, 40);
+	CHECK(index.Find(3)->stale);
+
+	std::vector<uint8_t> image;
+	index.Serialize(image);
+	CHECK(image.size() == sizeof(DividerIndexFileHeader));
+
+	index.Invalidate(3);
+	CHECK(index.Find(3) == NULL);
+}
+
+// Load of a 500-comp project: the sidecar parse a project open pays
+// before the first fold (file read not counted)
+static void IndexLoadBenchmark()
+{
+	const A_long kComps = 500;
+	const size_t kDividers = 40;
+
+	DividerIndex index;
+	index.BindProject(TEST_PROJECT_KEY);
+	for (A_long c = 0; c < kComps; c++) {
+		index.Store(1000 + c, 400, (uint64_t)c * 0x9e3779b97f4a7c15ULL,
+					MakeEntries((uint32_t)c * 1000, kDividers));
+	}
+	std::vector<uint8_t> image;
+	index.Serialize(image);
+
+	const int kLoads = 20;
+	DividerIndex loaded;
+	loaded.BindProject(TEST_PROJECT_KEY);
+	bool ok = true;
+	const double start = PerfNowSeconds();
+	for (int l = 0; l < kLoads; l++) ok = loaded.Deserialize(&image[0], image.size()) && ok;
+	const double elapsed = PerfNowSeconds() - start;
+	CHECK(ok);
+	CHECK(loaded.Size() == (size_t)kComps);
+
+	printf("  load: %d comps x %d dividers (%u KB), %.3f ms per load\n", (int)kComps, (int)kDividers,
+		   (unsigned)(image.size() / 1024), elapsed * 1e3 / kLoads);
+}
+
+void RunDividerIndexTests()
+{
+	ImageRoundTrip();
+	ImageRejects();
+	ChangeEvents();
+	IndexLoadBenchmark();
+}
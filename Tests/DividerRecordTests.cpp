@@ -0,0 +1,144 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Divider Record Tests                          */
+/*      Format, parse, version and checksum of FD- records         */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/DividerRecord.h"
+#include "Utils/PerfStats.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static void RecordRoundTrip()
+{
+	const char* hierarchies[] = { "", "1", "1/A", "12/C/d/k", "999/Z" };
+	for (size_t h = 0; h < sizeof(hierarchies) / sizeof(hierarchies[0]); h++) {
+		DividerRecord record;
+		record.version = DIVIDER_RECORD_VERSION;
+		record.folded = (h % 2) != 0;
+		record.markerStore = (h % 3) == 0;
+		record.groupId = 0x3fa90c12u + (uint32_t)h;
+		record.hierarchy = hierarchies[h];
+
+		DividerRecord parsed;
+		const std::string text = FormatDividerRecord(record);
+		CHECK(ParseDividerRecord(text, &parsed));
+		CHECK(parsed.version == DIVIDER_RECORD_VERSION);
+		CHECK(parsed.folded == record.folded);
+		CHECK(parsed.markerStore == record.markerStore);
+		CHECK(parsed.groupId == record.groupId);
+		CHECK(parsed.hierarchy == record.hierarchy);
+	}
+}
+
+static void RecordRejects()
+{
+	DividerRecord record;
+	record.version = DIVIDER_RECORD_VERSION;
+	record.folded = true;
+	record.markerStore = false;
+	record.groupId = 0x01020304u;
+	record.hierarchy = "3/B";
+	const std::string text = FormatDividerRecord(record);
+
+	DividerRecord parsed;
+	CHECK(!ParseDividerRecord("", &parsed));
+	CHECK(!ParseDividerRecord("FD-0", &parsed));
+	CHECK(!ParseDividerRecord("FD-1", &parsed));
+	CHECK(!ParseDividerRecord("FD-H:1/A", &parsed));
+	CHECK(!ParseDividerRecord(text.substr(0, text.size() - 1), &parsed));
+
+	// Any changed character breaks the checksum (or the layout)
+	for (size_t i = 0; i < text.size(); i++) {
+		std::string damaged = text;
+		damaged[i] = (damaged[i] == 'x') ? 'y' : 'x';
+		CHECK(!ParseDividerRecord(damaged, &parsed));
+	}
+
+	// Other versions are not read as this one
+	std::string other = text;
+	other[5] = '4';
+	CHECK(!ParseDividerRecord(other, &parsed));
+
+	// Unknown store
+	std::string body = text.substr(0, text.rfind('|'));
+	body[7] = 'X';
+	char crc[16];
+	snprintf(crc, sizeof(crc), "|%08x", (unsigned)DividerRecordChecksum(body.data(), body.size()));
+	CHECK(!ParseDividerRecord(body + crc, &parsed));
+}
+
+// Version 2 records (no store field) still read, as contents records
+static void RecordVersion2()
+{
+	const std::string body = "FD-1|2|3fa90c12|1/A";
+	char crc[16];
+	snprintf(crc, sizeof(crc), "|%08x", (unsigned)DividerRecordChecksum(body.data(), body.size()));
+
+	DividerRecord parsed;
+	CHECK(ParseDividerRecord(body + crc, &parsed));
+	CHECK(parsed.version == 2);
+	CHECK(parsed.folded);
+	CHECK(!parsed.markerStore);
+	CHECK(parsed.groupId == 0x3fa90c12u);
+	CHECK(parsed.hierarchy == "1/A");
+
+	// A version 3 layout labelled 2 is malformed
+	const std::string mislabelled = "FD-1|2|C|3fa90c12|1/A";
+	snprintf(crc, sizeof(crc), "|%08x", (unsigned)DividerRecordChecksum(mislabelled.data(), mislabelled.size()));
+	CHECK(!ParseDividerRecord(mislabelled + crc, &parsed));
+}
+
+static void GroupIds()
+{
+	for (int i = 0; i < 100; i++) CHECK(NewDividerGroupId() != 0);
+
+	// CRC-32 (IEEE) check value
+	CHECK(DividerRecordChecksum("123456789", 9) == 0xCBF43926u);
+}
+
+// What the probe of a v3 divider pays once its name is read: one parse
+// (layout, hex fields, CRC-32). Timed over a batch of distinct records.
+static void RecordParseBenchmark()
+{
+	const int kRecords = 10000;
+	std::vector<std::string> texts;
+	texts.reserve(kRecords);
+	for (int i = 0; i < kRecords; i++) {
+		DividerRecord record;
+		record.version = DIVIDER_RECORD_VERSION;
+		record.folded = (i & 1) != 0;
+		record.markerStore = false;
+		record.groupId = 0x10000000u + (uint32_t)i;
+		char hierarchy[32];
+		snprintf(hierarchy, sizeof(hierarchy), "%d/%c/%c", 1 + i % 50, 'A' + i % 26, 'a' + i % 26);
+		record.hierarchy = hierarchy;
+		texts.push_back(FormatDividerRecord(record));
+	}
+
+	const int kPasses = 20;
+	int parsed = 0;
+	const double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		for (size_t t = 0; t < texts.size(); t++) {
+			DividerRecord record;
+			if (ParseDividerRecord(texts[t], &record)) parsed++;
+		}
+	}
+	const double elapsed = PerfNowSeconds() - start;
+	CHECK(parsed == kRecords * kPasses);
+	printf("  parse: %d records, %.0f ns per record\n", kRecords, elapsed * 1e9 / (kRecords * kPasses));
+}
+
+void RunDividerRecordTests()
+{
+	RecordRoundTrip();
+	RecordRejects();
+	RecordVersion2();
+	GroupIds();
+	RecordParseBenchmark();
+}
@@ -0,0 +1,156 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Dispatcher Tests                         */
+/*      Wake and pump driven by a simulated input source           */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "InputTestSupport.h"
+#include "Input/InputChannel.h"
+#include "Input/GestureRecognizer.h"
+#include "Input/FoldDispatcher.h"
+#include "Utils/PerfStats.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+typedef struct {
+	std::mutex				lock;
+	std::condition_variable	woken;
+	bool					pending;
+	int						wakes;
+} SimWake;
+
+static void SimWakeFunc(void* refcon)
+{
+	SimWake* wake = (SimWake*)refcon;
+	std::lock_guard<std::mutex> guard(wake->lock);
+	wake->pending = true;
+	wake->wakes++;
+	wake->woken.notify_one();
+}
+
+static std::atomic<int>	S_sim_folds(0);
+
+static bool SimFoldHandler(void* refcon, const FoldIntent& intent)
+{
+	(void)refcon;   // Unused parameter
+	(void)intent;   // Unused parameter
+
+	S_sim_folds++;
+	return true;
+}
+
+// A producer thread plays the platform hook: it publishes one OS
+// double-click at a time and waits for its fold. The main thread only runs
+// when woken, so every fold comes from the wake path, and its latency is
+// the dispatcher's input -> fold histogram.
+static void SimulatedInputSource()
+{
+	FoldDispatcher& dispatcher = S_fold_dispatcher;
+	SimWake wake;
+	wake.pending = false;
+	wake.wakes = 0;
+
+	GestureConfig config = DefaultGestureConfig();
+	config.cooldown = 0.0;
+	dispatcher.Recognizer().SetConfig(config);
+	dispatcher.Recognizer().Reset();
+	dispatcher.ResetStats();
+	dispatcher.SetWake(SimWakeFunc, &wake);
+	dispatcher.SetHandler(SimFoldHandler, NULL);
+	S_input_channel.DiscardClicks();
+	S_sim_folds = 0;
+
+	const int kGestures = 500;
+	std::atomic<bool> done(false);
+	std::thread producer([&]() {
+		for (int g = 0; g < kGestures; g++) {
+			S_input_channel.PushClick(InputMakeClickEvent(InputClick_Double, 2, InputModifier_None));
+			dispatcher.NotifyInput();
+			while (S_sim_folds.load() <= g) std::this_thread::yield();
+		}
+		done = true;
+	});
+
+	while (!done.load()) {
+		std::unique_lock<std::mutex> guard(wake.lock);
+		wake.woken.wait_for(guard, std::chrono::milliseconds(10), [&]() { return wake.pending; });
+		const bool pending = wake.pending;
+		wake.pending = false;
+		guard.unlock();
+		if (pending) dispatcher.Pump();
+	}
+	producer.join();
+
+	CHECK(S_sim_folds.load() == kGestures);
+	CHECK(dispatcher.Latency().Count() == (uint32_t)kGestures);
+	CHECK(dispatcher.Stats().wakeRequests == (uint32_t)kGestures);
+	printf("  %s\n", dispatcher.Latency().Summary("fold latency").c_str());
+
+	dispatcher.SetWake(NULL, NULL);
+	dispatcher.SetHandler(NULL, NULL);
+	dispatcher.Recognizer().SetConfig(DefaultGestureConfig());
+}
+
+// A fold that spins a nested loop: a click arriving meanwhile wakes a
+// re-entrant Pump, which leaves it queued. The outer Pump must wake again
+// for it rather than leave the wake flag stuck.
+static int	S_reentrant_calls = 0;
+
+static bool ReentrantFoldHandler(void* refcon, const FoldIntent& intent)
+{
+	(void)refcon;   // Unused parameter
+
+	if (S_reentrant_calls++ == 0) {
+		S_input_channel.PushClick(MakeClick(InputClick_Double, intent.inputTimestamp + 1.0));
+		S_fold_dispatcher.NotifyInput();
+		CHECK(S_fold_dispatcher.Pump() == 0);
+	}
+	return true;
+}
+
+static void ReentrantPumpRearmsWake()
+{
+	FoldDispatcher& dispatcher = S_fold_dispatcher;
+	SimWake wake;
+	wake.pending = false;
+	wake.wakes = 0;
+
+	dispatcher.Recognizer().Reset();
+	dispatcher.ResetStats();
+	dispatcher.SetWake(SimWakeFunc, &wake);
+	dispatcher.SetHandler(ReentrantFoldHandler, NULL);
+	S_input_channel.DiscardClicks();
+	S_reentrant_calls = 0;
+
+	S_input_channel.PushClick(MakeClick(InputClick_Double, 50.0));
+	dispatcher.NotifyInput();
+	CHECK(wake.wakes == 1);
+
+	CHECK(dispatcher.Pump() == 1);
+	CHECK(dispatcher.Stats().reentrantPumps == 1);
+	CHECK(wake.wakes == 3);
+	CHECK(S_input_channel.PendingClicks() == 1);
+
+	CHECK(dispatcher.Pump() == 1);
+	CHECK(S_reentrant_calls == 2);
+
+	// Nothing left pending: the next click gets its own wake
+	S_input_channel.PushClick(MakeClick(InputClick_Double, 60.0));
+	dispatcher.NotifyInput();
+	CHECK(wake.wakes == 4);
+	dispatcher.Pump();
+
+	dispatcher.SetWake(NULL, NULL);
+	dispatcher.SetHandler(NULL, NULL);
+}
+
+void RunFoldDispatcherTests()
+{
+	ReentrantPumpRearmsWake();
+	SimulatedInputSource();
+}
@@ -0,0 +1,152 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Layout Tests                             */
+/*      FL-LAYOUT: records, lookups and save / restore cost        */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/FoldLayout.h"
+#include "Utils/PerfStats.h"
+
+#include <string>
+#include <vector>
+
+static FoldLayoutEntry MakeEntry(AEGP_LayerIDVal id, bool folded)
+{
+	FoldLayoutEntry entry;
+	entry.id = id;
+	entry.folded = folded;
+	return entry;
+}
+
+static void LayoutRoundTrip()
+{
+	FoldLayout layout;
+	layout.name = "Review";
+	layout.entries.push_back(MakeEntry(0x2a, true));
+	layout.entries.push_back(MakeEntry(0x4, false));
+	layout.entries.push_back(MakeEntry(0x1000, true));
+	layout.entries.push_back(MakeEntry(0x5, true));
+	layout.entries.push_back(MakeEntry(0x6, false));
+
+	// Sorted by ID, deltas after the first, four fold bits per digit
+	const std::string text = FormatFoldLayout(layout);
+	CHECK(text == "FL-LAYOUT:Review|1|5|4.1.1.24.fd6|a1");
+	CHECK(layout.entries[0].id == 0x4 && layout.entries[4].id == 0x1000);
+
+	FoldLayout parsed;
+	CHECK(ParseFoldLayout(text, &parsed));
+	CHECK(parsed.name == "Review");
+	CHECK(parsed.entries.size() == 5);
+	for (size_t i = 0; i < parsed.entries.size() && i < layout.entries.size(); i++) {
+		CHECK(parsed.entries[i].id == layout.entries[i].id);
+		CHECK(parsed.entries[i].folded == layout.entries[i].folded);
+	}
+
+	// The example in FoldLayout.h
+	CHECK(ParseFoldLayout("FL-LAYOUT:Review|1|3|4.2.1a|5", &parsed));
+	CHECK(parsed.entries.size() == 3);
+	CHECK(parsed.entries[2].id == 0x20 && parsed.entries[2].folded && !parsed.entries[1].folded);
+
+	FoldLayout empty;
+	empty.name = "Empty";
+	CHECK(FormatFoldLayout(empty) == "FL-LAYOUT:Empty|1|0||");
+	CHECK(ParseFoldLayout("FL-LAYOUT:Empty|1|0||", &parsed));
+	CHECK(parsed.name == "Empty" && parsed.entries.empty());
+}
+
+static void LayoutRejects()
+{
+	FoldLayout parsed;
+	CHECK(!ParseFoldLayout("", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUTS:A|1|1|4|1", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|2|1|4|1", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|1|4", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|1|4|1|", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4.1.1|1", &parsed));		// More IDs than the count
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|3|4.1|1", &parsed));			// Fewer
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4.1|", &parsed));			// No fold bits
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4.1|11", &parsed));		// Too many
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4.0|1", &parsed));			// Repeated ID
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4..1|1", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|2|4.g|1", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|1|123456789|1", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|1|4|x", &parsed));
+	CHECK(!ParseFoldLayout("FL-LAYOUT:A|1|-1|4|1", &parsed));
+}
+
+static void LayoutLookupsAndNames()
+{
+	FoldLayout layout;
+	CHECK(ParseFoldLayout("FL-LAYOUT:Review|1|3|4.2.1a|5", &layout));
+
+	bool folded = false;
+	CHECK(FindFoldLayoutState(layout, 4, &folded) && folded);
+	CHECK(FindFoldLayoutState(layout, 6, &folded) && !folded);
+	CHECK(FindFoldLayoutState(layout, 0x20, &folded) && folded);
+	CHECK(!FindFoldLayoutState(layout, 5, &folded));
+	CHECK(!FindFoldLayoutState(layout, 0x21, &folded));
+
+	CHECK(IsValidFoldLayoutName("Review 2"));
+	CHECK(!IsValidFoldLayoutName(""));
+	CHECK(!IsValidFoldLayoutName("a|b"));
+	CHECK(!IsValidFoldLayoutName("tab\there"));
+	CHECK(IsValidFoldLayoutName(std::string(FOLD_LAYOUT_MAX_NAME, 'n')));
+	CHECK(!IsValidFoldLayoutName(std::string(FOLD_LAYOUT_MAX_NAME + 1, 'n')));
+	CHECK(FoldLayoutRecordPrefix("Review") == "FL-LAYOUT:Review|");
+}
+
+// A 10,000-layer comp with 2,000 dividers. Save: entries from the layer
+// walk, then the record. Restore: parse the record, then one lookup per
+// layer of the walk (the comp's own reads not counted).
+static void LayoutBenchmark()
+{
+	const A_long kLayers = 10000;
+	const A_long kEvery = 5;
+
+	const int kPasses = 20;
+	std::string text;
+	double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		FoldLayout layout;
+		layout.name = "Bench";
+		for (A_long i = 0; i < kLayers; i += kEvery) {
+			layout.entries.push_back(MakeEntry((AEGP_LayerIDVal)(kLayers - i) * 3, (i / kEvery) % 3 == 0));
+		}
+		text = FormatFoldLayout(layout);
+	}
+	const double save = (PerfNowSeconds() - start) / kPasses;
+	CHECK(text.size() <= (size_t)FOLD_LAYOUT_MAX_CHARS);
+
+	A_long found = 0;
+	A_long folded = 0;
+	start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		FoldLayout layout;
+		CHECK(ParseFoldLayout(text, &layout));
+		found = 0;
+		folded = 0;
+		for (A_long i = 0; i < kLayers; i++) {
+			bool state = false;
+			if (FindFoldLayoutState(layout, (AEGP_LayerIDVal)(kLayers - i) * 3, &state)) {
+				found++;
+				if (state) folded++;
+			}
+		}
+	}
+	const double restore = (PerfNowSeconds() - start) / kPasses;
+	CHECK(found == kLayers / kEvery);
+	CHECK(folded == (kLayers / kEvery + 2) / 3);
+
+	printf("  layout: %d layers, %d dividers, %u chars; save %.3f ms, restore %.3f ms\n",
+		   (int)kLayers, (int)found, (unsigned)text.size(), save * 1e3, restore * 1e3);
+}
+
+void RunFoldLayoutTests()
+{
+	LayoutRoundTrip();
+	LayoutRejects();
+	LayoutLookupsAndNames();
+	LayoutBenchmark();
+}
@@ -0,0 +1,191 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Outline Tests                            */
+/*      Group selection over the snapshot's containment links      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/FoldOutline.h"
+#include "Utils/PerfStats.h"
+
+#include <vector>
+
+static FoldPlanLayer MakeLayer(AEGP_LayerIDVal id)
+{
+	FoldPlanLayer layer;
+	layer.layerH = NULL;
+	layer.id = id;
+	layer.shy = false;
+	layer.isDivider = false;
+	layer.folded = false;
+	layer.hasRow = false;
+	layer.depth = 0;
+	layer.target = FoldTarget_Keep;
+	return layer;
+}
+
+static FoldPlanLayer MakeDivider(AEGP_LayerIDVal id, int depth, bool hasRow = false)
+{
+	FoldPlanLayer layer = MakeLayer(id);
+	layer.isDivider = true;
+	layer.depth = depth;
+	layer.hasRow = hasRow;
+	return layer;
+}
+
+static std::vector<A_long> Selected(const FoldOutline& outline, const std::vector<A_long>& roots, bool nested)
+{
+	std::vector<bool> selected;
+	outline.SelectGroups(roots, nested, selected);
+	std::vector<A_long> indices;
+	for (size_t i = 0; i < selected.size(); i++) {
+		if (selected[i]) indices.push_back((A_long)i);
+	}
+	return indices;
+}
+
+static std::vector<A_long> Indices(const A_long* indices, size_t count)
+{
+	return std::vector<A_long>(indices, indices + count);
+}
+
+// Contents stops at sub groups; nested takes their trees as well
+static void ContentsAndNested()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0));
+	layers.push_back(MakeLayer(2));
+	layers.push_back(MakeDivider(3, 1));
+	layers.push_back(MakeLayer(4));
+	layers.push_back(MakeLayer(5));
+	layers.push_back(MakeDivider(6, 0));
+	layers.push_back(MakeLayer(7));
+
+	FoldOutline outline;
+	outline.Build(layers, FoldPlanRows());
+	CHECK(outline.Parent(3) == 2 && outline.Parent(2) == 0 && outline.Parent(6) == 5);
+	CHECK(outline.GroupEnd(0) == 5 && outline.GroupEnd(2) == 5 && outline.GroupEnd(5) == 7);
+
+	std::vector<A_long> roots(1, 0);
+	const A_long contents[] = { 0, 1 };
+	CHECK(Selected(outline, roots, false) == Indices(contents, 2));
+	const A_long nested[] = { 0, 1, 2, 3, 4 };
+	CHECK(Selected(outline, roots, true) == Indices(nested, 5));
+
+	// The sub group alone, and both top groups at once
+	roots[0] = 2;
+	const A_long child[] = { 2, 3, 4 };
+	CHECK(Selected(outline, roots, false) == Indices(child, 3));
+	roots[0] = 0;
+	roots.push_back(5);
+	const A_long both[] = { 0, 1, 5, 6 };
+	CHECK(Selected(outline, roots, false) == Indices(both, 4));
+}
+
+// Overlapping roots select each layer once; roots that are not dividers
+// (or not in the comp) select nothing
+static void RootsOverlapAndSkip()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0));
+	layers.push_back(MakeLayer(2));
+	layers.push_back(MakeDivider(3, 1));
+	layers.push_back(MakeLayer(4));
+
+	FoldOutline outline;
+	outline.Build(layers, FoldPlanRows());
+
+	const A_long overlap[] = { 2, 0 };
+	const A_long all[] = { 0, 1, 2, 3 };
+	CHECK(Selected(outline, Indices(overlap, 2), false) == Indices(all, 4));
+	CHECK(Selected(outline, Indices(overlap, 2), true) == Indices(all, 4));
+
+	const A_long skipped[] = { -1, 1, 3, 4, 99 };
+	CHECK(Selected(outline, Indices(skipped, 5), true).empty());
+
+	std::vector<bool> selected;
+	outline.SelectGroups(std::vector<A_long>(), true, selected);
+	CHECK(selected.size() == layers.size());
+}
+
+// A row owner's group is its row, wherever the members sit; members in
+// another group's range are still its own contents
+static void RowOwners()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0, true));
+	layers.push_back(MakeLayer(2));
+	layers.push_back(MakeDivider(3, 0));
+	layers.push_back(MakeLayer(4));
+	layers.push_back(MakeLayer(5));
+
+	FoldPlanRows rows;
+	rows[1].push_back(5);
+	rows[1].push_back(99);		// Deleted member: dropped
+	FoldOutline outline;
+	outline.Build(layers, rows);
+	CHECK(outline.Parent(1) == -1 && outline.Parent(4) == 2);
+
+	std::vector<A_long> roots(1, 0);
+	const A_long row[] = { 0, 4 };
+	CHECK(Selected(outline, roots, false) == Indices(row, 2));
+	CHECK(Selected(outline, roots, true) == Indices(row, 2));
+
+	// The positional group still owns the member too
+	roots[0] = 2;
+	const A_long range[] = { 2, 3, 4 };
+	CHECK(Selected(outline, roots, false) == Indices(range, 3));
+}
+
+// Select a 5,000-layer group (500 sub groups) of a 10,000-layer comp:
+// outline build plus both selections, against the layers the group holds
+static void SelectBenchmark()
+{
+	const A_long kLayers = 10000;
+	const A_long kGroup = 5000;
+	const A_long kEvery = 10;
+
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0));
+	for (A_long i = 1; i < kLayers; i++) {
+		const AEGP_LayerIDVal id = (AEGP_LayerIDVal)i + 1;
+		if (i == kGroup) layers.push_back(MakeDivider(id, 0));
+		else if (i % kEvery == 0) layers.push_back(MakeDivider(id, 1));
+		else layers.push_back(MakeLayer(id));
+	}
+
+	const int kPasses = 20;
+	const std::vector<A_long> roots(1, 0);
+	std::vector<bool> contents;
+	std::vector<bool> nested;
+	const double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		FoldOutline outline;
+		outline.Build(layers, FoldPlanRows());
+		outline.SelectGroups(roots, false, contents);
+		outline.SelectGroups(roots, true, nested);
+	}
+	const double elapsed = PerfNowSeconds() - start;
+
+	A_long inContents = 0;
+	A_long inNested = 0;
+	for (A_long i = 0; i < kLayers; i++) {
+		if (contents[(size_t)i]) inContents++;
+		if (nested[(size_t)i]) inNested++;
+	}
+	CHECK(inContents == kEvery);
+	CHECK(inNested == kGroup);
+	CHECK(!nested[(size_t)kGroup]);
+
+	printf("  select group: %d layers, %d in the group, %.3f ms per build and select\n",
+		   (int)kLayers, (int)inNested, elapsed * 1e3 / kPasses);
+}
+
+void RunFoldOutlineTests()
+{
+	ContentsAndNested();
+	RootsOverlapAndSkip();
+	RowOwners();
+	SelectBenchmark();
+}
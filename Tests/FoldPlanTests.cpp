@@ -0,0 +1,265 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Fold Plan Tests                               */
+/*      Divider flips and shy changes planned from a snapshot      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/FoldPlanner.h"
+#include "Utils/PerfStats.h"
+
+#include <utility>
+#include <vector>
+
+static FoldPlanLayer MakeLayer(AEGP_LayerIDVal id, bool shy)
+{
+	FoldPlanLayer layer;
+	layer.layerH = NULL;
+	layer.id = id;
+	layer.shy = shy;
+	layer.isDivider = false;
+	layer.folded = false;
+	layer.hasRow = false;
+	layer.depth = 0;
+	layer.target = FoldTarget_Keep;
+	return layer;
+}
+
+static FoldPlanLayer MakeDivider(AEGP_LayerIDVal id, int depth, bool folded, int target, bool shy = false)
+{
+	FoldPlanLayer layer = MakeLayer(id, shy);
+	layer.isDivider = true;
+	layer.folded = folded;
+	layer.depth = depth;
+	layer.target = target;
+	return layer;
+}
+
+typedef std::pair<A_long, bool>	ShyChange;
+
+static std::vector<ShyChange> Shy(const ShyChange* changes, size_t count)
+{
+	return std::vector<ShyChange>(changes, changes + count);
+}
+
+static void NothingToDo()
+{
+	std::vector<FoldPlanLayer> layers;
+	FoldPlanRows rows;
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers.empty() && plan.shy.empty());
+
+	layers.push_back(MakeDivider(1, 0, true, FoldTarget_Keep));
+	layers.push_back(MakeLayer(2, true));
+	layers.push_back(MakeDivider(3, 0, false, FoldTarget_Unfold));
+	layers.push_back(MakeLayer(4, false));
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers.empty() && plan.shy.empty());
+}
+
+// Folding a group hides the layers down to the next divider of its level;
+// layers outside it keep their flags, even ones set by hand
+static void FoldOneGroup()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeLayer(1, true));
+	layers.push_back(MakeDivider(2, 0, false, FoldTarget_Fold));
+	layers.push_back(MakeLayer(3, false));
+	layers.push_back(MakeLayer(4, true));
+	layers.push_back(MakeDivider(5, 0, false, FoldTarget_Keep));
+	layers.push_back(MakeLayer(6, true));
+
+	FoldPlanRows rows;
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers == std::vector<A_long>(1, 1));
+	const ShyChange expected[] = { ShyChange(2, true) };
+	CHECK(plan.shy == Shy(expected, 1));
+
+	// Unfolding it shows both members again
+	layers[1] = MakeDivider(2, 0, true, FoldTarget_Unfold);
+	layers[2].shy = true;
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers == std::vector<A_long>(1, 1));
+	const ShyChange unfolded[] = { ShyChange(2, false), ShyChange(3, false) };
+	CHECK(plan.shy == Shy(unfolded, 2));
+}
+
+// A folded child group keeps its members hidden when the parent unfolds,
+// and the child divider itself follows the parent
+static void NestedGroups()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0, true, FoldTarget_Unfold));
+	layers.push_back(MakeLayer(2, true));
+	layers.push_back(MakeDivider(3, 1, true, FoldTarget_Keep, true));
+	layers.push_back(MakeLayer(4, true));
+	layers.push_back(MakeDivider(5, 1, false, FoldTarget_Keep, true));
+	layers.push_back(MakeLayer(6, true));
+	layers.push_back(MakeDivider(7, 0, false, FoldTarget_Keep));
+
+	FoldPlanRows rows;
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers == std::vector<A_long>(1, 0));
+	const ShyChange expected[] = { ShyChange(1, false), ShyChange(2, false), ShyChange(4, false), ShyChange(5, false) };
+	CHECK(plan.shy == Shy(expected, 4));
+
+	// Folding the parent and unfolding the child: everything below stays hidden
+	layers[0] = MakeDivider(1, 0, false, FoldTarget_Fold);
+	layers[1].shy = false;
+	layers[2] = MakeDivider(3, 1, true, FoldTarget_Unfold, false);
+	layers[4].shy = false;
+	layers[5].shy = false;
+	PlanFold(layers, rows, plan);
+	const A_long flips[] = { 0, 2 };
+	CHECK(plan.dividers == std::vector<A_long>(flips, flips + 2));
+	const ShyChange folded[] = { ShyChange(1, true), ShyChange(2, true), ShyChange(4, true), ShyChange(5, true) };
+	CHECK(plan.shy == Shy(folded, 4));
+}
+
+// A row owner hides its members wherever they are, not the layers below it
+static void ExplicitRows()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0, false, FoldTarget_Fold));
+	layers[0].hasRow = true;
+	layers.push_back(MakeLayer(2, false));
+	layers.push_back(MakeDivider(3, 0, false, FoldTarget_Keep));
+	layers.push_back(MakeLayer(4, false));
+	layers.push_back(MakeLayer(5, false));
+
+	FoldPlanRows rows;
+	rows[1].push_back(5);
+	rows[1].push_back(99);		// Deleted member: ignored
+
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers == std::vector<A_long>(1, 0));
+	const ShyChange expected[] = { ShyChange(4, true) };
+	CHECK(plan.shy == Shy(expected, 1));
+
+	// Without its row in the table the owner hides nothing
+	rows.clear();
+	PlanFold(layers, rows, plan);
+	CHECK(plan.dividers == std::vector<A_long>(1, 0));
+	CHECK(plan.shy.empty());
+}
+
+static void FinalStates()
+{
+	CHECK(FinalFolded(MakeDivider(1, 0, true, FoldTarget_Keep)));
+	CHECK(!FinalFolded(MakeDivider(1, 0, false, FoldTarget_Keep)));
+	CHECK(FinalFolded(MakeDivider(1, 0, false, FoldTarget_Fold)));
+	CHECK(!FinalFolded(MakeDivider(1, 0, true, FoldTarget_Unfold)));
+}
+
+static std::vector<int> Targets(const std::vector<FoldPlanLayer>& layers)
+{
+	std::vector<int> targets;
+	for (size_t i = 0; i < layers.size(); i++) targets.push_back(layers[i].target);
+	return targets;
+}
+
+// Level N is depth N - 1. Fold to N folds level N and deeper; Expand to N
+// folds only what is deeper than N. Plain layers keep their Keep target.
+static void LevelTargets()
+{
+	const int depths[] = { 0, -1, 1, 2, -1, 1, 0 };
+	std::vector<FoldPlanLayer> layers;
+	for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+		layers.push_back(depths[i] < 0 ? MakeLayer((AEGP_LayerIDVal)i + 1, false) :
+			MakeDivider((AEGP_LayerIDVal)i + 1, depths[i], false, FoldTarget_Keep));
+	}
+
+	const int K = FoldTarget_Keep, F = FoldTarget_Fold, U = FoldTarget_Unfold;
+	SetFoldLevelTargets(layers, 2, false);
+	const int foldTo2[] = { U, K, F, F, K, F, U };
+	CHECK(Targets(layers) == std::vector<int>(foldTo2, foldTo2 + 7));
+
+	SetFoldLevelTargets(layers, 2, true);
+	const int expandTo2[] = { U, K, U, F, K, U, U };
+	CHECK(Targets(layers) == std::vector<int>(expandTo2, expandTo2 + 7));
+
+	SetFoldLevelTargets(layers, 1, false);
+	const int foldTo1[] = { F, K, F, F, K, F, F };
+	CHECK(Targets(layers) == std::vector<int>(foldTo1, foldTo1 + 7));
+
+	SetFoldLevelTargets(layers, 3, true);
+	const int expandTo3[] = { U, K, U, U, K, U, U };
+	CHECK(Targets(layers) == std::vector<int>(expandTo3, expandTo3 + 7));
+}
+
+// Expand to level 1 from everything folded: the top-level groups open,
+// their child dividers show, the children's members stay hidden
+static void ExpandToLevelPlan()
+{
+	std::vector<FoldPlanLayer> layers;
+	layers.push_back(MakeDivider(1, 0, true, FoldTarget_Keep));
+	layers.push_back(MakeDivider(2, 1, true, FoldTarget_Keep, true));
+	layers.push_back(MakeLayer(3, true));
+	layers.push_back(MakeLayer(4, true));
+	layers.push_back(MakeDivider(5, 0, true, FoldTarget_Keep));
+	layers.push_back(MakeLayer(6, true));
+
+	SetFoldLevelTargets(layers, 1, true);
+	FoldPlanRows rows;
+	FoldPlan plan;
+	PlanFold(layers, rows, plan);
+	const A_long flips[] = { 0, 4 };
+	CHECK(plan.dividers == std::vector<A_long>(flips, flips + 2));
+	const ShyChange expected[] = { ShyChange(1, false), ShyChange(5, false) };
+	CHECK(plan.shy == Shy(expected, 2));
+}
+
+// Fold to level 2 on 10,000 layers (1,000 dividers, four levels deep):
+// targets and plan in one pass, against the layers the old per-divider
+// toggles read, each scanning its own group
+static void FoldLevelBenchmark()
+{
+	const A_long kDividers = 1000;
+	const A_long kMembers = 9;
+	std::vector<FoldPlanLayer> layers;
+	for (A_long d = 0; d < kDividers; d++) {
+		layers.push_back(MakeDivider((AEGP_LayerIDVal)layers.size() + 1, (int)(d % 4), false, FoldTarget_Keep));
+		for (A_long m = 0; m < kMembers; m++) layers.push_back(MakeLayer((AEGP_LayerIDVal)layers.size() + 1, false));
+	}
+
+	const int kPasses = 20;
+	FoldPlanRows rows;
+	FoldPlan plan;
+	const double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		SetFoldLevelTargets(layers, 2, false);
+		PlanFold(layers, rows, plan);
+	}
+	const double elapsed = PerfNowSeconds() - start;
+	CHECK(plan.dividers.size() == (size_t)(kDividers * 3 / 4));
+
+	// One group scan per changed divider: its layers down to the next
+	// divider of the same or a higher level
+	size_t scanned = 0;
+	for (size_t p = 0; p < plan.dividers.size(); p++) {
+		const size_t d = (size_t)plan.dividers[p];
+		size_t i = d + 1;
+		while (i < layers.size() && !(layers[i].isDivider && layers[i].depth <= layers[d].depth)) i++;
+		scanned += i - d - 1;
+	}
+
+	printf("  fold to level: %d layers, %.3f ms per pass, %d layers read vs %d by per-divider scans\n",
+		   (int)layers.size(), elapsed * 1e3 / kPasses, (int)layers.size(), (int)scanned);
+}
+
+void RunFoldPlanTests()
+{
+	NothingToDo();
+	FoldOneGroup();
+	NestedGroups();
+	ExplicitRows();
+	FinalStates();
+	LevelTargets();
+	ExpandToLevelPlan();
+	FoldLevelBenchmark();
+}
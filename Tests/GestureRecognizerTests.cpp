@@ -0,0 +1,120 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Gesture Recognizer Tests                      */
+/*      Fake clock: time is the click timestamps                   */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "InputTestSupport.h"
+#include "Input/GestureRecognizer.h"
+#include "Utils/PerfStats.h"
+
+// Feeds one click; returns whether an intent came out
+static bool Feed(GestureRecognizer& recognizer, InputClickKind kind, double timestamp)
+{
+	FoldIntent intent;
+	const bool fired = recognizer.Consume(MakeClick(kind, timestamp), timestamp, &intent);
+	if (fired) CHECK(intent.kind == FoldIntent_Toggle && intent.inputTimestamp == timestamp);
+	return fired;
+}
+
+static void PairedPresses()
+{
+	GestureRecognizer recognizer;
+	CHECK(!Feed(recognizer, InputClick_Down, 10.0));
+	CHECK(Feed(recognizer, InputClick_Down, 10.2));
+
+	// A third press starts a new pair instead of firing again
+	CHECK(!Feed(recognizer, InputClick_Down, 10.5));
+	CHECK(recognizer.Stats().intentsEmitted == 1);
+}
+
+static void IntervalLimits()
+{
+	GestureRecognizer recognizer;
+
+	// Bounce keeps the first anchor
+	CHECK(!Feed(recognizer, InputClick_Down, 1.0));
+	CHECK(!Feed(recognizer, InputClick_Down, 1.01));
+	CHECK(recognizer.Stats().rejectedTooFast == 1);
+	CHECK(Feed(recognizer, InputClick_Down, 1.3));
+
+	// Too slow: the late press becomes the new anchor
+	CHECK(!Feed(recognizer, InputClick_Down, 5.0));
+	CHECK(!Feed(recognizer, InputClick_Down, 5.9));
+	CHECK(Feed(recognizer, InputClick_Down, 6.1));
+}
+
+static void Cooldown()
+{
+	GestureRecognizer recognizer;
+	CHECK(Feed(recognizer, InputClick_Double, 2.0));
+	CHECK(!Feed(recognizer, InputClick_Double, 2.1));
+	CHECK(recognizer.Stats().suppressedByCooldown == 1);
+	CHECK(Feed(recognizer, InputClick_Double, 2.5));
+}
+
+// Event tap double-click, then the polling path reporting that gesture's
+// second press late: a later single click must not toggle
+static void LatePolledPressAfterDouble()
+{
+	GestureRecognizer recognizer;
+	CHECK(Feed(recognizer, InputClick_Double, 3.0));
+	CHECK(!Feed(recognizer, InputClick_Down, 2.99));
+	CHECK(recognizer.Stats().coveredByDouble == 1);
+	CHECK(!Feed(recognizer, InputClick_Down, 3.4));
+	CHECK(Feed(recognizer, InputClick_Down, 3.6));
+}
+
+static void OsDoubleClickDisabled()
+{
+	GestureConfig config = DefaultGestureConfig();
+	config.acceptOsDoubleClick = false;
+	GestureRecognizer recognizer(config);
+	CHECK(!Feed(recognizer, InputClick_Double, 1.0));
+	CHECK(recognizer.Stats().intentsEmitted == 0);
+}
+
+static void History()
+{
+	GestureRecognizer recognizer;
+	for (int i = 0; i < GestureRecognizer::kHistorySize + 2; i++) {
+		Feed(recognizer, InputClick_Down, 100.0 + i);
+	}
+	CHECK(recognizer.HistoryCount() == (size_t)GestureRecognizer::kHistorySize);
+	CHECK(recognizer.HistoryAt(0).timestamp == 100.0 + GestureRecognizer::kHistorySize + 1);
+	CHECK(recognizer.HistoryAt(GestureRecognizer::kHistorySize - 1).timestamp == 102.0);
+
+	recognizer.Reset();
+	CHECK(recognizer.HistoryCount() == 0);
+}
+
+// Cost of recognizing one gesture (two presses), on the real clock. Too
+// short to time one at a time, so the batch is timed.
+static void RecognizerBenchmark()
+{
+	GestureRecognizer recognizer;
+	const int kGestures = 200000;
+	int fired = 0;
+	const double start = PerfNowSeconds();
+	for (int g = 0; g < kGestures; g++) {
+		const double t = g * 1.0;
+		Feed(recognizer, InputClick_Down, t);
+		if (Feed(recognizer, InputClick_Down, t + 0.2)) fired++;
+	}
+	const double elapsed = PerfNowSeconds() - start;
+	CHECK(fired == kGestures);
+	printf("  recognize: %d gestures, %.0f ns per gesture\n", kGestures, elapsed * 1e9 / kGestures);
+}
+
+void RunGestureRecognizerTests()
+{
+	PairedPresses();
+	IntervalLimits();
+	Cooldown();
+	LatePolledPressAfterDouble();
+	OsDoubleClickDisabled();
+	History();
+	RecognizerBenchmark();
+}
@@ -0,0 +1,78 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Group Member Row Tests                        */
+/*      FD-M: row format and the rows it refuses                   */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/GroupMembership.h"
+#include "FoldLayers.h"
+
+#include <string>
+#include <vector>
+
+static void RowRoundTrip()
+{
+	const AEGP_LayerIDVal ids[] = { 1, 0xffffffffu, 0x20, 7 };
+	std::vector<AEGP_LayerIDVal> members(ids, ids + 4);
+
+	const std::string text = FormatGroupMemberRow(0x1a, members);
+	CHECK(text == std::string(DIVIDER_MEMBERS_MARKER_PREFIX) + "1a|1,ffffffff,20,7");
+
+	AEGP_LayerIDVal owner = 0;
+	std::vector<AEGP_LayerIDVal> parsed;
+	CHECK(ParseGroupMemberRow(text, &owner, parsed));
+	CHECK(owner == 0x1a);
+	CHECK(parsed == members);
+
+	// Empty group: the owner alone
+	members.clear();
+	CHECK(FormatGroupMemberRow(5, members) == std::string(DIVIDER_MEMBERS_MARKER_PREFIX) + "5|");
+	CHECK(ParseGroupMemberRow(FormatGroupMemberRow(5, members), &owner, parsed));
+	CHECK(owner == 5);
+	CHECK(parsed.empty());
+}
+
+static void RowRejects()
+{
+	AEGP_LayerIDVal owner = 0;
+	std::vector<AEGP_LayerIDVal> parsed;
+	const std::string prefix = DIVIDER_MEMBERS_MARKER_PREFIX;
+
+	CHECK(!ParseGroupMemberRow("", &owner, parsed));
+	CHECK(!ParseGroupMemberRow("FD-S:1|2", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix, &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "|1", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "1a", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "1A|2", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "1|2,", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "1|2,,3", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "1|2;3", &owner, parsed));
+
+	// IDs are 32-bit: a ninth digit is not part of the field
+	CHECK(!ParseGroupMemberRow(prefix + "1|123456789", &owner, parsed));
+	CHECK(!ParseGroupMemberRow(prefix + "123456789|1", &owner, parsed));
+}
+
+// A row at the member limit reads back; one more member is refused
+static void RowLimit()
+{
+	std::vector<AEGP_LayerIDVal> members;
+	for (AEGP_LayerIDVal id = 1; id <= GROUP_MEMBERS_MAX; id++) members.push_back(id);
+
+	AEGP_LayerIDVal owner = 0;
+	std::vector<AEGP_LayerIDVal> parsed;
+	CHECK(ParseGroupMemberRow(FormatGroupMemberRow(9, members), &owner, parsed));
+	CHECK(parsed.size() == (size_t)GROUP_MEMBERS_MAX);
+
+	members.push_back(GROUP_MEMBERS_MAX + 1);
+	CHECK(!ParseGroupMemberRow(FormatGroupMemberRow(9, members), &owner, parsed));
+}
+
+void RunGroupMemberRowTests()
+{
+	RowRoundTrip();
+	RowRejects();
+	RowLimit();
+}
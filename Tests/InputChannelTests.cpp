@@ -0,0 +1,106 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Input Channel Tests                           */
+/*      Click ring and selection generation across threads         */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "InputTestSupport.h"
+#include "Input/InputChannel.h"
+
+#include <atomic>
+#include <thread>
+
+// One producer thread, one consumer thread: every click arrives once, in
+// order, or is counted as dropped; selection generations never go back
+static void StressInputChannel()
+{
+	static InputChannel channel;
+	const int kClicks = 200000;
+	std::atomic<bool> producerDone(false);
+	std::atomic<bool> generationWentBack(false);
+
+	std::thread producer([&]() {
+		uint32_t lastGeneration = 0;
+		for (int i = 1; i <= kClicks; i++) {
+			InputClickEvent ev = MakeClick(InputClick_Down, (double)i);
+			ev.clickCount = i;
+			channel.PushClick(ev);
+
+			const uint32_t generation = channel.SelectionGeneration();
+			if (generation < lastGeneration) generationWentBack = true;
+			lastGeneration = generation;
+		}
+		producerDone = true;
+	});
+
+	int received = 0;
+	int last = 0;
+	bool ordered = true;
+	bool selected = false;
+	for (;;) {
+		const bool done = producerDone.load();
+		InputClickEvent ev;
+		while (channel.PopClick(&ev)) {
+			if (ev.clickCount <= last || ev.timestamp != (double)ev.clickCount) ordered = false;
+			last = ev.clickCount;
+			received++;
+			if ((received & 255) == 0) {
+				selected = !selected;
+				channel.PublishSelection(selected);
+			}
+		}
+		if (done) break;
+	}
+	producer.join();
+
+	CHECK(ordered);
+	CHECK(!generationWentBack);
+	CHECK(received > 0);
+	CHECK((uint32_t)received + channel.DroppedClicks() == (uint32_t)kClicks);
+	CHECK(channel.PendingClicks() == 0);
+}
+
+static void RingCapacity()
+{
+	InputChannel channel;
+	for (int i = 0; i < InputChannel::kRingCapacity + 3; i++) {
+		InputClickEvent ev = MakeClick(InputClick_Down, (double)i);
+		ev.clickCount = i;
+		channel.PushClick(ev);
+	}
+	CHECK(channel.PendingClicks() == (size_t)InputChannel::kRingCapacity);
+	CHECK(channel.DroppedClicks() == 3);
+
+	// The newest clicks are the ones dropped
+	InputClickEvent first;
+	CHECK(channel.PopClick(&first));
+	CHECK(first.clickCount == 0);
+
+	channel.DiscardClicks();
+	CHECK(channel.PendingClicks() == 0);
+	CHECK(!channel.PopClick(&first));
+}
+
+static void SelectionGeneration()
+{
+	InputChannel channel;
+	CHECK(!channel.IsDividerSelected());
+	CHECK(channel.SelectionGeneration() == 0);
+
+	channel.PublishSelection(false);
+	CHECK(channel.SelectionGeneration() == 1);
+	channel.PublishSelection(false);
+	CHECK(channel.SelectionGeneration() == 1);
+	channel.PublishSelection(true);
+	CHECK(channel.IsDividerSelected());
+	CHECK(channel.SelectionGeneration() == 2);
+}
+
+void RunInputChannelTests()
+{
+	RingCapacity();
+	SelectionGeneration();
+	StressInputChannel();
+}
@@ -0,0 +1,27 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Input Test Support                            */
+/*      Click events for the input suites                          */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef INPUT_TEST_SUPPORT_H
+#define INPUT_TEST_SUPPORT_H
+
+#include "Input/InputChannel.h"
+
+// A click at a fixed timestamp (the recognizer's fake clock)
+static inline InputClickEvent MakeClick(InputClickKind kind, double timestamp)
+{
+	InputClickEvent ev;
+	ev.timestamp = timestamp;
+	ev.kind = kind;
+	ev.clickCount = (kind == InputClick_Double) ? 2 : 1;
+	ev.modifiers = InputModifier_None;
+	ev.selectionGeneration = 0;
+	return ev;
+}
+
+#endif // INPUT_TEST_SUPPORT_H
@@ -0,0 +1,176 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Layer ID Map Tests                            */
+/*      Map operations and snapshots that need no AE calls         */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Cache/LayerIdMap.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+static AEGP_LayerH FakeHandle(AEGP_LayerIDVal id)
+{
+	return (AEGP_LayerH)(uintptr_t)(0x1000 + id);
+}
+
+// Every reference entry is found with its data, and the size matches
+static void CheckAgainst(LayerIdMap& map, const std::map<AEGP_LayerIDVal, A_long>& reference)
+{
+	CHECK(map.Size() == reference.size());
+	for (std::map<AEGP_LayerIDVal, A_long>::const_iterator it = reference.begin(); it != reference.end(); ++it) {
+		const LayerIdEntry* entry = map.Find(it->first);
+		CHECK(entry != NULL);
+		if (entry) {
+			CHECK(entry->index == it->second);
+			CHECK(entry->layerH == FakeHandle(it->first));
+		}
+	}
+}
+
+static void EraseBasics()
+{
+	LayerIdMap map;
+	CHECK(!map.Erase(5));
+	CHECK(map.Find(5) == NULL);
+
+	map.Put(5, FakeHandle(5), 0);
+	map.Put(6, FakeHandle(6), 1);
+	CHECK(map.Size() == 2);
+	CHECK(!map.Erase(0));
+	CHECK(!map.Erase(7));
+	CHECK(map.Erase(5));
+	CHECK(!map.Erase(5));
+	CHECK(map.Find(5) == NULL);
+	CHECK(map.Find(6) != NULL);
+	CHECK(map.Size() == 1);
+}
+
+// Random puts and erases against std::map. Dense and strided IDs make long
+// probe runs that wrap around the table, which is where backward-shift
+// deletion can go wrong.
+static void EraseRandom()
+{
+	std::mt19937 rng(7);
+	for (int round = 0; round < 50; round++) {
+		LayerIdMap map;
+		std::map<AEGP_LayerIDVal, A_long> reference;
+		const AEGP_LayerIDVal stride = (round % 2) ? 1 : 64;
+
+		for (int op = 0; op < 4000; op++) {
+			const AEGP_LayerIDVal id = 1 + (AEGP_LayerIDVal)(rng() % 300) * stride;
+			if (rng() % 3 == 0) {
+				CHECK(map.Erase(id) == (reference.erase(id) != 0));
+			} else {
+				const A_long index = (A_long)(rng() % 1000);
+				map.Put(id, FakeHandle(id), index);
+				reference[id] = index;
+			}
+			if (op % 500 == 0) CheckAgainst(map, reference);
+		}
+		CheckAgainst(map, reference);
+
+		// Erased IDs stay gone
+		for (AEGP_LayerIDVal id = 1; id <= 300 * stride; id += stride) {
+			if (!reference.count(id)) CHECK(map.Find(id) == NULL);
+		}
+	}
+}
+
+// A snapshot places every layer, drops IDs that are gone and marks the
+// map synced; a second one only touches what moved
+static void SnapshotApply()
+{
+	AEGP_CompH compH = (AEGP_CompH)(uintptr_t)0x42;
+	std::vector<AEGP_LayerIDVal> ids;
+	std::vector<AEGP_LayerH> handles;
+	for (AEGP_LayerIDVal id = 10; id < 20; id++) {
+		ids.push_back(id);
+		handles.push_back(FakeHandle(id));
+	}
+
+	LayerIdMap map;
+	map.Put(99, FakeHandle(99), 3);
+	map.ApplySnapshot(compH, ids, handles);
+	CHECK(map.Comp() == compH);
+	CHECK(map.Synced());
+	CHECK(map.Size() == ids.size());
+	CHECK(map.Order() == ids);
+	CHECK(map.Find(99) == NULL);
+	CHECK(map.Find(15) != NULL && map.Find(15)->index == 5);
+
+	// Layer 10 moves to the bottom, 12 is deleted
+	std::rotate(ids.begin(), ids.begin() + 1, ids.end());
+	std::rotate(handles.begin(), handles.begin() + 1, handles.end());
+	ids.erase(ids.begin() + 1);
+	handles.erase(handles.begin() + 1);
+	map.ApplySnapshot(compH, ids, handles);
+	CHECK(map.Size() == ids.size());
+	CHECK(map.Find(12) == NULL);
+	CHECK(map.Find(10) != NULL && map.Find(10)->index == (A_long)ids.size() - 1);
+	CHECK(map.Find(11) != NULL && map.Find(11)->index == 0);
+	CHECK(map.Find(13) != NULL && map.Find(13)->layerH == FakeHandle(13));
+}
+
+// 10,000 layers: an idle snapshot, then ID lookups against the walk by
+// index the plugin did before the map (the walk's AE calls not counted)
+static void LayerIdMapBenchmark()
+{
+	const A_long kLayers = 10000;
+	AEGP_CompH compH = (AEGP_CompH)(uintptr_t)0x43;
+	std::vector<AEGP_LayerIDVal> ids;
+	std::vector<AEGP_LayerH> handles;
+	for (A_long i = 0; i < kLayers; i++) {
+		const AEGP_LayerIDVal id = 1 + (AEGP_LayerIDVal)i * 3;
+		ids.push_back(id);
+		handles.push_back(FakeHandle(id));
+	}
+
+	LayerIdMap map;
+	double start = PerfNowSeconds();
+	map.ApplySnapshot(compH, ids, handles);
+	const double snapshot = PerfNowSeconds() - start;
+	CHECK(map.Size() == (size_t)kLayers);
+
+	std::vector<AEGP_LayerIDVal> lookups(ids);
+	std::shuffle(lookups.begin(), lookups.end(), std::mt19937(11));
+
+	A_long found = 0;
+	start = PerfNowSeconds();
+	for (size_t l = 0; l < lookups.size(); l++) {
+		const LayerIdEntry* entry = map.Find(lookups[l]);
+		if (entry && ids[(size_t)entry->index] == lookups[l]) found++;
+	}
+	const double mapped = PerfNowSeconds() - start;
+	CHECK(found == kLayers);
+
+	const size_t kWalks = 1000;
+	A_long walked = 0;
+	start = PerfNowSeconds();
+	for (size_t l = 0; l < kWalks; l++) {
+		for (A_long i = 0; i < kLayers; i++) {
+			if (ids[(size_t)i] == lookups[l]) {
+				walked++;
+				break;
+			}
+		}
+	}
+	const double walk = PerfNowSeconds() - start;
+	CHECK(walked == (A_long)kWalks);
+
+	printf("  %d layers: snapshot %.2f ms, lookup %.0f ns, walk by index %.0f ns\n", (int)kLayers,
+		   snapshot * 1e3, mapped * 1e9 / kLayers, walk * 1e9 / kWalks);
+}
+
+void RunLayerIdMapTests()
+{
+	EraseBasics();
+	EraseRandom();
+	SnapshotApply();
+	LayerIdMapBenchmark();
+}
@@ -0,0 +1,539 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Reorder Plan Tests                            */
+/*      Fewest reorders for a new order, and the group plans       */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+#include "Hierarchy/GroupPlans.h"
+#include "Hierarchy/HierarchyRepair.h"
+#include "Hierarchy/ReorderPlan.h"
+#include "Utils/PerfStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+/*******************************************************************/
+/*      Reorder plan                                               */
+/*******************************************************************/
+
+// Runs moves the way AEGP_ReorderLayer would on layers named by their
+// starting index; the result lists them top to bottom
+static std::vector<A_long> ApplyMoves(A_long count, const std::vector<ReorderMove>& moves)
+{
+	std::vector<A_long> layers((size_t)count);
+	for (A_long i = 0; i < count; i++) layers[(size_t)i] = i;
+
+	for (size_t m = 0; m < moves.size(); m++) {
+		std::vector<A_long>::iterator it = std::find(layers.begin(), layers.end(), moves[m].layer);
+		layers.erase(it);
+		layers.insert(layers.begin() + moves[m].to, moves[m].layer);
+	}
+	return layers;
+}
+
+static size_t LongestIncreasingRun(const std::vector<A_long>& order)
+{
+	std::vector<A_long> tails;
+	for (size_t i = 0; i < order.size(); i++) {
+		std::vector<A_long>::iterator it = std::lower_bound(tails.begin(), tails.end(), order[i]);
+		if (it == tails.end()) tails.push_back(order[i]);
+		else *it = order[i];
+	}
+	return tails.size();
+}
+
+static void CheckPlan(const std::vector<A_long>& order)
+{
+	std::vector<ReorderMove> moves;
+	PlanReorder(order, moves);
+	CHECK(ApplyMoves((A_long)order.size(), moves) == order);
+	CHECK(moves.size() == order.size() - LongestIncreasingRun(order));
+}
+
+static void ReorderPlanCases()
+{
+	std::vector<A_long> order;
+	CheckPlan(order);
+
+	for (A_long i = 0; i < 10; i++) order.push_back(i);
+	std::vector<ReorderMove> moves;
+	PlanReorder(order, moves);
+	CHECK(moves.empty());
+
+	// Swapping two blocks moves the smaller one
+	const A_long swapped[] = { 0, 7, 8, 1, 2, 3, 4, 5, 6, 9 };
+	order.assign(swapped, swapped + 10);
+	PlanReorder(order, moves);
+	CHECK(moves.size() == 2);
+	CheckPlan(order);
+
+	std::reverse(order.begin(), order.end());
+	CheckPlan(order);
+}
+
+static void ReorderPlanRandom()
+{
+	std::mt19937 rng(2024);
+	for (int round = 0; round < 2000; round++) {
+		std::vector<A_long> order((size_t)(rng() % 40));
+		for (size_t i = 0; i < order.size(); i++) order[i] = (A_long)i;
+
+		// Mostly local shuffles, like real group moves, plus some full ones
+		if (round % 4 == 0) {
+			std::shuffle(order.begin(), order.end(), rng);
+		} else if (order.size() > 2) {
+			const size_t a = rng() % order.size();
+			const size_t b = rng() % order.size();
+			const size_t c = rng() % order.size();
+			size_t lo = std::min(a, std::min(b, c));
+			size_t hi = std::max(a, std::max(b, c));
+			size_t mid = a + b + c - lo - hi;
+			std::rotate(order.begin() + lo, order.begin() + mid, order.begin() + hi);
+		}
+		CheckPlan(order);
+	}
+}
+
+/*******************************************************************/
+/*      Group moves                                                */
+/*******************************************************************/
+
+// depths[i] is layer i's divider depth, -1 for a plain layer
+static void BuildTree(const int* depths, size_t count, GroupTree& outTree)
+{
+	std::vector<IndexedDivider> dividers;
+	for (size_t i = 0; i < count; i++) {
+		if (depths[i] < 0) continue;
+		IndexedDivider divider;
+		divider.id = (AEGP_LayerIDVal)i + 1;
+		divider.layerH = NULL;
+		divider.index = (A_long)i;
+		divider.depth = depths[i];
+		divider.folded = false;
+		dividers.push_back(divider);
+	}
+	outTree.Build(dividers, (A_long)count);
+}
+
+static std::vector<A_long> Order(const A_long* order, size_t count)
+{
+	return std::vector<A_long>(order, order + count);
+}
+
+// Plans a move and checks that its reorders reach the order
+static std::vector<A_long> MoveOrder(const GroupTree& tree, const std::vector<A_long>& roots, int direction,
+									 A_long targetIndex = 0)
+{
+	std::vector<A_long> order;
+	PlanGroupMove(tree, roots, direction, targetIndex, order);
+	if (!order.empty()) CheckPlan(order);
+	return order;
+}
+
+//   0 A   2 B   4 B1   6 B2   8 C      (B1, B2 inside B)
+static const int	S_move_depths[] = { 0, -1, 0, -1, 1, -1, 1, -1, 0, -1 };
+static const A_long	S_identity10[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+static void GroupTreeShape()
+{
+	GroupTree tree;
+	BuildTree(S_move_depths, 10, tree);
+	CHECK(tree.Count() == 5 && tree.NumLayers() == 10);
+	CHECK(tree.End(0) == 2 && tree.End(1) == 8 && tree.End(2) == 6 && tree.End(3) == 8 && tree.End(4) == 10);
+	CHECK(tree.Parent(2) == 1 && tree.Parent(3) == 1 && tree.Parent(4) == -1);
+	const A_long top[] = { 0, 1, 4 };
+	CHECK(tree.Children(-1) == Order(top, 3));
+	CHECK(tree.AtIndex(4) == 2 && tree.AtIndex(5) == -1);
+	CHECK(tree.Container(5) == 2 && tree.Container(4) == 1 && tree.Container(9) == 4 && tree.Container(0) == -1);
+}
+
+static void GroupMoveCases()
+{
+	GroupTree tree;
+	BuildTree(S_move_depths, 10, tree);
+	std::vector<A_long> roots(1, 1);
+
+	// B up past A: the smaller block (A) moves
+	const A_long bUp[] = { 2, 3, 4, 5, 6, 7, 0, 1, 8, 9 };
+	CHECK(MoveOrder(tree, roots, MoveGroup_Up) == Order(bUp, 10));
+	std::vector<ReorderMove> moves;
+	PlanReorder(Order(bUp, 10), moves);
+	CHECK(moves.size() == 2);
+
+	roots[0] = 0;
+	CHECK(MoveOrder(tree, roots, MoveGroup_Down) == Order(bUp, 10));
+	CHECK(MoveOrder(tree, roots, MoveGroup_Up).empty());
+	roots[0] = 4;
+	CHECK(MoveOrder(tree, roots, MoveGroup_Down).empty());
+
+	// Child groups move inside their parent
+	roots[0] = 3;
+	const A_long b2Up[] = { 0, 1, 2, 3, 6, 7, 4, 5, 8, 9 };
+	CHECK(MoveOrder(tree, roots, MoveGroup_Up) == Order(b2Up, 10));
+
+	// A run of selected groups moves together
+	roots[0] = 1;
+	roots.push_back(4);
+	const A_long runUp[] = { 2, 3, 4, 5, 6, 7, 8, 9, 0, 1 };
+	CHECK(MoveOrder(tree, roots, MoveGroup_Up) == Order(runUp, 10));
+
+	// To the sibling slot holding the target index
+	roots.assign(1, 0);
+	CHECK(MoveOrder(tree, roots, MoveGroup_ToIndex, 9) == Order(runUp, 10));
+	roots[0] = 4;
+	const A_long cToTop[] = { 8, 9, 0, 1, 2, 3, 4, 5, 6, 7 };
+	CHECK(MoveOrder(tree, roots, MoveGroup_ToIndex, 0) == Order(cToTop, 10));
+	CHECK(MoveOrder(tree, roots, MoveGroup_ToIndex, 8).empty());
+}
+
+// Siblings at different levels do not pass each other
+static void GroupMoveLevels()
+{
+	const int depths[] = { 1, -1, 0, -1 };
+	GroupTree tree;
+	BuildTree(depths, 4, tree);
+	CHECK(tree.Children(-1).size() == 2);
+
+	std::vector<A_long> roots(1, 1);
+	CHECK(MoveOrder(tree, roots, MoveGroup_Up).empty());
+	CHECK(MoveOrder(tree, roots, MoveGroup_ToIndex, 0).empty());
+	roots[0] = 0;
+	CHECK(MoveOrder(tree, roots, MoveGroup_Down).empty());
+}
+
+// A 2,000-layer group moved up past a 10-layer group in a 10,000-layer
+// comp: the plan's reorders against moving each of the group's layers on
+// its own. Applying replays the moves on a layer list, where each one
+// shifts the indices below it as AEGP_ReorderLayer does.
+static void GroupMoveBenchmark()
+{
+	const A_long kLayers = 10000;
+	const A_long kSmallAt = 3000;
+	const A_long kSmall = 10;
+	const A_long kLarge = 2000;
+	const A_long kEvery = 20;
+
+	std::vector<int> depths((size_t)kLayers, -1);
+	for (A_long i = 0; i < kLayers; i += 100) depths[(size_t)i] = 0;
+	depths[(size_t)kSmallAt] = 0;
+	depths[(size_t)(kSmallAt + kSmall)] = 0;
+	for (A_long i = kSmallAt + kSmall + 1; i < kSmallAt + kSmall + kLarge; i++) {
+		depths[(size_t)i] = (i - kSmallAt) % kEvery == 0 ? 1 : -1;
+	}
+	depths[(size_t)(kSmallAt + kSmall + kLarge)] = 0;
+
+	GroupTree tree;
+	BuildTree(&depths[0], depths.size(), tree);
+	std::vector<A_long> roots(1, tree.AtIndex(kSmallAt + kSmall));
+	CHECK(tree.End(roots[0]) - tree.Divider(roots[0]).index == kLarge);
+
+	const int kPasses = 5;
+	std::vector<A_long> order;
+	std::vector<ReorderMove> moves;
+	std::vector<A_long> result;
+	double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		PlanGroupMove(tree, roots, MoveGroup_Up, 0, order);
+		PlanReorder(order, moves);
+		result = ApplyMoves(kLayers, moves);
+	}
+	const double planned = (PerfNowSeconds() - start) / kPasses;
+	CHECK(result == order);
+	CHECK(moves.size() == (size_t)kSmall);
+
+	// Layer by layer: each of the group's layers to its slot, top first
+	std::vector<ReorderMove> naive;
+	for (A_long k = 0; k < kLarge; k++) {
+		ReorderMove move;
+		move.layer = kSmallAt + kSmall + k;
+		move.to = kSmallAt + k;
+		naive.push_back(move);
+	}
+	start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) result = ApplyMoves(kLayers, naive);
+	const double layered = (PerfNowSeconds() - start) / kPasses;
+	CHECK(result == order);
+
+	printf("  group move: %d layers, %d reorders in %.3f ms vs %d layer by layer in %.3f ms\n",
+		   (int)kLayers, (int)moves.size(), planned * 1e3, (int)naive.size(), layered * 1e3);
+}
+
+/*******************************************************************/
+/*      Group selection                                            */
+/*******************************************************************/
+
+static GroupSelectionPlan SelectionPlan(const GroupTree& tree, const A_long* indices, size_t count)
+{
+	GroupSelectionPlan plan;
+	PlanGroupSelection(tree, std::vector<A_long>(indices, indices + count), plan);
+	if (!plan.order.empty()) CheckPlan(plan.order);
+	return plan;
+}
+
+// Orders count the new divider, created at insertAt before the moves
+static void GroupSelectionCases()
+{
+	GroupTree tree;
+	BuildTree(S_move_depths, 10, tree);
+
+	// Layers of two top-level groups: a new top-level group above the first
+	const A_long twoGroups[] = { 3, 1 };
+	GroupSelectionPlan plan = SelectionPlan(tree, twoGroups, 2);
+	const A_long topOrder[] = { 0, 2, 4, 1, 3, 5, 6, 7, 8, 9, 10 };
+	CHECK(plan.parent == -1 && plan.insertAt == 0 && plan.layers == 2 && plan.roots.empty());
+	CHECK(plan.order == Order(topOrder, 11));
+
+	// Layers of two child groups nest the new group in their parent, B
+	const A_long children[] = { 5, 7 };
+	plan = SelectionPlan(tree, children, 2);
+	const A_long childOrder[] = { 0, 1, 2, 3, 4, 6, 8, 5, 7, 9, 10 };
+	CHECK(plan.parent == 1 && plan.insertAt == 4);
+	CHECK(plan.order == Order(childOrder, 11));
+
+	// A selected group moves with its subtree; the divider goes below it
+	const A_long withGroup[] = { 4, 7 };
+	plan = SelectionPlan(tree, withGroup, 2);
+	const A_long groupOrder[] = { 0, 1, 2, 3, 6, 4, 5, 8, 7, 9, 10 };
+	CHECK(plan.parent == 1 && plan.insertAt == 6 && plan.layers == 3);
+	CHECK(plan.roots == std::vector<A_long>(1, 2));
+	CHECK(plan.order == Order(groupOrder, 11));
+
+	// A direct member of B: after B's direct members, above its child groups
+	const A_long direct[] = { 3, 3 };
+	plan = SelectionPlan(tree, direct, 2);
+	const A_long directOrder[] = { 0, 1, 2, 4, 3, 5, 6, 7, 8, 9, 10 };
+	CHECK(plan.parent == 1 && plan.insertAt == 4 && plan.layers == 1);
+	CHECK(plan.order == Order(directOrder, 11));
+
+	// Layers inside a selected group are part of it
+	const A_long inside[] = { 5, 2 };
+	plan = SelectionPlan(tree, inside, 2);
+	const A_long insideOrder[] = { 0, 1, 8, 2, 3, 4, 5, 6, 7, 9, 10 };
+	CHECK(plan.parent == -1 && plan.insertAt == 8 && plan.layers == 6);
+	CHECK(plan.roots == std::vector<A_long>(1, 1));
+	CHECK(plan.order == Order(insideOrder, 11));
+
+	const A_long outside[] = { -1, 10 };
+	plan = SelectionPlan(tree, outside, 2);
+	CHECK(plan.order.empty() && plan.layers == 0 && plan.parent == -1);
+	plan = SelectionPlan(tree, outside, 0);
+	CHECK(plan.order.empty());
+}
+
+/*******************************************************************/
+/*      Duplicate group                                            */
+/*******************************************************************/
+
+static std::vector<A_long> DuplicateOrder(A_long numLayers, const std::vector<std::vector<A_long> >& copyIndices,
+										  const std::vector<A_long>& rootEnds)
+{
+	std::vector<A_long> order;
+	PlanDuplicateOrder(numLayers, copyIndices, rootEnds, order);
+	CheckPlan(order);
+	return order;
+}
+
+static void DuplicateOrderCases()
+{
+	// Six layers, copies of the group at 1..2 made at the top
+	std::vector<std::vector<A_long> > copyIndices(1);
+	copyIndices[0].push_back(0);
+	copyIndices[0].push_back(1);
+	std::vector<A_long> rootEnds(1, 3);
+	const A_long below[] = { 2, 3, 4, 0, 1, 5, 6, 7 };
+	CHECK(DuplicateOrder(8, copyIndices, rootEnds) == Order(below, 8));
+
+	// Each copy right above its original, as AEGP_DuplicateLayer leaves it
+	copyIndices[0][0] = 1;
+	copyIndices[0][1] = 3;
+	const A_long interleaved[] = { 0, 2, 4, 1, 3, 5, 6, 7 };
+	CHECK(DuplicateOrder(8, copyIndices, rootEnds) == Order(interleaved, 8));
+
+	// Two groups, copies at the bottom: each block goes below its own group
+	copyIndices.assign(2, std::vector<A_long>());
+	copyIndices[0].push_back(7);
+	copyIndices[1].push_back(8);
+	rootEnds.assign(1, 2);
+	rootEnds.push_back(5);
+	const A_long twoGroups[] = { 0, 1, 7, 2, 3, 4, 8, 5, 6 };
+	CHECK(DuplicateOrder(9, copyIndices, rootEnds) == Order(twoGroups, 9));
+
+	// A group at the end of the comp
+	rootEnds[1] = 7;
+	const A_long atEnd[] = { 0, 1, 7, 2, 3, 4, 5, 6, 8 };
+	CHECK(DuplicateOrder(9, copyIndices, rootEnds) == Order(atEnd, 9));
+
+	// Nothing copied: the comp as it is
+	copyIndices.clear();
+	rootEnds.clear();
+	std::vector<A_long> order;
+	PlanDuplicateOrder(3, copyIndices, rootEnds, order);
+	const A_long same[] = { 0, 1, 2 };
+	CHECK(order == Order(same, 3));
+}
+
+// A 500-layer group duplicated in a 10,000-layer comp, each copy made right
+// above its original: order and reorder plan, one move per copy
+static void DuplicateOrderBenchmark()
+{
+	const A_long kLayers = 10000;
+	const A_long kFirst = 4000;
+	const A_long kGroup = 500;
+
+	std::vector<std::vector<A_long> > copyIndices(1);
+	for (A_long c = 0; c < kGroup; c++) copyIndices[0].push_back(kFirst + c * 2);
+	const std::vector<A_long> rootEnds(1, kFirst + kGroup);
+
+	const int kPasses = 20;
+	std::vector<A_long> order;
+	std::vector<ReorderMove> moves;
+	const double start = PerfNowSeconds();
+	for (int pass = 0; pass < kPasses; pass++) {
+		PlanDuplicateOrder(kLayers + kGroup, copyIndices, rootEnds, order);
+		PlanReorder(order, moves);
+	}
+	const double elapsed = (PerfNowSeconds() - start) / kPasses;
+	CHECK(moves.size() == (size_t)kGroup);
+	CHECK(ApplyMoves(kLayers + kGroup, moves) == order);
+
+	printf("  duplicate: %d-layer group in %d layers, %d reorders, %.3f ms to plan\n",
+		   (int)kGroup, (int)kLayers, (int)moves.size(), elapsed * 1e3);
+}
+
+/*******************************************************************/
+/*      Ungroup                                                    */
+/*******************************************************************/
+
+static std::vector<A_long> UngroupOrder(const GroupTree& tree, const A_long* removedGroups, size_t count)
+{
+	std::vector<bool> removed((size_t)tree.Count(), false);
+	for (size_t r = 0; r < count; r++) removed[(size_t)removedGroups[r]] = true;
+	std::vector<A_long> order;
+	PlanUngroupOrder(tree, removed, order);
+	CheckPlan(order);
+	return order;
+}
+
+// Orders are of the comp once the removed dividers are deleted
+static void UngroupOrderCases()
+{
+	GroupTree tree;
+	BuildTree(S_move_depths, 10, tree);
+
+	// B: its direct member has no group above and goes to the top; B1 and
+	// B2 become top-level groups where they are
+	const A_long b[] = { 1 };
+	const A_long bOrder[] = { 2, 0, 1, 3, 4, 5, 6, 7, 8 };
+	CHECK(UngroupOrder(tree, b, 1) == Order(bOrder, 9));
+
+	// B1: its member is already in B's direct members
+	const A_long b1[] = { 2 };
+	const A_long b1Order[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+	CHECK(UngroupOrder(tree, b1, 1) == Order(b1Order, 9));
+
+	// B2: its member joins B's direct members, above B1, rather than B1
+	const A_long b2[] = { 3 };
+	const A_long b2Order[] = { 0, 1, 2, 3, 6, 4, 5, 7, 8 };
+	CHECK(UngroupOrder(tree, b2, 1) == Order(b2Order, 9));
+
+	const A_long ac[] = { 0, 4 };
+	const A_long acOrder[] = { 0, 7, 1, 2, 3, 4, 5, 6 };
+	CHECK(UngroupOrder(tree, ac, 2) == Order(acOrder, 8));
+
+	CHECK(UngroupOrder(tree, ac, 0) == Order(S_identity10, 10));
+
+	std::vector<bool> removed((size_t)tree.Count(), false);
+	removed[1] = true;
+	CHECK(SurvivingGroup(tree, removed, 1) == -1 && SurvivingGroup(tree, removed, 2) == 2);
+	removed[1] = false;
+	removed[2] = true;
+	CHECK(SurvivingGroup(tree, removed, 2) == 1 && SurvivingGroup(tree, removed, -1) == -1);
+}
+
+// Groups below a removed one take the first free label of their new
+// parent; every other path stays as it is
+static void RepairHierarchyCases()
+{
+	//   1   1/A   1/A/a   .   1/A/b   1/B   1/B/a
+	const int depths[] = { 0, 1, 2, -1, 2, 1, 2 };
+	const char* const paths[] = { "1", "1/A", "1/A/a", "1/A/b", "1/B", "1/B/a" };
+	GroupTree tree;
+	BuildTree(depths, 7, tree);
+	const std::vector<std::string> before(paths, paths + 6);
+
+	std::vector<bool> removed((size_t)tree.Count(), false);
+	std::vector<std::string> after;
+	CHECK(RepairHierarchy(tree, before, removed, after));
+	CHECK(after == before);
+
+	removed[1] = true;
+	CHECK(RepairHierarchy(tree, before, removed, after));
+	CHECK(after[2] == "1/A" && after[3] == "1/C");
+	CHECK(after[0] == "1" && after[4] == "1/B" && after[5] == "1/B/a");
+
+	// Removing 1/B/a changes nothing else
+	removed[1] = false;
+	removed[5] = true;
+	CHECK(RepairHierarchy(tree, before, removed, after));
+	CHECK(after == before);
+
+	// A top-level group's children become top-level groups (no path), and
+	// their children take labels under that
+	removed[5] = false;
+	removed[0] = true;
+	CHECK(RepairHierarchy(tree, before, removed, after));
+	CHECK(after[1] == "" && after[4] == "");
+	CHECK(after[2] == "1" && after[3] == "2" && after[5] == "3");
+}
+
+// Two groups moving up into one free label: the level runs out
+static void RepairHierarchyFull()
+{
+	std::vector<int> depths(1, 0);
+	std::vector<std::string> paths(1, "1");
+	for (char label = 'A'; label <= 'Z'; label++) {
+		depths.push_back(1);
+		paths.push_back(std::string("1/") + label);
+	}
+	depths.push_back(2);
+	paths.push_back("1/Z/a");
+	depths.push_back(2);
+	paths.push_back("1/Z/b");
+
+	GroupTree tree;
+	BuildTree(&depths[0], depths.size(), tree);
+	std::vector<bool> removed((size_t)tree.Count(), false);
+	std::vector<std::string> after;
+
+	removed[26] = true;
+	CHECK(!RepairHierarchy(tree, paths, removed, after));
+
+	// With one child fewer it fits in the label that was freed
+	depths.pop_back();
+	paths.pop_back();
+	BuildTree(&depths[0], depths.size(), tree);
+	removed.assign((size_t)tree.Count(), false);
+	removed[26] = true;
+	CHECK(RepairHierarchy(tree, paths, removed, after));
+	CHECK(after[27] == "1/Z");
+}
+
+void RunReorderPlanTests()
+{
+	ReorderPlanCases();
+	ReorderPlanRandom();
+	GroupTreeShape();
+	GroupMoveCases();
+	GroupMoveLevels();
+	GroupMoveBenchmark();
+	GroupSelectionCases();
+	DuplicateOrderCases();
+	DuplicateOrderBenchmark();
+	UngroupOrderCases();
+	RepairHierarchyCases();
+	RepairHierarchyFull();
+}
@@ -0,0 +1,39 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Test Harness                                  */
+/*      Minimal checks for the AE-independent modules              */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <cstdio>
+
+// Failed checks so far; main() turns a non-zero count into a failing exit code
+extern int	S_test_failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			S_test_failures++; \
+			fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+		} \
+	} while (0)
+
+// One suite per module, run by name from TestMain.cpp
+void RunInputChannelTests();
+void RunGestureRecognizerTests();
+void RunFoldDispatcherTests();
+void RunReorderPlanTests();
+void RunDividerRecordTests();
+void RunLayerIdMapTests();
+void RunGroupMemberRowTests();
+void RunDividerIndexTests();
+void RunFoldPlanTests();
+void RunFoldLayoutTests();
+void RunFoldOutlineTests();
+
+#endif // TEST_HARNESS_H
@@ -0,0 +1,51 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Test Runner                                   */
+/*      FoldLayersTests [suite]: runs one suite, or all of them    */
+/*                                                                 */
+/*******************************************************************/
+
+#include "TestHarness.h"
+
+#include <cstring>
+
+int	S_test_failures = 0;
+
+typedef struct {
+	const char*	name;
+	void		(*run)();
+} TestSuite;
+
+static const TestSuite	S_suites[] = {
+	{ "input_channel",		RunInputChannelTests },
+	{ "gesture_recognizer",	RunGestureRecognizerTests },
+	{ "fold_dispatcher",	RunFoldDispatcherTests },
+	{ "reorder_plan",		RunReorderPlanTests },
+	{ "divider_record",		RunDividerRecordTests },
+	{ "layer_id_map",		RunLayerIdMapTests },
+	{ "group_member_row",	RunGroupMemberRowTests },
+	{ "divider_index",		RunDividerIndexTests },
+	{ "fold_plan",			RunFoldPlanTests },
+	{ "fold_layout",		RunFoldLayoutTests },
+	{ "fold_outline",		RunFoldOutlineTests }
+};
+
+int main(int argc, char** argv)
+{
+	const char* only = (argc > 1) ? argv[1] : NULL;
+	bool ran = false;
+
+	for (size_t s = 0; s < sizeof(S_suites) / sizeof(S_suites[0]); s++) {
+		if (only && strcmp(only, S_suites[s].name) != 0) continue;
+		const int before = S_test_failures;
+		S_suites[s].run();
+		printf("%s: %s\n", S_suites[s].name, S_test_failures == before ? "ok" : "FAILED");
+		ran = true;
+	}
+
+	if (!ran) {
+		fprintf(stderr, "Unknown suite: %s\n", only);
+		return 2;
+	}
+	return S_test_failures ? 1 : 0;
+}
@@ -0,0 +1,270 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Layer Marker Records                          */
+/*      Plugin-owned metadata stored in layer marker comments      */
+/*                                                                 */
+/*******************************************************************/
+
+#include "LayerMarkers.h"
+#include "FoldLayers.h"
+
+#include <vector>
+
+// Upper bound on markers scanned per layer (records sit near the start)
+static const A_long	MAX_MARKERS_TO_SCAN	= 256;
+
+// *outTruncated: the comment is longer than LAYER_MARKER_MAX_CHARS and
+// comment holds only its start
+static A_Err ReadMarkerComment(AEGP_SuiteHandler& suites, AEGP_StreamRefH markerStreamH,
+							   AEGP_KeyframeIndex index, std::string& comment, bool* outTruncated)
+{
+	A_Err err = A_Err_NONE;
+	comment.clear();
+	*outTruncated = false;
+
+	AEGP_StreamValue2 value;
+	memset(&value, 0, sizeof(value));
+	ERR(suites.KeyframeSuite4()->AEGP_GetNewKeyframeValue(S_my_id, markerStreamH, index, &value));
+	if (err) return err;
+
+	if (value.val.markerP) {
+		AEGP_MemHandle commentH = NULL;
+		ERR(suites.MarkerSuite2()->AEGP_GetMarkerString(S_my_id, value.val.markerP, AEGP_MarkerString_COMMENT, &commentH));
+		if (!err && commentH) {
+			void* dataP = NULL;
+			if (suites.MemorySuite1()->AEGP_LockMemHandle(commentH, &dataP) == A_Err_NONE && dataP) {
+				const A_u_short* comment16 = (const A_u_short*)dataP;
+				int i = 0;
+				for (; comment16[i] && i < LAYER_MARKER_MAX_CHARS; i++) {
+					if (comment16[i] < 0x80) {
+						comment += (char)comment16[i];
+					}
+				}
+				*outTruncated = comment16[i] != 0;
+				suites.MemorySuite1()->AEGP_UnlockMemHandle(commentH);
+			}
+			suites.MemorySuite1()->AEGP_FreeMemHandle(commentH);
+		}
+	}
+
+	suites.StreamSuite4()->AEGP_DisposeStreamValue(&value);
+	return err;
+}
+
+static A_Err FindRecordInStream(AEGP_SuiteHandler& suites, AEGP_StreamRefH markerStreamH, const char* prefix,
+								AEGP_KeyframeIndex* outIndex, std::string* outComment)
+{
+	A_Err err = A_Err_NONE;
+	*outIndex = -1;
+
+	A_long numMarkers = 0;
+	ERR(suites.KeyframeSuite4()->AEGP_GetStreamNumKFs(markerStreamH, &numMarkers));
+	if (numMarkers > MAX_MARKERS_TO_SCAN) numMarkers = MAX_MARKERS_TO_SCAN;
+
+	const size_t prefixLen = strlen(prefix);
+	std::string comment;
+	bool truncated = false;
+	for (A_long i = 0; i < numMarkers && !err && *outIndex < 0; i++) {
+		if (ReadMarkerComment(suites, markerStreamH, i, comment, &truncated) == A_Err_NONE &&
+			comment.compare(0, prefixLen, prefix) == 0) {
+			// A cut-short record is still found (so it can be replaced or
+			// removed) but never handed out to be parsed
+			*outIndex = i;
+			if (outComment) *outComment = truncated ? std::string() : comment;
+		}
+	}
+
+	return err;
+}
+
+A_Err FindLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix,
+							AEGP_KeyframeIndex* outIndex, std::string* outComment)
+{
+	A_Err err = A_Err_NONE;
+	*outIndex = -1;
+	if (!layerH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.StreamSuite4()->AEGP_GetNewLayerStream(S_my_id, layerH, AEGP_LayerStream_MARKER, &markerStreamH));
+	if (!err && markerStreamH) {
+		ERR(FindRecordInStream(suites, markerStreamH, prefix, outIndex, outComment));
+		suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	}
+
+	return err;
+}
+
+// First 1/100 s slot at or after time 0 (layer or comp time) without a marker
+static A_Err FindFreeMarkerTime(AEGP_SuiteHandler& suites, AEGP_StreamRefH markerStreamH, AEGP_LTimeMode timeMode,
+								A_Time* outTime)
+{
+	A_Err err = A_Err_NONE;
+
+	A_long numMarkers = 0;
+	ERR(suites.KeyframeSuite4()->AEGP_GetStreamNumKFs(markerStreamH, &numMarkers));
+	if (numMarkers > MAX_MARKERS_TO_SCAN) numMarkers = MAX_MARKERS_TO_SCAN;
+
+	std::vector<double> taken;
+	for (A_long i = 0; i < numMarkers && !err; i++) {
+		A_Time t;
+		ERR(suites.KeyframeSuite4()->AEGP_GetKeyframeTime(markerStreamH, i, timeMode, &t));
+		if (!err && t.scale) {
+			taken.push_back((double)t.value / (double)t.scale);
+		}
+	}
+
+	outTime->scale = 100;
+	for (A_long slot = 0; slot <= MAX_MARKERS_TO_SCAN; slot++) {
+		const double seconds = (double)slot / 100.0;
+		bool used = false;
+		for (size_t i = 0; i < taken.size() && !used; i++) {
+			const double diff = taken[i] - seconds;
+			used = (diff < 0.005 && diff > -0.005);
+		}
+		if (!used) {
+			outTime->value = slot;
+			return err;
+		}
+	}
+
+	return A_Err_GENERIC;
+}
+
+static A_Err WriteRecordInStream(AEGP_SuiteHandler& suites, AEGP_StreamRefH markerStreamH, AEGP_LTimeMode timeMode,
+								 const char* prefix, const std::string& comment)
+{
+	A_Err err = A_Err_NONE;
+
+	// Could not be read back whole
+	if (comment.size() > (size_t)LAYER_MARKER_MAX_CHARS) return A_Err_PARAMETER;
+
+	AEGP_KeyframeIndex index = -1;
+	std::string existing;
+	ERR(FindRecordInStream(suites, markerStreamH, prefix, &index, &existing));
+
+	// Unchanged records are not rewritten (keeps the undo stack clean)
+	if (!err && index >= 0 && existing == comment) return err;
+
+	if (!err && index < 0) {
+		A_Time markerTime;
+		ERR(FindFreeMarkerTime(suites, markerStreamH, timeMode, &markerTime));
+		ERR(suites.KeyframeSuite4()->AEGP_InsertKeyframe(markerStreamH, timeMode, &markerTime, &index));
+	}
+
+	AEGP_MarkerValP markerP = NULL;
+	ERR(suites.MarkerSuite2()->AEGP_NewMarker(&markerP));
+	if (!err && markerP) {
+		std::vector<A_u_short> comment16;
+		for (size_t i = 0; i < comment.size(); i++) {
+			comment16.push_back((A_u_short)(unsigned char)comment[i]);
+		}
+		comment16.push_back(0);
+		ERR(suites.MarkerSuite2()->AEGP_SetMarkerString(markerP, AEGP_MarkerString_COMMENT, comment16.data(), (A_long)comment.size()));
+
+		AEGP_StreamValue2 value;
+		memset(&value, 0, sizeof(value));
+		value.streamH = markerStreamH;
+		value.val.markerP = markerP;
+		ERR(suites.KeyframeSuite4()->AEGP_SetKeyframeValue(markerStreamH, index, &value));
+
+		suites.MarkerSuite2()->AEGP_DisposeMarker(markerP);
+	}
+
+	return err;
+}
+
+A_Err WriteLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix,
+							 const std::string& comment)
+{
+	A_Err err = A_Err_NONE;
+	if (!layerH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.StreamSuite4()->AEGP_GetNewLayerStream(S_my_id, layerH, AEGP_LayerStream_MARKER, &markerStreamH));
+	if (err || !markerStreamH) return err;
+
+	ERR(WriteRecordInStream(suites, markerStreamH, AEGP_LTimeMode_LayerTime, prefix, comment));
+
+	suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	return err;
+}
+
+A_Err RemoveLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix)
+{
+	A_Err err = A_Err_NONE;
+	if (!layerH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.StreamSuite4()->AEGP_GetNewLayerStream(S_my_id, layerH, AEGP_LayerStream_MARKER, &markerStreamH));
+	if (!err && markerStreamH) {
+		AEGP_KeyframeIndex index = -1;
+		ERR(FindRecordInStream(suites, markerStreamH, prefix, &index, NULL));
+		if (!err && index >= 0) {
+			ERR(suites.KeyframeSuite4()->AEGP_DeleteKeyframe(markerStreamH, index));
+		}
+		suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	}
+
+	return err;
+}
+
+A_Err FindCompMarkerRecord(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+						   AEGP_KeyframeIndex* outIndex, std::string* outComment)
+{
+	A_Err err = A_Err_NONE;
+	*outIndex = -1;
+	if (!compH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCompMarkerStream(S_my_id, compH, &markerStreamH));
+	if (!err && markerStreamH) {
+		ERR(FindRecordInStream(suites, markerStreamH, prefix, outIndex, outComment));
+		suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	}
+
+	return err;
+}
+
+A_Err ListCompMarkerRecords(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+							std::vector<std::string>& outComments)
+{
+	A_Err err = A_Err_NONE;
+	if (!compH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCompMarkerStream(S_my_id, compH, &markerStreamH));
+	if (err || !markerStreamH) return err;
+
+	A_long numMarkers = 0;
+	ERR(suites.KeyframeSuite4()->AEGP_GetStreamNumKFs(markerStreamH, &numMarkers));
+	if (numMarkers > MAX_MARKERS_TO_SCAN) numMarkers = MAX_MARKERS_TO_SCAN;
+
+	const size_t prefixLen = strlen(prefix);
+	std::string comment;
+	bool truncated = false;
+	for (A_long i = 0; i < numMarkers && !err; i++) {
+		if (ReadMarkerComment(suites, markerStreamH, i, comment, &truncated) == A_Err_NONE &&
+			!truncated && comment.compare(0, prefixLen, prefix) == 0) {
+			outComments.push_back(comment);
+		}
+	}
+
+	suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	return err;
+}
+
+A_Err WriteCompMarkerRecord(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+							const std::string& comment)
+{
+	A_Err err = A_Err_NONE;
+	if (!compH || !prefix) return A_Err_STRUCT;
+
+	AEGP_StreamRefH markerStreamH = NULL;
+	ERR(suites.CompSuite11()->AEGP_GetNewCompMarkerStream(S_my_id, compH, &markerStreamH));
+	if (err || !markerStreamH) return err;
+
+	ERR(WriteRecordInStream(suites, markerStreamH, AEGP_LTimeMode_CompTime, prefix, comment));
+
+	suites.StreamSuite4()->AEGP_DisposeStream(markerStreamH);
+	return err;
+}
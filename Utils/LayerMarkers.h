@@ -0,0 +1,54 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Layer Marker Records                          */
+/*      Plugin-owned metadata stored in layer marker comments      */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef LAYER_MARKERS_H
+#define LAYER_MARKERS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <string>
+#include <vector>
+
+// Layer markers are not renderable data: editing them leaves the layer's
+// pixels (and AE's render/disk cache for the comp) untouched. Each record
+// is one marker whose comment starts with a fixed ASCII prefix, e.g. "FD-S:1".
+// Comments are plugin-owned ASCII; other characters are dropped on read.
+// Comp markers hold comp-wide records the same way.
+
+// Longest record (chars) read back whole. Longer records are refused on
+// write (A_Err_PARAMETER); a longer comment found on read is not returned.
+#define LAYER_MARKER_MAX_CHARS		32768
+
+// Find the first marker on layerH whose comment starts with prefix.
+// *outIndex is -1 when there is no such marker. outComment may be NULL;
+// it is left empty when the record is too long to read whole.
+A_Err FindLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix,
+							AEGP_KeyframeIndex* outIndex, std::string* outComment);
+
+// Create or replace the record marker for prefix. New markers go at layer
+// time 0, or the first free 1/100 s slot after it if a user marker sits there.
+A_Err WriteLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix,
+							 const std::string& comment);
+
+// Delete the record marker for prefix, if present
+A_Err RemoveLayerMarkerRecord(AEGP_SuiteHandler& suites, AEGP_LayerH layerH, const char* prefix);
+
+// Comp marker counterparts (new markers go at comp time 0 or the first
+// free slot after it)
+A_Err FindCompMarkerRecord(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+						   AEGP_KeyframeIndex* outIndex, std::string* outComment);
+A_Err WriteCompMarkerRecord(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+							const std::string& comment);
+
+// Comments of every comp marker starting with prefix, in marker order
+// (records too long to read whole are skipped)
+A_Err ListCompMarkerRecords(AEGP_SuiteHandler& suites, AEGP_CompH compH, const char* prefix,
+							std::vector<std::string>& outComments);
+
+#endif // LAYER_MARKERS_H
@@ -0,0 +1,117 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Performance Statistics                        */
+/*      Latency histograms and optional perf logging               */
+/*                                                                 */
+/*******************************************************************/
+
+#include "PerfStats.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+LatencyHistogram::LatencyHistogram()
+{
+	Reset();
+}
+
+void LatencyHistogram::Reset()
+{
+	memset(m_buckets, 0, sizeof(m_buckets));
+	m_count = 0;
+	m_sumSeconds = 0.0;
+	m_maxSeconds = 0.0;
+}
+
+void LatencyHistogram::Record(double seconds)
+{
+	if (!(seconds >= 0.0)) seconds = 0.0;
+
+	uint64_t micros = (uint64_t)(seconds * 1e6);
+	int bucket = 0;
+	while (micros > 1 && bucket < kNumBuckets - 1) {
+		micros >>= 1;
+		bucket++;
+	}
+
+	m_buckets[bucket]++;
+	m_count++;
+	m_sumSeconds += seconds;
+	if (seconds > m_maxSeconds) m_maxSeconds = seconds;
+}
+
+uint32_t LatencyHistogram::BucketCount(int bucket) const
+{
+	if (bucket < 0 || bucket >= kNumBuckets) return 0;
+	return m_buckets[bucket];
+}
+
+double LatencyHistogram::MeanSeconds() const
+{
+	return m_count ? m_sumSeconds / (double)m_count : 0.0;
+}
+
+double LatencyHistogram::PercentileSeconds(double p) const
+{
+	if (!m_count) return 0.0;
+	if (p < 0.0) p = 0.0;
+	if (p > 1.0) p = 1.0;
+
+	const uint64_t target = (uint64_t)(p * (double)m_count + 0.5);
+	uint64_t seen = 0;
+	for (int i = 0; i < kNumBuckets; i++) {
+		seen += m_buckets[i];
+		if (seen >= target && seen > 0) {
+			return (double)((uint64_t)1 << (i + 1)) * 1e-6;
+		}
+	}
+	return m_maxSeconds;
+}
+
+std::string LatencyHistogram::Summary(const char* label) const
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%s: n=%u mean=%.2fms p50<=%.2fms p95<=%.2fms max=%.2fms",
+		label ? label : "latency",
+		m_count,
+		MeanSeconds() * 1e3,
+		PercentileSeconds(0.50) * 1e3,
+		PercentileSeconds(0.95) * 1e3,
+		m_maxSeconds * 1e3);
+	return std::string(buf);
+}
+
+double PerfNowSeconds()
+{
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
+
+void PerfLog(const char* fmt, ...)
+{
+#if FOLDLAYERS_PERF_LOG
+	// File-based logging (stderr isn't visible in AE)
+	char path[512];
+#ifdef AE_OS_WIN
+	const char* tmp = getenv("TEMP");
+	snprintf(path, sizeof(path), "%s\\foldlayers_perf.log", tmp ? tmp : ".");
+#else
+	snprintf(path, sizeof(path), "/tmp/foldlayers_perf.log");
+#endif
+	FILE* f = fopen(path, "a");
+	if (f) {
+		va_list args;
+		va_start(args, fmt);
+		fprintf(f, "[FoldLayers] ");
+		vfprintf(f, fmt, args);
+		va_end(args);
+		fprintf(f, "\n");
+		fclose(f);
+	}
+#else
+	(void)fmt;
+#endif
+}
@@ -0,0 +1,58 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Performance Statistics                        */
+/*      Latency histograms and optional perf logging               */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <cstdint>
+#include <string>
+
+// Enable perf logging (set to 1 to append summaries to a temp log file)
+#ifndef FOLDLAYERS_PERF_LOG
+	#define FOLDLAYERS_PERF_LOG 0
+#endif
+
+// Log2 histogram of durations: bucket i holds [2^i, 2^(i+1)) microseconds,
+// so 24 buckets cover 1 us .. ~16 s with constant memory and O(1) record.
+class LatencyHistogram {
+public:
+	enum { kNumBuckets = 24 };
+
+	LatencyHistogram();
+
+	void		Record(double seconds);
+	void		Reset();
+
+	uint32_t	Count() const { return m_count; }
+	uint32_t	BucketCount(int bucket) const;
+	double		MeanSeconds() const;
+	double		MaxSeconds() const { return m_maxSeconds; }
+
+	// Upper bound of the bucket containing the p-th percentile (0..1)
+	double		PercentileSeconds(double p) const;
+
+	// One-line summary, e.g. "fold latency: n=12 mean=3.1ms p50<=4.1ms p95<=8.2ms max=7.9ms"
+	std::string	Summary(const char* label) const;
+
+private:
+	uint32_t	m_buckets[kNumBuckets];
+	uint32_t	m_count;
+	double		m_sumSeconds;
+	double		m_maxSeconds;
+};
+
+// Monotonic seconds for timing (same clock as InputNowSeconds)
+double PerfNowSeconds();
+
+// Append a line to the perf log when FOLDLAYERS_PERF_LOG is enabled; no-op
+// otherwise. The arguments are still evaluated, so calls that format a
+// Summary() sit inside #if FOLDLAYERS_PERF_LOG.
+void PerfLog(const char* fmt, ...);
+
+#endif // PERF_STATS_H
@@ -0,0 +1,112 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Scripting                                     */
+/*      ExtendScript calls for parameters and small UI             */
+/*                                                                 */
+/*******************************************************************/
+
+#include "Scripting.h"
+#include "FoldLayers.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+A_Err RunScript(AEGP_SuiteHandler& suites, const std::string& script, std::string* outResult)
+{
+	A_Err err = A_Err_NONE;
+	AEGP_MemHandle resultH = NULL;
+	AEGP_MemHandle errorH = NULL;
+
+	ERR(suites.UtilitySuite6()->AEGP_ExecuteScript(S_my_id, script.c_str(), FALSE, &resultH, &errorH));
+
+	if (resultH) {
+		void* resultP = NULL;
+		if (outResult && suites.MemorySuite1()->AEGP_LockMemHandle(resultH, &resultP) == A_Err_NONE && resultP) {
+			*outResult = (const char*)resultP;
+			suites.MemorySuite1()->AEGP_UnlockMemHandle(resultH);
+		}
+		suites.MemorySuite1()->AEGP_FreeMemHandle(resultH);
+	}
+	if (errorH) suites.MemorySuite1()->AEGP_FreeMemHandle(errorH);
+
+	return err;
+}
+
+A_Err TakeScriptGlobal(AEGP_SuiteHandler& suites, const char* name, std::string* outValue, bool* outFound)
+{
+	A_Err err = A_Err_NONE;
+	*outFound = false;
+
+	// A leading marker tells "unset" apart from an empty string
+	const std::string global = std::string("$.global.") + name;
+	const std::string script =
+		"(function(){var v=" + global + ";if(v===undefined||v===null){return '';}" +
+		global + "=undefined;return '1'+String(v);})();";
+
+	std::string result;
+	ERR(RunScript(suites, script, &result));
+	if (!err && !result.empty() && result[0] == '1') {
+		*outValue = result.substr(1);
+		*outFound = true;
+	}
+	return err;
+}
+
+A_Err PromptForNumber(AEGP_SuiteHandler& suites, const char* message, A_long defaultValue,
+					  A_long* outValue, bool* outCancelled)
+{
+	A_Err err = A_Err_NONE;
+	*outCancelled = true;
+
+	char script[512];
+	snprintf(script, sizeof(script), "(function(){var v=prompt('%s','%d');return v===null?'':v;})();",
+		message, (int)defaultValue);
+
+	std::string result;
+	ERR(RunScript(suites, script, &result));
+	if (err || result.empty()) return err;
+
+	char* end = NULL;
+	const long value = strtol(result.c_str(), &end, 10);
+	if (end && end != result.c_str() && *end == '\0') {
+		*outValue = (A_long)value;
+		*outCancelled = false;
+	}
+	return err;
+}
+
+std::string ScriptQuote(const std::string& text)
+{
+	std::string quoted = "'";
+	for (size_t i = 0; i < text.size(); i++) {
+		const char c = text[i];
+		if (c == '\\' || c == '\'') {
+			quoted += '\\';
+			quoted += c;
+		} else if (c == '\n') {
+			quoted += "\\n";
+		} else if ((unsigned char)c >= 0x20) {
+			quoted += c;
+		}
+	}
+	return quoted + "'";
+}
+
+A_Err PromptForText(AEGP_SuiteHandler& suites, const std::string& message, const std::string& defaultValue,
+					std::string* outValue, bool* outCancelled)
+{
+	A_Err err = A_Err_NONE;
+	*outCancelled = true;
+
+	// A leading marker tells a cancel apart from an empty answer
+	const std::string script = "(function(){var v=prompt(" + ScriptQuote(message) + "," + ScriptQuote(defaultValue) +
+		");return v===null?'':'1'+v;})();";
+
+	std::string result;
+	ERR(RunScript(suites, script, &result));
+	if (!err && !result.empty() && result[0] == '1') {
+		*outValue = result.substr(1);
+		*outCancelled = false;
+	}
+	return err;
+}
@@ -0,0 +1,38 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Scripting                                     */
+/*      ExtendScript calls for parameters and small UI             */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDLAYERS_SCRIPTING_H
+#define FOLDLAYERS_SCRIPTING_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+#include <string>
+
+// Run a script (one line: multi-line scripts fail on macOS). *outResult
+// (may be NULL) gets the value of its last expression as a string.
+A_Err RunScript(AEGP_SuiteHandler& suites, const std::string& script, std::string* outResult);
+
+// Value of $.global[name] as a string, clearing it. *outFound is false when
+// the global is not set.
+A_Err TakeScriptGlobal(AEGP_SuiteHandler& suites, const char* name, std::string* outValue, bool* outFound);
+
+// Ask for a whole number with the ExtendScript prompt. *outCancelled is
+// true when the user cancelled or entered something that is not a number.
+A_Err PromptForNumber(AEGP_SuiteHandler& suites, const char* message, A_long defaultValue,
+					  A_long* outValue, bool* outCancelled);
+
+// Ask for a line of text with the ExtendScript prompt. *outCancelled is
+// true when the user cancelled.
+A_Err PromptForText(AEGP_SuiteHandler& suites, const std::string& message, const std::string& defaultValue,
+					std::string* outValue, bool* outCancelled);
+
+// text as a single-quoted ExtendScript string literal
+std::string ScriptQuote(const std::string& text);
+
+#endif // FOLDLAYERS_SCRIPTING_H
@@ -0,0 +1,66 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Settings                                      */
+/*      User preferences persisted in the AE application prefs     */
+/*                                                                 */
+/*******************************************************************/
+
+#include "Settings.h"
+#include "AE_Macros.h"
+
+// Prefs section and keys
+#define SETTINGS_SECTION			"FoldLayers"
+#define SETTINGS_KEY_STATE_STORE	"Fold State Store"
+#define SETTINGS_KEY_NAME_PREFIX	"Sync Name Prefix"
+#define SETTINGS_KEY_DIVIDER_TYPE	"Divider Layer Type"
+#define SETTINGS_KEY_MEMBERSHIP		"Group Membership"
+#define SETTINGS_KEY_FOLD_LEVEL		"Fold Level"
+
+FoldLayersSettings	S_settings = { FoldStateStore_Contents, true, DividerLayer_Shape, GroupMembership_Positional, 2 };
+
+A_Err LoadSettings(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+
+	AEGP_PersistentBlobH blobH = NULL;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetApplicationBlob(AEGP_PersistentType_MACHINE_INDEPENDENT, &blobH));
+	if (err || !blobH) return err;
+
+	A_long store = S_settings.foldStateStore;
+	A_long namePrefix = S_settings.syncNamePrefix ? 1 : 0;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_STATE_STORE, store, &store));
+	ERR(suites.PersistentDataSuite4()->AEGP_GetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_NAME_PREFIX, namePrefix, &namePrefix));
+	A_long dividerType = S_settings.dividerLayerType;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_DIVIDER_TYPE, dividerType, &dividerType));
+	A_long membership = S_settings.groupMembership;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_MEMBERSHIP, membership, &membership));
+	A_long foldLevel = S_settings.foldLevel;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_FOLD_LEVEL, foldLevel, &foldLevel));
+
+	if (!err) {
+		S_settings.foldStateStore = (store == FoldStateStore_Marker) ? FoldStateStore_Marker : FoldStateStore_Contents;
+		S_settings.syncNamePrefix = (namePrefix != 0);
+		S_settings.dividerLayerType = (dividerType == DividerLayer_Null) ? DividerLayer_Null : DividerLayer_Shape;
+		S_settings.groupMembership = (membership == GroupMembership_Explicit) ? GroupMembership_Explicit : GroupMembership_Positional;
+		if (foldLevel >= FOLD_LEVEL_MIN && foldLevel <= FOLD_LEVEL_MAX) S_settings.foldLevel = foldLevel;
+	}
+
+	return err;
+}
+
+A_Err SaveSettings(AEGP_SuiteHandler& suites)
+{
+	A_Err err = A_Err_NONE;
+
+	AEGP_PersistentBlobH blobH = NULL;
+	ERR(suites.PersistentDataSuite4()->AEGP_GetApplicationBlob(AEGP_PersistentType_MACHINE_INDEPENDENT, &blobH));
+	if (err || !blobH) return err;
+
+	ERR(suites.PersistentDataSuite4()->AEGP_SetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_STATE_STORE, S_settings.foldStateStore));
+	ERR(suites.PersistentDataSuite4()->AEGP_SetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_NAME_PREFIX, S_settings.syncNamePrefix ? 1 : 0));
+	ERR(suites.PersistentDataSuite4()->AEGP_SetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_DIVIDER_TYPE, S_settings.dividerLayerType));
+	ERR(suites.PersistentDataSuite4()->AEGP_SetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_MEMBERSHIP, S_settings.groupMembership));
+	ERR(suites.PersistentDataSuite4()->AEGP_SetLong(blobH, SETTINGS_SECTION, SETTINGS_KEY_FOLD_LEVEL, S_settings.foldLevel));
+
+	return err;
+}
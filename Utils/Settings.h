@@ -0,0 +1,55 @@
+/*******************************************************************/
+/*                                                                 */
+/*      FoldLayers - Settings                                      */
+/*      User preferences persisted in the AE application prefs     */
+/*                                                                 */
+/*******************************************************************/
+
+#pragma once
+
+#ifndef FOLDLAYERS_SETTINGS_H
+#define FOLDLAYERS_SETTINGS_H
+
+#include "AEConfig.h"
+#include "AEGP_SuiteHandler.h"
+
+// Where a divider's fold state is written
+enum FoldStateStore {
+	FoldStateStore_Contents = 0,	// FD-0/FD-1 vector group inside the shape layer (legacy)
+	FoldStateStore_Marker = 1		// "FD-S:" layer marker comment (non-renderable)
+};
+
+// Layer type used for new dividers
+enum DividerLayerType {
+	DividerLayer_Shape = 0,			// Shape layer with FD- groups in Contents (legacy)
+	DividerLayer_Null = 1			// Null guide layer with FD-D:/FD-S: layer markers
+};
+
+// How a divider's members are found
+enum GroupMembership {
+	GroupMembership_Positional = 0,	// Layers below the divider, up to the next same-level divider
+	GroupMembership_Explicit = 1	// Layer IDs listed in the divider's "FD-M:" marker
+};
+
+// Levels accepted by Fold/Expand to Level (1 = top-level groups)
+#define FOLD_LEVEL_MIN		1
+#define FOLD_LEVEL_MAX		99
+
+typedef struct {
+	A_long		foldStateStore;		// FoldStateStore
+	bool		syncNamePrefix;		// Rewrite the ▸/▾ name prefix on fold/unfold
+	A_long		dividerLayerType;	// DividerLayerType for Create Group Layer
+	A_long		groupMembership;	// GroupMembership
+	A_long		foldLevel;			// Last level used by Fold/Expand to Level
+} FoldLayersSettings;
+
+// Current settings (defaults until LoadSettings runs)
+extern FoldLayersSettings	S_settings;
+
+// Read settings from the application prefs; missing keys keep their defaults
+A_Err LoadSettings(AEGP_SuiteHandler& suites);
+
+// Write S_settings back to the application prefs
+A_Err SaveSettings(AEGP_SuiteHandler& suites);
+
+#endif // FOLDLAYERS_SETTINGS_H